@@ -0,0 +1,52 @@
+#!/bin/bash
+
+# Blur benchmark: renders one blurred layer offscreen at several radii with
+# each uncached blur path (single-pass kernel, separable, dual-Kawase) and
+# prints the average frame time. Frames end in glFinish, so under Mesa
+# llvmpipe the frame time is the GPU time of the blur.
+
+# Always run from repo root
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+ROOT_DIR="$(cd "$SCRIPT_DIR/../.." && pwd)"
+cd "$ROOT_DIR" || exit 1
+
+IMAGE="${HYPRLAX_BENCH_IMAGE:-$ROOT_DIR/examples/pixel-city/1.png}"
+FRAMES="${HYPRLAX_BENCH_FRAMES:-120}"
+SIZE="${HYPRLAX_BENCH_SIZE:-1920x1080}"
+RADII="${HYPRLAX_BENCH_RADII:-0.5 1 2 4 8}"
+
+echo "=== Headless Blur Benchmark ==="
+echo "Image:  $IMAGE"
+echo "Frames: $FRAMES at $SIZE, blur amounts: $RADII"
+echo "Override via: HYPRLAX_BENCH_IMAGE, HYPRLAX_BENCH_FRAMES, HYPRLAX_BENCH_SIZE, HYPRLAX_BENCH_RADII"
+echo ""
+
+CONFIG="$(mktemp --suffix=.toml)"
+trap 'rm -f "$CONFIG"' EXIT
+
+# Average frame ms for one mode; extra arguments are environment settings
+run_mode() {
+    env HYPRLAX_RENDER_BLUR_CACHE=0 "$@" \
+        ./hyprlax --headless --frames "$FRAMES" --headless-size "$SIZE" -c "$CONFIG" 2>/dev/null |
+        awk '/headless: frame ms avg/ { print $5 }'
+}
+
+printf "%-8s %12s %12s %12s\n" "blur" "kernel" "separable" "kawase"
+for radius in $RADII; do
+    cat > "$CONFIG" <<TOML
+[global]
+fps = 60
+vsync = false
+
+[[global.layers]]
+path = "$IMAGE"
+shift_multiplier = 0.5
+blur = $radius
+TOML
+    kernel=$(run_mode HYPRLAX_RENDER_KAWASE_BLUR=0 HYPRLAX_RENDER_SEPARABLE_BLUR=0)
+    separable=$(run_mode HYPRLAX_RENDER_KAWASE_BLUR=0 HYPRLAX_RENDER_SEPARABLE_BLUR=1)
+    kawase=$(run_mode HYPRLAX_RENDER_KAWASE_BLUR=1 HYPRLAX_RENDER_SEPARABLE_BLUR=0)
+    printf "%-8s %12s %12s %12s\n" "$radius" "${kernel:-n/a}" "${separable:-n/a}" "${kawase:-n/a}"
+done
+echo ""
+echo "(average frame ms; lower is better)"
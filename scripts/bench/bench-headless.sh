@@ -0,0 +1,26 @@
+#!/bin/bash
+
+# Headless replay benchmark: renders a fixed workspace trace offscreen and
+# prints frame timings plus a checksum of the last frame. Needs no
+# compositor, so it runs in CI (Mesa llvmpipe works).
+
+# Always run from repo root
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+ROOT_DIR="$(cd "$SCRIPT_DIR/../.." && pwd)"
+cd "$ROOT_DIR" || exit 1
+
+CONFIG_DEFAULT="examples/pixel-city/parallax.toml"
+CONFIG="${HYPRLAX_BENCH_CONFIG:-$CONFIG_DEFAULT}"
+TRACE="${HYPRLAX_BENCH_TRACE:-scripts/bench/headless.trace}"
+FRAMES="${HYPRLAX_BENCH_FRAMES:-600}"
+SIZE="${HYPRLAX_BENCH_SIZE:-1920x1080}"
+
+echo "=== Headless Replay Benchmark ==="
+echo "Config: $CONFIG"
+echo "Trace:  $TRACE ($FRAMES frames at $SIZE)"
+echo "Override via: HYPRLAX_BENCH_CONFIG, HYPRLAX_BENCH_TRACE, HYPRLAX_BENCH_FRAMES, HYPRLAX_BENCH_SIZE"
+echo ""
+
+./hyprlax --headless --frames "$FRAMES" --headless-size "$SIZE" \
+    --trace="$TRACE" ${HYPRLAX_BENCH_DUMP:+--dump "$HYPRLAX_BENCH_DUMP"} \
+    -c "$CONFIG"
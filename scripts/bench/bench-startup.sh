@@ -0,0 +1,53 @@
+#!/bin/bash
+
+# Startup benchmark: time from launch to the first frame drawn offscreen,
+# with images decoded on the main thread (render.decode_threads = 0) and
+# on the decode pool. Headless runs wait for every decode before drawing,
+# so the difference is what parallel decoding saves; an interactive run
+# also keeps animating and answering IPC while images decode. A last row
+# starts from a warm image cache (in a scratch directory), where nothing
+# is decoded at all.
+
+# Always run from repo root
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+ROOT_DIR="$(cd "$SCRIPT_DIR/../.." && pwd)"
+cd "$ROOT_DIR" || exit 1
+
+CONFIG_DEFAULT="examples/pixel-city/parallax.toml"
+CONFIG="${HYPRLAX_BENCH_CONFIG:-$CONFIG_DEFAULT}"
+RUNS="${HYPRLAX_BENCH_RUNS:-5}"
+SIZE="${HYPRLAX_BENCH_SIZE:-1920x1080}"
+THREADS="${HYPRLAX_BENCH_THREADS:-0 1 2 4}"
+
+echo "=== Headless Startup Benchmark ==="
+echo "Config: $CONFIG"
+echo "Runs:   $RUNS at $SIZE, decode threads: $THREADS"
+echo "Override via: HYPRLAX_BENCH_CONFIG, HYPRLAX_BENCH_RUNS, HYPRLAX_BENCH_SIZE, HYPRLAX_BENCH_THREADS"
+echo ""
+
+CACHE_DIR="$(mktemp -d)"
+trap 'rm -rf "$CACHE_DIR"' EXIT
+
+# Average wall-clock ms of a one-frame run; $1 decode threads, $2 cache MiB
+run_mode() {
+    local total=0
+    for _ in $(seq "$RUNS"); do
+        local start end
+        start=$(date +%s%N)
+        XDG_CACHE_HOME="$CACHE_DIR" HYPRLAX_RENDER_DECODE_THREADS="$1" HYPRLAX_RENDER_IMAGE_CACHE="$2" \
+            ./hyprlax --headless --frames 1 --headless-size "$SIZE" -c "$CONFIG" >/dev/null 2>&1
+        end=$(date +%s%N)
+        total=$((total + (end - start) / 1000))
+    done
+    awk -v us="$total" -v n="$RUNS" 'BEGIN { printf "%.1f", us / n / 1000.0 }'
+}
+
+printf "%-16s %12s\n" "decode threads" "startup ms"
+for threads in $THREADS; do
+    printf "%-16s %12s\n" "$threads" "$(run_mode "$threads" 0)"
+done
+# A first pass fills the cache, the second reads it
+run_mode 4 1024 >/dev/null
+printf "%-16s %12s\n" "4, warm cache" "$(run_mode 4 1024)"
+echo ""
+echo "(0 = decode on the main thread; lower is better)"
@@ -63,6 +63,8 @@ void config_set_defaults(config_t *cfg) {
     cfg->render_tile_y = 0;
     cfg->render_accumulate = false;
     cfg->render_trail_strength = HYPRLAX_DEFAULT_TRAIL_STRENGTH; /* per-frame fade when accumulating */
+    cfg->render_threaded = false;
+    cfg->render_options = (render_options_t)RENDER_OPTIONS_DEFAULTS;
     cfg->cursor_sensitivity_x = 1.0f;
     cfg->cursor_sensitivity_y = 1.0f;
     cfg->cursor_deadzone_px = 4.0f;
@@ -215,6 +215,25 @@ static void parse_global_table(toml_table_t *global, config_t *cfg)
         }
         toml_datum_t acc = toml_bool_in(render, "accumulate");
         if (acc.ok) cfg->render_accumulate = acc.u.b;
+        toml_datum_t thr = toml_bool_in(render, "threaded");
+        if (thr.ok) cfg->render_threaded = thr.u.b;
+        /* Renderer tuning switches (render_options.h) */
+        for (int i = 0; render_options_name(i); i++) {
+            const char *name = render_options_name(i);
+            char value[32];
+            if (render_options_is_int(name)) {
+                toml_datum_t d = toml_int_in(render, name);
+                if (!d.ok) continue;
+                snprintf(value, sizeof(value), "%lld", (long long)d.u.i);
+            } else {
+                toml_datum_t d = toml_bool_in(render, name);
+                if (!d.ok) continue;
+                snprintf(value, sizeof(value), "%s", d.u.b ? "true" : "false");
+            }
+            if (render_options_set(&cfg->render_options, name, value) != 0) {
+                LOG_WARN("Ignoring render.%s = %s (out of range)", name, value);
+            }
+        }
         toml_datum_t ts = toml_double_in(render, "trail_strength");
         if (ts.ok) {
             float v = (float)ts.u.d; if (v < 0.0f) v = 0.0f; if (v > 1.0f) v = 1.0f;
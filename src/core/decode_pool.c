@@ -0,0 +1,235 @@
+/*
+ * decode_pool.c - Worker threads for image decoding
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "../include/decode_pool.h"
+#include "../include/log.h"
+
+typedef struct dp_job {
+    uint32_t ticket;
+    decode_pool_fn run;
+    decode_pool_fn discard;
+    void *arg;
+    bool cancelled;             /* Discard once run() returns */
+    struct dp_job *next;
+} dp_job_t;
+
+/* FIFO of jobs */
+typedef struct {
+    dp_job_t *head;
+    dp_job_t *tail;
+} dp_list_t;
+
+struct decode_pool {
+    pthread_t *workers;
+    int threads;
+    int event_fd;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work;        /* Queue gained a job, or stopping */
+    pthread_cond_t idle;        /* A job finished */
+    dp_list_t queued;
+    dp_list_t running;
+    dp_list_t done;
+    int pending;                /* Jobs in any of the three lists */
+    uint32_t next_ticket;
+    bool stop;
+};
+
+static void dp_push(dp_list_t *list, dp_job_t *job) {
+    job->next = NULL;
+    if (list->tail) list->tail->next = job;
+    else list->head = job;
+    list->tail = job;
+}
+
+static dp_job_t *dp_pop(dp_list_t *list) {
+    dp_job_t *job = list->head;
+    if (!job) return NULL;
+    list->head = job->next;
+    if (!list->head) list->tail = NULL;
+    job->next = NULL;
+    return job;
+}
+
+/* Unlink the job with ticket from list; NULL if it is not there */
+static dp_job_t *dp_remove(dp_list_t *list, uint32_t ticket) {
+    dp_job_t *prev = NULL;
+    for (dp_job_t *job = list->head; job; prev = job, job = job->next) {
+        if (job->ticket != ticket) continue;
+        if (prev) prev->next = job->next;
+        else list->head = job->next;
+        if (list->tail == job) list->tail = prev;
+        job->next = NULL;
+        return job;
+    }
+    return NULL;
+}
+
+static void dp_discard(dp_job_t *job) {
+    if (job->discard) job->discard(job->arg);
+    free(job);
+}
+
+static void *dp_worker(void *arg) {
+    decode_pool_t *pool = arg;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && !pool->queued.head) pthread_cond_wait(&pool->work, &pool->lock);
+        if (pool->stop) break;
+        dp_job_t *job = dp_pop(&pool->queued);
+        dp_push(&pool->running, job);
+        pthread_mutex_unlock(&pool->lock);
+
+        job->run(job->arg);
+
+        pthread_mutex_lock(&pool->lock);
+        dp_remove(&pool->running, job->ticket);
+        if (job->cancelled) {
+            pool->pending--;
+            pthread_mutex_unlock(&pool->lock);
+            dp_discard(job);
+            pthread_mutex_lock(&pool->lock);
+        } else {
+            dp_push(&pool->done, job);
+            uint64_t one = 1;
+            if (write(pool->event_fd, &one, sizeof(one)) < 0) {
+                /* Counter saturated: the main thread has plenty to read */
+            }
+        }
+        pthread_cond_broadcast(&pool->idle);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+decode_pool_t *decode_pool_create(int threads) {
+    if (threads < 1) threads = 1;
+    decode_pool_t *pool = calloc(1, sizeof(*pool));
+    if (!pool) return NULL;
+    pool->workers = calloc((size_t)threads, sizeof(*pool->workers));
+    pool->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (!pool->workers || pool->event_fd < 0) {
+        if (pool->event_fd >= 0) close(pool->event_fd);
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+    pool->next_ticket = 1;
+
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&pool->workers[i], NULL, dp_worker, pool) != 0) {
+            LOG_WARN("Decode pool: started %d of %d threads", i, threads);
+            break;
+        }
+        pool->threads++;
+    }
+    if (pool->threads == 0) {
+        decode_pool_destroy(pool);
+        return NULL;
+    }
+    LOG_DEBUG("Decode pool: %d threads", pool->threads);
+    return pool;
+}
+
+void decode_pool_destroy(decode_pool_t *pool) {
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    for (dp_job_t *job = pool->running.head; job; job = job->next) job->cancelled = true;
+    dp_list_t queued = pool->queued;
+    pool->queued = (dp_list_t){ NULL, NULL };
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    /* Running jobs finish and are discarded by their worker */
+    for (int i = 0; i < pool->threads; i++) pthread_join(pool->workers[i], NULL);
+    for (dp_job_t *job; (job = dp_pop(&queued));) dp_discard(job);
+    for (dp_job_t *job; (job = dp_pop(&pool->done));) dp_discard(job);
+
+    pthread_cond_destroy(&pool->idle);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+    close(pool->event_fd);
+    free(pool->workers);
+    free(pool);
+}
+
+int decode_pool_threads(const decode_pool_t *pool) {
+    return pool ? pool->threads : 0;
+}
+
+int decode_pool_event_fd(const decode_pool_t *pool) {
+    return pool ? pool->event_fd : -1;
+}
+
+uint32_t decode_pool_submit(decode_pool_t *pool, decode_pool_fn run, decode_pool_fn discard, void *arg) {
+    if (!pool || !run) return 0;
+    dp_job_t *job = calloc(1, sizeof(*job));
+    if (!job) return 0;
+    job->run = run;
+    job->discard = discard;
+    job->arg = arg;
+    pthread_mutex_lock(&pool->lock);
+    job->ticket = pool->next_ticket++;
+    if (pool->next_ticket == 0) pool->next_ticket = 1;
+    dp_push(&pool->queued, job);
+    pool->pending++;
+    pthread_cond_signal(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    return job->ticket;
+}
+
+void *decode_pool_take(decode_pool_t *pool, uint32_t *ticket) {
+    if (!pool) return NULL;
+    pthread_mutex_lock(&pool->lock);
+    dp_job_t *job = dp_pop(&pool->done);
+    if (job) pool->pending--;
+    pthread_mutex_unlock(&pool->lock);
+    if (!job) return NULL;
+    if (ticket) *ticket = job->ticket;
+    void *arg = job->arg;
+    free(job);
+    return arg;
+}
+
+bool decode_pool_cancel(decode_pool_t *pool, uint32_t ticket) {
+    if (!pool || ticket == 0) return false;
+    pthread_mutex_lock(&pool->lock);
+    dp_job_t *job = dp_remove(&pool->queued, ticket);
+    if (!job) job = dp_remove(&pool->done, ticket);
+    if (job) {
+        pool->pending--;
+        pthread_mutex_unlock(&pool->lock);
+        dp_discard(job);
+        return true;
+    }
+    bool found = false;
+    for (job = pool->running.head; job; job = job->next) {
+        if (job->ticket == ticket) { job->cancelled = true; found = true; break; }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return found;
+}
+
+void decode_pool_wait(decode_pool_t *pool) {
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    while (pool->queued.head || pool->running.head) pthread_cond_wait(&pool->idle, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int decode_pool_pending(const decode_pool_t *pool) {
+    if (!pool) return 0;
+    pthread_mutex_lock((pthread_mutex_t *)&pool->lock);
+    int pending = pool->pending;
+    pthread_mutex_unlock((pthread_mutex_t *)&pool->lock);
+    return pending;
+}
@@ -14,6 +14,8 @@
 #include "../include/platform.h"
 #include "../include/compositor.h"
 #include "../include/log.h"
+#include "../include/render_thread.h"
+#include "../include/decode_pool.h"
 #include "../ipc.h"
 #include "../include/defaults.h"
 
@@ -78,6 +80,8 @@ void hyprlax_setup_epoll(hyprlax_context_t *ctx) {
     epoll_add_fd(ctx->epoll_fd, ctx->ipc_event_fd, EPOLLIN);
     epoll_add_fd(ctx->epoll_fd, ctx->frame_timer_fd, EPOLLIN);
     epoll_add_fd(ctx->epoll_fd, ctx->debounce_timer_fd, EPOLLIN);
+    /* Images decoded at startup may still be in flight */
+    if (ctx->decode_pool) epoll_add_fd(ctx->epoll_fd, decode_pool_event_fd(ctx->decode_pool), EPOLLIN);
 }
 
 void hyprlax_arm_frame_timer(hyprlax_context_t *ctx, int fps) {
@@ -119,20 +123,29 @@ static double ev_get_time(void) {
     return ts.tv_sec + ts.tv_nsec / 1000000000.0;
 }
 
+/* Predict each output's next present; layers are shared, so they are
+ * sampled at the earliest one */
+static double ev_predict_present(hyprlax_context_t *ctx, double now) {
+    double earliest = 0.0;
+    if (ctx->monitors) {
+        for (monitor_instance_t *m = ctx->monitors->head; m; m = m->next) {
+            m->present_target = frame_clock_predict(&m->clock, now);
+            if (earliest == 0.0 || m->present_target < earliest) earliest = m->present_target;
+        }
+    }
+    ctx->frame_target_time = earliest > 0.0 ? earliest : now;
+    return ctx->frame_target_time;
+}
+
 /* Main run loop */
 int hyprlax_run(hyprlax_context_t *ctx) {
     if (!ctx) return HYPRLAX_ERROR_INVALID_ARGS;
+    if (ctx->headless.enabled) return hyprlax_run_headless(ctx);
 
     if (ctx->config.debug) {
         LOG_DEBUG("Starting main loop (target FPS: %d)", ctx->config.target_fps);
     }
 
-    static int s_render_diag = -1;
-    if (s_render_diag == -1) {
-        const char *p = getenv("HYPRLAX_RENDER_DIAG");
-        s_render_diag = (p && *p) ? 1 : 0;
-    }
-
     double last_render_time = ev_get_time();
     double last_frame_time = last_render_time;
     double frame_time = 1.0 / (double)(ctx->config.target_fps > 0 ? ctx->config.target_fps : HYPRLAX_DEFAULT_FPS);
@@ -145,9 +158,7 @@ int hyprlax_run(hyprlax_context_t *ctx) {
         int current_fps = ctx->config.target_fps;
         if (current_fps <= 0) current_fps = HYPRLAX_DEFAULT_FPS;
         if (current_fps != prev_target_fps) {
-            const char *fc_env = getenv("HYPRLAX_FRAME_CALLBACK");
-            bool use_frame_callback = (fc_env && *fc_env);
-            if (!use_frame_callback) {
+            if (!ctx->config.render_options.frame_callback) {
                 hyprlax_arm_frame_timer(ctx, current_fps);
             }
             prev_target_fps = current_fps;
@@ -159,8 +170,14 @@ int hyprlax_run(hyprlax_context_t *ctx) {
         ctx->delta_time = current_time - last_frame_time;
         last_frame_time = current_time;
 
+        /* Platform events add, resize and pace outputs the render thread
+         * may be drawing */
         platform_event_t platform_event;
-        if (PLATFORM_POLL_EVENTS(ctx->platform, &platform_event) == HYPRLAX_SUCCESS) {
+        render_thread_lock_outputs(ctx->render_thread);
+        int polled = PLATFORM_POLL_EVENTS(ctx->platform, &platform_event);
+        render_thread_unlock_outputs(ctx->render_thread);
+        render_thread_kick(ctx->render_thread);
+        if (polled == HYPRLAX_SUCCESS) {
             switch (platform_event.type) {
                 case PLATFORM_EVENT_CLOSE: ctx->running = false; break;
                 case PLATFORM_EVENT_RESIZE:
@@ -171,6 +188,8 @@ int hyprlax_run(hyprlax_context_t *ctx) {
         }
 
         if (ctx->ipc_ctx && ipc_process_commands((ipc_context_t*)ctx->ipc_ctx)) {
+            /* IPC edits layer fields directly */
+            hyprlax_mark_layers_changed(ctx);
             needs_render = true;
         }
 
@@ -185,22 +204,26 @@ int hyprlax_run(hyprlax_context_t *ctx) {
             }
         }
 
+        /* Outputs held back by an in-flight frame are drawn once its frame
+         * callback arrives (by the render thread itself when there is one) */
+        if (!needs_render && ctx->nonblocking_present && !ctx->render_thread && ctx->monitors) {
+            for (monitor_instance_t *m = ctx->monitors->head; m; m = m->next) {
+                if (m->render_dirty && !m->frame_pending) { needs_render = true; break; }
+            }
+        }
+
         bool animations_active = false;
         {
-            parallax_layer_t *layer = ctx->layers;
-            while (layer) {
-                if ((layer->is_gif && layer->frame_count > 1) || animation_is_active(&layer->x_animation) || animation_is_active(&layer->y_animation)) { animations_active = true; break; }
-                layer = layer->next;
-            }
+            layer_store_refresh(&ctx->layer_store, ctx->layers);
+            animations_active = layer_store_animating(&ctx->layer_store);
             if (!animations_active && ctx->monitors) {
             monitor_instance_t *m = ctx->monitors->head;
             while (m) { if (m->animating) { animations_active = true; break; } m = m->next; }
             }
         }
 
-        const char *use_fc = getenv("HYPRLAX_FRAME_CALLBACK");
         if (animations_active) {
-            if (use_fc && *use_fc && ctx->monitors) {
+            if (ctx->config.render_options.frame_callback && !ctx->render_thread && ctx->monitors) {
                 bool can_render = false;
                 monitor_instance_t *m = ctx->monitors->head;
                 while (m) { if (!m->frame_pending) { can_render = true; break; } m = m->next; }
@@ -213,9 +236,7 @@ int hyprlax_run(hyprlax_context_t *ctx) {
         if (needs_render) {
             double time_since_render = current_time - last_render_time;
             if (time_since_render < frame_time) {
-                const char *fc_env = getenv("HYPRLAX_FRAME_CALLBACK");
-                bool use_frame_callback = (fc_env && *fc_env);
-                if (!use_frame_callback) {
+                if (!ctx->config.render_options.frame_callback) {
                     int sleep_ms = (int)((frame_time - time_since_render) * 1000.0);
                     if (sleep_ms > 0) {
                         struct timespec ts; ts.tv_sec = sleep_ms / 1000; ts.tv_nsec = (sleep_ms % 1000) * 1000000L;
@@ -226,11 +247,12 @@ int hyprlax_run(hyprlax_context_t *ctx) {
             /* Ensure input providers (e.g., cursor) update during continuous render
                windows (animations), even when we aren't blocking on epoll. */
             hyprlax_cursor_tick(ctx);
-            /* Advance animations before rendering */
-            hyprlax_update_layers(ctx, current_time);
+            /* Advance animations to when this frame will be shown */
+            double present_time = ev_predict_present(ctx, ev_get_time());
+            hyprlax_update_layers(ctx, present_time);
             if (ctx->monitors) {
                 monitor_instance_t *m = ctx->monitors->head;
-                while (m) { monitor_update_animation(m, current_time); m = m->next; }
+                while (m) { monitor_update_animation(m, m->present_target); m = m->next; }
             }
             hyprlax_render_frame(ctx);
             ctx->fps = 1.0 / (time_since_render > 0 ? time_since_render : frame_time);
@@ -241,14 +263,35 @@ int hyprlax_run(hyprlax_context_t *ctx) {
             if (ctx->config.debug) {
                 debug_timer += time_since_render;
                 if (debug_timer >= 1.0) {
-                    LOG_DEBUG("FPS: %.1f, Layers: %d, Animations: %s", ctx->fps, ctx->layer_count, animations_active ? "active" : "idle");
+                    render_thread_take_stats(ctx->render_thread, &ctx->render_stats);
+                    const render_stats_t *rs = &ctx->render_stats;
+                    double damage_saved = rs->surface_px > 0
+                        ? 100.0 * (1.0 - (double)rs->damaged_px / (double)rs->surface_px) : 0.0;
+                    LOG_DEBUG("FPS: %.1f, Layers: %d, Animations: %s, Damage saved: %.1f%%, Skipped monitors: %.1f/s, Throttled: %.1f/s",
+                              ctx->fps, ctx->layer_count, animations_active ? "active" : "idle",
+                              damage_saved, (double)rs->monitors_skipped / debug_timer,
+                              (double)rs->monitors_throttled / debug_timer);
+                    if (rs->outputs_presented > 0 && (rs->gl_calls || rs->gl_calls_elided)) {
+                        LOG_DEBUG("  GL calls/frame: %.0f (%.0f elided)",
+                                  (double)rs->gl_calls / (double)rs->outputs_presented,
+                                  (double)rs->gl_calls_elided / (double)rs->outputs_presented);
+                    }
+                    for (monitor_instance_t *m = ctx->monitors ? ctx->monitors->head : NULL; m; m = m->next) {
+                        double avg = frame_clock_average_interval(&m->clock);
+                        if (avg > 0.0) {
+                            LOG_DEBUG("  %s: present %.2f ms (refresh %.2f ms, %s), missed %u/%u",
+                                      m->name, avg * 1000.0, frame_clock_interval(&m->clock) * 1000.0,
+                                      frame_clock_source_name(m->clock.source),
+                                      m->clock.missed, m->clock.presented);
+                        }
+                        frame_clock_reset_window(&m->clock);
+                    }
+                    memset(&ctx->render_stats, 0, sizeof(ctx->render_stats));
                     debug_timer = 0.0;
                 }
             }
         } else {
-            const char *fc_env = getenv("HYPRLAX_FRAME_CALLBACK");
-            bool use_frame_callback = (fc_env && *fc_env);
-            if (!use_frame_callback) {
+            if (!ctx->config.render_options.frame_callback) {
                 if (animations_active) {
                     if (!ctx->frame_timer_armed) hyprlax_arm_frame_timer(ctx, ctx->config.target_fps);
                 } else {
@@ -286,6 +329,10 @@ int hyprlax_run(hyprlax_context_t *ctx) {
                             needs_render = true;
                         } else if (fd == ctx->cursor_event_fd) {
                             if (hyprlax_cursor_tick(ctx)) needs_render = true;
+                        } else if (fd == decode_pool_event_fd(ctx->decode_pool)) {
+                            /* Decoded images are uploaded by the next frame's prepare */
+                            hyprlax_clear_timerfd(fd);
+                            needs_render = true;
                         } else {
                             /* Other FDs handled in subsequent loop iteration */
                         }
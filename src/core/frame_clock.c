@@ -0,0 +1,128 @@
+/*
+ * frame_clock.c - Per-output presentation clock
+ *
+ * Keeps the phase (last presentation) and period (refresh interval) of an
+ * output, see frame_clock.h. Presentation feedback gives exact timestamps,
+ * refresh counters and usually the interval itself; frame callbacks only
+ * tell when the compositor finished a repaint, which is close enough to
+ * the refresh edge to keep the phase.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "../include/frame_clock.h"
+#include "../include/defaults.h"
+
+static double fc_nominal(int refresh_hz) {
+    return 1.0 / (double)(refresh_hz > 0 ? refresh_hz : HYPRLAX_DEFAULT_FPS);
+}
+
+void frame_clock_init(frame_clock_t *clock, int refresh_hz) {
+    if (!clock) return;
+    memset(clock, 0, sizeof(*clock));
+    clock->nominal_interval = fc_nominal(refresh_hz);
+    clock->interval = clock->nominal_interval;
+}
+
+void frame_clock_set_refresh(frame_clock_t *clock, int refresh_hz) {
+    if (!clock) return;
+    double nominal = fc_nominal(refresh_hz);
+    /* A new mode invalidates what was measured on the old one */
+    if (fabs(nominal - clock->nominal_interval) > 1e-9) {
+        clock->nominal_interval = nominal;
+        clock->interval = nominal;
+    }
+}
+
+void frame_clock_submitted(frame_clock_t *clock, double target) {
+    if (clock) clock->pending_target = target;
+}
+
+static void fc_update(frame_clock_t *clock, double time, double refresh,
+                      uint64_t msc, bool has_msc) {
+    if (clock->last_present > 0.0 && time > clock->last_present) {
+        double delta = time - clock->last_present;
+        double refreshes;
+        if (has_msc && clock->has_msc && msc > clock->last_msc) {
+            refreshes = (double)(msc - clock->last_msc);
+        } else {
+            refreshes = floor(delta / clock->interval + 0.5);
+            if (refreshes < 1.0) refreshes = 1.0;
+        }
+
+        if (refresh > 0.0) {
+            clock->interval = refresh;
+        } else {
+            /* Only trust samples near the nominal rate: a stalled loop
+             * must not drag the period */
+            double sample = delta / refreshes;
+            if (sample > clock->nominal_interval * 0.5 && sample < clock->nominal_interval * 2.0) {
+                clock->interval += (sample - clock->interval) * HYPRLAX_FRAME_CLOCK_SMOOTHING;
+            }
+        }
+
+        if (delta < clock->interval * HYPRLAX_FRAME_CLOCK_IDLE_GAP) {
+            clock->interval_sum += delta;
+            clock->interval_count++;
+        }
+    }
+
+    if (clock->pending_target > 0.0) {
+        if (time > clock->pending_target + clock->interval * 0.5) clock->missed++;
+        clock->pending_target = 0.0;
+    }
+    clock->presented++;
+    clock->last_present = time;
+    clock->last_msc = msc;
+    clock->has_msc = has_msc;
+}
+
+void frame_clock_presented(frame_clock_t *clock, double time, double refresh,
+                           uint64_t msc, bool has_msc) {
+    if (!clock) return;
+    clock->source = FRAME_CLOCK_PRESENTATION;
+    fc_update(clock, time, refresh, msc, has_msc);
+}
+
+void frame_clock_discarded(frame_clock_t *clock) {
+    if (!clock) return;
+    clock->discarded++;
+    clock->pending_target = 0.0;
+}
+
+void frame_clock_frame_done(frame_clock_t *clock, double time) {
+    if (!clock || clock->source == FRAME_CLOCK_PRESENTATION) return;
+    clock->source = FRAME_CLOCK_CALLBACK;
+    fc_update(clock, time, 0.0, 0, false);
+}
+
+double frame_clock_predict(const frame_clock_t *clock, double now) {
+    if (!clock || clock->source == FRAME_CLOCK_NONE || clock->last_present <= 0.0) return now;
+    double interval = clock->interval;
+    if (now < clock->last_present) return clock->last_present + interval;
+    double elapsed = now - clock->last_present;
+    return clock->last_present + (floor(elapsed / interval) + 1.0) * interval;
+}
+
+double frame_clock_interval(const frame_clock_t *clock) {
+    return clock ? clock->interval : fc_nominal(0);
+}
+
+double frame_clock_average_interval(const frame_clock_t *clock) {
+    if (!clock || clock->interval_count == 0) return 0.0;
+    return clock->interval_sum / (double)clock->interval_count;
+}
+
+void frame_clock_reset_window(frame_clock_t *clock) {
+    if (!clock) return;
+    clock->interval_sum = 0.0;
+    clock->interval_count = 0;
+}
+
+const char* frame_clock_source_name(frame_clock_source_t source) {
+    switch (source) {
+        case FRAME_CLOCK_PRESENTATION: return "presentation";
+        case FRAME_CLOCK_CALLBACK: return "frame-callback";
+        default: return "timer";
+    }
+}
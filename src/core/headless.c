@@ -0,0 +1,366 @@
+/*
+ * headless.c - Offscreen replay for benchmarks and golden images
+ *
+ * Drives the regular render core against a virtual output backed by an EGL
+ * pbuffer (or a plain memory buffer with -r software): no compositor,
+ * platform or IPC. Frames advance on a simulated
+ * clock (frame / fps) so layer animations land on the same frames on every
+ * run; optional trace events are fed through the same workspace and
+ * property paths the live daemon uses. Reports frame timings and a checksum
+ * of the final frame, and can dump it as PNG.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/hyprlax.h"
+#include "../include/renderer.h"
+#include "../include/trace.h"
+#include "../include/log.h"
+#include "../include/defaults.h"
+#include "../core/monitor.h"
+
+extern void process_workspace_event(hyprlax_context_t *ctx, const compositor_event_t *comp_event);
+
+static double hl_get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+/* Offscreen renderer plus one virtual output; replaces init steps 1-6 */
+int hyprlax_init_headless(hyprlax_context_t *ctx) {
+    if (!ctx || !ctx->monitors) return HYPRLAX_ERROR_INVALID_ARGS;
+    const headless_options_t *opt = &ctx->headless;
+
+    const char *backend = ctx->backends.renderer_backend;
+    const char *name = "headless";
+    /* auto stays on GLES2 so golden checksums do not depend on the driver */
+    if (backend && (strcmp(backend, "software") == 0 || strcmp(backend, "cpu") == 0)) {
+        name = "software";
+    } else if (backend && strcmp(backend, "gles3") == 0) {
+        name = "headless-gles3";
+    } else if (backend && strcmp(backend, "auto") != 0 && strcmp(backend, "headless") != 0) {
+        LOG_WARN("Renderer '%s' ignored in headless mode", backend);
+    }
+    int ret = renderer_create(&ctx->renderer, name);
+    if (ret != HYPRLAX_SUCCESS) {
+        LOG_ERROR("Failed to create headless renderer");
+        return ret;
+    }
+
+    renderer_config_t render_config = {
+        .width = opt->width,
+        .height = opt->height,
+        .vsync = false,
+        .target_fps = ctx->config.target_fps,
+        .capabilities = 0,
+    };
+    renderer_set_options(&ctx->config.render_options);
+    ret = RENDERER_INIT(ctx->renderer, NULL, NULL, &render_config);
+    if (ret != HYPRLAX_SUCCESS && strcmp(name, "headless-gles3") == 0) {
+        LOG_INFO("OpenGL ES 3.0 unavailable, falling back to OpenGL ES 2.0");
+        renderer_destroy(ctx->renderer);
+        ctx->renderer = NULL;
+        ret = renderer_create(&ctx->renderer, "headless");
+        if (ret != HYPRLAX_SUCCESS) return ret;
+        ret = RENDERER_INIT(ctx->renderer, NULL, NULL, &render_config);
+    }
+    if (ret != HYPRLAX_SUCCESS) {
+        LOG_ERROR("Failed to initialize headless renderer (no EGL pbuffer support?)");
+        renderer_destroy(ctx->renderer);
+        ctx->renderer = NULL;
+        return ret;
+    }
+    ctx->renderer->initialized = true;
+    LOG_DEBUG("Renderer: %s", ctx->renderer->ops->get_name());
+
+    monitor_instance_t *monitor = monitor_instance_create(HYPRLAX_HEADLESS_MONITOR_NAME);
+    if (!monitor) return HYPRLAX_ERROR_NO_MEMORY;
+    monitor_update_geometry(monitor, opt->width, opt->height, 1,
+                            ctx->config.target_fps > 0 ? ctx->config.target_fps : HYPRLAX_DEFAULT_FPS);
+    config_t *config = monitor_resolve_config(monitor, &ctx->config);
+    monitor_apply_config(monitor, config);
+    monitor_list_add(ctx->monitors, monitor);
+
+    if (ctx->renderer->ops->create_surface) {
+        monitor->render_surface = ctx->renderer->ops->create_surface(NULL, opt->width, opt->height);
+    } else {
+        monitor->egl_surface = gles2_create_offscreen_surface(opt->width, opt->height);
+    }
+    if (!monitor->egl_surface && !monitor->render_surface) {
+        LOG_ERROR("Failed to create offscreen surface %dx%d", opt->width, opt->height);
+        return HYPRLAX_ERROR_GL_INIT;
+    }
+
+    if (hyprlax_load_layer_textures(ctx) != HYPRLAX_SUCCESS) {
+        LOG_WARN("[INIT] Warning: Some textures failed to load");
+    }
+    hyprlax_finish_texture_decodes(ctx);
+
+    ctx->state = APP_STATE_RUNNING;
+    ctx->running = true;
+    return HYPRLAX_SUCCESS;
+}
+
+static void hl_apply_event(hyprlax_context_t *ctx, const trace_event_t *event) {
+    switch (event->type) {
+        case TRACE_EVENT_WORKSPACE:
+        case TRACE_EVENT_WORKSPACE_2D: {
+            compositor_event_t comp_event;
+            memset(&comp_event, 0, sizeof(comp_event));
+            comp_event.type = COMPOSITOR_EVENT_WORKSPACE_CHANGE;
+            if (event->type == TRACE_EVENT_WORKSPACE) {
+                comp_event.data.workspace.from_workspace = ctx->current_workspace;
+                comp_event.data.workspace.to_workspace = event->workspace;
+                ctx->current_workspace = event->workspace;
+            } else {
+                comp_event.data.workspace.from_x = event->from_x;
+                comp_event.data.workspace.from_y = event->from_y;
+                comp_event.data.workspace.to_x = event->to_x;
+                comp_event.data.workspace.to_y = event->to_y;
+            }
+            snprintf(comp_event.data.workspace.monitor_name,
+                     sizeof(comp_event.data.workspace.monitor_name), "%s", event->monitor);
+            process_workspace_event(ctx, &comp_event);
+            break;
+        }
+        case TRACE_EVENT_SET:
+            if (hyprlax_runtime_set_property(ctx, event->property, event->value) != 0) {
+                LOG_WARN("Trace: cannot set %s=%s", event->property, event->value);
+            }
+            break;
+    }
+}
+
+/* Output animations are started on the wall clock; move the ones an event
+ * just started onto the simulated clock */
+static void hl_rebase_monitor_animations(hyprlax_context_t *ctx, const double *before,
+                                         int count, double sim_time) {
+    int i = 0;
+    for (monitor_instance_t *m = ctx->monitors->head; m && i < count; m = m->next, i++) {
+        if (m->animating && m->animation_start_time != before[i]) {
+            m->animation_start_time = sim_time;
+        }
+    }
+}
+
+static int hl_cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* FNV-1a over the frame, so golden runs can compare one number */
+static uint64_t hl_checksum(const uint8_t *data, size_t len) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/* Minimal PNG encoder: RGBA8, stored (uncompressed) deflate blocks */
+static uint32_t hl_crc_table[256];
+
+static uint32_t hl_crc32(uint32_t crc, const uint8_t *data, size_t len) {
+    if (!hl_crc_table[1]) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            hl_crc_table[n] = c;
+        }
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) crc = hl_crc_table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void hl_put_be32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8); p[3] = (uint8_t)v;
+}
+
+static bool hl_write_chunk(FILE *f, const char *type, const uint8_t *data, uint32_t len) {
+    uint8_t head[8];
+    hl_put_be32(head, len);
+    memcpy(head + 4, type, 4);
+    uint32_t crc = hl_crc32(0, head + 4, 4);
+    crc = hl_crc32(crc, data, len);
+    uint8_t tail[4];
+    hl_put_be32(tail, crc);
+    return fwrite(head, 1, 8, f) == 8 &&
+           (len == 0 || fwrite(data, 1, len, f) == len) &&
+           fwrite(tail, 1, 4, f) == 4;
+}
+
+/* rgba has a bottom-left origin (glReadPixels); rows are flipped on write */
+static int hl_write_png(const char *path, const uint8_t *rgba, int width, int height) {
+    size_t row = (size_t)width * 4 + 1;
+    size_t raw_len = row * (size_t)height;
+    size_t blocks = (raw_len + 65534) / 65535;
+    size_t z_len = 2 + raw_len + blocks * 5 + 4;
+    if (z_len > 0x7fffffffu) return HYPRLAX_ERROR_INVALID_ARGS;
+
+    uint8_t *raw = malloc(raw_len);
+    uint8_t *z = malloc(z_len);
+    if (!raw || !z) {
+        free(raw);
+        free(z);
+        return HYPRLAX_ERROR_NO_MEMORY;
+    }
+    for (int y = 0; y < height; y++) {
+        uint8_t *dst = raw + (size_t)y * row;
+        dst[0] = 0;  /* filter: none */
+        memcpy(dst + 1, rgba + (size_t)(height - 1 - y) * width * 4, (size_t)width * 4);
+    }
+
+    /* zlib stream of stored blocks */
+    size_t o = 0;
+    z[o++] = 0x78;
+    z[o++] = 0x01;
+    uint32_t a = 1, b = 0;
+    for (size_t off = 0; off < raw_len; off += 65535) {
+        size_t n = raw_len - off < 65535 ? raw_len - off : 65535;
+        z[o++] = off + n == raw_len ? 1 : 0;
+        z[o++] = (uint8_t)n; z[o++] = (uint8_t)(n >> 8);
+        z[o++] = (uint8_t)~n; z[o++] = (uint8_t)(~n >> 8);
+        memcpy(z + o, raw + off, n);
+        o += n;
+        for (size_t i = 0; i < n; i++) {
+            a = (a + raw[off + i]) % 65521;
+            b = (b + a) % 65521;
+        }
+    }
+    hl_put_be32(z + o, (b << 16) | a);
+    o += 4;
+    free(raw);
+
+    int ret = HYPRLAX_ERROR_LOAD_FAILED;
+    FILE *f = fopen(path, "wb");
+    if (f) {
+        static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        uint8_t ihdr[13];
+        hl_put_be32(ihdr, (uint32_t)width);
+        hl_put_be32(ihdr + 4, (uint32_t)height);
+        ihdr[8] = 8;   /* bit depth */
+        ihdr[9] = 6;   /* RGBA */
+        ihdr[10] = 0; ihdr[11] = 0; ihdr[12] = 0;
+        bool ok = fwrite(sig, 1, 8, f) == 8 &&
+                  hl_write_chunk(f, "IHDR", ihdr, sizeof(ihdr)) &&
+                  hl_write_chunk(f, "IDAT", z, (uint32_t)o) &&
+                  hl_write_chunk(f, "IEND", NULL, 0);
+        if (fclose(f) == 0 && ok) ret = HYPRLAX_SUCCESS;
+    }
+    free(z);
+    return ret;
+}
+
+int hyprlax_run_headless(hyprlax_context_t *ctx) {
+    if (!ctx || !ctx->renderer || !ctx->monitors || !ctx->monitors->head) {
+        return HYPRLAX_ERROR_INVALID_ARGS;
+    }
+    const headless_options_t *opt = &ctx->headless;
+
+    trace_t trace;
+    memset(&trace, 0, sizeof(trace));
+    if (opt->trace_path) {
+        int ret = trace_load(opt->trace_path, &trace);
+        if (ret != HYPRLAX_SUCCESS) return ret;
+        LOG_INFO("Replaying %d events from %s", trace.count, opt->trace_path);
+    }
+
+    int frames = opt->frames > 0 ? opt->frames : HYPRLAX_HEADLESS_DEFAULT_FRAMES;
+    double *frame_ms = calloc((size_t)frames, sizeof(double));
+    double start_times[8];
+    if (!frame_ms) {
+        trace_free(&trace);
+        return HYPRLAX_ERROR_NO_MEMORY;
+    }
+
+    double origin = hl_get_time();
+    double sim_time = origin;
+    int next_event = 0;
+    int rendered = 0, drawn = 0;
+    for (int f = 0; f < frames && ctx->running; f++) {
+        /* fps may change mid-run, so accumulate the step */
+        int fps = ctx->config.target_fps > 0 ? ctx->config.target_fps : HYPRLAX_DEFAULT_FPS;
+        if (f > 0) sim_time += 1.0 / (double)fps;
+
+        if (next_event < trace.count && trace.events[next_event].time <= sim_time - origin) {
+            int n = 0;
+            for (monitor_instance_t *m = ctx->monitors->head; m && n < 8; m = m->next) {
+                start_times[n++] = m->animation_start_time;
+            }
+            while (next_event < trace.count && trace.events[next_event].time <= sim_time - origin) {
+                hl_apply_event(ctx, &trace.events[next_event++]);
+            }
+            hl_rebase_monitor_animations(ctx, start_times, n, sim_time);
+        }
+
+        /* Simulated frames have no real time to decode or slice uploads
+         * over; finish them so what a frame shows does not depend on the
+         * host's speed */
+        hyprlax_finish_texture_decodes(ctx);
+        renderer_finish_uploads();
+        ctx->frame_target_time = sim_time;
+        hyprlax_update_layers(ctx, sim_time);
+        for (monitor_instance_t *m = ctx->monitors->head; m; m = m->next) {
+            m->present_target = sim_time;
+            monitor_update_animation(m, sim_time);
+        }
+
+        uint64_t skipped = ctx->render_stats.monitors_skipped;
+        double t0 = hl_get_time();
+        hyprlax_render_frame(ctx);
+        frame_ms[f] = (hl_get_time() - t0) * 1000.0;
+        if (ctx->render_stats.monitors_skipped == skipped) drawn++;
+        rendered++;
+    }
+    trace_free(&trace);
+
+    if (rendered == 0) {
+        free(frame_ms);
+        return HYPRLAX_SUCCESS;
+    }
+
+    double total = 0.0;
+    for (int i = 0; i < rendered; i++) total += frame_ms[i];
+    qsort(frame_ms, (size_t)rendered, sizeof(double), hl_cmp_double);
+    printf("headless: %d frames (%d drawn) at %dx%d, %.2f s simulated\n",
+           rendered, drawn, opt->width, opt->height, sim_time - origin);
+    printf("headless: frame ms avg %.3f p50 %.3f p95 %.3f p99 %.3f max %.3f\n",
+           total / rendered, frame_ms[rendered / 2], frame_ms[(rendered * 95) / 100],
+           frame_ms[(rendered * 99) / 100], frame_ms[rendered - 1]);
+    free(frame_ms);
+
+    /* Read back the last frame of the virtual output */
+    const renderer_ops_t *ops = ctx->renderer->ops;
+    int ret = HYPRLAX_SUCCESS;
+    if (ops->read_pixels) {
+        monitor_instance_t *monitor = ctx->monitors->head;
+        int w = monitor->width * monitor->scale;
+        int h = monitor->height * monitor->scale;
+        uint8_t *pixels = malloc((size_t)w * (size_t)h * 4);
+        if (!pixels) return HYPRLAX_ERROR_NO_MEMORY;
+        int bound = ops->make_current ? ops->make_current(monitor->render_surface, w, h)
+                                      : gles2_make_current(monitor->egl_surface);
+        if (bound == HYPRLAX_SUCCESS &&
+            ops->read_pixels(0, 0, w, h, pixels) == HYPRLAX_SUCCESS) {
+            printf("headless: checksum %016llx\n",
+                   (unsigned long long)hl_checksum(pixels, (size_t)w * (size_t)h * 4));
+            if (opt->dump_path) {
+                ret = hl_write_png(opt->dump_path, pixels, w, h);
+                if (ret == HYPRLAX_SUCCESS) LOG_INFO("Wrote %s", opt->dump_path);
+                else LOG_ERROR("Failed to write %s", opt->dump_path);
+            }
+        } else {
+            LOG_ERROR("Failed to read back the last frame");
+            ret = HYPRLAX_ERROR_GL_INIT;
+        }
+        free(pixels);
+    }
+    fflush(stdout);
+    return ret;
+}
@@ -0,0 +1,376 @@
+/*
+ * image.c - CPU-side processing of decoded layer images
+ *
+ * The resampler's inner loops (the Lanczos row fold and taps, the opaque
+ * 2:1 box) come in scalar, SSE2 and AVX2 versions, picked once for the
+ * widest the CPU has. They do the same float operations in the same
+ * order as the scalar loops, so every version gives the same pixels.
+ */
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "../include/core.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define IMAGE_X86 1
+#include <immintrin.h>
+#endif
+
+#define LANCZOS_A 3
+
+static float lanczos(float x) {
+    if (x < 0.0f) x = -x;
+    if (x < 1e-6f) return 1.0f;
+    if (x >= (float)LANCZOS_A) return 0.0f;
+    const float pi = 3.14159265358979f;
+    float px = pi * x;
+    return (float)LANCZOS_A * sinf(px) * sinf(px / (float)LANCZOS_A) / (px * px);
+}
+
+/* Normalised Lanczos taps for output sample `o` of an axis scaled from
+ * `in` to `out` samples; returns the first source index, fills weights */
+static int filter_taps(int o, int in, int out, int max_taps, float *weights, int *count) {
+    float scale = (float)in / (float)out;
+    float support = scale > 1.0f ? LANCZOS_A * scale : (float)LANCZOS_A;
+    float stretch = scale > 1.0f ? 1.0f / scale : 1.0f;
+    float center = ((float)o + 0.5f) * scale - 0.5f;
+    int first = (int)floorf(center - support) + 1;
+    int last = (int)ceilf(center + support) - 1;
+    if (first < 0) first = 0;
+    if (last > in - 1) last = in - 1;
+    if (last - first + 1 > max_taps) last = first + max_taps - 1;
+    float sum = 0.0f;
+    for (int i = first; i <= last; i++) {
+        weights[i - first] = lanczos(((float)i - center) * stretch);
+        sum += weights[i - first];
+    }
+    int n = last - first + 1;
+    if (n <= 0 || sum == 0.0f) {
+        /* Degenerate footprint: nearest sample */
+        first = (int)(center + 0.5f);
+        if (first < 0) first = 0;
+        if (first > in - 1) first = in - 1;
+        weights[0] = 1.0f;
+        n = 1;
+    } else {
+        for (int i = 0; i < n; i++) weights[i] /= sum;
+    }
+    *count = n;
+    return first;
+}
+
+static int max_taps_for(int in, int out) {
+    float scale = (float)in / (float)out;
+    if (scale < 1.0f) scale = 1.0f;
+    return (int)ceilf(2.0f * LANCZOS_A * scale) + 2;
+}
+
+/* Inner loops of the resampler, one set per instruction set */
+typedef struct {
+    const char *name;
+    /* row += wt * alpha * (r, g, b, 1) for each of w pixels of in */
+    void (*fold)(float *row, const uint8_t *in, int w, float wt);
+    /* acc = sum over count taps of wts[t] * in[t] (premultiplied float pixels) */
+    void (*taps)(const float *in, const float *wts, int count, float acc[4]);
+    /* Output pixels [x, ow) of a row halved on both axes (rows r0, r1) */
+    void (*halve2)(uint8_t *out, const uint8_t *r0, const uint8_t *r1, int x, int ow);
+} image_kernels_t;
+
+/* Alpha-weighted 2:1 box of output pixels [x, ow) of a row (fx in {1, 2});
+ * colour of fully transparent texels does not bleed into visible ones */
+static void halve_scalar(uint8_t *out, const uint8_t *r0, const uint8_t *r1, int fx, int x, int ow) {
+    for (; x < ow; x++) {
+        const uint8_t *a0 = r0 + (size_t)x * fx * 4, *a1 = a0 + (fx - 1) * 4;
+        const uint8_t *b0 = r1 + (size_t)x * fx * 4, *b1 = b0 + (fx - 1) * 4;
+        /* Along an unreduced axis each sample is counted twice: still / 4 */
+        uint32_t a = (uint32_t)a0[3] + a1[3] + b0[3] + b1[3];
+        if (a == 4 * 255) {
+            for (int ch = 0; ch < 4; ch++) {
+                out[x * 4 + ch] = (uint8_t)(((uint32_t)a0[ch] + a1[ch] + b0[ch] + b1[ch] + 2) / 4);
+            }
+            continue;
+        }
+        for (int ch = 0; ch < 3; ch++) {
+            uint32_t c = (uint32_t)a0[ch] * a0[3] + (uint32_t)a1[ch] * a1[3] +
+                         (uint32_t)b0[ch] * b0[3] + (uint32_t)b1[ch] * b1[3];
+            uint32_t plain = (uint32_t)a0[ch] + a1[ch] + b0[ch] + b1[ch];
+            out[x * 4 + ch] = (uint8_t)(a ? (c + a / 2) / a : (plain + 2) / 4);
+        }
+        out[x * 4 + 3] = (uint8_t)((a + 2) / 4);
+    }
+}
+
+static void halve2_scalar(uint8_t *out, const uint8_t *r0, const uint8_t *r1, int x, int ow) {
+    halve_scalar(out, r0, r1, 2, x, ow);
+}
+
+static void fold_scalar(float *row, const uint8_t *in, int w, float wt) {
+    for (int x = 0; x < w; x++) {
+        float a = wt * (float)in[x * 4 + 3];
+        row[x * 4 + 0] += a * (float)in[x * 4 + 0];
+        row[x * 4 + 1] += a * (float)in[x * 4 + 1];
+        row[x * 4 + 2] += a * (float)in[x * 4 + 2];
+        row[x * 4 + 3] += a;
+    }
+}
+
+static void taps_scalar(const float *in, const float *wts, int count, float acc[4]) {
+    acc[0] = acc[1] = acc[2] = acc[3] = 0.0f;
+    for (int t = 0; t < count; t++) {
+        for (int ch = 0; ch < 4; ch++) acc[ch] += wts[t] * in[t * 4 + ch];
+    }
+}
+
+#ifdef IMAGE_X86
+/* One pixel per step: its four channels are the four lanes */
+__attribute__((target("sse2")))
+static void fold_sse2(float *row, const uint8_t *in, int w, float wt) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 rgb = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    const __m128 one_a = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+    const __m128 wv = _mm_set1_ps(wt);
+    for (int x = 0; x < w; x++) {
+        int bytes;
+        memcpy(&bytes, in + x * 4, sizeof(bytes));
+        __m128i v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero), zero);
+        __m128 px = _mm_cvtepi32_ps(v);
+        __m128 a = _mm_mul_ps(wv, _mm_shuffle_ps(px, px, _MM_SHUFFLE(3, 3, 3, 3)));
+        __m128 c = _mm_or_ps(_mm_and_ps(px, rgb), one_a);
+        _mm_storeu_ps(row + x * 4, _mm_add_ps(_mm_loadu_ps(row + x * 4), _mm_mul_ps(a, c)));
+    }
+}
+
+__attribute__((target("sse2")))
+static void taps_sse2(const float *in, const float *wts, int count, float acc[4]) {
+    __m128 sum = _mm_setzero_ps();
+    for (int t = 0; t < count; t++) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(wts[t]), _mm_loadu_ps(in + t * 4)));
+    }
+    _mm_storeu_ps(acc, sum);
+}
+
+/* Two output pixels per step from four texels of each row; steps with a
+ * texel under full alpha take the scalar path */
+__attribute__((target("sse2")))
+static void halve2_sse2(uint8_t *out, const uint8_t *r0, const uint8_t *r1, int x, int ow) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    for (; x + 2 <= ow; x += 2) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(r0 + (size_t)x * 8));
+        __m128i b = _mm_loadu_si128((const __m128i *)(r1 + (size_t)x * 8));
+        int opaque = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(a, b), _mm_set1_epi8(-1)));
+        if ((opaque & 0x8888) != 0x8888) {
+            halve_scalar(out, r0, r1, 2, x, x + 2);
+            continue;
+        }
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+        lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+        hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+        __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), two), 2);
+        _mm_storel_epi64((__m128i *)(out + (size_t)x * 4), _mm_packus_epi16(sum, sum));
+    }
+    halve_scalar(out, r0, r1, 2, x, ow);
+}
+
+/* Two pixels per step, one per 128-bit lane */
+__attribute__((target("avx2")))
+static void fold_avx2(float *row, const uint8_t *in, int w, float wt) {
+    const __m256 one_a = _mm256_setr_ps(0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+    const __m256 wv = _mm256_set1_ps(wt);
+    int x = 0;
+    for (; x + 2 <= w; x += 2) {
+        __m128i bytes = _mm_loadl_epi64((const __m128i *)(in + x * 4));
+        __m256 px = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+        __m256 a = _mm256_mul_ps(wv, _mm256_shuffle_ps(px, px, _MM_SHUFFLE(3, 3, 3, 3)));
+        __m256 c = _mm256_blend_ps(px, one_a, 0x88);
+        _mm256_storeu_ps(row + x * 4, _mm256_add_ps(_mm256_loadu_ps(row + x * 4), _mm256_mul_ps(a, c)));
+    }
+    fold_sse2(row + x * 4, in + x * 4, w - x, wt);
+}
+
+/* Four output pixels per step. Unpack and pack work within 128-bit lanes,
+ * so the lanes hold pixels {0, 1} / {2, 3} until the final permute. */
+__attribute__((target("avx2")))
+static void halve2_avx2(uint8_t *out, const uint8_t *r0, const uint8_t *r1, int x, int ow) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i two = _mm256_set1_epi16(2);
+    for (; x + 4 <= ow; x += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(r0 + (size_t)x * 8));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(r1 + (size_t)x * 8));
+        unsigned opaque = (unsigned)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_and_si256(a, b), _mm256_set1_epi8(-1)));
+        if ((opaque & 0x88888888u) != 0x88888888u) {
+            halve_scalar(out, r0, r1, 2, x, x + 4);
+            continue;
+        }
+        __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero));
+        __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero));
+        lo = _mm256_add_epi16(lo, _mm256_srli_si256(lo, 8));
+        hi = _mm256_add_epi16(hi, _mm256_srli_si256(hi, 8));
+        __m256i sum = _mm256_srli_epi16(_mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi), two), 2);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(sum, sum), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128((__m128i *)(out + (size_t)x * 4), _mm256_castsi256_si128(packed));
+    }
+    halve2_sse2(out, r0, r1, x, ow);
+}
+#endif /* IMAGE_X86 */
+
+static const image_kernels_t k_kernels[] = {
+    { "scalar", fold_scalar, taps_scalar, halve2_scalar },
+#ifdef IMAGE_X86
+    { "sse2", fold_sse2, taps_sse2, halve2_sse2 },
+    /* Summing taps two at a time would reorder the additions */
+    { "avx2", fold_avx2, taps_sse2, halve2_avx2 },
+#endif
+};
+
+#define KERNEL_COUNT ((int)(sizeof(k_kernels) / sizeof(k_kernels[0])))
+
+static bool kernels_supported(const image_kernels_t *k) {
+#ifdef IMAGE_X86
+    __builtin_cpu_init();
+    if (!strcmp(k->name, "sse2")) return __builtin_cpu_supports("sse2");
+    if (!strcmp(k->name, "avx2")) return __builtin_cpu_supports("avx2");
+#endif
+    return !strcmp(k->name, "scalar");
+}
+
+static const image_kernels_t *_Atomic s_kernels;
+
+/* Widest supported set, picked on first use (decode workers may race to
+ * it; they agree) */
+static const image_kernels_t *kernels(void) {
+    const image_kernels_t *k = atomic_load(&s_kernels);
+    if (k) return k;
+    k = &k_kernels[0];
+    for (int i = KERNEL_COUNT - 1; i > 0; i--) {
+        if (kernels_supported(&k_kernels[i])) {
+            k = &k_kernels[i];
+            break;
+        }
+    }
+    atomic_store(&s_kernels, k);
+    return k;
+}
+
+const char *image_resample_use(const char *isa) {
+    if (isa) {
+        for (int i = 0; i < KERNEL_COUNT; i++) {
+            if (!strcasecmp(isa, k_kernels[i].name) && kernels_supported(&k_kernels[i])) {
+                atomic_store(&s_kernels, &k_kernels[i]);
+                return k_kernels[i].name;
+            }
+        }
+        return NULL;
+    }
+    atomic_store(&s_kernels, NULL);
+    return kernels()->name;
+}
+
+/* Alpha-weighted 2:1 box reduction of either or both axes (fx, fy in {1, 2}) */
+static uint8_t *halve(const uint8_t *src, int w, int h, int fx, int fy, int *out_w, int *out_h) {
+    int ow = w / fx, oh = h / fy;
+    uint8_t *dst = malloc((size_t)ow * (size_t)oh * 4);
+    if (!dst) return NULL;
+    const image_kernels_t *k = kernels();
+    for (int y = 0; y < oh; y++) {
+        const uint8_t *r0 = src + (size_t)(y * fy) * (size_t)w * 4;
+        const uint8_t *r1 = r0 + (fy == 2 ? (size_t)w * 4 : 0);
+        uint8_t *out = dst + (size_t)y * (size_t)ow * 4;
+        if (fx == 2) k->halve2(out, r0, r1, 0, ow);
+        else halve_scalar(out, r0, r1, fx, 0, ow);
+    }
+    *out_w = ow;
+    *out_h = oh;
+    return dst;
+}
+
+static uint8_t clamp_byte(float v) {
+    if (v <= 0.0f) return 0;
+    if (v >= 255.0f) return 255;
+    return (uint8_t)(v + 0.5f);
+}
+
+/* Separable alpha-weighted Lanczos-3, one output row at a time: the source
+ * rows under its vertical taps are folded into a premultiplied float row,
+ * which is then filtered horizontally */
+static int lanczos_resample(const uint8_t *src, int w, int h, uint8_t *dst, int ow, int oh) {
+    int htaps = max_taps_for(w, ow);
+    int vtaps = max_taps_for(h, oh);
+    float *row = malloc((size_t)w * 4 * sizeof(float));
+    float *hweights = malloc((size_t)ow * (size_t)htaps * sizeof(float));
+    int *hfirst = malloc((size_t)ow * sizeof(int));
+    int *hcount = malloc((size_t)ow * sizeof(int));
+    float *vweights = malloc((size_t)vtaps * sizeof(float));
+    if (!row || !hweights || !hfirst || !hcount || !vweights) {
+        free(row); free(hweights); free(hfirst); free(hcount); free(vweights);
+        return -1;
+    }
+    for (int x = 0; x < ow; x++) {
+        hfirst[x] = filter_taps(x, w, ow, htaps, hweights + (size_t)x * htaps, &hcount[x]);
+    }
+    const image_kernels_t *k = kernels();
+
+    for (int y = 0; y < oh; y++) {
+        int vcount;
+        int vfirst = filter_taps(y, h, oh, vtaps, vweights, &vcount);
+        memset(row, 0, (size_t)w * 4 * sizeof(float));
+        for (int t = 0; t < vcount; t++) {
+            k->fold(row, src + (size_t)(vfirst + t) * (size_t)w * 4, w, vweights[t]);
+        }
+
+        uint8_t *out = dst + (size_t)y * (size_t)ow * 4;
+        for (int x = 0; x < ow; x++) {
+            float acc[4];
+            k->taps(row + (size_t)hfirst[x] * 4, hweights + (size_t)x * htaps, hcount[x], acc);
+            float inv = acc[3] > 1e-3f ? 1.0f / acc[3] : 0.0f;
+            out[x * 4 + 0] = clamp_byte(acc[0] * inv);
+            out[x * 4 + 1] = clamp_byte(acc[1] * inv);
+            out[x * 4 + 2] = clamp_byte(acc[2] * inv);
+            out[x * 4 + 3] = clamp_byte(acc[3]);
+        }
+    }
+
+    free(row); free(hweights); free(hfirst); free(hcount); free(vweights);
+    return 0;
+}
+
+/* Box-halve each axis while it is at least twice its target, then Lanczos
+ * the remaining (under 2:1) step */
+uint8_t *image_resample_rgba(const uint8_t *rgba, int width, int height, int out_width, int out_height) {
+    if (!rgba || width <= 0 || height <= 0 || out_width <= 0 || out_height <= 0) return NULL;
+
+    const uint8_t *src = rgba;
+    uint8_t *owned = NULL;
+    int w = width, h = height;
+    while (w / 2 >= out_width || h / 2 >= out_height) {
+        int fx = w / 2 >= out_width ? 2 : 1;
+        int fy = h / 2 >= out_height ? 2 : 1;
+        int nw, nh;
+        uint8_t *next = halve(src, w, h, fx, fy, &nw, &nh);
+        free(owned);
+        if (!next) return NULL;
+        src = owned = next;
+        w = nw;
+        h = nh;
+    }
+
+    if (w == out_width && h == out_height) {
+        if (owned) return owned;
+        uint8_t *copy = malloc((size_t)w * (size_t)h * 4);
+        if (copy) memcpy(copy, src, (size_t)w * (size_t)h * 4);
+        return copy;
+    }
+
+    uint8_t *dst = malloc((size_t)out_width * (size_t)out_height * 4);
+    if (dst && lanczos_resample(src, w, h, dst, out_width, out_height) != 0) {
+        free(dst);
+        dst = NULL;
+    }
+    free(owned);
+    return dst;
+}
@@ -75,6 +75,40 @@ parallax_layer_t* layer_create(const char *image_path, float shift_multiplier, f
     return layer;
 }
 
+/* Scan RGBA pixels for full opacity and the bounding box of visible texels.
+ * A fully transparent image reports an empty (zero-sized) box. */
+void layer_analyze_alpha(const uint8_t *rgba, int width, int height,
+                         bool *opaque, int bbox[4]) {
+    bool all_opaque = rgba && width > 0 && height > 0;
+    int x0 = width, y0 = height, x1 = -1, y1 = -1;
+    for (int y = 0; rgba && y < height; y++) {
+        const uint8_t *row = rgba + (size_t)y * (size_t)width * 4;
+        int first = -1, last = -1;
+        for (int x = 0; x < width; x++) {
+            uint8_t a = row[x * 4 + 3];
+            if (a != 255) all_opaque = false;
+            if (a) {
+                if (first < 0) first = x;
+                last = x;
+            }
+        }
+        if (first < 0) continue;
+        if (first < x0) x0 = first;
+        if (last > x1) x1 = last;
+        if (y < y0) y0 = y;
+        y1 = y;
+    }
+    if (opaque) *opaque = all_opaque;
+    if (bbox) {
+        if (x1 < 0) {
+            bbox[0] = bbox[1] = bbox[2] = bbox[3] = 0;
+        } else {
+            bbox[0] = x0; bbox[1] = y0;
+            bbox[2] = x1 - x0 + 1; bbox[3] = y1 - y0 + 1;
+        }
+    }
+}
+
 /* Destroy a layer and free resources */
 void layer_destroy(parallax_layer_t *layer) {
     if (!layer) return;
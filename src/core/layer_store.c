@@ -0,0 +1,243 @@
+/*
+ * layer_store.c - Structure-of-arrays layer state
+ *
+ * Mirrors the hot per-layer state (offsets, multipliers, animations) of the
+ * layer list into contiguous arrays so ticks and retargets stream memory
+ * instead of chasing list nodes. The list stays the owner; the store is
+ * rebuilt from it after invalidation and carries animation state across
+ * rebuilds by layer id.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "../include/core.h"
+#include "../include/log.h"
+#include "../include/defaults.h"
+
+/* Fibonacci hashing of layer ids into the slot index */
+static inline uint32_t store_hash(uint32_t id, int size) {
+    return (id * 2654435769u) & (uint32_t)(size - 1);
+}
+
+static void store_free_arrays(layer_store_t *store) {
+    free(store->layers);
+    free(store->ids);
+    free(store->current_x);
+    free(store->current_y);
+    free(store->shift);
+    free(store->shift_x);
+    free(store->shift_y);
+    free(store->aspect);
+    free(store->from_x);
+    free(store->from_y);
+    free(store->to_x);
+    free(store->to_y);
+    free(store->start);
+    free(store->duration);
+    free(store->easing);
+    free(store->active);
+    free(store->index);
+}
+
+static int store_alloc_arrays(layer_store_t *store, int capacity, int index_size) {
+    size_t n = (size_t)capacity;
+    store->layers = calloc(n, sizeof(*store->layers));
+    store->ids = calloc(n, sizeof(*store->ids));
+    store->current_x = calloc(n, sizeof(float));
+    store->current_y = calloc(n, sizeof(float));
+    store->shift = calloc(n, sizeof(float));
+    store->shift_x = calloc(n, sizeof(float));
+    store->shift_y = calloc(n, sizeof(float));
+    store->aspect = calloc(n, sizeof(float));
+    store->from_x = calloc(n, sizeof(float));
+    store->from_y = calloc(n, sizeof(float));
+    store->to_x = calloc(n, sizeof(float));
+    store->to_y = calloc(n, sizeof(float));
+    store->start = calloc(n, sizeof(double));
+    store->duration = calloc(n, sizeof(double));
+    store->easing = calloc(n, sizeof(uint8_t));
+    store->active = calloc(n, sizeof(uint8_t));
+    store->index = malloc((size_t)index_size * sizeof(int32_t));
+    if (!store->layers || !store->ids || !store->current_x || !store->current_y ||
+        !store->shift || !store->shift_x || !store->shift_y || !store->aspect ||
+        !store->from_x || !store->from_y || !store->to_x || !store->to_y ||
+        !store->start || !store->duration || !store->easing || !store->active ||
+        !store->index) {
+        store_free_arrays(store);
+        return HYPRLAX_ERROR_NO_MEMORY;
+    }
+    memset(store->index, 0xff, (size_t)index_size * sizeof(int32_t));
+    store->capacity = capacity;
+    store->index_size = index_size;
+    return HYPRLAX_SUCCESS;
+}
+
+/* Free all arrays; the store can be refreshed again afterwards */
+void layer_store_destroy(layer_store_t *store) {
+    if (!store) return;
+    store_free_arrays(store);
+    memset(store, 0, sizeof(*store));
+}
+
+/* The list changed (membership, order, properties or textures) */
+void layer_store_invalidate(layer_store_t *store) {
+    if (store) store->valid = false;
+}
+
+/* Seed a new slot's animation from the node's own animation state */
+static void store_seed_from_node(layer_store_t *store, int i, const parallax_layer_t *layer) {
+    const animation_state_t *ax = &layer->x_animation;
+    const animation_state_t *ay = &layer->y_animation;
+    const animation_state_t *timing = ax->active ? ax : ay;
+    store->current_x[i] = layer->current_x;
+    store->current_y[i] = layer->current_y;
+    store->from_x[i] = ax->active ? ax->from_value : layer->current_x;
+    store->to_x[i] = ax->active ? ax->to_value : layer->current_x;
+    store->from_y[i] = ay->active ? ay->from_value : layer->current_y;
+    store->to_y[i] = ay->active ? ay->to_value : layer->current_y;
+    store->start[i] = timing->start_time;
+    store->duration[i] = timing->duration;
+    store->easing[i] = (uint8_t)timing->easing;
+    store->active[i] = (ax->active || ay->active) ? 1 : 0;
+}
+
+/* Rebuild from the list if invalidated; a no-op otherwise */
+int layer_store_refresh(layer_store_t *store, parallax_layer_t *head) {
+    if (!store) return HYPRLAX_ERROR_INVALID_ARGS;
+    if (store->valid) return HYPRLAX_SUCCESS;
+
+    int count = 0;
+    for (parallax_layer_t *it = head; it; it = it->next) count++;
+    int index_size = 16;
+    while (index_size < count * 2) index_size <<= 1;
+
+    layer_store_t next;
+    memset(&next, 0, sizeof(next));
+    if (store_alloc_arrays(&next, count > 0 ? count : 1, index_size) != HYPRLAX_SUCCESS) {
+        LOG_ERROR("Out of memory building layer store (%d layers)", count);
+        return HYPRLAX_ERROR_NO_MEMORY;
+    }
+
+    int i = 0;
+    for (parallax_layer_t *layer = head; layer && i < count; layer = layer->next, i++) {
+        next.layers[i] = layer;
+        next.ids[i] = layer->id;
+        next.shift[i] = layer->shift_multiplier;
+        next.shift_x[i] = layer->shift_multiplier_x;
+        next.shift_y[i] = layer->shift_multiplier_y;
+        next.aspect[i] = (layer->width > 0 && layer->height > 0)
+            ? (float)layer->height / (float)layer->width : 1.0f;
+        if (layer->is_gif && layer->frame_count > 1) next.animated_gif_count++;
+
+        /* Keep offsets and running animations across rebuilds */
+        int old = layer_store_slot(store, layer->id);
+        if (old >= 0) {
+            next.current_x[i] = store->current_x[old];
+            next.current_y[i] = store->current_y[old];
+            next.from_x[i] = store->from_x[old];
+            next.from_y[i] = store->from_y[old];
+            next.to_x[i] = store->to_x[old];
+            next.to_y[i] = store->to_y[old];
+            next.start[i] = store->start[old];
+            next.duration[i] = store->duration[old];
+            next.easing[i] = store->easing[old];
+            next.active[i] = store->active[old];
+        } else {
+            store_seed_from_node(&next, i, layer);
+        }
+        if (next.active[i]) next.active_count++;
+
+        uint32_t h = store_hash(layer->id, index_size);
+        while (next.index[h] >= 0) h = (h + 1) & (uint32_t)(index_size - 1);
+        next.index[h] = i;
+    }
+    next.count = i;
+    next.valid = true;
+
+    store_free_arrays(store);
+    *store = next;
+    return HYPRLAX_SUCCESS;
+}
+
+/* Slot of a layer id, or -1 */
+int layer_store_slot(const layer_store_t *store, uint32_t layer_id) {
+    if (!store || !store->index || store->index_size <= 0) return -1;
+    uint32_t mask = (uint32_t)(store->index_size - 1);
+    for (uint32_t h = store_hash(layer_id, store->index_size), probes = 0;
+         probes <= mask; h = (h + 1) & mask, probes++) {
+        int32_t slot = store->index[h];
+        if (slot < 0) return -1;
+        if (store->ids[slot] == layer_id) return slot;
+    }
+    return -1;
+}
+
+/* O(1) lookup; only valid after a refresh */
+parallax_layer_t* layer_store_find(const layer_store_t *store, uint32_t layer_id) {
+    if (!store || !store->valid) return NULL;
+    int slot = layer_store_slot(store, layer_id);
+    return slot >= 0 ? store->layers[slot] : NULL;
+}
+
+/* Animate a slot from its current offset to a target (see layer_update_offset) */
+void layer_store_animate_to(layer_store_t *store, int slot, float target_x, float target_y,
+                            double duration, easing_type_t easing) {
+    if (!store || slot < 0 || slot >= store->count) return;
+    store->from_x[slot] = store->current_x[slot];
+    store->from_y[slot] = store->current_y[slot];
+    store->to_x[slot] = target_x;
+    store->to_y[slot] = target_y;
+    store->duration[slot] = duration;
+    store->easing[slot] = (uint8_t)easing;
+    store->start[slot] = -1.0;  /* Set on first tick */
+    if (!store->active[slot]) {
+        store->active[slot] = 1;
+        store->active_count++;
+    }
+}
+
+/* Advance all running animations; returns true if any offset was updated,
+ * including the tick that lands an animation on its final value. Offsets are
+ * written back to the list nodes for cold readers. */
+bool layer_store_tick(layer_store_t *store, double current_time) {
+    if (!store || store->active_count == 0) return false;
+
+    bool moved = false;
+    for (int i = 0; i < store->count; i++) {
+        if (!store->active[i]) continue;
+        moved = true;
+
+        if (store->start[i] < 0) store->start[i] = current_time;
+        double elapsed = current_time - store->start[i];
+        float t;
+        if (elapsed <= 0.0) {
+            t = 0.0f;
+        } else if (elapsed >= store->duration[i]) {
+            t = 1.0f;
+            store->active[i] = 0;
+            store->active_count--;
+        } else {
+            /* Smooth completion: treat very close to 1.0 as complete */
+            float n = (float)(elapsed / store->duration[i]);
+            if (n > HYPRLAX_ANIM_COMPLETE_EPS) n = 1.0f;
+            t = apply_easing(n, (easing_type_t)store->easing[i]);
+        }
+
+        float x = (t == 1.0f) ? store->to_x[i] : store->from_x[i] + (store->to_x[i] - store->from_x[i]) * t;
+        float y = (t == 1.0f) ? store->to_y[i] : store->from_y[i] + (store->to_y[i] - store->from_y[i]) * t;
+        store->current_x[i] = x;
+        store->current_y[i] = y;
+
+        parallax_layer_t *layer = store->layers[i];
+        layer->current_x = x;
+        layer->current_y = y;
+        layer->offset_x = x;
+        layer->offset_y = y;
+    }
+    return moved;
+}
+
+/* Does any layer need frames (running animation or multi-frame GIF)? */
+bool layer_store_animating(const layer_store_t *store) {
+    return store && (store->active_count > 0 || store->animated_gif_count > 0);
+}
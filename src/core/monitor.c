@@ -67,11 +67,15 @@ monitor_instance_t* monitor_instance_create(const char *name) {
     monitor->parallax_offset_x = 0.0f;
     monitor->parallax_offset_y = 0.0f;
     monitor->target_frame_time = 1000.0 / 60.0;  /* Default 60 Hz */
+    frame_clock_init(&monitor->clock, monitor->refresh_rate);
+    monitor->render_dirty = true;
+    monitor->packets_stale = true;
 
     return monitor;
 }
 
-/* Destroy a monitor instance */
+/* Destroy a monitor instance; its renderer targets must already be released
+ * (hyprlax_render_release_output) */
 void monitor_instance_destroy(monitor_instance_t *monitor) {
     if (!monitor) return;
 
@@ -79,6 +83,9 @@ void monitor_instance_destroy(monitor_instance_t *monitor) {
     if (monitor->config) {
         free(monitor->config);
     }
+    free(monitor->packets);
+    free(monitor->draw_hashes);
+    free(monitor->draw_rects);
 
     free(monitor);
 }
@@ -250,59 +257,20 @@ void monitor_handle_workspace_change(hyprlax_context_t *ctx,
     monitor_handle_workspace_context_change(ctx, monitor, &new_context);
 }
 
-/* Handle workspace context change (flexible model) */
-void monitor_handle_workspace_context_change(hyprlax_context_t *ctx,
-                                            monitor_instance_t *monitor,
-                                            const workspace_context_t *new_context) {
-    if (!monitor || !new_context) return;
-
-    /* Check if context actually changed */
-    if (workspace_context_equal(&monitor->current_context, new_context)) {
-        if (ctx && ctx->config.debug) {
-            fprintf(stderr, "[DEBUG] monitor_handle_workspace_context_change: No change detected\n");
-        }
-        return;
-    }
-
-    /* If workspace input is disabled, do not drive parallax from workspace changes. */
-    if (ctx && ctx->input.weights[INPUT_WORKSPACE] <= 0.0f) {
-        monitor->previous_context = monitor->current_context;
-        monitor->current_context = *new_context;
-        if (ctx->config.debug) {
-            fprintf(stderr, "[DEBUG] monitor_handle_workspace_context_change: workspace input disabled; skipping parallax update\n");
-        }
-        return;
-    }
-
-    if (ctx && ctx->config.debug) {
-        fprintf(stderr, "[DEBUG] monitor_handle_workspace_context_change:\n");
-        fprintf(stderr, "[DEBUG]   Monitor: %s\n", monitor->name);
-        fprintf(stderr, "[DEBUG]   Model: %s\n", workspace_model_to_string(new_context->model));
-        if (new_context->model == WS_MODEL_PER_OUTPUT_NUMERIC) {
-            fprintf(stderr, "[DEBUG]   From workspace ID: %d\n", monitor->current_context.data.workspace_id);
-            fprintf(stderr, "[DEBUG]   To workspace ID: %d\n", new_context->data.workspace_id);
-        }
-    }
-
-    /* On first event, capture the origin context (the context BEFORE this change)
-       so the very first workspace event animates from the actual previous state. */
-    if (!monitor->origin_set) {
-        monitor->origin_context = monitor->current_context; /* old context */
-        monitor->origin_set = true;
-        if (ctx && ctx->config.debug) {
-            LOG_DEBUG("  Captured origin context for absolute positioning");
-        }
+/* Workspaces the compositor reports, for the auto shift (at least 2) */
+int monitor_workspace_count(const hyprlax_context_t *ctx) {
+    int workspace_count = HYPRLAND_DEFAULT_WORKSPACE_COUNT;
+    if (ctx && ctx->compositor && ctx->compositor->ops && ctx->compositor->ops->get_workspace_count) {
+        int wc = ctx->compositor->ops->get_workspace_count();
+        if (wc > 1 && wc < 1000) workspace_count = wc;
     }
+    if (workspace_count <= 1) workspace_count = 2;
+    return workspace_count;
+}
 
-    /* Check if this is a 2D workspace model */
-    bool is_2d = (new_context->model == WS_MODEL_SET_BASED ||
-                  new_context->model == WS_MODEL_PER_OUTPUT_NUMERIC);
-
-    workspace_offset_t offset_2d = {0.0f, 0.0f};
-    float offset_1d = 0.0f;
-
-    /* Calculate shift in pixels from unified helper */
-    config_t *config = monitor->config ? monitor->config : (ctx ? &ctx->config : NULL);
+/* Pixels one workspace step moves the parallax on this monitor */
+float monitor_workspace_shift_px(const hyprlax_context_t *ctx, const monitor_instance_t *monitor) {
+    const config_t *config = monitor->config ? monitor->config : (ctx ? &ctx->config : NULL);
     float shift_pixels = 0.0f;
     if (config) {
         if (config->shift_percent > 0.0f) {
@@ -342,12 +310,7 @@ void monitor_handle_workspace_context_change(hyprlax_context_t *ctx,
                 margin_px = (scale - 1.0f) * 0.5f * screen_w;
             }
 
-            int workspace_count = HYPRLAND_DEFAULT_WORKSPACE_COUNT;
-            if (ctx && ctx->compositor && ctx->compositor->ops && ctx->compositor->ops->get_workspace_count) {
-                int wc = ctx->compositor->ops->get_workspace_count();
-                if (wc > 1 && wc < 1000) workspace_count = wc;
-            }
-            if (workspace_count <= 1) workspace_count = 2;
+            int workspace_count = monitor_workspace_count(ctx);
 
             /* Leave comfortable headroom. Use (count) instead of (count-1) to be extra safe. */
             float fudge = 0.90f;
@@ -366,6 +329,62 @@ void monitor_handle_workspace_context_change(hyprlax_context_t *ctx,
         /* Fallback */
         shift_pixels = (HYPRLAX_DEFAULT_SHIFT_PERCENT / 100.0f) * monitor->width;
     }
+    return shift_pixels;
+}
+
+/* Handle workspace context change (flexible model) */
+void monitor_handle_workspace_context_change(hyprlax_context_t *ctx,
+                                            monitor_instance_t *monitor,
+                                            const workspace_context_t *new_context) {
+    if (!monitor || !new_context) return;
+
+    /* Check if context actually changed */
+    if (workspace_context_equal(&monitor->current_context, new_context)) {
+        if (ctx && ctx->config.debug) {
+            fprintf(stderr, "[DEBUG] monitor_handle_workspace_context_change: No change detected\n");
+        }
+        return;
+    }
+
+    /* If workspace input is disabled, do not drive parallax from workspace changes. */
+    if (ctx && ctx->input.weights[INPUT_WORKSPACE] <= 0.0f) {
+        monitor->previous_context = monitor->current_context;
+        monitor->current_context = *new_context;
+        if (ctx->config.debug) {
+            fprintf(stderr, "[DEBUG] monitor_handle_workspace_context_change: workspace input disabled; skipping parallax update\n");
+        }
+        return;
+    }
+
+    if (ctx && ctx->config.debug) {
+        fprintf(stderr, "[DEBUG] monitor_handle_workspace_context_change:\n");
+        fprintf(stderr, "[DEBUG]   Monitor: %s\n", monitor->name);
+        fprintf(stderr, "[DEBUG]   Model: %s\n", workspace_model_to_string(new_context->model));
+        if (new_context->model == WS_MODEL_PER_OUTPUT_NUMERIC) {
+            fprintf(stderr, "[DEBUG]   From workspace ID: %d\n", monitor->current_context.data.workspace_id);
+            fprintf(stderr, "[DEBUG]   To workspace ID: %d\n", new_context->data.workspace_id);
+        }
+    }
+
+    /* On first event, capture the origin context (the context BEFORE this change)
+       so the very first workspace event animates from the actual previous state. */
+    if (!monitor->origin_set) {
+        monitor->origin_context = monitor->current_context; /* old context */
+        monitor->origin_set = true;
+        if (ctx && ctx->config.debug) {
+            LOG_DEBUG("  Captured origin context for absolute positioning");
+        }
+    }
+
+    /* Check if this is a 2D workspace model */
+    bool is_2d = (new_context->model == WS_MODEL_SET_BASED ||
+                  new_context->model == WS_MODEL_PER_OUTPUT_NUMERIC);
+
+    workspace_offset_t offset_2d = {0.0f, 0.0f};
+    float offset_1d = 0.0f;
+
+    /* Calculate shift in pixels from unified helper */
+    float shift_pixels = monitor_workspace_shift_px(ctx, monitor);
 
     if (is_2d) {
         /* Absolute 2D offset from origin */
@@ -393,6 +412,14 @@ void monitor_handle_workspace_context_change(hyprlax_context_t *ctx,
         fprintf(stderr, "[DEBUG]   Offset: X=%.1f, Y=%.1f\n", offset_2d.x, offset_2d.y);
     }
 
+    /* Layer images cropped to the reachable region must cover this offset */
+    if (ctx && (fabsf(offset_2d.x) > ctx->workspace_reach_px[0] ||
+                fabsf(offset_2d.y) > ctx->workspace_reach_px[1])) {
+        ctx->workspace_reach_px[0] = fmaxf(ctx->workspace_reach_px[0], fabsf(offset_2d.x));
+        ctx->workspace_reach_px[1] = fmaxf(ctx->workspace_reach_px[1], fabsf(offset_2d.y));
+        ctx->texture_fit_dirty = true;
+    }
+
     /* Keep a copy of the old context for correct delta calculations */
     workspace_context_t old_context = monitor->current_context;
 
@@ -411,56 +438,31 @@ void monitor_handle_workspace_context_change(hyprlax_context_t *ctx,
                 LOG_DEBUG("  Updating layers with absolute target: X=%.1f, Y=%.1f", absolute_target_x, absolute_target_y);
             }
 
-            parallax_layer_t *layer = ctx->layers;
-            int layer_count = 0;
+            layer_store_t *store = &ctx->layer_store;
+            layer_store_refresh(store, ctx->layers);
+            double duration = monitor->config ? monitor->config->animation_duration : 1.0;
+            easing_type_t easing = monitor->config ? monitor->config->default_easing : EASE_CUBIC_OUT;
 
-            while (layer) {
-                parallax_layer_t *next_layer = layer->next; /* capture next to avoid surprises */
+            for (int i = 0; i < store->count; i++) {
                 /* Each layer moves at its own speed based on per-axis multipliers */
-                float mx = layer->shift_multiplier_x;
-                float my = layer->shift_multiplier_y;
-
-                float layer_target_x = absolute_target_x * mx;
+                float layer_target_x = absolute_target_x * store->shift_x[i];
 
                 /* Preserve legacy aspect ratio scaling if per-axis not customized */
                 float layer_target_y;
                 float debug_aspect = 1.0f;
-                if (layer->shift_multiplier_x == layer->shift_multiplier &&
-                    layer->shift_multiplier_y == layer->shift_multiplier) {
-                    if (layer->texture_width > 0 && layer->texture_height > 0) {
-                        debug_aspect = (float)layer->texture_height / (float)layer->texture_width;
-                    }
-                    layer_target_y = absolute_target_y * my * debug_aspect;
+                if (store->shift_x[i] == store->shift[i] && store->shift_y[i] == store->shift[i]) {
+                    debug_aspect = store->aspect[i];
+                    layer_target_y = absolute_target_y * store->shift_y[i] * debug_aspect;
                 } else {
-                    layer_target_y = absolute_target_y * my;
+                    layer_target_y = absolute_target_y * store->shift_y[i];
                 }
 
-                if (ctx && ctx->config.debug) {
+                if (ctx->config.debug) {
                     fprintf(stderr, "[DEBUG]     Layer %d: multiplier=%.2f, aspect=%.2f, target=(%.1f, %.1f)\n",
-                            layer_count++, layer->shift_multiplier, debug_aspect,
-                            layer_target_x, layer_target_y);
+                            i, store->shift[i], debug_aspect, layer_target_x, layer_target_y);
                 }
 
-                layer_update_offset(layer, layer_target_x, layer_target_y,
-                                  monitor->config ? monitor->config->animation_duration : 1.0,
-                                  monitor->config ? monitor->config->default_easing : EASE_CUBIC_OUT);
-                /* Defensive: if any callee scribbled over the linked-list pointer, restore it */
-                if (layer->next != next_layer) {
-                    if (ctx && ctx->config.debug) {
-                        fprintf(stderr, "[DEBUG]     WARNING: layer->next mutated (%p -> %p); restoring\n",
-                                (void*)layer->next, (void*)next_layer);
-                    }
-                    layer->next = next_layer;
-                }
-                if (ctx && ctx->config.debug) {
-                    fprintf(stderr, "[DEBUG]     Layer %d updated; next=%p\n", layer_count-1, (void*)next_layer);
-                }
-                if (next_layer == layer) {
-                    /* Prevent infinite loop on corrupted list */
-                    if (ctx && ctx->config.debug) fprintf(stderr, "[DEBUG]     Detected self-referential next; breaking.\n");
-                    break;
-                }
-                layer = next_layer;
+                layer_store_animate_to(store, i, layer_target_x, layer_target_y, duration, easing);
             }
         } else {
             if (ctx && ctx->config.debug) {
@@ -471,9 +473,13 @@ void monitor_handle_workspace_context_change(hyprlax_context_t *ctx,
         /* Layer animations handle the visual motion. Avoid monitor-level animation
          * to prevent double-driving and race conditions. */
         (void)absolute_target_x; (void)absolute_target_y;
+
+        /* Layer offsets are shared, so every output drawing them changes */
+        if (ctx->layers) monitor_list_mark_dirty(ctx->monitors);
     }
 
     /* Update context after computing offsets */
+    monitor_mark_dirty(monitor);
     monitor->previous_context = old_context;
     monitor->current_context = *new_context;
 }
@@ -576,6 +582,7 @@ void monitor_start_parallax_animation_to(hyprlax_context_t *ctx,
 void monitor_update_animation(monitor_instance_t *monitor, double current_time) {
     if (!monitor || !monitor->animating || !monitor->config) return;
 
+    monitor->render_dirty = true;
     double elapsed = current_time - monitor->animation_start_time;
     double duration = monitor->config->animation_duration;  /* seconds */
     if (duration <= 0.0) duration = 0.001; /* safety */
@@ -634,6 +641,27 @@ void monitor_frame_done(monitor_instance_t *monitor) {
     }
 }
 
+/* Request a render pass for one output */
+void monitor_mark_dirty(monitor_instance_t *monitor) {
+    if (monitor) monitor->render_dirty = true;
+}
+
+/* Request a render pass for every output */
+void monitor_list_mark_dirty(monitor_list_t *list) {
+    if (!list) return;
+    for (monitor_instance_t *m = list->head; m; m = m->next) {
+        m->render_dirty = true;
+    }
+}
+
+void monitor_list_mark_layers_changed(monitor_list_t *list) {
+    if (!list) return;
+    for (monitor_instance_t *m = list->head; m; m = m->next) {
+        m->render_dirty = true;
+        m->packets_stale = true;
+    }
+}
+
 /* Update monitor geometry */
 void monitor_update_geometry(monitor_instance_t *monitor,
                             int width, int height,
@@ -644,9 +672,12 @@ void monitor_update_geometry(monitor_instance_t *monitor,
     monitor->height = height;
     monitor->scale = scale;
     monitor->refresh_rate = refresh_rate;
+    monitor->render_dirty = true;
+    monitor->packets_stale = true;
 
     /* Update target frame time */
     monitor->target_frame_time = 1000.0 / refresh_rate;
+    frame_clock_set_refresh(&monitor->clock, refresh_rate);
 
     LOG_INFO("Monitor %s geometry: %dx%d@%dHz scale=%d",
              monitor->name, width, height, refresh_rate, scale);
@@ -10,14 +10,18 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "core.h"
+#include "../include/defaults.h"
+#include "../include/frame_clock.h"
 
 /* Forward declarations */
 struct wl_output;
 struct wl_surface;
 struct zwlr_layer_surface_v1;
 struct wl_callback;
+struct wp_presentation_feedback;
 typedef struct EGLSurface_* EGLSurface;
 typedef struct hyprlax_context hyprlax_context_t;
+struct render_packet;
 
 /* Include workspace models for flexible workspace tracking */
 #include "../compositor/workspace_models.h"
@@ -53,17 +57,61 @@ typedef struct monitor_instance {
 
     /* EGL surface (shares context with others) */
     EGLSurface egl_surface;
+    /* Surface owned by renderers that do not present through EGL */
+    void *render_surface;
 
     /* Frame scheduling */
     struct wl_callback *frame_callback;
     bool frame_pending;
     double last_frame_time;
     double target_frame_time;         /* Based on refresh rate */
+    frame_clock_t clock;              /* Presentation timing, see frame_clock.h */
+    double present_target;            /* Predicted present time of the frame being drawn */
+    struct wp_presentation_feedback *presentation_feedback; /* Outstanding feedback, if any */
+
+    /* Render scheduling: set by anything that changes this output's image */
+    bool render_dirty;
 
     /* Cached GL state per monitor */
     int viewport_width;
     int viewport_height;
 
+    /* Compiled layer draws (see render_core.c); recompiled when stale */
+    struct render_packet *packets;
+    int packet_count;
+    int packet_capacity;
+    bool packets_stale;
+
+    /* Threaded rendering (see render_thread.h): the snapshots that last
+     * dirtied / invalidated this output, written by the main thread, and the
+     * ones the render thread last drew / compiled it for */
+    uint64_t dirty_serial;
+    uint64_t stale_serial;
+    uint64_t drawn_serial;
+    uint64_t compiled_serial;
+
+    /* Idle composite cache: the bottom run of unchanged layers is flattened
+     * into one renderer target and blitted instead of redrawn. */
+    uint32_t composite_target;        /* Renderer target handle (0 = none) */
+    int composite_width;
+    int composite_height;
+    int composite_layers;             /* Number of draws flattened into target */
+    uint64_t composite_hash;          /* Hash of the flattened draws */
+    uint64_t *draw_hashes;            /* Per-draw hashes from the last frame */
+    int draw_hash_count;
+    int draw_hash_capacity;
+    uint64_t frame_hash;              /* Hash of the last presented frame */
+    bool frame_presented;
+
+    /* Damage tracking: rects are {x, y, w, h}, bottom-left origin */
+    int *draw_rects;                  /* Per-draw screen rects from the last frame */
+    int presented_width;              /* Surface pixel size of the last present */
+    int presented_height;
+    int damage_history[HYPRLAX_DAMAGE_HISTORY][4]; /* Newest first */
+    int damage_history_len;
+    int opaque_width;                 /* Logical size the opaque region was set for */
+    int opaque_height;
+
     /* Workspace tracking (flexible model support) */
     workspace_context_t current_context;  /* Current workspace/tag/set state */
     workspace_context_t previous_context; /* Previous state for comparison */
@@ -141,6 +189,10 @@ void monitor_update_animation(monitor_instance_t *monitor, double current_time);
 bool monitor_should_render(monitor_instance_t *monitor, double current_time);
 void monitor_mark_frame_pending(monitor_instance_t *monitor);
 void monitor_frame_done(monitor_instance_t *monitor);
+void monitor_mark_dirty(monitor_instance_t *monitor);
+void monitor_list_mark_dirty(monitor_list_t *list);
+/* Layers, their properties or textures changed: recompile draws everywhere */
+void monitor_list_mark_layers_changed(monitor_list_t *list);
 
 /* Utility functions */
 void monitor_update_geometry(monitor_instance_t *monitor,
@@ -153,5 +205,9 @@ bool monitor_is_active(monitor_instance_t *monitor);
 /* Compute effective shift in pixels given config and a monitor.
  * Falls back to defaults if values are unset. */
 float monitor_effective_shift_px(const config_t *cfg, const monitor_instance_t *monitor);
+/* Workspace step in pixels as workspace changes apply it, including the
+ * automatic shift derived from the base layer and workspace count */
+float monitor_workspace_shift_px(const hyprlax_context_t *ctx, const monitor_instance_t *monitor);
+int monitor_workspace_count(const hyprlax_context_t *ctx);
 
 #endif /* MONITOR_H */
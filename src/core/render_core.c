@@ -6,12 +6,19 @@
 #include <math.h>
 #include <time.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/epoll.h>
 #include <GLES2/gl2.h>
 #include <string.h>
 #include "../include/hyprlax.h"
 #include "../include/renderer.h"
 #include "../core/monitor.h"
 #include "../include/log.h"
+#include "../include/render_thread.h"
+#include "../include/decode_pool.h"
+#include "../include/texture_cache.h"
+#include "../include/texture_registry.h"
 #include "../vendor/gifdec.h"
 
 static double rc_get_time(void) {
@@ -20,224 +27,1490 @@ static double rc_get_time(void) {
     return ts.tv_sec + ts.tv_nsec / 1000000000.0;
 }
 
-static inline int rc_is_pow2(int v) { return v > 0 && (v & (v - 1)) == 0; }
-
 /* texture loader (definition moved from hyprlax_main.c) */
 #include "../stb_image.h"
-GLuint load_texture(const char *path, int *width, int *height) {
-    int channels;
-    unsigned char *data = stbi_load(path, width, height, &channels, 4);
+
+/* Decode an image as RGBA8 (released with free) */
+static unsigned char *rc_decode_image(const char *path, int *width, int *height, int *channels) {
+    unsigned char *data = stbi_load(path, width, height, channels, 4);
     if (!data) {
         LOG_ERROR("Failed to load image '%s': %s", path, stbi_failure_reason());
-        return 0;
     }
+    return data;
+}
 
-    GLuint texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, *width, *height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-
-    if (rc_is_pow2(*width) && rc_is_pow2(*height)) {
-        glGenerateMipmap(GL_TEXTURE_2D);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+static void rc_measure_alpha(const unsigned char *data, int width, int height, int channels,
+                             bool *opaque, int bbox[4]) {
+    /* Images decoded without an alpha channel are opaque by construction */
+    if (channels == 1 || channels == 3) {
+        *opaque = true;
+        bbox[0] = 0; bbox[1] = 0;
+        bbox[2] = width; bbox[3] = height;
     } else {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        layer_analyze_alpha(data, width, height, opaque, bbox);
     }
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
 
+GLuint load_texture_ex(const char *path, int *width, int *height, parallax_layer_t *layer) {
+    int channels;
+    unsigned char *data = rc_decode_image(path, width, height, &channels);
+    if (!data) return 0;
+    if (layer) rc_measure_alpha(data, *width, *height, channels, &layer->opaque, layer->alpha_bbox);
+    uint32_t texture = renderer_upload_texture(data, *width, *height);
     stbi_image_free(data);
     return texture;
 }
 
-static void hyprlax_render_monitor(hyprlax_context_t *ctx, monitor_instance_t *monitor, double now_time) {
-    if (!ctx || !ctx->renderer || !monitor) {
-        LOG_TRACE("Skipping render: ctx=%p, renderer=%p, monitor=%p", ctx, ctx ? ctx->renderer : NULL, monitor);
-        return;
+GLuint load_texture(const char *path, int *width, int *height) {
+    return load_texture_ex(path, width, height, NULL);
+}
+
+void unload_texture(unsigned int texture) {
+    renderer_delete_texture(texture);
+}
+
+/* The pending image is on the GPU: it becomes the layer's texture */
+static void rc_apply_pending(hyprlax_context_t *ctx, parallax_layer_t *layer) {
+    layer_pending_texture_t *next = &layer->pending;
+    if (layer->texture_id) texture_registry_release(ctx->textures, layer->texture_id);
+    layer->texture_id = next->texture;
+    layer->width = next->source_width;
+    layer->height = next->source_height;
+    layer->texture_width = next->width;
+    layer->texture_height = next->height;
+    memcpy(layer->crop, next->crop, sizeof(layer->crop));
+    if (layer->tiles) virtual_texture_destroy(layer->tiles);
+    layer->tiles = next->tiles;
+    layer->tile_ids = virtual_texture_ids(layer->tiles);
+    if (layer->tiles) layer->tile_grid = *virtual_texture_grid(layer->tiles);
+    else memset(&layer->tile_grid, 0, sizeof(layer->tile_grid));
+    layer->opaque = next->opaque;
+    memcpy(layer->alpha_bbox, next->alpha_bbox, sizeof(layer->alpha_bbox));
+    memset(next, 0, sizeof(*next));
+}
+
+static void rc_layer_params(const hyprlax_context_t *ctx, const monitor_instance_t *monitor,
+                            const parallax_layer_t *layer, renderer_layer_params_t *p);
+
+/* What of a decoded image to upload */
+typedef struct {
+    int rect[4];            /* Image pixels {x, y, w, h} */
+    float crop[4];          /* ...as a UV window {u0, v0, u1, v1} */
+    float scale;            /* Texels per image pixel (1 = full resolution) */
+} rc_image_fit_t;
+
+/* Largest parallax offset in output pixels, per axis, a layer can be drawn
+ * with on a monitor: workspace steps over the workspace count (or the
+ * largest workspace offset applied so far), cursor offsets up to
+ * parallax.max_offset_px and window offsets up to half the output */
+static void rc_layer_reach(const hyprlax_context_t *ctx, const monitor_instance_t *monitor,
+                           const parallax_layer_t *layer, float aspect, float reach[2]) {
+    float steps = (float)(monitor_workspace_count(ctx) - 1) * monitor_workspace_shift_px(ctx, monitor);
+    bool is_2d = monitor->current_context.model == WS_MODEL_SET_BASED ||
+                 monitor->current_context.model == WS_MODEL_PER_OUTPUT_NUMERIC;
+    float workspace_x = fmaxf(steps, ctx->workspace_reach_px[0]);
+    float workspace_y = fmaxf(is_2d ? steps : 0.0f, ctx->workspace_reach_px[1]);
+    /* Without per-axis multipliers the workspace y offset follows the image aspect */
+    float workspace_mul_y = fabsf(layer->shift_multiplier_y);
+    if (layer->shift_multiplier_x == layer->shift_multiplier &&
+        layer->shift_multiplier_y == layer->shift_multiplier) {
+        workspace_mul_y *= aspect;
     }
-    if (!monitor->egl_surface) {
-        LOG_WARN("Monitor %s has no EGL surface", monitor->name);
-        return;
+    const float *w = ctx->input.weights;
+    reach[0] = workspace_x * fabsf(layer->shift_multiplier_x) * fabsf(w[INPUT_WORKSPACE]) +
+               (ctx->config.parallax_max_offset_x * fabsf(w[INPUT_CURSOR]) +
+                0.5f * (float)monitor->width * fabsf(ctx->config.window_sensitivity_x) * fabsf(w[INPUT_WINDOW])) *
+               fabsf(layer->shift_multiplier_x);
+    reach[1] = workspace_y * workspace_mul_y * fabsf(w[INPUT_WORKSPACE]) +
+               (ctx->config.parallax_max_offset_y * fabsf(w[INPUT_CURSOR]) +
+                0.5f * (float)monitor->height * fabsf(ctx->config.window_sensitivity_y) * fabsf(w[INPUT_WINDOW])) *
+               fabsf(layer->shift_multiplier_y);
+}
+
+/* Decide what of a width x height image to upload, from the geometry the
+ * layer's draws compile to on every output (fit mode, content scale,
+ * margins, shift safe area):
+ * - crop: on axes with overflow none and no tiling, the UV window those
+ *   draws can reach with the largest parallax offsets the layer can get,
+ *   plus the blur's reach and a safety margin
+ * - scale: the texel density at which every output samples at most 1:1
+ * Returns false if the whole image is needed, or no output size is known */
+static bool rc_fit_image(hyprlax_context_t *ctx, const parallax_layer_t *layer,
+                         int width, int height, rc_image_fit_t *fit) {
+    *fit = (rc_image_fit_t){ .rect = { 0, 0, width, height }, .crop = { 0.0f, 0.0f, 1.0f, 1.0f },
+                             .scale = 1.0f };
+    const render_options_t *opts = &ctx->config.render_options;
+    /* Offsets reach cropped textures through u_offset only */
+    bool crop_u = opts->image_crop && opts->uniform_offset;
+    bool crop_v = crop_u;
+    if ((!opts->image_downscale && !crop_u) || !ctx->monitors || !ctx->monitors->head) return false;
+
+    const texture_t tex = { .width = width, .height = height, .format = TEXTURE_FORMAT_RGBA };
+    float aspect = (float)height / (float)width;
+    float scale = 0.0f;
+    float reach[4] = { 1.0f, 1.0f, 0.0f, 0.0f };
+    float pad[2] = { 0.0f, 0.0f };
+    for (monitor_instance_t *monitor = ctx->monitors->head; monitor; monitor = monitor->next) {
+        int px_w = monitor->width * monitor->scale;
+        int px_h = monitor->height * monitor->scale;
+        if (px_w <= 0 || px_h <= 0) return false;
+        renderer_layer_params_t params;
+        renderer_draw_packet_t packet;
+        rc_layer_params(ctx, monitor, layer, &params);
+        memset(params.crop, 0, sizeof(params.crop));
+        renderer_compile_layer_geometry(px_w, px_h, &tex, 1.0f, 0.0f, &params, &packet);
+        const float *v = packet.vertices;
+        float u0 = fminf(v[2], v[6]), u1 = fmaxf(v[2], v[6]);
+        float v0 = fminf(v[3], v[11]), v1 = fmaxf(v[3], v[11]);
+        float quad_w = (packet.bounds[2] - packet.bounds[0]) * 0.5f * (float)px_w;
+        float quad_h = (packet.bounds[3] - packet.bounds[1]) * 0.5f * (float)px_h;
+        if (u1 <= u0 || v1 <= v0 || quad_w <= 0.0f || quad_h <= 0.0f) {
+            /* Degenerate window (e.g. a safe area wider than the image) */
+            crop_u = crop_v = false;
+            continue;
+        }
+        /* Quad size on screen over the image window it shows */
+        scale = fmaxf(scale, fmaxf(quad_w / ((u1 - u0) * (float)width),
+                                   quad_h / ((v1 - v0) * (float)height)));
+
+        float offset[2];
+        rc_layer_reach(ctx, monitor, layer, aspect, offset);
+        float du = offset[0] / (float)monitor->width * packet.offset_scale[0];
+        float dv = offset[1] / (float)monitor->height * packet.offset_scale[1];
+        reach[0] = fminf(reach[0], u0 - du);
+        reach[1] = fminf(reach[1], v0 - dv);
+        reach[2] = fmaxf(reach[2], u1 + du);
+        reach[3] = fmaxf(reach[3], v1 + dv);
+        /* Blur taps and filtering read past the window */
+        float blur_px = layer->blur_amount * HYPRLAX_BLUR_KERNEL_SIZE + 2.0f;
+        pad[0] = fmaxf(pad[0], blur_px * (u1 - u0) / quad_w);
+        pad[1] = fmaxf(pad[1], blur_px * (v1 - v0) / quad_h);
+        crop_u = crop_u && params.overflow_mode == 4 && !params.tile_x;
+        crop_v = crop_v && params.overflow_mode == 4 && !params.tile_y;
     }
-    if (gles2_make_current(monitor->egl_surface) != HYPRLAX_SUCCESS) {
-        LOG_ERROR("Failed to make EGL surface current for monitor %s", monitor->name);
-        return;
+
+    bool reduced = false;
+    if ((crop_u || crop_v) && reach[2] > reach[0] && reach[3] > reach[1]) {
+        int x0 = 0, y0 = 0, x1 = width, y1 = height;
+        if (crop_u) {
+            x0 = (int)floorf((reach[0] - pad[0] - HYPRLAX_CROP_MARGIN) * (float)width);
+            x1 = (int)ceilf((reach[2] + pad[0] + HYPRLAX_CROP_MARGIN) * (float)width);
+        }
+        if (crop_v) {
+            y0 = (int)floorf((reach[1] - pad[1] - HYPRLAX_CROP_MARGIN) * (float)height);
+            y1 = (int)ceilf((reach[3] + pad[1] + HYPRLAX_CROP_MARGIN) * (float)height);
+        }
+        if (x0 < 0) x0 = 0;
+        if (y0 < 0) y0 = 0;
+        if (x1 > width) x1 = width;
+        if (y1 > height) y1 = height;
+        if ((float)(x1 - x0) * (float)(y1 - y0) <=
+            (1.0f - HYPRLAX_CROP_MIN_SAVING) * (float)width * (float)height) {
+            fit->rect[0] = x0; fit->rect[1] = y0;
+            fit->rect[2] = x1 - x0; fit->rect[3] = y1 - y0;
+            fit->crop[0] = (float)x0 / (float)width;
+            fit->crop[1] = (float)y0 / (float)height;
+            fit->crop[2] = (float)x1 / (float)width;
+            fit->crop[3] = (float)y1 / (float)height;
+            reduced = true;
+        }
     }
-    glViewport(0, 0, monitor->width * monitor->scale, monitor->height * monitor->scale);
+    if (opts->image_downscale && scale > 0.0f && scale * scale <= 1.0f - HYPRLAX_DOWNSCALE_MIN_SAVING) {
+        fit->scale = scale;
+        reduced = true;
+    }
+    return reduced;
+}
 
-    static int s_profile = -1;
-    if (s_profile == -1) {
-        const char *p = getenv("HYPRLAX_PROFILE");
-        s_profile = (p && *p) ? 1 : 0;
+/* Crop and resample decoded pixels as fit says; returns the buffer to
+ * upload (data itself, or a new one with data released) and its size */
+static unsigned char *rc_apply_fit(unsigned char *data, int width, const rc_image_fit_t *fit,
+                                   int *out_width, int *out_height) {
+    const int *r = fit->rect;
+    if (r[0] != 0 || r[1] != 0 || r[2] != width) {
+        /* In place: every row moves towards the start of the buffer */
+        for (int y = 0; y < r[3]; y++) {
+            memmove(data + (size_t)y * (size_t)r[2] * 4,
+                    data + ((size_t)(r[1] + y) * (size_t)width + (size_t)r[0]) * 4,
+                    (size_t)r[2] * 4);
+        }
     }
-    double t_draw_start = 0.0, t_present_start = 0.0;
-    if (s_profile) t_draw_start = rc_get_time();
+    *out_width = r[2];
+    *out_height = r[3];
+    if (fit->scale < 1.0f) {
+        int w = (int)ceilf((float)r[2] * fit->scale);
+        int h = (int)ceilf((float)r[3] * fit->scale);
+        unsigned char *scaled = image_resample_rgba(data, r[2], r[3], w > 0 ? w : 1, h > 0 ? h : 1);
+        if (scaled) {
+            stbi_image_free(data);
+            data = scaled;
+            *out_width = w > 0 ? w : 1;
+            *out_height = h > 0 ? h : 1;
+        } else {
+            LOG_WARN("Could not downscale a %dx%d image, uploading it at full size", r[2], r[3]);
+        }
+    }
+    return data;
+}
 
-    RENDERER_BEGIN_FRAME(ctx->renderer);
-    /* Frame prep: either clear (default) or fade previous frame for trails */
-    if (ctx->config.render_accumulate) {
-        float a = ctx->config.render_trail_strength;
-        if (a > 0.0f && ctx->renderer && ctx->renderer->ops && ctx->renderer->ops->fade_frame) {
-            ctx->renderer->ops->fade_frame(0.0f, 0.0f, 0.0f, a);
+/* Tiles are drawn masked to their own part of the image, so a tiled layer
+ * shows nothing past the image edges: repeating layers keep one texture.
+ * Offsets reach tiles through u_offset only, as with cropping. */
+static bool rc_can_tile(const hyprlax_context_t *ctx, const parallax_layer_t *layer) {
+    const renderer_ops_t *ops = ctx->renderer ? ctx->renderer->ops : NULL;
+    if (!ops || !ops->compile_layer || !ops->draw_packet) return false;
+    if (!ctx->config.render_options.uniform_offset) return false;
+    int over = layer->overflow_mode >= 0 ? layer->overflow_mode : ctx->config.render_overflow_mode;
+    int tile_x = layer->tile_x >= 0 ? layer->tile_x : ctx->config.render_tile_x;
+    int tile_y = layer->tile_y >= 0 ? layer->tile_y : ctx->config.render_tile_y;
+    return (over == 0 || over == 4) && !tile_x && !tile_y;
+}
+
+/* width x height scaled to fit limit on its longer side */
+static void rc_fallback_size(int width, int height, int limit, int *out_width, int *out_height) {
+    float scale = (float)limit / (float)(width > height ? width : height);
+    if (scale > 1.0f) scale = 1.0f;
+    *out_width = (int)((float)width * scale + 0.5f);
+    *out_height = (int)((float)height * scale + 0.5f);
+    if (*out_width < 1) *out_width = 1;
+    if (*out_height < 1) *out_height = 1;
+    if (*out_width > limit) *out_width = limit;
+    if (*out_height > limit) *out_height = limit;
+}
+
+/* One image load. The main thread decides everything that reads the
+ * config, outputs or renderer from the image header; a decode worker (or
+ * the main thread, without one) does the pixel work; the main thread then
+ * queues the upload. */
+typedef struct {
+    uint32_t layer_id;
+    char *path;
+    int source_width;           /* From the header */
+    int source_height;
+    bool fitted;                /* Apply fit */
+    rc_image_fit_t fit;
+    int max_size;               /* GPU texture limit (0 = unknown) */
+    uint64_t budget;            /* render.tile_budget in bytes */
+    bool can_tile;
+    uint64_t cache_budget;      /* render.image_cache in bytes (0 = no cache) */
+    uint64_t share_key;         /* Texture registry key (0 = do not share) */
+    /* Worker results */
+    int status;
+    layer_pending_texture_t next;
+    unsigned char *data;        /* Pixels to upload */
+    texture_cache_entry_t *cached; /* ...when they are a cache entry's mapping */
+    int upload_width;
+    int upload_height;
+} rc_decode_job_t;
+
+/* What of the decoded pixels a cache entry holds; part of its key */
+typedef struct {
+    int32_t fitted;
+    int32_t rect[4];
+    float scale;
+} rc_cache_variant_t;
+
+/* ...and what decides the texture made from them: the registry's key */
+typedef struct {
+    rc_cache_variant_t image;
+    int32_t max_size;
+    int32_t can_tile;
+    uint64_t budget;
+} rc_share_variant_t;
+
+static void rc_cache_variant(const rc_decode_job_t *job, rc_cache_variant_t *variant) {
+    memset(variant, 0, sizeof(*variant));
+    variant->fitted = job->fitted;
+    variant->scale = 1.0f;
+    if (job->fitted) {
+        memcpy(variant->rect, job->fit.rect, sizeof(variant->rect));
+        variant->scale = job->fit.scale;
+    }
+}
+
+static void rc_decode_job_free(void *arg) {
+    rc_decode_job_t *job = arg;
+    if (!job) return;
+    if (job->cached) texture_cache_close(job->cached);
+    else free(job->data);
+    virtual_texture_destroy(job->next.tiles);
+    free(job->path);
+    free(job);
+}
+
+/* The image as a cache entry last stored it, mapped; NULL on a miss */
+static unsigned char *rc_decode_cached(rc_decode_job_t *job, uint64_t key) {
+    texture_cache_info_t info;
+    texture_cache_entry_t *entry = texture_cache_open(key, &info);
+    if (!entry) return NULL;
+    layer_pending_texture_t *next = &job->next;
+    next->source_width = info.source_width;
+    next->source_height = info.source_height;
+    next->width = info.width;
+    next->height = info.height;
+    memcpy(next->crop, info.crop, sizeof(next->crop));
+    next->opaque = info.opaque;
+    memcpy(next->alpha_bbox, info.alpha_bbox, sizeof(next->alpha_bbox));
+    job->cached = entry;
+    LOG_DEBUG("Layer %u: %s %dx%d from the image cache", job->layer_id, job->path, info.width, info.height);
+    return (unsigned char *)texture_cache_pixels(entry);
+}
+
+/* Decode, crop and downscale, and measure alpha; the result goes to the
+ * cache under key (0 = none) */
+static unsigned char *rc_decode_fresh(rc_decode_job_t *job, uint64_t key) {
+    layer_pending_texture_t *next = &job->next;
+    int channels;
+    unsigned char *data = rc_decode_image(job->path, &next->source_width, &next->source_height, &channels);
+    if (!data) return NULL;
+    next->width = next->source_width;
+    next->height = next->source_height;
+
+    /* Texels no output can show cost VRAM and upload time, and alias */
+    bool as_planned = !job->fitted;
+    if (job->fitted && next->source_width == job->source_width && next->source_height == job->source_height) {
+        as_planned = true;
+        const rc_image_fit_t *fit = &job->fit;
+        data = rc_apply_fit(data, next->source_width, fit, &next->width, &next->height);
+        if (fit->rect[2] != next->source_width || fit->rect[3] != next->source_height) {
+            memcpy(next->crop, fit->crop, sizeof(next->crop));
         }
+        LOG_DEBUG("Layer %u: %s %dx%d uploaded as %dx%d (crop %d,%d %dx%d)", job->layer_id, job->path,
+                  next->source_width, next->source_height, next->width, next->height,
+                  fit->rect[0], fit->rect[1], fit->rect[2], fit->rect[3]);
+    }
+    rc_measure_alpha(data, next->width, next->height, channels, &next->opaque, next->alpha_bbox);
+
+    /* A file that changed since its header was read is not what key names */
+    if (key && as_planned) {
+        texture_cache_info_t info = {
+            .width = next->width, .height = next->height,
+            .source_width = next->source_width, .source_height = next->source_height,
+            .opaque = next->opaque,
+        };
+        memcpy(info.crop, next->crop, sizeof(info.crop));
+        memcpy(info.alpha_bbox, next->alpha_bbox, sizeof(info.alpha_bbox));
+        if (texture_cache_store(key, &info, data) == HYPRLAX_SUCCESS) texture_cache_trim(job->cache_budget);
+    }
+    return data;
+}
+
+/* Worker side: decode (or map the cached result), and split into tiles or
+ * fit the GPU limit. Touches neither the context nor GL. */
+static void rc_decode_run(void *arg) {
+    rc_decode_job_t *job = arg;
+    layer_pending_texture_t *next = &job->next;
+    uint64_t key = 0;
+    unsigned char *data = NULL;
+    if (job->cache_budget) {
+        rc_cache_variant_t variant;
+        rc_cache_variant(job, &variant);
+        key = texture_cache_key(job->path, &variant, sizeof(variant));
+        if (key) data = rc_decode_cached(job, key);
+    }
+    if (!data) data = rc_decode_fresh(job, key);
+    if (!data) { job->status = HYPRLAX_ERROR_LOAD_FAILED; return; }
+
+    int max_size = job->max_size;
+    bool over_limit = max_size > 0 && (next->width > max_size || next->height > max_size);
+    bool over_budget = job->budget > 0 && (uint64_t)next->width * (uint64_t)next->height * 4u > job->budget;
+    job->upload_width = next->width;
+    job->upload_height = next->height;
+    bool tiled = (over_limit || over_budget) && job->can_tile;
+    if (job->cached && (tiled || over_limit)) {
+        /* Tiles keep, and resampling releases, a heap copy */
+        size_t bytes = (size_t)next->width * (size_t)next->height * 4u;
+        unsigned char *copy = malloc(bytes);
+        if (copy) memcpy(copy, data, bytes);
+        texture_cache_close(job->cached);
+        job->cached = NULL;
+        data = copy;
+        if (!data) { job->status = HYPRLAX_ERROR_NO_MEMORY; return; }
+    }
+    if (tiled) {
+        /* Streamed as tiles, with a small copy of the whole to draw
+         * until the tiles in view are resident */
+        int tile_size = max_size > 0 && max_size < HYPRLAX_TILE_SIZE ? max_size : HYPRLAX_TILE_SIZE;
+        rc_fallback_size(next->width, next->height, tile_size, &job->upload_width, &job->upload_height);
+        tile_size -= 2 * HYPRLAX_TILE_GUTTER;
+        unsigned char *fallback = image_resample_rgba(data, next->width, next->height,
+                                                      job->upload_width, job->upload_height);
+        next->tiles = fallback ? virtual_texture_create(data, next->width, next->height, tile_size) : NULL;
+        if (!next->tiles) {
+            free(fallback);
+            stbi_image_free(data);
+            job->status = HYPRLAX_ERROR_NO_MEMORY;
+            return;
+        }
+        data = fallback;
+        LOG_INFO("Layer %u: %s streamed as %dx%d tiles of %d px", job->layer_id, job->path,
+                 virtual_texture_grid(next->tiles)->cols, virtual_texture_grid(next->tiles)->rows, tile_size);
+    } else if (over_limit) {
+        rc_fallback_size(next->width, next->height, max_size, &job->upload_width, &job->upload_height);
+        unsigned char *scaled = image_resample_rgba(data, next->width, next->height,
+                                                    job->upload_width, job->upload_height);
+        stbi_image_free(data);
+        if (!scaled) { job->status = HYPRLAX_ERROR_NO_MEMORY; return; }
+        data = scaled;
+        LOG_WARN("Layer %u: %s is %dx%d, over the GPU's %d px texture limit; uploaded at %dx%d",
+                 job->layer_id, job->path, next->width, next->height, max_size,
+                 job->upload_width, job->upload_height);
+        next->width = job->upload_width;
+        next->height = job->upload_height;
+    }
+    job->data = data;
+    job->status = HYPRLAX_SUCCESS;
+}
+
+/* next becomes the layer's pending image, superseding one still uploading */
+static void rc_set_pending(hyprlax_context_t *ctx, parallax_layer_t *layer, const layer_pending_texture_t *next) {
+    if (layer->pending.texture) texture_registry_release(ctx->textures, layer->pending.texture);
+    virtual_texture_destroy(layer->pending.tiles);
+    layer->pending = *next;
+    if (renderer_texture_ready(next->texture)) {
+        rc_apply_pending(ctx, layer);
     } else {
-        if (ctx->renderer && ctx->renderer->ops && ctx->renderer->ops->clear) {
-            ctx->renderer->ops->clear(0.0f, 0.0f, 0.0f, 1.0f);
+        ctx->texture_uploads = true;
+    }
+}
+
+/* A new reference to the texture registered under key, as a pending
+ * image; false if there is none */
+static bool rc_shared_texture(hyprlax_context_t *ctx, uint64_t key, layer_pending_texture_t *next) {
+    texture_cache_info_t info;
+    uint32_t texture;
+    if (!texture_registry_acquire(ctx->textures, key, &texture, &info)) return false;
+    *next = (layer_pending_texture_t){
+        .texture = texture, .width = info.width, .height = info.height,
+        .source_width = info.source_width, .source_height = info.source_height, .opaque = info.opaque,
+    };
+    memcpy(next->crop, info.crop, sizeof(next->crop));
+    memcpy(next->alpha_bbox, info.alpha_bbox, sizeof(next->alpha_bbox));
+    return true;
+}
+
+static void rc_share_texture(hyprlax_context_t *ctx, uint64_t key, const layer_pending_texture_t *next) {
+    if (!ctx->textures && !(ctx->textures = texture_registry_create())) return;
+    texture_cache_info_t info = {
+        .width = next->width, .height = next->height,
+        .source_width = next->source_width, .source_height = next->source_height, .opaque = next->opaque,
+    };
+    memcpy(info.crop, next->crop, sizeof(info.crop));
+    memcpy(info.alpha_bbox, next->alpha_bbox, sizeof(info.alpha_bbox));
+    /* Unregistered, the texture is simply the layer's own */
+    texture_registry_add(ctx->textures, key, next->texture, &info);
+}
+
+/* Main-thread side: queue the decoded image's upload as the layer's next */
+static int rc_install_decoded(hyprlax_context_t *ctx, parallax_layer_t *layer, rc_decode_job_t *job) {
+    if (job->status != HYPRLAX_SUCCESS) return job->status;
+    layer_pending_texture_t next = job->next;
+
+    /* Tiles stream per layer; anything else may have been uploaded for
+     * another layer while this one decoded */
+    bool share = job->share_key && !next.tiles;
+    if (share && rc_shared_texture(ctx, job->share_key, &next)) {
+        rc_set_pending(ctx, layer, &next);
+        return HYPRLAX_SUCCESS;
+    }
+
+    /* The renderer frees the pixels (or unmaps the cache entry) once they
+     * are uploaded */
+    if (job->cached) {
+        next.texture = renderer_queue_texture_with(job->data, job->upload_width, job->upload_height,
+                                                   texture_cache_close, job->cached);
+    } else {
+        next.texture = renderer_queue_texture(job->data, job->upload_width, job->upload_height);
+    }
+    job->data = NULL;
+    job->cached = NULL;
+    if (!next.texture) return HYPRLAX_ERROR_GL_INIT;
+    job->next.tiles = NULL;
+    if (share) rc_share_texture(ctx, job->share_key, &next);
+    rc_set_pending(ctx, layer, &next);
+    return HYPRLAX_SUCCESS;
+}
+
+/* The pool at render.decode_threads workers (capped at the CPU count);
+ * NULL to decode on the calling thread. It is resized once idle. */
+static decode_pool_t *rc_decode_pool(hyprlax_context_t *ctx) {
+    int threads = ctx->config.render_options.decode_threads;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 0 && threads > cpus) threads = (int)cpus;
+    decode_pool_t *pool = ctx->decode_pool;
+    if (pool && decode_pool_threads(pool) != threads && decode_pool_pending(pool) == 0) {
+        hyprlax_stop_texture_decodes(ctx);
+        pool = NULL;
+    }
+    if (threads <= 0) return NULL;
+    if (!pool) {
+        pool = decode_pool_create(threads);
+        if (!pool) {
+            LOG_WARN("Could not start image decode threads; decoding on the main thread");
+            return NULL;
         }
+        ctx->decode_pool = pool;
+        if (ctx->epoll_fd >= 0) epoll_add_fd(ctx->epoll_fd, decode_pool_event_fd(pool), EPOLLIN);
     }
+    return pool;
+}
 
-    input_manager_tick(&ctx->input, monitor, now_time, NULL, NULL);
+int hyprlax_queue_layer_texture(hyprlax_context_t *ctx, parallax_layer_t *layer, const char *path) {
+    if (!ctx || !layer || !path) return HYPRLAX_ERROR_INVALID_ARGS;
+    int width, height, channels;
+    if (!stbi_info(path, &width, &height, &channels)) {
+        LOG_ERROR("Failed to load image '%s': %s", path, stbi_failure_reason());
+        return HYPRLAX_ERROR_LOAD_FAILED;
+    }
 
-    parallax_layer_t *layer = ctx->layers;
-    while (layer) {
-        if (layer->hidden) { layer = layer->next; continue; }
+    rc_decode_job_t *job = calloc(1, sizeof(*job));
+    if (!job || !(job->path = strdup(path))) {
+        free(job);
+        return HYPRLAX_ERROR_NO_MEMORY;
+    }
+    job->layer_id = layer->id;
+    job->source_width = width;
+    job->source_height = height;
+    job->fitted = rc_fit_image(ctx, layer, width, height, &job->fit);
+    job->max_size = renderer_max_texture_size();
+    job->budget = (uint64_t)ctx->config.render_options.tile_budget << 20;
+    job->can_tile = rc_can_tile(ctx, layer);
+    job->cache_budget = (uint64_t)ctx->config.render_options.image_cache << 20;
+    rc_share_variant_t share = {
+        .max_size = job->max_size, .can_tile = job->can_tile, .budget = job->budget,
+    };
+    rc_cache_variant(job, &share.image);
+    job->share_key = texture_cache_key(path, &share, sizeof(share));
+
+    /* A newer image supersedes one still decoding */
+    if (layer->decode_ticket) {
+        decode_pool_cancel(ctx->decode_pool, layer->decode_ticket);
+        layer->decode_ticket = 0;
+    }
 
-        if (layer->is_gif) {
-            if (now_time - layer->last_frame_time > layer->gif_delays[layer->current_frame] / 1000.0) {
-                layer->current_frame = (layer->current_frame + 1) % layer->frame_count;
-                layer->texture_id = layer->gif_textures[layer->current_frame];
-                layer->last_frame_time = now_time;
+    /* Another layer (or the config before a reload) already shows it */
+    layer_pending_texture_t next;
+    if (job->share_key && rc_shared_texture(ctx, job->share_key, &next)) {
+        LOG_DEBUG("Layer %u: %s shares texture %u", layer->id, path, next.texture);
+        rc_decode_job_free(job);
+        rc_set_pending(ctx, layer, &next);
+        return HYPRLAX_SUCCESS;
+    }
+
+    decode_pool_t *pool = rc_decode_pool(ctx);
+    if (pool) {
+        layer->decode_ticket = decode_pool_submit(pool, rc_decode_run, rc_decode_job_free, job);
+        if (layer->decode_ticket) return HYPRLAX_SUCCESS;
+    }
+    rc_decode_run(job);
+    int ret = rc_install_decoded(ctx, layer, job);
+    rc_decode_job_free(job);
+    return ret;
+}
+
+/* Queue the uploads of finished decodes; true if any layer changed */
+static bool rc_collect_decodes(hyprlax_context_t *ctx) {
+    bool changed = false;
+    uint32_t ticket;
+    rc_decode_job_t *job;
+    while ((job = decode_pool_take(ctx->decode_pool, &ticket))) {
+        parallax_layer_t *layer = ctx->layers;
+        while (layer && layer->id != job->layer_id) layer = layer->next;
+        if (layer && layer->decode_ticket == ticket) {
+            layer->decode_ticket = 0;
+            if (rc_install_decoded(ctx, layer, job) == HYPRLAX_SUCCESS) {
+                changed = true;
+            } else {
+                LOG_ERROR("Failed to load texture for layer %u: %s", layer->id, job->path);
             }
         }
+        rc_decode_job_free(job);
+    }
+    return changed;
+}
+
+void hyprlax_finish_texture_decodes(hyprlax_context_t *ctx) {
+    if (!ctx || !ctx->decode_pool) return;
+    decode_pool_wait(ctx->decode_pool);
+    if (rc_collect_decodes(ctx)) hyprlax_mark_layers_changed(ctx);
+}
+
+void hyprlax_stop_texture_decodes(hyprlax_context_t *ctx) {
+    if (!ctx || !ctx->decode_pool) return;
+    if (ctx->epoll_fd >= 0) epoll_del_fd(ctx->epoll_fd, decode_pool_event_fd(ctx->decode_pool));
+    decode_pool_destroy(ctx->decode_pool);
+    ctx->decode_pool = NULL;
+    for (parallax_layer_t *layer = ctx->layers; layer; layer = layer->next) layer->decode_ticket = 0;
+}
+
+bool hyprlax_poll_texture_uploads(hyprlax_context_t *ctx) {
+    if (!ctx) return false;
+    if (ctx->decode_pool && rc_collect_decodes(ctx)) hyprlax_mark_layers_changed(ctx);
+    if (!ctx->texture_uploads) return false;
+    bool waiting = false, swapped = false;
+    for (parallax_layer_t *layer = ctx->layers; layer; layer = layer->next) {
+        if (!layer->pending.texture) continue;
+        if (renderer_texture_ready(layer->pending.texture)) {
+            rc_apply_pending(ctx, layer);
+            swapped = true;
+        } else {
+            waiting = true;
+        }
+    }
+    if (swapped) hyprlax_mark_layers_changed(ctx);
+    ctx->texture_uploads = waiting;
+    return waiting;
+}
+
+/* Compiled per-monitor layer draw. Everything except the blended offset and
+ * the (GIF-animated) texture id is resolved once, when the monitor's packets
+ * go stale: config, layer properties, texture sizes or geometry changed. */
+struct render_packet {
+    parallax_layer_t *layer;
+    int slot;                         /* Layer store slot (-1 = read the node) */
+    uint64_t hash;                    /* Hash of the compiled inputs */
+    int rect[4];                      /* Surface pixels covered, bottom-left origin */
+    float workspace_sign_x;           /* Workspace inversion */
+    float workspace_sign_y;
+    float cursor_mul_x;               /* Shift multiplier with inversion folded in */
+    float cursor_mul_y;
+    float window_mul_x;
+    float window_mul_y;
+    float opacity;
+    float blur;
+    int tile;                         /* Virtual texture tile drawn (-1 = the layer's texture) */
+    texture_t tex;
+    renderer_layer_params_t params;   /* For renderers without draw packets */
+    renderer_draw_packet_t packet;
+    bool opaque;                      /* Every covered pixel is written with alpha 1 */
+    bool covers;                      /* Opaque and spans the whole viewport */
+    int inner[4];                     /* Pixels fully inside the quad (occluders) */
+    /* Per frame */
+    uint32_t texture_id;
+    float x, y;
+};
 
-        if (layer->texture_id == 0) { layer = layer->next; continue; }
-
-        /* Workspace-driven offsets (pixels) */
-        /* Use the current animated value only; offset_x/y are maintained by layer_tick
-           and should not be summed with current to avoid double-application. */
-        float workspace_x = layer->current_x;
-        float workspace_y = layer->current_y;
-
-        /* Apply optional workspace inversion (global xor layer) */
-        bool workspace_invert_x = ctx->config.invert_workspace_x ^ layer->invert_workspace_x;
-        bool workspace_invert_y = ctx->config.invert_workspace_y ^ layer->invert_workspace_y;
-        if (workspace_invert_x) workspace_x = -workspace_x;
-        if (workspace_invert_y) workspace_y = -workspace_y;
-
-        /* Cursor-driven offsets (normalized -> pixels) */
-        float cursor_weight = ctx->input.weights[INPUT_CURSOR];
-        float window_weight = ctx->input.weights[INPUT_WINDOW];
-        float cursor_x_px = 0.0f;
-        float cursor_y_px = 0.0f;
-        if (cursor_weight > 0.0f) {
-            input_sample_t cursor_sample;
-            bool have_cursor_sample = input_manager_last_source(&ctx->input, monitor, INPUT_CURSOR, &cursor_sample);
-            if (!have_cursor_sample || !cursor_sample.valid) {
-                cursor_sample.x = ctx->cursor_eased_x * ctx->config.parallax_max_offset_x;
-                cursor_sample.y = ctx->cursor_eased_y * ctx->config.parallax_max_offset_y;
-                cursor_sample.valid = true;
+#define RC_HASH_SEED 1469598103934665603ULL
+
+/* FNV-1a over raw bytes */
+static uint64_t rc_hash_bytes(uint64_t h, const void *data, size_t len) {
+    const unsigned char *b = (const unsigned char *)data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= b[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static void rc_issue_draw(hyprlax_context_t *ctx, const struct render_packet *pk) {
+    const renderer_ops_t *ops = ctx->renderer->ops;
+    if (ops->compile_layer && ops->draw_packet) {
+        ops->draw_packet(&pk->packet, pk->texture_id, pk->x, pk->y);
+        return;
+    }
+    texture_t tex = pk->tex;
+    tex.id = pk->texture_id;
+    if (ops->draw_layer_ex) {
+        ops->draw_layer_ex(&tex, pk->x, pk->y, pk->opacity, pk->blur, &pk->params);
+    } else if (ops->draw_layer) {
+        ops->draw_layer(&tex, pk->x, pk->y, pk->opacity, pk->blur);
+    }
+}
+
+/* Draw packets [from, to) bottom-up, folding eligible runs into single
+ * composite passes when the renderer supports it. With opaque_base the
+ * first draw replaces the pixels under it, so it is issued without
+ * blending; a base that does not cover the viewport is drawn on its own so
+ * a composite pass cannot overwrite the clear around it. */
+static void rc_issue_draws(hyprlax_context_t *ctx, const struct render_packet *packets,
+                           int from, int to, bool opaque_base) {
+    const renderer_ops_t *ops = ctx->renderer->ops;
+    bool batch = ops->draw_packet_batch && ops->compile_layer && ops->draw_packet;
+    opaque_base = opaque_base && ops->set_blend && from < to;
+    if (opaque_base) ops->set_blend(false);
+    int i = from;
+    while (i < to) {
+        /* Tiles out of view, or waiting on their fallback */
+        if (!packets[i].texture_id) { i++; continue; }
+        if (batch && to - i >= 2 && !(opaque_base && !packets[i].covers)) {
+            renderer_packet_draw_t draws[HYPRLAX_COMPOSITE_MAX_LAYERS];
+            int index[HYPRLAX_COMPOSITE_MAX_LAYERS];
+            int count = 0;
+            for (int k = i; count < HYPRLAX_COMPOSITE_MAX_LAYERS && k < to; k++) {
+                const struct render_packet *pk = &packets[k];
+                if (!pk->texture_id) continue;
+                draws[count].packet = &pk->packet;
+                draws[count].texture_id = pk->texture_id;
+                draws[count].x = pk->x;
+                draws[count].y = pk->y;
+                index[count++] = k;
             }
-            cursor_x_px = cursor_sample.x * layer->shift_multiplier_x;
-            cursor_y_px = cursor_sample.y * layer->shift_multiplier_y;
-            bool cursor_invert_x = ctx->config.invert_cursor_x ^ layer->invert_cursor_x;
-            bool cursor_invert_y = ctx->config.invert_cursor_y ^ layer->invert_cursor_y;
-            if (cursor_invert_x) cursor_x_px = -cursor_x_px;
-            if (cursor_invert_y) cursor_y_px = -cursor_y_px;
-        }
-
-        float window_x_px = 0.0f;
-        float window_y_px = 0.0f;
-        if (window_weight > 0.0f) {
-            input_sample_t window_sample;
-            bool have_window_sample = input_manager_last_source(&ctx->input, monitor, INPUT_WINDOW, &window_sample);
-            if (have_window_sample && window_sample.valid) {
-                window_x_px = window_sample.x * layer->shift_multiplier_x;
-                window_y_px = window_sample.y * layer->shift_multiplier_y;
-                bool window_invert_x = ctx->config.invert_window_x ^ layer->invert_window_x;
-                bool window_invert_y = ctx->config.invert_window_y ^ layer->invert_window_y;
-                if (window_invert_x) window_x_px = -window_x_px;
-                if (window_invert_y) window_y_px = -window_y_px;
+            int used = count >= 2 ? ops->draw_packet_batch(draws, count) : 0;
+            if (used > 0) {
+                i = index[used - 1] + 1;
+                if (opaque_base) { ops->set_blend(true); opaque_base = false; }
+                continue;
             }
         }
+        rc_issue_draw(ctx, &packets[i]);
+        i++;
+        if (opaque_base) { ops->set_blend(true); opaque_base = false; }
+    }
+}
 
-        /* Blend according to selected mode */
-        float workspace_weight = ctx->input.weights[INPUT_WORKSPACE];
-        float offset_x = workspace_x * workspace_weight + cursor_x_px * cursor_weight + window_x_px * window_weight;
-        float offset_y = workspace_y * workspace_weight + cursor_y_px * cursor_weight + window_y_px * window_weight;
+/* Grow rect a ({x, y, w, h}) to cover b; empty rects have w or h <= 0 */
+static void rc_rect_union(int a[4], const int b[4]) {
+    if (b[2] <= 0 || b[3] <= 0) return;
+    if (a[2] <= 0 || a[3] <= 0) { memcpy(a, b, 4 * sizeof(int)); return; }
+    int x0 = a[0] < b[0] ? a[0] : b[0];
+    int y0 = a[1] < b[1] ? a[1] : b[1];
+    int x1 = (a[0] + a[2]) > (b[0] + b[2]) ? (a[0] + a[2]) : (b[0] + b[2]);
+    int y1 = (a[1] + a[3]) > (b[1] + b[3]) ? (a[1] + a[3]) : (b[1] + b[3]);
+    a[0] = x0; a[1] = y0; a[2] = x1 - x0; a[3] = y1 - y0;
+}
 
-        texture_t tex = {
-            .id = (uint32_t)layer->texture_id,
-            .width = layer->texture_width > 0 ? layer->texture_width : layer->width,
-            .height = layer->texture_height > 0 ? layer->texture_height : layer->height,
-            .format = TEXTURE_FORMAT_RGBA
-        };
+/* Does rect a ({x, y, w, h}) lie inside rect b? */
+static bool rc_rect_contains(const int b[4], const int a[4]) {
+    return b[2] > 0 && b[3] > 0 &&
+           a[0] >= b[0] && a[1] >= b[1] &&
+           a[0] + a[2] <= b[0] + b[2] && a[1] + a[3] <= b[1] + b[3];
+}
+
+/* Pixel rect fully inside an NDC extent (rounded inward), clamped to the surface */
+static void rc_ndc_rect_inner(const float ndc[4], int px_w, int px_h, int out[4]) {
+    int x0 = (int)ceilf((ndc[0] + 1.0f) * 0.5f * (float)px_w - 1e-3f);
+    int y0 = (int)ceilf((ndc[1] + 1.0f) * 0.5f * (float)px_h - 1e-3f);
+    int x1 = (int)floorf((ndc[2] + 1.0f) * 0.5f * (float)px_w + 1e-3f);
+    int y1 = (int)floorf((ndc[3] + 1.0f) * 0.5f * (float)px_h + 1e-3f);
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > px_w) x1 = px_w;
+    if (y1 > px_h) y1 = px_h;
+    out[0] = x0; out[1] = y0;
+    out[2] = x1 > x0 ? x1 - x0 : 0;
+    out[3] = y1 > y0 ? y1 - y0 : 0;
+}
+
+/* Pixel rect of an NDC extent, rounded outward and clamped to the surface */
+static void rc_ndc_rect(const float ndc[4], int px_w, int px_h, int out[4]) {
+    int x0 = (int)floorf((ndc[0] + 1.0f) * 0.5f * (float)px_w);
+    int y0 = (int)floorf((ndc[1] + 1.0f) * 0.5f * (float)px_h);
+    int x1 = (int)ceilf((ndc[2] + 1.0f) * 0.5f * (float)px_w);
+    int y1 = (int)ceilf((ndc[3] + 1.0f) * 0.5f * (float)px_h);
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > px_w) x1 = px_w;
+    if (y1 > px_h) y1 = px_h;
+    out[0] = x0; out[1] = y0;
+    out[2] = x1 > x0 ? x1 - x0 : 0;
+    out[3] = y1 > y0 ? y1 - y0 : 0;
+}
+
+/* Renderer params of a layer on an output: overflow/tile/margin inheritance */
+static void rc_layer_params(const hyprlax_context_t *ctx, const monitor_instance_t *monitor,
+                            const parallax_layer_t *layer, renderer_layer_params_t *p) {
+    int eff_over = (layer->overflow_mode >= 0) ? layer->overflow_mode : ctx->config.render_overflow_mode;
+    int eff_tile_x = (layer->tile_x >= 0) ? layer->tile_x : ctx->config.render_tile_x;
+    int eff_tile_y = (layer->tile_y >= 0) ? layer->tile_y : ctx->config.render_tile_y;
+
+    memset(p, 0, sizeof(*p));
+    p->fit_mode = layer->fit_mode;
+    p->content_scale = layer->content_scale;
+    p->align_x = layer->align_x;
+    p->align_y = layer->align_y;
+    p->base_uv_x = layer->base_uv_x;
+    p->base_uv_y = layer->base_uv_y;
+    p->overflow_mode = eff_over;
+    p->margin_px_x = (layer->margin_px_x != 0.0f || layer->margin_px_y != 0.0f) ? layer->margin_px_x : ctx->config.render_margin_px_x;
+    p->margin_px_y = (layer->margin_px_y != 0.0f || layer->margin_px_x != 0.0f) ? layer->margin_px_y : ctx->config.render_margin_px_y;
+    p->tile_x = eff_tile_x;
+    p->tile_y = eff_tile_y;
+    p->auto_safe_norm_x = (ctx->config.parallax_max_offset_x > 0.0f && (eff_tile_x == 0) && (eff_over == 4))
+        ? (ctx->config.parallax_max_offset_x / (float)monitor->width) : 0.0f;
+    p->auto_safe_norm_y = (ctx->config.parallax_max_offset_y > 0.0f && (eff_tile_y == 0) && (eff_over == 4))
+        ? (ctx->config.parallax_max_offset_y / (float)monitor->height) : 0.0f;
+    p->tint_r = layer->tint_r;
+    p->tint_g = layer->tint_g;
+    p->tint_b = layer->tint_b;
+    p->tint_strength = layer->tint_strength;
+    memcpy(p->crop, layer->crop, sizeof(p->crop));
+}
+
+/* Shift multipliers with optional inversions (global xor layer) folded in */
+static void rc_offset_multipliers(const hyprlax_context_t *ctx, const parallax_layer_t *layer,
+                                  struct render_packet *pk) {
+    pk->workspace_sign_x = (ctx->config.invert_workspace_x ^ layer->invert_workspace_x) ? -1.0f : 1.0f;
+    pk->workspace_sign_y = (ctx->config.invert_workspace_y ^ layer->invert_workspace_y) ? -1.0f : 1.0f;
+    pk->cursor_mul_x = layer->shift_multiplier_x *
+        ((ctx->config.invert_cursor_x ^ layer->invert_cursor_x) ? -1.0f : 1.0f);
+    pk->cursor_mul_y = layer->shift_multiplier_y *
+        ((ctx->config.invert_cursor_y ^ layer->invert_cursor_y) ? -1.0f : 1.0f);
+    pk->window_mul_x = layer->shift_multiplier_x *
+        ((ctx->config.invert_window_x ^ layer->invert_window_x) ? -1.0f : 1.0f);
+    pk->window_mul_y = layer->shift_multiplier_y *
+        ((ctx->config.invert_window_y ^ layer->invert_window_y) ? -1.0f : 1.0f);
+}
 
-        int eff_over = (layer->overflow_mode >= 0) ? layer->overflow_mode : ctx->config.render_overflow_mode;
-        int eff_tile_x = (layer->tile_x >= 0) ? layer->tile_x : ctx->config.render_tile_x;
-        int eff_tile_y = (layer->tile_y >= 0) ? layer->tile_y : ctx->config.render_tile_y;
-
-        if (ctx->renderer->ops->draw_layer_ex) {
-            float eff_shift = monitor_effective_shift_px(&ctx->config, monitor);
-            LOG_DEBUG("Rendering layer: fit_mode=%d, content_scale=%.2f, shift=%.1f",
-                      layer->fit_mode, layer->content_scale, eff_shift);
-            renderer_layer_params_t p = {
-                .fit_mode = layer->fit_mode,
-                .content_scale = layer->content_scale,
-                .align_x = layer->align_x,
-                .align_y = layer->align_y,
-                .base_uv_x = layer->base_uv_x,
-                .base_uv_y = layer->base_uv_y,
-                .overflow_mode = eff_over,
-                .margin_px_x = (layer->margin_px_x != 0.0f || layer->margin_px_y != 0.0f) ? layer->margin_px_x : ctx->config.render_margin_px_x,
-                .margin_px_y = (layer->margin_px_y != 0.0f || layer->margin_px_x != 0.0f) ? layer->margin_px_y : ctx->config.render_margin_px_y,
-                .tile_x = eff_tile_x,
-                .tile_y = eff_tile_y,
-                .auto_safe_norm_x = (ctx->config.parallax_max_offset_x > 0.0f && (eff_tile_x == 0) && (eff_over == 4))
-                    ? (ctx->config.parallax_max_offset_x / (float)monitor->width) : 0.0f,
-                .auto_safe_norm_y = (ctx->config.parallax_max_offset_y > 0.0f && (eff_tile_y == 0) && (eff_over == 4))
-                    ? (ctx->config.parallax_max_offset_y / (float)monitor->height) : 0.0f,
-                .tint_r = layer->tint_r,
-                .tint_g = layer->tint_g,
-                .tint_b = layer->tint_b,
-                .tint_strength = layer->tint_strength,
-            };
-            ctx->renderer->ops->draw_layer_ex(
-                &tex,
-                offset_x / monitor->width,
-                offset_y / monitor->height,
-                layer->opacity,
-                layer->blur_amount,
-                &p
-            );
-        } else if (ctx->renderer->ops->draw_layer) {
-            ctx->renderer->ops->draw_layer(
-                &tex,
-                offset_x / monitor->width,
-                offset_y / monitor->height,
-                layer->opacity,
-                layer->blur_amount
-            );
+/* Resolve overflow/tile/margin inheritance and renderer geometry for every
+ * visible layer; returns false if the packet array could not be grown */
+static bool rc_compile_packets(hyprlax_context_t *ctx, monitor_instance_t *monitor,
+                               int px_w, int px_h) {
+    const renderer_ops_t *ops = ctx->renderer->ops;
+    bool compiled = ops->compile_layer && ops->draw_packet;
+    int count = 0;
+    for (parallax_layer_t *layer = ctx->layers; layer; layer = layer->next) {
+        if (layer->hidden || layer->texture_id == 0) continue;
+        count += 1 + (compiled && layer->tile_ids ? layer->tile_grid.cols * layer->tile_grid.rows : 0);
+    }
+    if (count > monitor->packet_capacity) {
+        struct render_packet *grown = realloc(monitor->packets, (size_t)count * sizeof(*grown));
+        if (!grown) {
+            LOG_ERROR("Out of memory compiling draws for monitor %s", monitor->name);
+            monitor->packet_count = 0;
+            return false;
         }
+        monitor->packets = grown;
+        monitor->packet_capacity = count;
+    }
 
-        layer = layer->next;
+    float eff_shift = monitor_effective_shift_px(&ctx->config, monitor);
+    int n = 0;
+    for (parallax_layer_t *layer = ctx->layers; layer && n < count; layer = layer->next) {
+        if (layer->hidden || layer->texture_id == 0) continue;
+
+        struct render_packet *pk = &monitor->packets[n++];
+        memset(pk, 0, sizeof(*pk));
+        pk->layer = layer;
+        pk->slot = layer_store_slot(&ctx->layer_store, layer->id);
+
+        pk->tile = -1;
+        rc_offset_multipliers(ctx, layer, pk);
+
+        pk->tex.width = layer->texture_width > 0 ? layer->texture_width : layer->width;
+        pk->tex.height = layer->texture_height > 0 ? layer->texture_height : layer->height;
+        pk->tex.format = TEXTURE_FORMAT_RGBA;
+        pk->opacity = layer->opacity;
+        pk->blur = layer->blur_amount;
+
+        LOG_DEBUG("Compiling layer %u: fit_mode=%d, content_scale=%.2f, shift=%.1f",
+                  layer->id, layer->fit_mode, layer->content_scale, eff_shift);
+        renderer_layer_params_t *p = &pk->params;
+        rc_layer_params(ctx, monitor, layer, p);
+
+        float ndc[4] = { -1.0f, -1.0f, 1.0f, 1.0f };
+        bool tiled = compiled && layer->tile_ids;
+        if (compiled) {
+            ops->compile_layer(&pk->tex, pk->opacity, pk->blur, p, &pk->packet);
+            memcpy(ndc, pk->packet.bounds, sizeof(ndc));
+            /* Tiles draw only their own part of the image; the fallback
+             * matches them past the edges */
+            if (tiled) pk->packet.mask[0] = pk->packet.mask[1] = 1.0f;
+        }
+        rc_ndc_rect(ndc, px_w, px_h, pk->rect);
+
+        /* Opaque texels at full opacity replace what is under them; blur and
+         * overflow masking can leave uncovered pixels inside the quad (a
+         * cached blur is an opaque image again) */
+        if (ops->compile_layer && ops->draw_packet && layer->opaque && pk->opacity >= 1.0f &&
+            (pk->packet.program == RENDERER_PROGRAM_BASIC ||
+             pk->packet.program == RENDERER_PROGRAM_BLUR_CACHED) &&
+            pk->packet.mask[0] == 0.0f && pk->packet.mask[1] == 0.0f) {
+            pk->opaque = true;
+            rc_ndc_rect_inner(ndc, px_w, px_h, pk->inner);
+            pk->covers = pk->inner[0] == 0 && pk->inner[1] == 0 &&
+                         pk->inner[2] == px_w && pk->inner[3] == px_h;
+        }
+
+        /* Everything above except the layer pointer; the id stands in for it */
+        pk->hash = rc_hash_bytes(RC_HASH_SEED, &layer->id, sizeof(layer->id));
+        pk->hash = rc_hash_bytes(pk->hash, &pk->workspace_sign_x,
+                                 offsetof(struct render_packet, texture_id) -
+                                 offsetof(struct render_packet, workspace_sign_x));
+
+        /* One draw per tile over the same quad, its UVs mapped into the tile
+         * texture and masked to the tile without its gutter */
+        int tiles = tiled ? layer->tile_grid.cols * layer->tile_grid.rows : 0;
+        const struct render_packet *base = pk;
+        const float *crop = layer->crop[2] > 0.0f ? layer->crop : (const float[4]){ 0.0f, 0.0f, 1.0f, 1.0f };
+        for (int t = 0; t < tiles && n < count; t++) {
+            struct render_packet *tp = &monitor->packets[n++];
+            *tp = *base;
+            tp->tile = t;
+            int rect[4];
+            virtual_texture_tile_rect(&layer->tile_grid, t, rect);
+            int g = layer->tile_grid.gutter;
+            tp->tex.width = rect[2] + 2 * g;
+            tp->tex.height = rect[3] + 2 * g;
+            float gw = (float)layer->tile_grid.width, gh = (float)layer->tile_grid.height;
+            tp->params.crop[0] = crop[0] + (float)(rect[0] - g) / gw * (crop[2] - crop[0]);
+            tp->params.crop[1] = crop[1] + (float)(rect[1] - g) / gh * (crop[3] - crop[1]);
+            tp->params.crop[2] = crop[0] + (float)(rect[0] + rect[2] + g) / gw * (crop[2] - crop[0]);
+            tp->params.crop[3] = crop[1] + (float)(rect[1] + rect[3] + g) / gh * (crop[3] - crop[1]);
+            ops->compile_layer(&tp->tex, tp->opacity, tp->blur, &tp->params, &tp->packet);
+            tp->packet.mask[0] = 1.0f - (float)g / (float)tp->tex.width;
+            tp->packet.mask[1] = 1.0f - (float)g / (float)tp->tex.height;
+            /* Offsets must move tiles together, so they go through offset_scale */
+            tp->packet.uniform_offset = true;
+            tp->hash = rc_hash_bytes(base->hash, &tp->tile, sizeof(tp->tile));
+            tp->hash = rc_hash_bytes(tp->hash, &tp->packet, sizeof(tp->packet));
+        }
+    }
+
+    /* Occlusion culling: walking top-down, drop draws that lie entirely
+     * inside an opaque draw above them */
+    int occluders[8];
+    int occluder_count = 0;
+    int culled = 0;
+    bool covered = false;
+    for (int i = n - 1; i >= 0; i--) {
+        struct render_packet *pk = &monitor->packets[i];
+        bool hidden = covered;
+        for (int k = 0; !hidden && k < occluder_count; k++) {
+            hidden = rc_rect_contains(monitor->packets[occluders[k]].inner, pk->rect);
+        }
+        if (hidden) {
+            pk->layer = NULL;
+            culled++;
+            continue;
+        }
+        if (pk->covers) covered = true;
+        else if (pk->opaque && occluder_count < (int)(sizeof(occluders) / sizeof(occluders[0]))) {
+            occluders[occluder_count++] = i;
+        }
+    }
+    if (culled > 0) {
+        int kept = 0;
+        for (int i = 0; i < n; i++) {
+            if (!monitor->packets[i].layer) continue;
+            if (kept != i) monitor->packets[kept] = monitor->packets[i];
+            kept++;
+        }
+        n = kept;
+    }
+
+    monitor->packet_count = n;
+    LOG_TRACE("Monitor %s: compiled %d draw packets (%d occluded)", monitor->name, n, culled);
+    return true;
+}
+
+/* Resolve what this output's next frame is drawn from */
+void hyprlax_render_inputs(hyprlax_context_t *ctx, monitor_instance_t *monitor, render_inputs_t *out) {
+    float cursor_weight = ctx->input.weights[INPUT_CURSOR];
+    float window_weight = ctx->input.weights[INPUT_WINDOW];
+    memset(out, 0, sizeof(*out));
+    out->present_target = monitor->present_target;
+    out->workspace_weight = ctx->input.weights[INPUT_WORKSPACE];
+
+    /* Cursor-driven offsets (normalized -> pixels) */
+    if (cursor_weight > 0.0f) {
+        input_sample_t cursor_sample;
+        bool have_cursor_sample = input_manager_last_source(&ctx->input, monitor, INPUT_CURSOR, &cursor_sample);
+        if (!have_cursor_sample || !cursor_sample.valid) {
+            cursor_sample.x = ctx->cursor_eased_x * ctx->config.parallax_max_offset_x;
+            cursor_sample.y = ctx->cursor_eased_y * ctx->config.parallax_max_offset_y;
+        }
+        out->cursor_x = cursor_sample.x * cursor_weight;
+        out->cursor_y = cursor_sample.y * cursor_weight;
+    }
+
+    if (window_weight > 0.0f) {
+        input_sample_t window_sample;
+        bool have_window_sample = input_manager_last_source(&ctx->input, monitor, INPUT_WINDOW, &window_sample);
+        if (have_window_sample && window_sample.valid) {
+            out->window_x = window_sample.x * window_weight;
+            out->window_y = window_sample.y * window_weight;
+        }
+    }
+}
+
+/* Blend workspace, cursor and window offsets for a packet's layer into the
+ * offset its draw takes (fractions of the output) */
+static void rc_packet_offset(const struct render_packet *pk, const monitor_instance_t *monitor,
+                             const render_inputs_t *in, float workspace_x, float workspace_y,
+                             float *x, float *y) {
+    float offset_x = workspace_x * pk->workspace_sign_x * in->workspace_weight +
+                     in->cursor_x * pk->cursor_mul_x + in->window_x * pk->window_mul_x;
+    float offset_y = workspace_y * pk->workspace_sign_y * in->workspace_weight +
+                     in->cursor_y * pk->cursor_mul_y + in->window_y * pk->window_mul_y;
+    *x = offset_x / monitor->width;
+    *y = offset_y / monitor->height;
+}
+
+/* Does a tile draw, at this frame's offset, sample any of its tile? */
+static bool rc_tile_in_view(const struct render_packet *pk) {
+    const float *v = pk->packet.vertices;
+    float ox = pk->x * pk->packet.offset_scale[0];
+    float oy = -pk->y * pk->packet.offset_scale[1];
+    return fmaxf(v[2], v[6]) + ox > 0.0f && fminf(v[2], v[6]) + ox < 1.0f &&
+           fmaxf(v[3], v[11]) + oy > 0.0f && fminf(v[3], v[11]) + oy < 1.0f;
+}
+
+/* Per-frame: blend workspace, cursor and window offsets into each packet */
+static void rc_apply_offsets(hyprlax_context_t *ctx, monitor_instance_t *monitor,
+                             const render_inputs_t *in) {
+    const layer_store_t *store = &ctx->layer_store;
+    for (int i = 0; i < monitor->packet_count; i++) {
+        struct render_packet *pk = &monitor->packets[i];
+        const parallax_layer_t *layer = pk->layer;
+        /* Use the current animated value only; offset_x/y track it and
+           should not be summed with current. */
+        float workspace_x = pk->slot >= 0 ? store->current_x[pk->slot] : layer->current_x;
+        float workspace_y = pk->slot >= 0 ? store->current_y[pk->slot] : layer->current_y;
+        rc_packet_offset(pk, monitor, in, workspace_x, workspace_y, &pk->x, &pk->y);
+        pk->texture_id = pk->tile >= 0 ? layer->tile_ids[pk->tile] : (uint32_t)layer->texture_id;
+    }
+
+    /* Tiled layers draw the tiles in view once every one of them is
+     * resident, and their fallback until then (texture 0 = no draw) */
+    for (int i = 0; i < monitor->packet_count; i++) {
+        struct render_packet *pk = &monitor->packets[i];
+        if (pk->tile >= 0 || !pk->layer->tile_ids) continue;
+        int end = i + 1;
+        bool resident = true;
+        for (; end < monitor->packet_count && monitor->packets[end].layer == pk->layer; end++) {
+            struct render_packet *tp = &monitor->packets[end];
+            if (!rc_tile_in_view(tp)) tp->texture_id = 0;
+            else if (!tp->texture_id) resident = false;
+        }
+        if (end == i + 1) continue;
+        if (resident) {
+            pk->texture_id = 0;
+        } else {
+            for (int k = i + 1; k < end; k++) monitor->packets[k].texture_id = 0;
+        }
+        i = end - 1;
+    }
+}
+
+/* Make sure the monitor's composite target matches its pixel size */
+static bool rc_ensure_composite_target(hyprlax_context_t *ctx, monitor_instance_t *monitor, int w, int h) {
+    const renderer_ops_t *ops = ctx->renderer->ops;
+    if (monitor->composite_target && (monitor->composite_width != w || monitor->composite_height != h)) {
+        ops->destroy_target(monitor->composite_target);
+        monitor->composite_target = 0;
+        monitor->composite_layers = 0;
+    }
+    if (!monitor->composite_target) {
+        monitor->composite_target = ops->create_target(w, h);
+        monitor->composite_width = w;
+        monitor->composite_height = h;
+        monitor->composite_layers = 0;
+    }
+    return monitor->composite_target != 0;
+}
+
+/* Free the output's composite so its target slot can be reused */
+void hyprlax_render_release_output(hyprlax_context_t *ctx, monitor_instance_t *monitor) {
+    if (!ctx || !ctx->renderer || !monitor) return;
+    const renderer_ops_t *ops = ctx->renderer->ops;
+    if (monitor->composite_target && ops->destroy_target) {
+        ops->destroy_target(monitor->composite_target);
+    }
+    monitor->composite_target = 0;
+    monitor->composite_layers = 0;
+}
+
+/* Remember per-draw hashes and rects so the next frame can diff against them */
+static void rc_store_draw_state(monitor_instance_t *monitor, const uint64_t *hashes,
+                                const int *rects, int n) {
+    if (n > monitor->draw_hash_capacity) {
+        uint64_t *grown = realloc(monitor->draw_hashes, (size_t)n * sizeof(*grown));
+        int *grown_rects = grown ? realloc(monitor->draw_rects, (size_t)n * 4 * sizeof(int)) : NULL;
+        if (grown) monitor->draw_hashes = grown;
+        if (!grown || !grown_rects) { monitor->draw_hash_count = 0; return; }
+        monitor->draw_rects = grown_rects;
+        monitor->draw_hash_capacity = n;
+    }
+    if (n > 0) {
+        memcpy(monitor->draw_hashes, hashes, (size_t)n * sizeof(*hashes));
+        memcpy(monitor->draw_rects, rects, (size_t)n * 4 * sizeof(int));
     }
+    monitor->draw_hash_count = n;
+}
+
+/* Draw and present one output. The caller owns the dirty and stale flags
+ * (the render thread tracks them per snapshot), so it is told whether to
+ * recompile and learns whether the output still needs drawing. */
+bool hyprlax_render_output(hyprlax_context_t *ctx, monitor_instance_t *monitor,
+                           const render_inputs_t *inputs, bool recompile) {
+    if (!ctx || !ctx->renderer || !monitor) {
+        LOG_TRACE("Skipping render: ctx=%p, renderer=%p, monitor=%p", ctx, ctx ? ctx->renderer : NULL, monitor);
+        return true;
+    }
+    const renderer_ops_t *ops = ctx->renderer->ops;
+    if (ops->make_current ? !monitor->render_surface : !monitor->egl_surface) {
+        LOG_WARN("Monitor %s has no render surface", monitor->name);
+        return true;
+    }
+
+    bool profile = ctx->config.render_options.profile;
+    double t_draw_start = 0.0, t_present_start = 0.0;
+    if (profile) t_draw_start = rc_get_time();
+
+    int px_w = monitor->width * monitor->scale;
+    int px_h = monitor->height * monitor->scale;
+
+    /* Renderer-owned surfaces are cheap to bind and carry the viewport the
+     * packets are compiled against, so bind them up front */
+    bool bound = false;
+    if (ops->make_current) {
+        if (ops->make_current(monitor->render_surface, px_w, px_h) != HYPRLAX_SUCCESS) {
+            LOG_ERROR("Failed to bind render surface for monitor %s", monitor->name);
+            return false;
+        }
+        bound = true;
+    }
+
+    /* Recompile draw packets only when their inputs changed, then apply this
+     * frame's offsets and hash: per draw, per bottom-up prefix and per frame */
+    if (recompile && !rc_compile_packets(ctx, monitor, px_w, px_h)) return false;
+    rc_apply_offsets(ctx, monitor, inputs);
+    const struct render_packet *packets = monitor->packets;
+    int n = monitor->packet_count;
+    uint64_t stack_hashes[32];
+    int stack_rects[32 * 4];
+    uint64_t *hashes = stack_hashes;
+    int *rects = stack_rects;
+    if (n > 32) {
+        hashes = malloc((size_t)n * sizeof(uint64_t));
+        rects = malloc((size_t)n * 4 * sizeof(int));
+        if (!hashes || !rects) {
+            free(hashes);
+            free(rects);
+            hashes = stack_hashes;
+            rects = stack_rects;
+            n = 32;
+        }
+    }
+    uint64_t frame_hash = rc_hash_bytes(RC_HASH_SEED, &px_w, sizeof(px_w));
+    frame_hash = rc_hash_bytes(frame_hash, &px_h, sizeof(px_h));
+    for (int i = 0; i < n; i++) {
+        hashes[i] = rc_hash_bytes(packets[i].hash, &packets[i].texture_id, sizeof(packets[i].texture_id));
+        hashes[i] = rc_hash_bytes(hashes[i], &packets[i].x, sizeof(packets[i].x));
+        hashes[i] = rc_hash_bytes(hashes[i], &packets[i].y, sizeof(packets[i].y));
+        frame_hash = rc_hash_bytes(frame_hash, &hashes[i], sizeof(hashes[i]));
+    }
+
+    /* Trails depend on the previous frame, so they bypass both shortcuts */
+    bool accumulate = ctx->config.render_accumulate;
+    if (!accumulate && monitor->frame_presented && monitor->frame_hash == frame_hash) {
+        LOG_TRACE("Monitor %s unchanged; skipping present", monitor->name);
+        ctx->render_stats.monitors_skipped++;
+        goto out;
+    }
+
+    if (!bound) {
+        if (gles2_make_current(monitor->egl_surface) != HYPRLAX_SUCCESS) {
+            LOG_ERROR("Failed to make EGL surface current for monitor %s", monitor->name);
+            goto out;
+        }
+        gles2_set_viewport(px_w, px_h);
+    }
+
+    /* Damage: union of old and new rects of every draw that changed */
+    bool full_damage = accumulate || !monitor->frame_presented ||
+                       n != monitor->draw_hash_count ||
+                       px_w != monitor->presented_width || px_h != monitor->presented_height;
+    int damage[4] = { 0, 0, 0, 0 };
+    for (int i = 0; i < n; i++) {
+        memcpy(&rects[i * 4], packets[i].rect, 4 * sizeof(int));
+        if (!full_damage && hashes[i] != monitor->draw_hashes[i]) {
+            rc_rect_union(damage, &rects[i * 4]);
+            rc_rect_union(damage, &monitor->draw_rects[i * 4]);
+        }
+    }
+    if (full_damage) {
+        damage[0] = 0; damage[1] = 0; damage[2] = px_w; damage[3] = px_h;
+    }
+
+    if (ops->set_damage_region && ops->get_buffer_age) {
+        /* Partial update: the back buffer also misses the damage of the
+         * frames presented since it was last used */
+        int age = ops->get_buffer_age();
+        int region[4] = { damage[0], damage[1], damage[2], damage[3] };
+        if (age <= 0 || age - 1 > monitor->damage_history_len) {
+            region[0] = 0; region[1] = 0; region[2] = px_w; region[3] = px_h;
+        } else {
+            for (int i = 0; i < age - 1; i++) rc_rect_union(region, monitor->damage_history[i]);
+        }
+        ops->set_damage_region(region);
+    }
+
+    /* Bottom-up run of draws unchanged since the last frame */
+    int static_count = 0;
+    uint64_t static_hash = RC_HASH_SEED;
+    while (static_count < n && static_count < monitor->draw_hash_count &&
+           hashes[static_count] == monitor->draw_hashes[static_count]) {
+        static_hash = rc_hash_bytes(static_hash, &hashes[static_count], sizeof(uint64_t));
+        static_count++;
+    }
+
+    bool cache_ok = !accumulate && ops->create_target && ops->destroy_target &&
+                    ops->bind_target && ops->blit_target;
+    int first_live = 0;
+    /* An opaque bottom layer is drawn without blending; one that spans the
+     * viewport also replaces the clear (or trail fade) */
+    bool base_opaque = n > 0 && packets[0].opaque;
+    bool base_covers = n > 0 && packets[0].covers;
+
+    /* Every frame starts from an opaque clear or an opaque full-cover layer,
+     * so the compositor can skip whatever lies beneath the whole surface */
+    if ((monitor->opaque_width != monitor->width || monitor->opaque_height != monitor->height) &&
+        ctx->platform && ctx->platform->ops && ctx->platform->ops->set_opaque_region) {
+        ctx->platform->ops->set_opaque_region(monitor, 0, 0, monitor->width, monitor->height);
+        monitor->opaque_width = monitor->width;
+        monitor->opaque_height = monitor->height;
+    }
+
+    RENDERER_BEGIN_FRAME(ctx->renderer);
+    if (cache_ok && static_count > 0 && rc_ensure_composite_target(ctx, monitor, px_w, px_h)) {
+        if (monitor->composite_layers != static_count || monitor->composite_hash != static_hash) {
+            /* Flatten the static run once */
+            ops->bind_target(monitor->composite_target);
+            if (ops->clear && !base_covers) ops->clear(0.0f, 0.0f, 0.0f, 1.0f);
+            rc_issue_draws(ctx, packets, 0, static_count, base_opaque);
+            ops->bind_target(0);
+            monitor->composite_layers = static_count;
+            monitor->composite_hash = static_hash;
+            LOG_TRACE("Monitor %s: flattened %d layers into composite", monitor->name, static_count);
+        }
+        /* Opaque blit replaces the clear */
+        ops->blit_target(monitor->composite_target);
+        first_live = static_count;
+    } else if (!base_covers) {
+        /* Frame prep: either clear (default) or fade previous frame for trails */
+        if (accumulate) {
+            float a = ctx->config.render_trail_strength;
+            if (a > 0.0f && ops->fade_frame) {
+                ops->fade_frame(0.0f, 0.0f, 0.0f, a);
+            }
+        } else if (ops->clear) {
+            ops->clear(0.0f, 0.0f, 0.0f, 1.0f);
+        }
+    }
+
+    rc_issue_draws(ctx, packets, first_live, n, first_live == 0 && base_opaque);
 
     RENDERER_END_FRAME(ctx->renderer);
-    double t_draw_end = s_profile ? rc_get_time() : 0.0;
-    if (s_profile) t_present_start = t_draw_end;
-    RENDERER_PRESENT(ctx->renderer);
-    double t_present_end = s_profile ? rc_get_time() : 0.0;
-    if (s_profile && ctx->config.debug) {
+    double t_draw_end = profile ? rc_get_time() : 0.0;
+    if (profile) t_present_start = t_draw_end;
+    bool damage_honored = false;
+    if (monitor->wl_surface && ctx->platform && ctx->platform->ops && ctx->platform->ops->request_present_feedback) {
+        ctx->platform->ops->request_present_feedback(monitor);
+    }
+    if (ops->present_damage) {
+        damage_honored = ops->present_damage(damage);
+    } else {
+        RENDERER_PRESENT(ctx->renderer);
+    }
+    double t_present_end = profile ? rc_get_time() : 0.0;
+    if (profile && ctx->config.debug) {
         double draw_ms = (t_draw_end - t_draw_start) * 1000.0;
         double present_ms = (t_present_end - t_present_start) * 1000.0;
-        LOG_DEBUG("[PROFILE] monitor=%s draw=%.2f ms present=%.2f ms", monitor->name, draw_ms, present_ms);
+        LOG_DEBUG("[PROFILE] monitor=%s draw=%.2f ms present=%.2f ms cached=%d/%d",
+                  monitor->name, draw_ms, present_ms, first_live, n);
     }
     if (monitor->wl_surface && ctx->platform && ctx->platform->ops && ctx->platform->ops->commit_monitor_surface) {
         ctx->platform->ops->commit_monitor_surface(monitor);
     }
+    frame_clock_submitted(&monitor->clock, inputs->present_target);
+
+    /* Debug stats: area the compositor was told to recomposite */
+    uint64_t surface_px = (uint64_t)px_w * (uint64_t)px_h;
+    ctx->render_stats.surface_px += surface_px;
+    ctx->render_stats.damaged_px += damage_honored
+        ? (uint64_t)damage[2] * (uint64_t)damage[3] : surface_px;
+    ctx->render_stats.outputs_presented++;
+    if (ops->take_stats) {
+        renderer_stats_t gl = {0};
+        ops->take_stats(&gl);
+        ctx->render_stats.gl_calls += gl.gl_calls;
+        ctx->render_stats.gl_calls_elided += gl.gl_calls_elided;
+    }
+
+    memmove(monitor->damage_history[1], monitor->damage_history[0],
+            (HYPRLAX_DAMAGE_HISTORY - 1) * sizeof(monitor->damage_history[0]));
+    memcpy(monitor->damage_history[0], damage, sizeof(damage));
+    if (monitor->damage_history_len < HYPRLAX_DAMAGE_HISTORY) monitor->damage_history_len++;
+
+    rc_store_draw_state(monitor, hashes, rects, n);
+    monitor->frame_hash = frame_hash;
+    monitor->frame_presented = true;
+    monitor->presented_width = px_w;
+    monitor->presented_height = px_h;
+out:
+    if (hashes != stack_hashes) free(hashes);
+    if (rects != stack_rects) free(rects);
+    return true;
 }
 
-void hyprlax_render_frame(hyprlax_context_t *ctx) {
-    if (!ctx || !ctx->renderer) {
-        LOG_ERROR("render_frame: No renderer available");
-        return;
+static bool rc_sample_changed(const input_sample_t *a, const input_sample_t *b) {
+    return a->valid != b->valid || a->x != b->x || a->y != b->y;
+}
+
+/* Has this monitor's cached input sample moved since the previous tick? */
+static bool rc_input_changed(const input_monitor_cache_entry_t *before,
+                             const input_monitor_cache_entry_t *after) {
+    if (!before || !after) return true;
+    if (before->composite_valid != after->composite_valid ||
+        rc_sample_changed(&before->composite, &after->composite)) {
+        return true;
     }
-    if (!ctx->monitors || ctx->monitors->count == 0) {
-        LOG_WARN("No monitors available for rendering");
-        return;
+    for (int i = 0; i < INPUT_MAX; i++) {
+        if (before->source_valid[i] != after->source_valid[i] ||
+            rc_sample_changed(&before->sources[i], &after->sources[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Non-blocking presents: an output whose last frame the compositor has not
+ * shown yet (frame callback pending) or the GPU has not finished is skipped
+ * instead of blocking every other output behind it */
+bool hyprlax_render_blocked(hyprlax_context_t *ctx, monitor_instance_t *monitor) {
+    if (!ctx->nonblocking_present) return false;
+    if (monitor->frame_pending) return true;
+    const renderer_ops_t *ops = ctx->renderer->ops;
+    if (!ops->gpu_busy) return false;
+    void *surface = ops->make_current ? monitor->render_surface : (void *)monitor->egl_surface;
+    if (!surface || !ops->gpu_busy(surface)) return false;
+    /* No event announces the fence, so poll on the next loop pass */
+    ctx->deferred_render_needed = true;
+    return true;
+}
+
+/* Reload layers whose downscaled image is now too small for some output
+ * (an output was added or grew, or the layer's geometry changed), and
+ * whole images that can now be cropped (overflow none set, tiling or
+ * shifts removed). The old texture keeps drawing until the new one is
+ * uploaded. */
+static void rc_refit_layer_textures(hyprlax_context_t *ctx) {
+    int max_size = renderer_max_texture_size();
+    for (parallax_layer_t *layer = ctx->layers; layer; layer = layer->next) {
+        if (layer->is_gif || !layer->image_path || !layer->texture_id || layer->pending.texture ||
+            layer->decode_ticket) continue;
+        if (layer->width <= 0 || layer->height <= 0) continue;
+        bool cropped = layer->crop[2] > 0.0f;
+        rc_image_fit_t fit;
+        rc_fit_image(ctx, layer, layer->width, layer->height, &fit);
+        /* Crops only start on a whole image: a cropped one that may no
+         * longer be cropped has its reach leave the uploaded window */
+        bool croppable = !cropped && (fit.rect[2] < layer->width || fit.rect[3] < layer->height);
+        /* Otherwise only ever grow: reload if the reachable window left the
+         * uploaded one, or an output needs more texels per image pixel */
+        const float *have = cropped ? layer->crop : (const float[4]){ 0.0f, 0.0f, 1.0f, 1.0f };
+        const float eps = 1e-4f;
+        bool outside = fit.crop[0] < have[0] - eps || fit.crop[1] < have[1] - eps ||
+                       fit.crop[2] > have[2] + eps || fit.crop[3] > have[3] + eps;
+        float density = fmaxf((float)layer->texture_width / ((have[2] - have[0]) * (float)layer->width),
+                              (float)layer->texture_height / ((have[3] - have[1]) * (float)layer->height));
+        /* Resampled to the GPU limit: no reload can add texels */
+        bool at_limit = max_size > 0 && (layer->texture_width >= max_size || layer->texture_height >= max_size);
+        if (!croppable && !outside && (fit.scale <= density + eps || at_limit)) continue;
+        LOG_INFO("Layer %u: reloading %s (%s)", layer->id, layer->image_path,
+                 croppable ? "it can now be cropped" :
+                 outside ? "parallax reaches past the uploaded region" : "an output needs more texels");
+        if (hyprlax_queue_layer_texture(ctx, layer, layer->image_path) != HYPRLAX_SUCCESS) {
+            LOG_ERROR("Failed to reload texture for layer: %s", layer->image_path);
+        }
+    }
+}
+
+/* Inputs to rc_fit_image that change without a layer change */
+static uint64_t rc_fit_key(const hyprlax_context_t *ctx) {
+    const config_t *c = &ctx->config;
+    const render_options_t *o = &c->render_options;
+    bool opts[3] = { o->image_downscale, o->image_crop, o->uniform_offset };
+    uint64_t key = rc_hash_bytes(RC_HASH_SEED, opts, sizeof(opts));
+    float params[9] = { c->shift_percent, c->shift_pixels, c->scale_factor,
+                        c->parallax_max_offset_x, c->parallax_max_offset_y,
+                        c->window_sensitivity_x, c->window_sensitivity_y,
+                        (float)c->render_margin_px_x, (float)c->render_margin_px_y };
+    key = rc_hash_bytes(key, params, sizeof(params));
+    int modes[3] = { c->render_overflow_mode, c->render_tile_x, c->render_tile_y };
+    key = rc_hash_bytes(key, modes, sizeof(modes));
+    key = rc_hash_bytes(key, ctx->input.weights, sizeof(ctx->input.weights));
+    for (monitor_instance_t *monitor = ctx->monitors ? ctx->monitors->head : NULL; monitor;
+         monitor = monitor->next) {
+        int dims[4] = { monitor->width, monitor->height, monitor->scale, (int)monitor->current_context.model };
+        key = rc_hash_bytes(key ^ RC_HASH_SEED, dims, sizeof(dims));
     }
-    double now_time = rc_get_time();
+    return key;
+}
+
+/* Request the tiles of every tiled layer that an output shows at its
+ * current offset or the one it animates to, plus a prefetch margin; then
+ * evict the least recently wanted past render.tile_budget */
+static void rc_stream_tiles(hyprlax_context_t *ctx) {
+    const layer_store_t *store = &ctx->layer_store;
+    uint64_t stamp = ++ctx->tile_stamp;
+    int tiled = 0;
+    for (int i = 0; i < store->count; i++) {
+        if (store->layers[i]->tiles) tiled++;
+    }
+    if (tiled == 0) return;
+
+    for (monitor_instance_t *monitor = ctx->monitors->head; monitor; monitor = monitor->next) {
+        int px_w = monitor->width * monitor->scale;
+        int px_h = monitor->height * monitor->scale;
+        if (px_w <= 0 || px_h <= 0) continue;
+        render_inputs_t in;
+        hyprlax_render_inputs(ctx, monitor, &in);
+        for (int i = 0; i < store->count; i++) {
+            parallax_layer_t *layer = store->layers[i];
+            if (!layer->tiles || layer->hidden) continue;
+            const texture_t tex = { .width = layer->tile_grid.width, .height = layer->tile_grid.height,
+                                    .format = TEXTURE_FORMAT_RGBA };
+            struct render_packet pk = { .layer = layer };
+            rc_offset_multipliers(ctx, layer, &pk);
+            rc_layer_params(ctx, monitor, layer, &pk.params);
+            renderer_compile_layer_geometry(px_w, px_h, &tex, 1.0f, 0.0f, &pk.params, &pk.packet);
+
+            const float *v = pk.packet.vertices;
+            float u0 = fminf(v[2], v[6]), u1 = fmaxf(v[2], v[6]);
+            float v0 = fminf(v[3], v[11]), v1 = fmaxf(v[3], v[11]);
+            float x[2], y[2];
+            rc_packet_offset(&pk, monitor, &in, store->current_x[i], store->current_y[i], &x[0], &y[0]);
+            rc_packet_offset(&pk, monitor, &in, store->to_x[i], store->to_y[i], &x[1], &y[1]);
+            float du0 = fminf(x[0], x[1]) * pk.packet.offset_scale[0];
+            float du1 = fmaxf(x[0], x[1]) * pk.packet.offset_scale[0];
+            float dv0 = -fmaxf(y[0], y[1]) * pk.packet.offset_scale[1];
+            float dv1 = -fminf(y[0], y[1]) * pk.packet.offset_scale[1];
+            float pad_u = (u1 - u0) * HYPRLAX_TILE_PREFETCH;
+            float pad_v = (v1 - v0) * HYPRLAX_TILE_PREFETCH;
+            float uv[4] = { u0 + du0 - pad_u, v0 + dv0 - pad_v, u1 + du1 + pad_u, v1 + dv1 + pad_v };
+            virtual_texture_request(layer->tiles, uv, stamp);
+        }
+    }
+
+    virtual_texture_t **vts = malloc((size_t)tiled * sizeof(*vts));
+    int count = 0, pending = 0;
+    bool changed = false;
+    for (int i = 0; i < store->count; i++) {
+        virtual_texture_t *vt = store->layers[i]->tiles;
+        if (!vt) continue;
+        int waiting;
+        if (virtual_texture_poll(vt, &waiting)) changed = true;
+        pending += waiting;
+        if (vts) vts[count++] = vt;
+    }
+    uint64_t budget = (uint64_t)ctx->config.render_options.tile_budget << 20;
+    if (vts && budget > 0) {
+        int evicted = virtual_texture_trim(vts, count, budget, stamp);
+        if (evicted > 0) LOG_TRACE("Evicted %d tiles over the %d MiB tile budget", evicted,
+                                   ctx->config.render_options.tile_budget);
+    }
+    free(vts);
+    if (changed) monitor_list_mark_dirty(ctx->monitors);
+    if (pending > 0) ctx->deferred_render_needed = true;
+}
+
+void hyprlax_render_prepare(hyprlax_context_t *ctx) {
+    /* Sample easing at the predicted present time, like layer animations */
+    double now_time = ctx->frame_target_time > 0.0 ? ctx->frame_target_time : rc_get_time();
+    float prev_eased_x = ctx->cursor_eased_x;
+    float prev_eased_y = ctx->cursor_eased_y;
     if (ctx->config.cursor_anim_duration > 0.0) {
         if (animation_is_active(&ctx->cursor_anim_x))
             ctx->cursor_eased_x = animation_evaluate(&ctx->cursor_anim_x, now_time);
@@ -251,20 +1524,103 @@ void hyprlax_render_frame(hyprlax_context_t *ctx) {
         ctx->cursor_eased_x = ctx->cursor_norm_x;
         ctx->cursor_eased_y = ctx->cursor_norm_y;
     }
-    monitor_instance_t *monitor = ctx->monitors->head;
-    while (monitor) {
-        hyprlax_render_monitor(ctx, monitor, now_time);
-        monitor = monitor->next;
+    /* Eased cursor is the shared fallback sample for every output */
+    if (ctx->input.weights[INPUT_CURSOR] > 0.0f &&
+        (ctx->cursor_eased_x != prev_eased_x || ctx->cursor_eased_y != prev_eased_y)) {
+        monitor_list_mark_dirty(ctx->monitors);
+    }
+
+    /* Layers added since the last frame, with their properties set */
+    if (ctx->texture_loads) hyprlax_load_layer_textures(ctx);
+
+    /* Outputs or layers changed: a downscaled image may now be too small */
+    uint64_t fit_key = rc_fit_key(ctx);
+    if (ctx->texture_fit_dirty || fit_key != ctx->texture_fit_key) {
+        ctx->texture_fit_dirty = false;
+        ctx->texture_fit_key = fit_key;
+        rc_refit_layer_textures(ctx);
+    }
+
+    /* Images uploading in bands appear once complete; until then keep
+     * frames coming so the renderer gets to upload them */
+    if (hyprlax_poll_texture_uploads(ctx)) ctx->deferred_render_needed = true;
+
+    /* Packets index the store; rebuild it first if layers changed */
+    layer_store_refresh(&ctx->layer_store, ctx->layers);
+
+    /* GIF frames are shared by all outputs; flip once per pass */
+    const layer_store_t *store = &ctx->layer_store;
+    for (int i = 0; store->animated_gif_count > 0 && i < store->count; i++) {
+        parallax_layer_t *layer = store->layers[i];
+        if (!layer->is_gif || layer->hidden || !layer->gif_textures || layer->frame_count <= 1) continue;
+        if (now_time - layer->last_frame_time > layer->gif_delays[layer->current_frame] / 1000.0) {
+            layer->current_frame = (layer->current_frame + 1) % layer->frame_count;
+            layer->texture_id = layer->gif_textures[layer->current_frame];
+            layer->last_frame_time = now_time;
+            monitor_list_mark_dirty(ctx->monitors);
+        }
+    }
+
+    /* Input providers sample per output; only a moved sample dirties it */
+    for (monitor_instance_t *monitor = ctx->monitors->head; monitor; monitor = monitor->next) {
+        input_monitor_cache_entry_t before;
+        const input_monitor_cache_entry_t *cached = input_manager_get_cache(&ctx->input, monitor);
+        if (cached) before = *cached;
+        input_manager_tick(&ctx->input, monitor, now_time, NULL, NULL);
+        if (rc_input_changed(cached ? &before : NULL, input_manager_get_cache(&ctx->input, monitor))) {
+            monitor_mark_dirty(monitor);
+        }
+    }
+
+    /* Tiles follow this frame's offsets */
+    rc_stream_tiles(ctx);
+}
+
+void hyprlax_render_frame(hyprlax_context_t *ctx) {
+    if (!ctx || !ctx->renderer) {
+        LOG_ERROR("render_frame: No renderer available");
+        return;
+    }
+    if (!ctx->monitors || ctx->monitors->count == 0) {
+        LOG_WARN("No monitors available for rendering");
+        return;
+    }
+    hyprlax_render_prepare(ctx);
+
+    if (ctx->render_thread) {
+        render_thread_publish(ctx->render_thread, ctx);
+        return;
+    }
+    renderer_pump_uploads();
+
+    for (monitor_instance_t *monitor = ctx->monitors->head; monitor; monitor = monitor->next) {
+        if (monitor->render_dirty && hyprlax_render_blocked(ctx, monitor)) {
+            /* Stays dirty; drawn once its previous frame is out of the way */
+            ctx->render_stats.monitors_throttled++;
+        } else if (monitor->render_dirty) {
+            render_inputs_t inputs;
+            hyprlax_render_inputs(ctx, monitor, &inputs);
+            bool recompile = monitor->packets_stale;
+            monitor->render_dirty = false;
+            monitor->packets_stale = false;
+            if (!hyprlax_render_output(ctx, monitor, &inputs, recompile)) {
+                monitor->render_dirty = true;
+                if (recompile) monitor->packets_stale = true;
+            }
+        } else {
+            ctx->render_stats.monitors_skipped++;
+        }
     }
 }
 
 int hyprlax_load_layer_textures(hyprlax_context_t *ctx) {
     if (!ctx) return HYPRLAX_ERROR_INVALID_ARGS;
+    ctx->texture_loads = false;
 
     int loaded = 0;
     parallax_layer_t *layer = ctx->layers;
     while (layer) {
-        if (layer->texture_id == 0 && layer->image_path) {
+        if (layer->texture_id == 0 && !layer->pending.texture && !layer->decode_ticket && layer->image_path) {
             const char *ext = strrchr(layer->image_path, '.');
             if (ext && strcasecmp(ext, ".gif") == 0) {
                 layer->is_gif = true;
@@ -296,6 +1652,9 @@ int hyprlax_load_layer_textures(hyprlax_context_t *ctx) {
                 layer->frame_count = frame_count;
                 layer->gif_textures = calloc(frame_count, sizeof(GLuint));
                 layer->gif_delays = calloc(frame_count, sizeof(int));
+                /* Alpha coverage is the union over all frames */
+                layer->opaque = true;
+                memset(layer->alpha_bbox, 0, sizeof(layer->alpha_bbox));
 
                 for (int i = 0; i < frame_count; i++) {
                     gd_get_frame(gif);
@@ -322,20 +1681,13 @@ int hyprlax_load_layer_textures(hyprlax_context_t *ctx) {
                         }
                     }
 
-                    GLuint texture;
-                    glGenTextures(1, &texture);
-                    glBindTexture(GL_TEXTURE_2D, texture);
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, gif->width, gif->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba_buffer);
+                    bool frame_opaque;
+                    int frame_bbox[4];
+                    layer_analyze_alpha(rgba_buffer, gif->width, gif->height, &frame_opaque, frame_bbox);
+                    if (!frame_opaque) layer->opaque = false;
+                    rc_rect_union(layer->alpha_bbox, frame_bbox);
 
-                    if (rc_is_pow2(gif->width) && rc_is_pow2(gif->height)) {
-                        glGenerateMipmap(GL_TEXTURE_2D);
-                        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-                    } else {
-                        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-                    }
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                    uint32_t texture = renderer_upload_texture(rgba_buffer, gif->width, gif->height);
 
                     layer->gif_textures[i] = texture;
                     layer->gif_delays[i] = (gif->gce.delay * 10 >= 10) ? gif->gce.delay * 10 : 10;
@@ -348,18 +1700,12 @@ int hyprlax_load_layer_textures(hyprlax_context_t *ctx) {
                 layer->last_frame_time = rc_get_time();
                 loaded++;
             } else {
-                int img_width, img_height;
-                GLuint texture = load_texture(layer->image_path, &img_width, &img_height);
-                if (texture != 0) {
-                    layer->texture_id = texture;
-                    layer->width = img_width;
-                    layer->height = img_height;
-                    layer->texture_width = img_width;
-                    layer->texture_height = img_height;
+                if (hyprlax_queue_layer_texture(ctx, layer, layer->image_path) == HYPRLAX_SUCCESS) {
                     loaded++;
                     if (ctx->config.debug) {
-                        LOG_DEBUG("Loaded texture for layer: %s (%dx%d)",
-                                  layer->image_path, img_width, img_height);
+                        LOG_DEBUG("Loading texture for layer: %s (%s)", layer->image_path,
+                                  layer->decode_ticket ? "decoding" :
+                                  layer->pending.texture ? "uploading" : "ready");
                     }
                 } else {
                     LOG_ERROR("Failed to load texture for layer: %s", layer->image_path);
@@ -369,6 +1715,9 @@ int hyprlax_load_layer_textures(hyprlax_context_t *ctx) {
         layer = layer->next;
     }
 
+    if (loaded > 0) {
+        hyprlax_mark_layers_changed(ctx);
+    }
     if (ctx->config.debug && loaded > 0) {
         LOG_INFO("Loaded %d layer textures", loaded);
     }
@@ -0,0 +1,130 @@
+/*
+ * render_options.c - Renderer tuning switches (see render_options.h)
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "../include/render_options.h"
+#include "../include/defaults.h"
+
+typedef struct {
+    const char *name;           /* render.<name>, HYPRLAX_RENDER_<NAME> */
+    size_t offset;
+    int max;                    /* Upper bound of an integer option (0 = boolean) */
+    const char *legacy_env;     /* Variable the option replaces (NULL = none) */
+    bool legacy_inverted;       /* Setting the legacy variable turns the option off */
+} render_option_desc_t;
+
+#define OPT(field) #field, offsetof(render_options_t, field)
+
+static const render_option_desc_t k_options[] = {
+    { OPT(uniform_offset), 0, "HYPRLAX_UNIFORM_OFFSET", false },
+    { OPT(separable_blur), 0, "HYPRLAX_SEPARABLE_BLUR", false },
+    { OPT(blur_downscale), HYPRLAX_BLUR_DOWNSCALE_MAX, "HYPRLAX_BLUR_DOWNSCALE", false },
+    { OPT(blur_cache),     0, NULL,                     false },
+    { OPT(kawase_blur),    0, NULL,                     false },
+    { OPT(upload_budget),  HYPRLAX_UPLOAD_BUDGET_MAX_US, NULL, false },
+    { OPT(image_downscale), 0, NULL,                    false },
+    { OPT(image_crop),     0, NULL,                     false },
+    { OPT(tile_budget),    HYPRLAX_TILE_BUDGET_MAX_MB, NULL, false },
+    { OPT(decode_threads), HYPRLAX_DECODE_THREADS_MAX, NULL, false },
+    { OPT(image_cache),    HYPRLAX_IMAGE_CACHE_MAX_MB, NULL, false },
+    { OPT(gl_finish),      0, "HYPRLAX_NO_GLFINISH",    true },
+    { OPT(single_pass),    0, "HYPRLAX_SINGLE_PASS",    false },
+    { OPT(tint),           0, "HYPRLAX_DISABLE_TINT",   true },
+    { OPT(tint_on_blur),   0, "HYPRLAX_TINT_ON_BLUR",   false },
+    { OPT(frame_callback), 0, "HYPRLAX_FRAME_CALLBACK", false },
+    { OPT(blocking_present), 0, "HYPRLAX_BLOCKING_PRESENT", false },
+    { OPT(debug),          0, "HYPRLAX_DEBUG",          false },
+    { OPT(profile),        0, "HYPRLAX_PROFILE",        false },
+};
+
+#undef OPT
+
+#define OPTION_COUNT ((int)(sizeof(k_options) / sizeof(k_options[0])))
+
+static const render_option_desc_t *find_option(const char *name) {
+    if (!name) return NULL;
+    for (int i = 0; i < OPTION_COUNT; i++) {
+        if (strcmp(k_options[i].name, name) == 0) return &k_options[i];
+    }
+    return NULL;
+}
+
+/* 1/0 for a boolean spelling, -1 otherwise */
+static int parse_bool(const char *v) {
+    if (!strcasecmp(v, "1") || !strcasecmp(v, "true") || !strcasecmp(v, "on") || !strcasecmp(v, "yes")) return 1;
+    if (!strcasecmp(v, "0") || !strcasecmp(v, "false") || !strcasecmp(v, "off") || !strcasecmp(v, "no")) return 0;
+    return -1;
+}
+
+static int set_value(render_options_t *opts, const render_option_desc_t *d, const char *value) {
+    char *field = (char *)opts + d->offset;
+    if (d->max > 0) {
+        char *end = NULL;
+        long v = strtol(value, &end, 10);
+        if (end == value || *end || v < 0 || v > d->max) return -1;
+        *(int *)field = (int)v;
+        return 0;
+    }
+    int b = parse_bool(value);
+    if (b < 0) return -1;
+    *(bool *)field = b != 0;
+    return 0;
+}
+
+void render_options_apply_env(render_options_t *opts) {
+    if (!opts) return;
+    for (int i = 0; i < OPTION_COUNT; i++) {
+        const render_option_desc_t *d = &k_options[i];
+        /* Legacy toggles were mostly "set to enable": any other value counts as set */
+        const char *legacy = d->legacy_env ? getenv(d->legacy_env) : NULL;
+        if (legacy && *legacy) {
+            if (d->max > 0) {
+                set_value(opts, d, legacy);
+            } else {
+                int b = parse_bool(legacy);
+                if (b < 0) b = 1;
+                *(bool *)((char *)opts + d->offset) = d->legacy_inverted ? !b : b != 0;
+            }
+        }
+
+        char env[64] = "HYPRLAX_RENDER_";
+        size_t len = strlen(env);
+        for (const char *p = d->name; *p && len + 1 < sizeof(env); p++) {
+            env[len++] = (char)toupper((unsigned char)*p);
+        }
+        env[len] = '\0';
+        const char *v = getenv(env);
+        if (v && *v && set_value(opts, d, v) != 0) {
+            fprintf(stderr, "Warning: ignoring %s=%s\n", env, v);
+        }
+    }
+}
+
+const char *render_options_name(int index) {
+    return (index >= 0 && index < OPTION_COUNT) ? k_options[index].name : NULL;
+}
+
+bool render_options_is_int(const char *name) {
+    const render_option_desc_t *d = find_option(name);
+    return d && d->max > 0;
+}
+
+int render_options_set(render_options_t *opts, const char *name, const char *value) {
+    const render_option_desc_t *d = find_option(name);
+    if (!opts || !d || !value) return -1;
+    return set_value(opts, d, value);
+}
+
+int render_options_get(const render_options_t *opts, const char *name, char *out, size_t out_size) {
+    const render_option_desc_t *d = find_option(name);
+    if (!opts || !d || !out || out_size == 0) return -1;
+    const char *field = (const char *)opts + d->offset;
+    if (d->max > 0) snprintf(out, out_size, "%d", *(const int *)field);
+    else snprintf(out, out_size, "%s", *(const bool *)field ? "true" : "false");
+    return 0;
+}
@@ -0,0 +1,407 @@
+/*
+ * render_thread.c - Optional dedicated render thread, see render_thread.h
+ *
+ * Ownership while the thread runs:
+ *  - main thread: ctx, the layer list and store, input, monitor flags
+ *    (render_dirty, packets_stale, dirty_serial, stale_serial) and the back
+ *    snapshot slot;
+ *  - render thread: the renderer context, the front slot, its layer copies
+ *    and each monitor's draw state (packets, hashes, damage, composite
+ *    cache, drawn_serial, compiled_serial);
+ *  - shared under output_lock: the monitor list, geometry, Wayland objects,
+ *    frame_pending and the frame clock.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/render_thread.h"
+#include "../include/defaults.h"
+#include "../include/log.h"
+
+void triple_buffer_init(triple_buffer_t *tb) {
+    tb->front = 0;
+    atomic_init(&tb->middle, 1u);
+    tb->back = 2;
+}
+
+void triple_buffer_publish(triple_buffer_t *tb) {
+    unsigned int prev = atomic_exchange_explicit(&tb->middle, tb->back | TRIPLE_BUFFER_FRESH,
+                                                 memory_order_acq_rel);
+    tb->back = prev & ~TRIPLE_BUFFER_FRESH;
+}
+
+bool triple_buffer_acquire(triple_buffer_t *tb) {
+    /* Only the writer sets FRESH, so it is still set at the exchange */
+    if (!(atomic_load_explicit(&tb->middle, memory_order_relaxed) & TRIPLE_BUFFER_FRESH)) return false;
+    unsigned int prev = atomic_exchange_explicit(&tb->middle, tb->front, memory_order_acq_rel);
+    tb->front = prev & ~TRIPLE_BUFFER_FRESH;
+    return true;
+}
+
+struct render_thread {
+    hyprlax_context_t *ctx;
+    pthread_t thread;
+
+    pthread_mutex_t output_lock;
+
+    /* Wake-ups and texture jobs; the snapshot hand-off itself is lock-free */
+    pthread_mutex_t wake_lock;
+    pthread_cond_t wake;
+    pthread_cond_t job_done;
+    bool kicked;
+    bool stop;
+    void (*job)(void *arg);
+    void *job_arg;
+    uint64_t job_seq;                 /* Last snapshot published when the job was posted */
+    uint64_t jobs_posted;
+    uint64_t jobs_done;
+
+    triple_buffer_t buffer;
+    render_snapshot_t slots[3];
+    uint64_t seq;                     /* Main thread: last published snapshot */
+
+    /* Render thread */
+    hyprlax_context_t view;           /* What hyprlax_render_output reads */
+    parallax_layer_t *layers;         /* Layer copies the compiled draws point into */
+    int layer_capacity;
+    uint64_t hold_seq;                /* Draw nothing from snapshots up to this one */
+
+    _Atomic uint64_t damaged_px;
+    _Atomic uint64_t surface_px;
+    _Atomic uint64_t monitors_skipped;
+    _Atomic uint64_t monitors_throttled;
+    _Atomic uint64_t outputs_presented;
+    _Atomic uint64_t gl_calls;
+    _Atomic uint64_t gl_calls_elided;
+};
+
+/* Dispatchers carry no user pointer; there is one render thread */
+static render_thread_t *g_render_thread = NULL;
+
+static bool rt_reserve(void **array, int *capacity, int count, size_t size) {
+    if (count <= *capacity) return true;
+    int grown = *capacity > 0 ? *capacity : 4;
+    while (grown < count) grown *= 2;
+    void *p = realloc(*array, (size_t)grown * size);
+    if (!p) return false;
+    *array = p;
+    *capacity = grown;
+    return true;
+}
+
+/* Texture uploads and deletes from the loaders run here, between frames */
+static void rt_dispatch(void (*job)(void *arg), void *arg) {
+    render_thread_t *rt = g_render_thread;
+    if (!rt || pthread_equal(pthread_self(), rt->thread)) {
+        job(arg);
+        return;
+    }
+    pthread_mutex_lock(&rt->wake_lock);
+    while (rt->job) pthread_cond_wait(&rt->job_done, &rt->wake_lock);
+    uint64_t ticket = ++rt->jobs_posted;
+    rt->job = job;
+    rt->job_arg = arg;
+    rt->job_seq = rt->seq;
+    pthread_cond_signal(&rt->wake);
+    while (rt->jobs_done < ticket) pthread_cond_wait(&rt->job_done, &rt->wake_lock);
+    pthread_mutex_unlock(&rt->wake_lock);
+}
+
+/* Take over the newest snapshot's layers and config */
+static void rt_adopt(render_thread_t *rt, const render_snapshot_t *snap) {
+    int count = snap->layer_count;
+    if (count > rt->layer_capacity) {
+        if (!rt_reserve((void **)&rt->layers, &rt->layer_capacity, count, sizeof(parallax_layer_t))) {
+            LOG_ERROR("Render thread: out of memory for %d layers", count);
+            count = 0;
+        }
+        /* Compiled draws pointed into the old copies */
+        pthread_mutex_lock(&rt->output_lock);
+        for (monitor_instance_t *m = rt->ctx->monitors->head; m; m = m->next) m->compiled_serial = 0;
+        pthread_mutex_unlock(&rt->output_lock);
+    }
+    if (count > 0) memcpy(rt->layers, snap->layers, (size_t)count * sizeof(parallax_layer_t));
+    for (int i = 0; i < count; i++) {
+        rt->layers[i].next = i + 1 < count ? &rt->layers[i + 1] : NULL;
+    }
+    rt->view.layers = count > 0 ? rt->layers : NULL;
+    rt->view.layer_count = count;
+    rt->view.config = snap->config;
+    /* Follows render.blocking_present; this thread owns the renderer */
+    const renderer_ops_t *ops = rt->view.renderer->ops;
+    if (ops->get_capabilities) {
+        rt->view.nonblocking_present =
+            (ops->get_capabilities() & RENDERER_CAP_NONBLOCKING_PRESENT) != 0;
+    }
+    rt->view.frame_target_time = snap->frame_time;
+}
+
+/* One pass over the front snapshot's outputs; true if an output waits on
+ * the GPU and should be polled again */
+static bool rt_draw(render_thread_t *rt) {
+    const render_snapshot_t *snap = &rt->slots[triple_buffer_front(&rt->buffer)];
+    if (snap->seq == 0 || snap->seq <= rt->hold_seq) return false;
+
+    hyprlax_context_t *view = &rt->view;
+    view->deferred_render_needed = false;
+    memset(&view->render_stats, 0, sizeof(view->render_stats));
+
+    for (int i = 0; i < snap->output_count; i++) {
+        const render_snapshot_output_t *out = &snap->outputs[i];
+        pthread_mutex_lock(&rt->output_lock);
+        monitor_instance_t *m = monitor_list_find_by_id(rt->ctx->monitors, out->monitor_id);
+        if (!m || out->dirty_serial == m->drawn_serial) {
+            view->render_stats.monitors_skipped++;
+        } else if (hyprlax_render_blocked(view, m)) {
+            view->render_stats.monitors_throttled++;
+        } else {
+            bool recompile = out->stale_serial != m->compiled_serial;
+            if (hyprlax_render_output(view, m, &out->inputs, recompile)) {
+                m->drawn_serial = out->dirty_serial;
+                if (recompile) m->compiled_serial = out->stale_serial;
+            }
+        }
+        pthread_mutex_unlock(&rt->output_lock);
+    }
+
+    atomic_fetch_add(&rt->damaged_px, view->render_stats.damaged_px);
+    atomic_fetch_add(&rt->surface_px, view->render_stats.surface_px);
+    atomic_fetch_add(&rt->monitors_skipped, view->render_stats.monitors_skipped);
+    atomic_fetch_add(&rt->monitors_throttled, view->render_stats.monitors_throttled);
+    atomic_fetch_add(&rt->outputs_presented, view->render_stats.outputs_presented);
+    atomic_fetch_add(&rt->gl_calls, view->render_stats.gl_calls);
+    atomic_fetch_add(&rt->gl_calls_elided, view->render_stats.gl_calls_elided);
+    return view->deferred_render_needed;
+}
+
+static void *rt_main(void *arg) {
+    render_thread_t *rt = arg;
+    const renderer_ops_t *ops = rt->ctx->renderer->ops;
+    if (ops->bind_context && ops->bind_context() != HYPRLAX_SUCCESS) {
+        LOG_ERROR("Render thread: failed to bind the renderer context");
+    }
+
+    bool poll = false;
+    for (;;) {
+        pthread_mutex_lock(&rt->wake_lock);
+        if (poll) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_nsec += HYPRLAX_RENDER_THREAD_RETRY_MS * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            while (!rt->stop && !rt->job && !rt->kicked) {
+                if (pthread_cond_timedwait(&rt->wake, &rt->wake_lock, &deadline) == ETIMEDOUT) break;
+            }
+        } else {
+            while (!rt->stop && !rt->job && !rt->kicked) pthread_cond_wait(&rt->wake, &rt->wake_lock);
+        }
+        bool stop = rt->stop;
+        void (*job)(void *) = rt->job;
+        void *job_arg = rt->job_arg;
+        uint64_t job_seq = rt->job_seq;
+        rt->kicked = false;
+        pthread_mutex_unlock(&rt->wake_lock);
+
+        if (job) {
+            job(job_arg);
+            /* Snapshots published before the job may still reference a
+             * texture it deleted */
+            if (job_seq > rt->hold_seq) rt->hold_seq = job_seq;
+            pthread_mutex_lock(&rt->wake_lock);
+            rt->job = NULL;
+            rt->jobs_done++;
+            pthread_cond_broadcast(&rt->job_done);
+            pthread_mutex_unlock(&rt->wake_lock);
+        }
+        if (stop) break;
+
+        if (triple_buffer_acquire(&rt->buffer)) {
+            rt_adopt(rt, &rt->slots[triple_buffer_front(&rt->buffer)]);
+        }
+        /* Image bands for this frame; the main thread keeps publishing
+         * frames until they are all in */
+        renderer_pump_uploads();
+        poll = rt_draw(rt);
+    }
+
+    if (ops->release_context) ops->release_context();
+    return NULL;
+}
+
+void render_thread_publish(render_thread_t *rt, hyprlax_context_t *ctx) {
+    if (!rt || !ctx) return;
+    render_snapshot_t *snap = &rt->slots[triple_buffer_back(&rt->buffer)];
+    uint64_t seq = rt->seq + 1;
+
+    int layer_count = 0, tile_count = 0;
+    for (parallax_layer_t *l = ctx->layers; l; l = l->next) {
+        layer_count++;
+        if (l->tile_ids) tile_count += l->tile_grid.cols * l->tile_grid.rows;
+    }
+    int output_count = ctx->monitors ? ctx->monitors->count : 0;
+    if (!rt_reserve((void **)&snap->layers, &snap->layer_capacity, layer_count, sizeof(parallax_layer_t)) ||
+        !rt_reserve((void **)&snap->tile_ids, &snap->tile_id_capacity, tile_count, sizeof(uint32_t)) ||
+        !rt_reserve((void **)&snap->outputs, &snap->output_capacity, output_count,
+                    sizeof(render_snapshot_output_t))) {
+        LOG_ERROR("Render thread: out of memory building a frame snapshot");
+        return;
+    }
+
+    /* Layers carry their offsets from the store (refreshed by prepare) */
+    const layer_store_t *store = &ctx->layer_store;
+    int n = 0, tiles = 0;
+    for (parallax_layer_t *l = ctx->layers; l && n < layer_count; l = l->next, n++) {
+        parallax_layer_t *copy = &snap->layers[n];
+        *copy = *l;
+        int slot = layer_store_slot(store, l->id);
+        if (slot >= 0) {
+            copy->current_x = store->current_x[slot];
+            copy->current_y = store->current_y[slot];
+        }
+        /* Tile residency changes under the main thread: draw from a copy */
+        if (l->tile_ids) {
+            int count = l->tile_grid.cols * l->tile_grid.rows;
+            memcpy(snap->tile_ids + tiles, l->tile_ids, (size_t)count * sizeof(uint32_t));
+            copy->tile_ids = snap->tile_ids + tiles;
+            tiles += count;
+        }
+        copy->tiles = NULL;
+        copy->next = NULL;
+    }
+    snap->layer_count = n;
+
+    /* Serials instead of flags: a snapshot the render thread never saw is
+     * covered by any later one */
+    n = 0;
+    for (monitor_instance_t *m = ctx->monitors ? ctx->monitors->head : NULL;
+         m && n < output_count; m = m->next, n++) {
+        if (m->render_dirty) {
+            m->dirty_serial = seq;
+            m->render_dirty = false;
+        }
+        if (m->packets_stale) {
+            m->stale_serial = seq;
+            m->packets_stale = false;
+        }
+        render_snapshot_output_t *out = &snap->outputs[n];
+        out->monitor_id = m->id;
+        out->dirty_serial = m->dirty_serial;
+        out->stale_serial = m->stale_serial;
+        hyprlax_render_inputs(ctx, m, &out->inputs);
+    }
+    snap->output_count = n;
+    snap->config = ctx->config;
+    snap->frame_time = ctx->frame_target_time;
+    snap->seq = seq;
+
+    pthread_mutex_lock(&rt->wake_lock);
+    rt->seq = seq;
+    pthread_mutex_unlock(&rt->wake_lock);
+    triple_buffer_publish(&rt->buffer);
+    render_thread_kick(rt);
+}
+
+void render_thread_kick(render_thread_t *rt) {
+    if (!rt) return;
+    pthread_mutex_lock(&rt->wake_lock);
+    rt->kicked = true;
+    pthread_cond_signal(&rt->wake);
+    pthread_mutex_unlock(&rt->wake_lock);
+}
+
+void render_thread_lock_outputs(render_thread_t *rt) {
+    if (rt) pthread_mutex_lock(&rt->output_lock);
+}
+
+void render_thread_unlock_outputs(render_thread_t *rt) {
+    if (rt) pthread_mutex_unlock(&rt->output_lock);
+}
+
+void render_thread_take_stats(render_thread_t *rt, render_stats_t *stats) {
+    if (!rt || !stats) return;
+    stats->damaged_px += atomic_exchange(&rt->damaged_px, 0);
+    stats->surface_px += atomic_exchange(&rt->surface_px, 0);
+    stats->monitors_skipped += atomic_exchange(&rt->monitors_skipped, 0);
+    stats->monitors_throttled += atomic_exchange(&rt->monitors_throttled, 0);
+    stats->outputs_presented += atomic_exchange(&rt->outputs_presented, 0);
+    stats->gl_calls += atomic_exchange(&rt->gl_calls, 0);
+    stats->gl_calls_elided += atomic_exchange(&rt->gl_calls_elided, 0);
+}
+
+int render_thread_start(hyprlax_context_t *ctx) {
+    if (!ctx || !ctx->renderer || !ctx->monitors) return HYPRLAX_ERROR_INVALID_ARGS;
+    if (ctx->render_thread) return HYPRLAX_SUCCESS;
+
+    render_thread_t *rt = calloc(1, sizeof(*rt));
+    if (!rt) return HYPRLAX_ERROR_NO_MEMORY;
+    rt->ctx = ctx;
+    pthread_mutex_init(&rt->output_lock, NULL);
+    pthread_mutex_init(&rt->wake_lock, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&rt->wake, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_cond_init(&rt->job_done, NULL);
+    triple_buffer_init(&rt->buffer);
+
+    rt->view.renderer = ctx->renderer;
+    rt->view.platform = ctx->platform;
+    rt->view.monitors = ctx->monitors;
+    rt->view.nonblocking_present = ctx->nonblocking_present;
+    rt->view.config = ctx->config;
+
+    const renderer_ops_t *ops = ctx->renderer->ops;
+    if (ops->release_context) ops->release_context();
+    g_render_thread = rt;
+    if (pthread_create(&rt->thread, NULL, rt_main, rt) != 0) {
+        LOG_ERROR("Failed to start the render thread; rendering on the main thread");
+        g_render_thread = NULL;
+        if (ops->bind_context) ops->bind_context();
+        pthread_cond_destroy(&rt->job_done);
+        pthread_cond_destroy(&rt->wake);
+        pthread_mutex_destroy(&rt->wake_lock);
+        pthread_mutex_destroy(&rt->output_lock);
+        free(rt);
+        return HYPRLAX_ERROR_NO_MEMORY;
+    }
+    renderer_set_dispatch(rt_dispatch);
+    ctx->render_thread = rt;
+    LOG_INFO("Rendering on a dedicated thread");
+    return HYPRLAX_SUCCESS;
+}
+
+void render_thread_stop(hyprlax_context_t *ctx) {
+    if (!ctx || !ctx->render_thread) return;
+    render_thread_t *rt = ctx->render_thread;
+
+    pthread_mutex_lock(&rt->wake_lock);
+    rt->stop = true;
+    pthread_cond_signal(&rt->wake);
+    pthread_mutex_unlock(&rt->wake_lock);
+    pthread_join(rt->thread, NULL);
+
+    renderer_set_dispatch(NULL);
+    g_render_thread = NULL;
+    const renderer_ops_t *ops = ctx->renderer ? ctx->renderer->ops : NULL;
+    if (ops && ops->bind_context) ops->bind_context();
+
+    for (int i = 0; i < 3; i++) {
+        free(rt->slots[i].layers);
+        free(rt->slots[i].tile_ids);
+        free(rt->slots[i].outputs);
+    }
+    free(rt->layers);
+    pthread_cond_destroy(&rt->job_done);
+    pthread_cond_destroy(&rt->wake);
+    pthread_mutex_destroy(&rt->wake_lock);
+    pthread_mutex_destroy(&rt->output_lock);
+    free(rt);
+    ctx->render_thread = NULL;
+}
@@ -0,0 +1,388 @@
+/*
+ * texture_cache.c - Decoded images kept on disk between runs
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../include/texture_cache.h"
+#include "../include/hyprlax_internal.h"
+#include "../include/log.h"
+
+#define TC_MAGIC "HLXTEX\0\0"
+#define TC_VERSION 1
+#define TC_SUFFIX ".tex"
+#define TC_TMP_SUFFIX ".tmp"
+#define TC_TMP_STALE_S 60           /* Older temporaries were left by a crash */
+#define TC_FNV_OFFSET 0xcbf29ce484222325ull
+#define TC_FNV_PRIME 0x100000001b3ull
+
+/* File layout: this header, then width * height * 4 bytes of pixels.
+ * Native byte order; the cache never leaves the machine. */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t key;
+    int32_t width;
+    int32_t height;
+    int32_t source_width;
+    int32_t source_height;
+    float crop[4];
+    int32_t alpha_bbox[4];
+    uint32_t opaque;
+    uint32_t reserved;
+    uint64_t payload_size;
+    uint64_t payload_sum;
+    uint64_t header_sum;        /* Of everything above */
+} tc_header_t;
+
+struct texture_cache_entry {
+    void *map;
+    size_t size;
+};
+
+/* One entry seen while scanning the directory */
+typedef struct {
+    char name[64];
+    uint64_t size;
+    struct timespec mtime;
+} tc_file_t;
+
+static atomic_uint_fast64_t g_hits;
+static atomic_uint_fast64_t g_misses;
+static atomic_uint_fast64_t g_stores;
+static atomic_uint_fast64_t g_evictions;
+static atomic_uint g_tmp_serial;
+
+static uint64_t tc_hash(uint64_t h, const void *data, size_t size) {
+    const uint8_t *p = data;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= TC_FNV_PRIME;
+    }
+    return h;
+}
+
+/* FNV-1a over 64-bit words: the whole image is checked on every hit, so
+ * this has to run at memory speed */
+static uint64_t tc_checksum(const void *data, size_t size) {
+    const uint8_t *p = data;
+    uint64_t h = TC_FNV_OFFSET;
+    size_t words = size / 8;
+    for (size_t i = 0; i < words; i++) {
+        uint64_t w;
+        memcpy(&w, p + i * 8, sizeof(w));
+        h ^= w;
+        h *= TC_FNV_PRIME;
+    }
+    return tc_hash(h, p + words * 8, size - words * 8);
+}
+
+static uint64_t tc_header_sum(const tc_header_t *h) {
+    return tc_checksum(h, offsetof(tc_header_t, header_sum));
+}
+
+bool texture_cache_dir(char *out, size_t size) {
+    const char *xdg = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    int n;
+    if (xdg && xdg[0] == '/') n = snprintf(out, size, "%s/hyprlax", xdg);
+    else if (home && home[0]) n = snprintf(out, size, "%s/.cache/hyprlax", home);
+    else return false;
+    return n > 0 && (size_t)n < size;
+}
+
+/* Create the directory (and ~/.cache under it) if it is missing */
+static bool tc_make_dir(const char *dir) {
+    if (mkdir(dir, 0700) == 0 || errno == EEXIST) return true;
+    if (errno != ENOENT) return false;
+    char parent[PATH_MAX];
+    snprintf(parent, sizeof(parent), "%s", dir);
+    char *slash = strrchr(parent, '/');
+    if (!slash || slash == parent) return false;
+    *slash = '\0';
+    if (mkdir(parent, 0700) != 0 && errno != EEXIST) return false;
+    return mkdir(dir, 0700) == 0 || errno == EEXIST;
+}
+
+static bool tc_entry_path(uint64_t key, char *out, size_t size) {
+    char dir[PATH_MAX];
+    if (!texture_cache_dir(dir, sizeof(dir))) return false;
+    int n = snprintf(out, size, "%s/%016" PRIx64 TC_SUFFIX, dir, key);
+    return n > 0 && (size_t)n < size;
+}
+
+static bool tc_has_suffix(const char *name, const char *suffix) {
+    size_t n = strlen(name), s = strlen(suffix);
+    return n > s && strcmp(name + n - s, suffix) == 0;
+}
+
+uint64_t texture_cache_key(const char *path, const void *variant, size_t variant_size) {
+    struct stat st;
+    if (!path || stat(path, &st) != 0) return 0;
+    char *real = realpath(path, NULL);
+    const char *name = real ? real : path;
+    uint64_t h = tc_hash(TC_FNV_OFFSET, name, strlen(name) + 1);
+    free(real);
+    /* Field by field: struct stat has padding */
+    uint64_t id[5] = {
+        (uint64_t)st.st_dev, (uint64_t)st.st_ino, (uint64_t)st.st_size,
+        (uint64_t)st.st_mtim.tv_sec, (uint64_t)st.st_mtim.tv_nsec,
+    };
+    h = tc_hash(h, id, sizeof(id));
+    if (variant && variant_size) h = tc_hash(h, variant, variant_size);
+    return h ? h : 1;
+}
+
+static bool tc_header_valid(const tc_header_t *h, uint64_t key, size_t file_size) {
+    if (memcmp(h->magic, TC_MAGIC, sizeof(h->magic)) != 0 || h->version != TC_VERSION ||
+        h->header_size != sizeof(*h) || h->key != key || h->header_sum != tc_header_sum(h)) {
+        return false;
+    }
+    if (h->width <= 0 || h->height <= 0) return false;
+    uint64_t payload = (uint64_t)h->width * (uint64_t)h->height * 4u;
+    return h->payload_size == payload && sizeof(*h) + payload == file_size;
+}
+
+texture_cache_entry_t *texture_cache_open(uint64_t key, texture_cache_info_t *info) {
+    char path[PATH_MAX];
+    if (!key || !info || !tc_entry_path(key, path, sizeof(path))) return NULL;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        atomic_fetch_add(&g_misses, 1);
+        return NULL;
+    }
+    struct stat st;
+    void *map = MAP_FAILED;
+    bool valid = false;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        atomic_fetch_add(&g_misses, 1);
+        return NULL;
+    }
+    if ((size_t)st.st_size >= sizeof(tc_header_t)) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            atomic_fetch_add(&g_misses, 1);
+            return NULL;
+        }
+        const tc_header_t *h = map;
+        valid = tc_header_valid(h, key, (size_t)st.st_size) &&
+                tc_checksum((const uint8_t *)map + sizeof(*h), h->payload_size) == h->payload_sum;
+    }
+    if (!valid) {
+        LOG_WARN("Texture cache: dropping damaged entry %s", path);
+        if (map != MAP_FAILED) munmap(map, (size_t)st.st_size);
+        unlink(path);
+        close(fd);
+        atomic_fetch_add(&g_misses, 1);
+        return NULL;
+    }
+    const tc_header_t *h = map;
+    /* Most recently used: trimming goes by mtime */
+    futimens(fd, NULL);
+    close(fd);
+
+    texture_cache_entry_t *entry = malloc(sizeof(*entry));
+    if (!entry) {
+        munmap(map, (size_t)st.st_size);
+        return NULL;
+    }
+    entry->map = map;
+    entry->size = (size_t)st.st_size;
+    info->width = h->width;
+    info->height = h->height;
+    info->source_width = h->source_width;
+    info->source_height = h->source_height;
+    memcpy(info->crop, h->crop, sizeof(info->crop));
+    info->opaque = h->opaque != 0;
+    for (int i = 0; i < 4; i++) info->alpha_bbox[i] = h->alpha_bbox[i];
+    atomic_fetch_add(&g_hits, 1);
+    return entry;
+}
+
+const uint8_t *texture_cache_pixels(const texture_cache_entry_t *entry) {
+    return entry ? (const uint8_t *)entry->map + sizeof(tc_header_t) : NULL;
+}
+
+void texture_cache_close(void *arg) {
+    texture_cache_entry_t *entry = arg;
+    if (!entry) return;
+    munmap(entry->map, entry->size);
+    free(entry);
+}
+
+static bool tc_write_all(int fd, const void *data, size_t size) {
+    const uint8_t *p = data;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+int texture_cache_store(uint64_t key, const texture_cache_info_t *info, const uint8_t *rgba) {
+    if (!key || !info || !rgba || info->width <= 0 || info->height <= 0) return HYPRLAX_ERROR_INVALID_ARGS;
+    char dir[PATH_MAX], path[PATH_MAX], tmp[PATH_MAX];
+    if (!texture_cache_dir(dir, sizeof(dir)) || !tc_entry_path(key, path, sizeof(path))) {
+        return HYPRLAX_ERROR_FILE_NOT_FOUND;
+    }
+    if (!tc_make_dir(dir)) {
+        LOG_WARN("Texture cache: cannot create %s: %s", dir, strerror(errno));
+        return HYPRLAX_ERROR_FILE_NOT_FOUND;
+    }
+    int n = snprintf(tmp, sizeof(tmp), "%s/%016" PRIx64 ".%ld.%u" TC_TMP_SUFFIX, dir, key,
+                     (long)getpid(), atomic_fetch_add(&g_tmp_serial, 1));
+    if (n < 0 || (size_t)n >= sizeof(tmp)) return HYPRLAX_ERROR_FILE_NOT_FOUND;
+
+    tc_header_t h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, TC_MAGIC, sizeof(h.magic));
+    h.version = TC_VERSION;
+    h.header_size = sizeof(h);
+    h.key = key;
+    h.width = info->width;
+    h.height = info->height;
+    h.source_width = info->source_width;
+    h.source_height = info->source_height;
+    memcpy(h.crop, info->crop, sizeof(h.crop));
+    for (int i = 0; i < 4; i++) h.alpha_bbox[i] = info->alpha_bbox[i];
+    h.opaque = info->opaque ? 1u : 0u;
+    h.payload_size = (uint64_t)info->width * (uint64_t)info->height * 4u;
+    h.payload_sum = tc_checksum(rgba, h.payload_size);
+    h.header_sum = tc_header_sum(&h);
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) return HYPRLAX_ERROR_FILE_NOT_FOUND;
+    bool ok = tc_write_all(fd, &h, sizeof(h)) && tc_write_all(fd, rgba, h.payload_size);
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(tmp, path) != 0) {
+        LOG_WARN("Texture cache: cannot write %s: %s", path, strerror(errno));
+        unlink(tmp);
+        return HYPRLAX_ERROR_LOAD_FAILED;
+    }
+    atomic_fetch_add(&g_stores, 1);
+    return HYPRLAX_SUCCESS;
+}
+
+/* Entries in the directory (malloc'd into *files); -1 without one. With
+ * remove_stale, temporaries abandoned by a crash are deleted on the way. */
+static int tc_scan(const char *dir, tc_file_t **files, bool remove_stale) {
+    DIR *d = opendir(dir);
+    if (!d) return -1;
+    int count = 0, cap = 0;
+    *files = NULL;
+    time_t now = time(NULL);
+    struct dirent *de;
+    while ((de = readdir(d))) {
+        struct stat st;
+        if (fstatat(dirfd(d), de->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISREG(st.st_mode)) continue;
+        if (tc_has_suffix(de->d_name, TC_TMP_SUFFIX)) {
+            if (remove_stale && now - st.st_mtim.tv_sec > TC_TMP_STALE_S) unlinkat(dirfd(d), de->d_name, 0);
+            continue;
+        }
+        size_t len = strlen(de->d_name);
+        if (!tc_has_suffix(de->d_name, TC_SUFFIX) || len >= sizeof((*files)->name)) continue;
+        if (count == cap) {
+            int grown = cap ? cap * 2 : 32;
+            tc_file_t *next = realloc(*files, (size_t)grown * sizeof(**files));
+            if (!next) break;
+            *files = next;
+            cap = grown;
+        }
+        tc_file_t *f = &(*files)[count++];
+        memcpy(f->name, de->d_name, len + 1);
+        f->size = (uint64_t)st.st_size;
+        f->mtime = st.st_mtim;
+    }
+    closedir(d);
+    return count;
+}
+
+static int tc_older_first(const void *a, const void *b) {
+    const struct timespec *x = &((const tc_file_t *)a)->mtime;
+    const struct timespec *y = &((const tc_file_t *)b)->mtime;
+    if (x->tv_sec != y->tv_sec) return x->tv_sec < y->tv_sec ? -1 : 1;
+    if (x->tv_nsec != y->tv_nsec) return x->tv_nsec < y->tv_nsec ? -1 : 1;
+    return 0;
+}
+
+int texture_cache_trim(uint64_t budget) {
+    char dir[PATH_MAX];
+    if (!texture_cache_dir(dir, sizeof(dir))) return 0;
+    tc_file_t *files;
+    int count = tc_scan(dir, &files, true);
+    if (count <= 0) {
+        if (count == 0) free(files);
+        return 0;
+    }
+    uint64_t total = 0;
+    for (int i = 0; i < count; i++) total += files[i].size;
+    int evicted = 0;
+    if (total > budget) {
+        qsort(files, (size_t)count, sizeof(*files), tc_older_first);
+        for (int i = 0; i < count && total > budget; i++) {
+            char path[PATH_MAX];
+            int n = snprintf(path, sizeof(path), "%s/%s", dir, files[i].name);
+            if (n < 0 || (size_t)n >= sizeof(path)) continue;
+            /* Another process may have got there first */
+            if (unlink(path) == 0 || errno == ENOENT) {
+                total -= files[i].size;
+                evicted++;
+            }
+        }
+        atomic_fetch_add(&g_evictions, (uint_fast64_t)evicted);
+        LOG_DEBUG("Texture cache: evicted %d entries, %" PRIu64 " bytes kept", evicted, total);
+    }
+    free(files);
+    return evicted;
+}
+
+int texture_cache_clear(void) {
+    char dir[PATH_MAX];
+    if (!texture_cache_dir(dir, sizeof(dir))) return -1;
+    DIR *d = opendir(dir);
+    if (!d) return errno == ENOENT ? 0 : -1;
+    int removed = 0;
+    struct dirent *de;
+    while ((de = readdir(d))) {
+        bool entry = tc_has_suffix(de->d_name, TC_SUFFIX);
+        if (!entry && !tc_has_suffix(de->d_name, TC_TMP_SUFFIX)) continue;
+        if (unlinkat(dirfd(d), de->d_name, 0) == 0 && entry) removed++;
+    }
+    closedir(d);
+    return removed;
+}
+
+int texture_cache_stats(texture_cache_stats_t *stats) {
+    if (!stats) return HYPRLAX_ERROR_INVALID_ARGS;
+    memset(stats, 0, sizeof(*stats));
+    stats->hits = atomic_load(&g_hits);
+    stats->misses = atomic_load(&g_misses);
+    stats->stores = atomic_load(&g_stores);
+    stats->evictions = atomic_load(&g_evictions);
+    char dir[PATH_MAX];
+    if (!texture_cache_dir(dir, sizeof(dir))) return HYPRLAX_ERROR_FILE_NOT_FOUND;
+    tc_file_t *files;
+    int count = tc_scan(dir, &files, false);
+    if (count < 0) return HYPRLAX_SUCCESS;
+    stats->entries = count;
+    for (int i = 0; i < count; i++) stats->bytes += files[i].size;
+    free(files);
+    return HYPRLAX_SUCCESS;
+}
@@ -0,0 +1,106 @@
+/*
+ * texture_registry.c - Layer textures shared by content
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "../include/texture_registry.h"
+#include "../include/renderer.h"
+#include "../include/hyprlax_internal.h"
+#include "../include/log.h"
+
+typedef struct {
+    uint64_t key;
+    uint32_t texture;
+    int refs;
+    texture_cache_info_t info;
+} tr_entry_t;
+
+struct texture_registry {
+    tr_entry_t *entries;
+    int count;
+    int capacity;
+    int holds;                  /* While > 0, unreferenced textures stay */
+};
+
+texture_registry_t *texture_registry_create(void) {
+    return calloc(1, sizeof(texture_registry_t));
+}
+
+void texture_registry_destroy(texture_registry_t *reg) {
+    if (!reg) return;
+    free(reg->entries);
+    free(reg);
+}
+
+/* Delete entry index's texture and drop the entry */
+static void tr_remove(texture_registry_t *reg, int index) {
+    renderer_delete_texture(reg->entries[index].texture);
+    reg->entries[index] = reg->entries[--reg->count];
+}
+
+bool texture_registry_acquire(texture_registry_t *reg, uint64_t key, uint32_t *texture,
+                              texture_cache_info_t *info) {
+    if (!reg || !key) return false;
+    for (int i = 0; i < reg->count; i++) {
+        tr_entry_t *e = &reg->entries[i];
+        if (e->key != key) continue;
+        e->refs++;
+        if (texture) *texture = e->texture;
+        if (info) *info = e->info;
+        return true;
+    }
+    return false;
+}
+
+int texture_registry_add(texture_registry_t *reg, uint64_t key, uint32_t texture,
+                         const texture_cache_info_t *info) {
+    if (!reg || !key || !texture || !info) return HYPRLAX_ERROR_INVALID_ARGS;
+    if (reg->count == reg->capacity) {
+        int grown = reg->capacity ? reg->capacity * 2 : 16;
+        tr_entry_t *entries = realloc(reg->entries, (size_t)grown * sizeof(*entries));
+        if (!entries) return HYPRLAX_ERROR_NO_MEMORY;
+        reg->entries = entries;
+        reg->capacity = grown;
+    }
+    reg->entries[reg->count++] = (tr_entry_t){ .key = key, .texture = texture, .refs = 1, .info = *info };
+    return HYPRLAX_SUCCESS;
+}
+
+void texture_registry_release(texture_registry_t *reg, uint32_t texture) {
+    if (!texture) return;
+    for (int i = 0; reg && i < reg->count; i++) {
+        tr_entry_t *e = &reg->entries[i];
+        if (e->texture != texture) continue;
+        if (e->refs > 0) e->refs--;
+        if (e->refs == 0 && reg->holds == 0) tr_remove(reg, i);
+        return;
+    }
+    renderer_delete_texture(texture);
+}
+
+void texture_registry_hold(texture_registry_t *reg) {
+    if (reg) reg->holds++;
+}
+
+int texture_registry_unhold(texture_registry_t *reg) {
+    if (!reg || reg->holds == 0 || --reg->holds > 0) return 0;
+    int freed = 0;
+    for (int i = reg->count - 1; i >= 0; i--) {
+        if (reg->entries[i].refs > 0) continue;
+        tr_remove(reg, i);
+        freed++;
+    }
+    if (freed) LOG_DEBUG("Texture registry: %d unused textures deleted", freed);
+    return freed;
+}
+
+void texture_registry_stats(const texture_registry_t *reg, int *textures, int *refs) {
+    int count = 0, total = 0;
+    for (int i = 0; reg && i < reg->count; i++) {
+        count++;
+        total += reg->entries[i].refs;
+    }
+    if (textures) *textures = count;
+    if (refs) *refs = total;
+}
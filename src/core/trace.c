@@ -0,0 +1,142 @@
+/*
+ * trace.c - Recorded event traces for headless replay
+ *
+ * Parses the line-based trace format described in trace.h. Parsing is kept
+ * free of any context so traces can be validated without a GL context.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "../include/trace.h"
+#include "../include/hyprlax_internal.h"
+#include "../include/log.h"
+
+/* Copy the next whitespace-separated token; returns the rest of the line */
+static const char* trace_next_token(const char *p, char *out, size_t out_size) {
+    while (*p && isspace((unsigned char)*p)) p++;
+    size_t n = 0;
+    while (*p && !isspace((unsigned char)*p)) {
+        if (n + 1 < out_size) out[n++] = *p;
+        p++;
+    }
+    if (out_size > 0) out[n] = '\0';
+    return p;
+}
+
+static bool trace_parse_int(const char *s, int *out) {
+    char *end = NULL;
+    long v = strtol(s, &end, 10);
+    if (!*s || !end || *end) return false;
+    *out = (int)v;
+    return true;
+}
+
+int trace_parse_line(const char *line, trace_event_t *event) {
+    if (!line || !event) return HYPRLAX_ERROR_INVALID_ARGS;
+
+    char tok[HYPRLAX_TRACE_MAX_LINE];
+    const char *p = trace_next_token(line, tok, sizeof(tok));
+    if (!tok[0] || tok[0] == '#') return 0;
+
+    memset(event, 0, sizeof(*event));
+    char *end = NULL;
+    event->time = strtod(tok, &end);
+    if (!end || *end || event->time < 0.0) return HYPRLAX_ERROR_INVALID_ARGS;
+
+    char kind[32];
+    p = trace_next_token(p, kind, sizeof(kind));
+
+    if (!strcmp(kind, "workspace")) {
+        event->type = TRACE_EVENT_WORKSPACE;
+        p = trace_next_token(p, tok, sizeof(tok));
+        if (!trace_parse_int(tok, &event->workspace)) return HYPRLAX_ERROR_INVALID_ARGS;
+    } else if (!strcmp(kind, "workspace2d")) {
+        event->type = TRACE_EVENT_WORKSPACE_2D;
+        int *fields[4] = { &event->from_x, &event->from_y, &event->to_x, &event->to_y };
+        for (int i = 0; i < 4; i++) {
+            p = trace_next_token(p, tok, sizeof(tok));
+            if (!trace_parse_int(tok, fields[i])) return HYPRLAX_ERROR_INVALID_ARGS;
+        }
+    } else if (!strcmp(kind, "set")) {
+        event->type = TRACE_EVENT_SET;
+        p = trace_next_token(p, event->property, sizeof(event->property));
+        p = trace_next_token(p, event->value, sizeof(event->value));
+        if (!event->property[0] || !event->value[0]) return HYPRLAX_ERROR_INVALID_ARGS;
+    } else {
+        return HYPRLAX_ERROR_INVALID_ARGS;
+    }
+
+    /* Workspace events take an optional output name */
+    if (event->type != TRACE_EVENT_SET) {
+        p = trace_next_token(p, event->monitor, sizeof(event->monitor));
+    }
+    p = trace_next_token(p, tok, sizeof(tok));
+    if (tok[0] && tok[0] != '#') return HYPRLAX_ERROR_INVALID_ARGS;
+    return 1;
+}
+
+static int trace_append(trace_t *trace, const trace_event_t *event) {
+    if (trace->count == trace->capacity) {
+        int capacity = trace->capacity ? trace->capacity * 2 : 32;
+        trace_event_t *events = realloc(trace->events, (size_t)capacity * sizeof(*events));
+        if (!events) return HYPRLAX_ERROR_NO_MEMORY;
+        trace->events = events;
+        trace->capacity = capacity;
+    }
+    trace->events[trace->count++] = *event;
+    return HYPRLAX_SUCCESS;
+}
+
+int trace_load(const char *path, trace_t *trace) {
+    if (!path || !trace) return HYPRLAX_ERROR_INVALID_ARGS;
+    memset(trace, 0, sizeof(*trace));
+
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        LOG_ERROR("Cannot open trace %s", path);
+        return HYPRLAX_ERROR_FILE_NOT_FOUND;
+    }
+
+    char line[HYPRLAX_TRACE_MAX_LINE];
+    int line_no = 0;
+    int ret = HYPRLAX_SUCCESS;
+    while (fgets(line, sizeof(line), f)) {
+        line_no++;
+        trace_event_t event;
+        int parsed = trace_parse_line(line, &event);
+        if (parsed < 0) {
+            LOG_ERROR("%s:%d: malformed trace event", path, line_no);
+            ret = HYPRLAX_ERROR_INVALID_ARGS;
+            break;
+        }
+        if (parsed == 0) continue;
+        ret = trace_append(trace, &event);
+        if (ret != HYPRLAX_SUCCESS) break;
+    }
+    fclose(f);
+
+    if (ret != HYPRLAX_SUCCESS) {
+        trace_free(trace);
+        return ret;
+    }
+
+    /* Stable insertion sort: traces are recorded nearly in order */
+    for (int i = 1; i < trace->count; i++) {
+        trace_event_t key = trace->events[i];
+        int j = i - 1;
+        while (j >= 0 && trace->events[j].time > key.time) {
+            trace->events[j + 1] = trace->events[j];
+            j--;
+        }
+        trace->events[j + 1] = key;
+    }
+    return HYPRLAX_SUCCESS;
+}
+
+void trace_free(trace_t *trace) {
+    if (!trace) return;
+    free(trace->events);
+    memset(trace, 0, sizeof(*trace));
+}
@@ -0,0 +1,216 @@
+/*
+ * virtual_texture.c - Images drawn from a grid of streamed tiles
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/virtual_texture.h"
+#include "../include/renderer.h"
+#include "../include/defaults.h"
+#include "../include/log.h"
+
+typedef struct {
+    uint32_t texture;           /* 0 = not resident */
+    bool ready;                 /* Upload complete */
+    uint64_t wanted;            /* Stamp of the last request covering it */
+} vt_tile_t;
+
+struct virtual_texture {
+    virtual_texture_grid_t grid;
+    uint8_t *pixels;
+    vt_tile_t *tiles;
+    uint32_t *ids;              /* Drawable texture per tile */
+    uint64_t resident_bytes;
+};
+
+virtual_texture_t *virtual_texture_create(uint8_t *rgba, int width, int height, int tile_size) {
+    if (!rgba || width <= 0 || height <= 0 || tile_size <= 0) return NULL;
+    virtual_texture_t *vt = calloc(1, sizeof(*vt));
+    if (!vt) return NULL;
+    vt->grid.width = width;
+    vt->grid.height = height;
+    vt->grid.tile_size = tile_size;
+    vt->grid.cols = (width + tile_size - 1) / tile_size;
+    vt->grid.rows = (height + tile_size - 1) / tile_size;
+    vt->grid.gutter = HYPRLAX_TILE_GUTTER;
+    int count = vt->grid.cols * vt->grid.rows;
+    vt->tiles = calloc((size_t)count, sizeof(*vt->tiles));
+    vt->ids = calloc((size_t)count, sizeof(*vt->ids));
+    if (!vt->tiles || !vt->ids) {
+        free(vt->tiles);
+        free(vt->ids);
+        free(vt);
+        return NULL;
+    }
+    vt->pixels = rgba;
+    return vt;
+}
+
+static uint64_t vt_tile_bytes(const virtual_texture_t *vt, int index) {
+    int rect[4];
+    virtual_texture_tile_rect(&vt->grid, index, rect);
+    int g = vt->grid.gutter;
+    return (uint64_t)(rect[2] + 2 * g) * (uint64_t)(rect[3] + 2 * g) * 4u;
+}
+
+static void vt_evict(virtual_texture_t *vt, int index) {
+    vt_tile_t *tile = &vt->tiles[index];
+    if (!tile->texture) return;
+    vt->ids[index] = 0;
+    renderer_delete_texture(tile->texture);
+    tile->texture = 0;
+    tile->ready = false;
+    vt->resident_bytes -= vt_tile_bytes(vt, index);
+}
+
+void virtual_texture_destroy(virtual_texture_t *vt) {
+    if (!vt) return;
+    int count = vt->grid.cols * vt->grid.rows;
+    for (int i = 0; i < count; i++) vt_evict(vt, i);
+    free(vt->pixels);
+    free(vt->tiles);
+    free(vt->ids);
+    free(vt);
+}
+
+const virtual_texture_grid_t *virtual_texture_grid(const virtual_texture_t *vt) {
+    return vt ? &vt->grid : NULL;
+}
+
+void virtual_texture_tile_rect(const virtual_texture_grid_t *grid, int index, int rect[4]) {
+    int col = index % grid->cols;
+    int row = index / grid->cols;
+    rect[0] = col * grid->tile_size;
+    rect[1] = row * grid->tile_size;
+    rect[2] = grid->width - rect[0] < grid->tile_size ? grid->width - rect[0] : grid->tile_size;
+    rect[3] = grid->height - rect[1] < grid->tile_size ? grid->height - rect[1] : grid->tile_size;
+}
+
+const uint32_t *virtual_texture_ids(const virtual_texture_t *vt) {
+    return vt ? vt->ids : NULL;
+}
+
+/* Copy a tile's rows and gutter out of the image (clamped to its edges)
+ * and queue them; false on failure */
+static bool vt_upload(virtual_texture_t *vt, int index) {
+    const virtual_texture_grid_t *g = &vt->grid;
+    int rect[4];
+    virtual_texture_tile_rect(g, index, rect);
+    int x0 = rect[0] - g->gutter, x1 = rect[0] + rect[2] + g->gutter;
+    int y0 = rect[1] - g->gutter, y1 = rect[1] + rect[3] + g->gutter;
+    int width = x1 - x0, height = y1 - y0;
+    /* Inside the image, each row is one copy */
+    int in0 = x0 < 0 ? 0 : x0;
+    int in1 = x1 > g->width ? g->width : x1;
+    size_t row_bytes = (size_t)width * 4;
+    uint8_t *rgba = malloc(row_bytes * (size_t)height);
+    if (!rgba) return false;
+    for (int y = y0; y < y1; y++) {
+        int sy = y < 0 ? 0 : (y >= g->height ? g->height - 1 : y);
+        const uint8_t *src = vt->pixels + (size_t)sy * (size_t)g->width * 4;
+        uint8_t *dst = rgba + (size_t)(y - y0) * row_bytes;
+        memcpy(dst + (size_t)(in0 - x0) * 4, src + (size_t)in0 * 4, (size_t)(in1 - in0) * 4);
+        for (int x = x0; x < in0; x++) memcpy(dst + (size_t)(x - x0) * 4, src, 4);
+        for (int x = in1; x < x1; x++) {
+            memcpy(dst + (size_t)(x - x0) * 4, src + (size_t)(g->width - 1) * 4, 4);
+        }
+    }
+    /* The renderer frees the rows once they are uploaded */
+    uint32_t texture = renderer_queue_texture(rgba, width, height);
+    if (!texture) return false;
+    vt_tile_t *tile = &vt->tiles[index];
+    tile->texture = texture;
+    tile->ready = renderer_texture_ready(texture);
+    if (tile->ready) vt->ids[index] = texture;
+    vt->resident_bytes += (uint64_t)width * (uint64_t)height * 4u;
+    return true;
+}
+
+/* Tiles [first, last] along an axis of n tiles of size s covering [a, b) of extent px */
+static bool vt_span(float a, float b, int px, int s, int n, int *first, int *last) {
+    if (b <= 0.0f || a >= 1.0f || b <= a) return false;
+    float p0 = fmaxf(a, 0.0f) * (float)px;
+    float p1 = fminf(b, 1.0f) * (float)px;
+    *first = (int)floorf(p0) / s;
+    *last = ((int)ceilf(p1) - 1) / s;
+    if (*first < 0) *first = 0;
+    if (*last > n - 1) *last = n - 1;
+    return *first <= *last;
+}
+
+int virtual_texture_request(virtual_texture_t *vt, const float uv[4], uint64_t stamp) {
+    if (!vt || !uv) return 0;
+    const virtual_texture_grid_t *g = &vt->grid;
+    int c0, c1, r0, r1;
+    if (!vt_span(uv[0], uv[2], g->width, g->tile_size, g->cols, &c0, &c1) ||
+        !vt_span(uv[1], uv[3], g->height, g->tile_size, g->rows, &r0, &r1)) {
+        return 0;
+    }
+    int queued = 0;
+    for (int row = r0; row <= r1; row++) {
+        for (int col = c0; col <= c1; col++) {
+            int index = row * g->cols + col;
+            vt->tiles[index].wanted = stamp;
+            if (vt->tiles[index].texture) continue;
+            if (vt_upload(vt, index)) {
+                queued++;
+            } else {
+                LOG_WARN("Could not upload tile %d,%d of a %dx%d image", col, row, g->width, g->height);
+            }
+        }
+    }
+    return queued;
+}
+
+bool virtual_texture_poll(virtual_texture_t *vt, int *pending) {
+    if (pending) *pending = 0;
+    if (!vt) return false;
+    bool changed = false;
+    int count = vt->grid.cols * vt->grid.rows;
+    for (int i = 0; i < count; i++) {
+        vt_tile_t *tile = &vt->tiles[i];
+        if (!tile->texture || tile->ready) continue;
+        if (renderer_texture_ready(tile->texture)) {
+            tile->ready = true;
+            vt->ids[i] = tile->texture;
+            changed = true;
+        } else if (pending) {
+            (*pending)++;
+        }
+    }
+    return changed;
+}
+
+uint64_t virtual_texture_resident_bytes(const virtual_texture_t *vt) {
+    return vt ? vt->resident_bytes : 0;
+}
+
+int virtual_texture_trim(virtual_texture_t *const *vts, int count, uint64_t budget, uint64_t stamp) {
+    uint64_t total = 0;
+    for (int i = 0; i < count; i++) total += virtual_texture_resident_bytes(vts[i]);
+    int evicted = 0;
+    while (total > budget) {
+        /* Least recently wanted tile of any virtual texture */
+        virtual_texture_t *victim = NULL;
+        int victim_index = -1;
+        for (int i = 0; i < count; i++) {
+            virtual_texture_t *vt = vts[i];
+            if (!vt) continue;
+            int tiles = vt->grid.cols * vt->grid.rows;
+            for (int t = 0; t < tiles; t++) {
+                const vt_tile_t *tile = &vt->tiles[t];
+                if (!tile->texture || tile->wanted == stamp) continue;
+                if (!victim || tile->wanted < victim->tiles[victim_index].wanted) {
+                    victim = vt;
+                    victim_index = t;
+                }
+            }
+        }
+        if (!victim) break;
+        total -= vt_tile_bytes(victim, victim_index);
+        vt_evict(victim, victim_index);
+        evicted++;
+    }
+    return evicted;
+}
@@ -245,6 +245,8 @@ static void print_ctl_help(const char *prog) {
     printf("      Show daemon status and statistics\n\n");
     printf("  reload\n");
     printf("      Reload configuration file\n\n");
+    printf("  cache stats|clear\n");
+    printf("      Show or empty the on-disk cache of decoded images\n\n");
     printf("  convert-config <legacy.conf> [dst.toml] [--yes]\n");
     printf("      Convert legacy config to TOML. Doesn't require daemon.\n\n");
 
@@ -418,6 +420,15 @@ static void help_diag(void) {
     printf("  texinfo <id>   Print texture info and basic file checks for a layer (JSON).\n");
 }
 
+static void help_cache(void) {
+    printf("Usage: hyprlax ctl cache stats|clear\n\n");
+    printf("Description:\n  Decoded images are kept under $XDG_CACHE_HOME/hyprlax (render.image_cache MiB)\n");
+    printf("  so that starts and reloads skip decoding.\n\n");
+    printf("Subcommands:\n");
+    printf("  stats   Entries, disk use, and this daemon's hits and misses\n");
+    printf("  clear   Delete every cached image\n");
+}
+
 /* Main entry point for ctl subcommand */
 int hyprlax_ctl_main(int argc, char **argv) {
     if (argc < 2) {
@@ -465,6 +476,7 @@ int hyprlax_ctl_main(int argc, char **argv) {
         else if (!strcmp(cmd, "up") || !strcmp(cmd, "forward")) help_up();
         else if (!strcmp(cmd, "down") || !strcmp(cmd, "backward")) help_down();
         else if (!strcmp(cmd, "diag")) help_diag();
+        else if (!strcmp(cmd, "cache")) help_cache();
         else { printf("Unknown command '%s'. Try: hyprlax ctl help\n", cmd); return 1; }
         return 0;
     }
@@ -487,6 +499,7 @@ int hyprlax_ctl_main(int argc, char **argv) {
             else if (!strcmp(cmd, "up") || !strcmp(cmd, "forward")) help_up();
             else if (!strcmp(cmd, "down") || !strcmp(cmd, "backward")) help_down();
             else if (!strcmp(cmd, "diag")) help_diag();
+            else if (!strcmp(cmd, "cache")) help_cache();
             else print_ctl_help("hyprlax");
             return 0;
         }
@@ -21,6 +21,9 @@
 #include "include/hyprlax_internal.h"
 #include "include/log.h"
 #include "include/renderer.h"
+#include "include/render_thread.h"
+#include "include/decode_pool.h"
+#include "include/texture_registry.h"
 #include "include/compositor.h"
 #include "include/config_toml.h"
 #include "include/wayland_api.h"
@@ -294,6 +297,11 @@ hyprlax_context_t* hyprlax_create(void) {
     ctx->frame_timer_armed = false;
     ctx->debounce_pending = false;
 
+    /* Headless defaults */
+    ctx->headless.frames = HYPRLAX_HEADLESS_DEFAULT_FRAMES;
+    ctx->headless.width = HYPRLAX_DEFAULT_WINDOW_W;
+    ctx->headless.height = HYPRLAX_DEFAULT_WINDOW_H;
+
     return ctx;
 }
 
@@ -305,6 +313,8 @@ void hyprlax_destroy(hyprlax_context_t *ctx) {
 
     /* Clean up configuration */
     config_cleanup(&ctx->config);
+    free(ctx->headless.trace_path);
+    free(ctx->headless.dump_path);
 
     free(ctx);
 }
@@ -328,7 +338,9 @@ int hyprlax_reload_config(hyprlax_context_t *ctx) {
     if (!path || !*path) {
         return HYPRLAX_ERROR_FILE_NOT_FOUND;
     }
-    /* Clear layers */
+    /* Clear layers; textures of images the new config keeps are picked up
+     * again instead of being decoded and uploaded anew */
+    texture_registry_hold(ctx->textures);
     while (ctx->layers) {
         uint32_t id = ctx->layers->id;
         hyprlax_remove_layer(ctx, id);
@@ -337,7 +349,14 @@ int hyprlax_reload_config(hyprlax_context_t *ctx) {
     const char *ext = strrchr(path, '.');
     if (ext && strcasecmp(ext, ".toml") == 0) {
         int rc = config_apply_toml_to_context(ctx, path);
+        /* Queued before the hold ends, with every layer property applied,
+         * so kept images find their old texture */
+        if (rc == HYPRLAX_SUCCESS && ctx->renderer && ctx->renderer->initialized) {
+            hyprlax_load_layer_textures(ctx);
+        }
+        texture_registry_unhold(ctx->textures);
         if (rc == HYPRLAX_SUCCESS) {
+            hyprlax_mark_layers_changed(ctx);
             input_manager_apply_config(&ctx->input, &ctx->config);
             hyprlax_update_cursor_provider(ctx);
             if (ctx->frame_timer_fd >= 0) {
@@ -347,6 +366,7 @@ int hyprlax_reload_config(hyprlax_context_t *ctx) {
         }
         return HYPRLAX_ERROR_INVALID_ARGS;
     }
+    texture_registry_unhold(ctx->textures);
     LOG_ERROR("Legacy config detected (%s). Please convert: hyprlax ctl convert-config %s ~/.config/hyprlax/hyprlax.toml --yes", path, path);
     return HYPRLAX_ERROR_INVALID_ARGS;
 }
@@ -384,7 +404,7 @@ static int parse_arguments(hyprlax_context_t *ctx, int argc, char **argv) {
         {"config", required_argument, 0, 'c'},
         {"debug", no_argument, 0, 'D'},
         {"debug-log", optional_argument, 0, 'L'},
-        {"trace", no_argument, 0, 'T'},
+        {"trace", optional_argument, 0, 'T'},
         {"renderer", required_argument, 0, 'r'},
         {"platform", required_argument, 0, 'p'},
         {"compositor", required_argument, 0, 'C'},
@@ -405,6 +425,10 @@ static int parse_arguments(hyprlax_context_t *ctx, int argc, char **argv) {
         {"accumulate", no_argument, 0, 1040},
         {"trail-strength", required_argument, 0, 1041},
         {"non-interactive", no_argument, 0, 1030},
+        {"headless", no_argument, 0, 1060},
+        {"frames", required_argument, 0, 1061},
+        {"headless-size", required_argument, 0, 1062},
+        {"dump", required_argument, 0, 1063},
         {0, 0, 0, 0}
     };
 
@@ -427,7 +451,8 @@ static int parse_arguments(hyprlax_context_t *ctx, int argc, char **argv) {
                 printf("  -D, --debug               Enable debug output (INFO/DEBUG)\n");
                 printf("  -L, --debug-log[=FILE]    Write debug output to file (default: /tmp/hyprlax-PID.log)\n");
                 printf("      --trace               Enable trace output (most verbose)\n");
-                printf("  -r, --renderer <backend>  Renderer backend (gles2, auto)\n");
+                printf("      --trace=FILE          With --headless: replay events from FILE\n");
+                printf("  -r, --renderer <backend>  Renderer backend (gles3, gles2, software, auto)\n");
                 printf("  -p, --platform <backend>  Platform backend (wayland, auto)\n");
                 printf("  -C, --compositor <backend> Compositor (hyprland, sway, generic, auto)\n");
                 printf("  -V, --vsync               Enable VSync (default: off)\n");
@@ -444,6 +469,12 @@ static int parse_arguments(hyprlax_context_t *ctx, int argc, char **argv) {
                 printf("      --no-tile-x/--no-tile-y  Disable tiling per axis\n");
                 printf("      --margin-px-x <px>    Extra horizontal safe margin (pixels)\n");
                 printf("      --margin-px-y <px>    Extra vertical safe margin (pixels)\n");
+                printf("\nHeadless mode (benchmarks, golden images):\n");
+                printf("      --headless            Render offscreen, no compositor needed\n");
+                printf("      --frames <n>          Frames to render (default: %d)\n", HYPRLAX_HEADLESS_DEFAULT_FRAMES);
+                printf("      --headless-size <WxH> Virtual output size (default: %dx%d)\n",
+                       HYPRLAX_DEFAULT_WINDOW_W, HYPRLAX_DEFAULT_WINDOW_H);
+                printf("      --dump <file.png>     Write the last frame as PNG\n");
                 printf("\nEasing types:\n");
                 printf("  linear, quad, cubic, quart, quint, sine, expo, circ,\n");
                 printf("  back, elastic, bounce, snap\n");
@@ -517,12 +548,26 @@ static int parse_arguments(hyprlax_context_t *ctx, int argc, char **argv) {
                 if (ctx->config.log_level < 3) ctx->config.log_level = 3; /* ensure LOG_DEBUG */
                 break;
 
-            case 'T': /* --trace */
+            case 'T': { /* --trace[=FILE] */
+                /* An event file for headless replay, not a log level; also
+                 * accept "--trace events.log" since images are positional */
+                const char *trace_file = optarg;
+                if (!trace_file && optind < argc && argv[optind][0] != '-') {
+                    const char *ext = strrchr(argv[optind], '.');
+                    if (ext && (!strcmp(ext, ".log") || !strcmp(ext, ".trace") || !strcmp(ext, ".txt"))) {
+                        trace_file = argv[optind++];
+                    }
+                }
+                if (trace_file) {
+                    free(ctx->headless.trace_path);
+                    ctx->headless.trace_path = strdup(trace_file);
+                    break;
+                }
                 ctx->config.debug = true; /* trace implies debug behavior */
                 setenv("HYPRLAX_DEBUG", "1", 1); /* enable legacy debug gating for adapters */
                 setenv("HYPRLAX_TRACE", "1", 1);
                 ctx->config.log_level = 4; /* LOG_TRACE */
-                break;
+                break; }
 
             case 'r':
                 ctx->backends.renderer_backend = optarg;
@@ -636,6 +681,28 @@ static int parse_arguments(hyprlax_context_t *ctx, int argc, char **argv) {
 
             case 1030: /* --non-interactive: handled in early main, ignore here */
                 break;
+
+            case 1060: /* --headless */
+                ctx->headless.enabled = true;
+                break;
+            case 1061: { /* --frames */
+                int n = atoi(optarg);
+                if (n > 0) ctx->headless.frames = n;
+                else LOG_WARN("Invalid frame count: %s", optarg);
+                break; }
+            case 1062: { /* --headless-size */
+                int w = 0, h = 0;
+                if (sscanf(optarg, "%dx%d", &w, &h) == 2 && w > 0 && h > 0) {
+                    ctx->headless.width = w;
+                    ctx->headless.height = h;
+                } else {
+                    LOG_WARN("Invalid headless size: %s (expected WxH)", optarg);
+                }
+                break; }
+            case 1063: /* --dump */
+                free(ctx->headless.dump_path);
+                ctx->headless.dump_path = strdup(optarg);
+                break;
             default:
                 return -1;
         }
@@ -786,14 +853,39 @@ int hyprlax_init_compositor(hyprlax_context_t *ctx) {
     return HYPRLAX_SUCCESS;
 }
 
+/* EGL window surface, or a renderer-owned one (software backend). A
+ * monitor without a platform surface yet is not an error. */
+int hyprlax_create_monitor_surface(hyprlax_context_t *ctx, monitor_instance_t *monitor) {
+    if (!ctx || !ctx->renderer || !monitor) return HYPRLAX_ERROR_INVALID_ARGS;
+    const renderer_ops_t *ops = ctx->renderer->ops;
+
+    if (ops->create_surface) {
+        if (!monitor->wl_surface || monitor->render_surface) return HYPRLAX_SUCCESS;
+        monitor->render_surface = ops->create_surface(monitor->wl_surface,
+                                                      monitor->width * monitor->scale,
+                                                      monitor->height * monitor->scale);
+        if (!monitor->render_surface) return HYPRLAX_ERROR_NO_MEMORY;
+        LOG_DEBUG("Created %s surface for monitor %s", ops->get_name(), monitor->name);
+        return HYPRLAX_SUCCESS;
+    }
+
+    if (!monitor->wl_egl_window || monitor->egl_surface) return HYPRLAX_SUCCESS;
+    monitor->egl_surface = gles2_create_monitor_surface(monitor->wl_egl_window);
+    if (!monitor->egl_surface) return HYPRLAX_ERROR_GL_INIT;
+    LOG_DEBUG("Created EGL surface for monitor %s", monitor->name);
+    return HYPRLAX_SUCCESS;
+}
+
 /* Initialize renderer module */
 int hyprlax_init_renderer(hyprlax_context_t *ctx) {
     if (!ctx || !ctx->platform) return HYPRLAX_ERROR_INVALID_ARGS;
 
-    /* Determine renderer backend */
+    /* Determine renderer backend: auto prefers OpenGL ES 3.0, and both auto
+     * and gles3 fall back to OpenGL ES 2.0 when no ES3 context is available */
     const char *backend = ctx->backends.renderer_backend;
-    if (strcmp(backend, "auto") == 0) {
-        backend = "gles2";  /* Default to OpenGL ES 2.0 */
+    bool es2_fallback = strcmp(backend, "auto") == 0 || strcmp(backend, "gles3") == 0;
+    if (es2_fallback) {
+        backend = "gles3";
     }
 
     /* Create renderer instance */
@@ -824,7 +916,16 @@ int hyprlax_init_renderer(hyprlax_context_t *ctx) {
     void *native_display = PLATFORM_GET_NATIVE_DISPLAY(ctx->platform);
     void *native_window = PLATFORM_GET_NATIVE_WINDOW(ctx->platform);
 
+    renderer_set_options(&ctx->config.render_options);
     ret = RENDERER_INIT(ctx->renderer, native_display, native_window, &render_config);
+    if (ret != HYPRLAX_SUCCESS && es2_fallback) {
+        LOG_INFO("OpenGL ES 3.0 unavailable, falling back to OpenGL ES 2.0");
+        renderer_destroy(ctx->renderer);
+        ctx->renderer = NULL;
+        ret = renderer_create(&ctx->renderer, "gles2");
+        if (ret != HYPRLAX_SUCCESS) return ret;
+        ret = RENDERER_INIT(ctx->renderer, native_display, native_window, &render_config);
+    }
     if (ret != HYPRLAX_SUCCESS) {
         LOG_ERROR("Failed to initialize renderer");
         renderer_destroy(ctx->renderer);
@@ -836,8 +937,11 @@ int hyprlax_init_renderer(hyprlax_context_t *ctx) {
      * can create textures. Previously this flag was never set, which
      * prevented textures for IPC-added layers from being loaded. */
     ctx->renderer->initialized = true;
+    ctx->nonblocking_present =
+        (ctx->renderer->ops->get_capabilities() & RENDERER_CAP_NONBLOCKING_PRESENT) != 0;
 
-    LOG_DEBUG("Renderer: %s", ctx->renderer->ops->get_name());
+    LOG_DEBUG("Renderer: %s (%s present)", ctx->renderer->ops->get_name(),
+              ctx->nonblocking_present ? "non-blocking" : "blocking");
 
     return HYPRLAX_SUCCESS;
 }
@@ -915,6 +1019,12 @@ int hyprlax_init(hyprlax_context_t *ctx, int argc, char **argv) {
             if (!strcasecmp(v, "1") || !strcasecmp(v, "true") || !strcasecmp(v, "on")) ctx->config.vsync = true;
             else if (!strcasecmp(v, "0") || !strcasecmp(v, "false") || !strcasecmp(v, "off")) ctx->config.vsync = false;
         }
+        v = getenv("HYPRLAX_RENDER_THREADED");
+        if (v && *v) {
+            if (!strcasecmp(v, "1") || !strcasecmp(v, "true") || !strcasecmp(v, "on")) ctx->config.render_threaded = true;
+            else if (!strcasecmp(v, "0") || !strcasecmp(v, "false") || !strcasecmp(v, "off")) ctx->config.render_threaded = false;
+        }
+        render_options_apply_env(&ctx->config.render_options);
         v = getenv("HYPRLAX_RENDER_TILE_X");
         if (v && *v) {
             if (!strcasecmp(v, "1") || !strcasecmp(v, "true") || !strcasecmp(v, "on")) ctx->config.render_tile_x = 1;
@@ -1084,6 +1194,13 @@ int hyprlax_init(hyprlax_context_t *ctx, int argc, char **argv) {
             ctx->monitor_mode == MULTI_MON_ALL ? "ALL" :
             ctx->monitor_mode == MULTI_MON_PRIMARY ? "PRIMARY" : "SPECIFIC");
 
+    /* Headless replay needs neither IPC nor a window system */
+    if (ctx->headless.enabled) {
+        LOG_INFO("[INIT] Headless mode: %dx%d, %d frames",
+                 ctx->headless.width, ctx->headless.height, ctx->headless.frames);
+        return hyprlax_init_headless(ctx);
+    }
+
     /* 1. Initialize IPC server first to check for existing instances */
     if (ctx->config.ipc_enabled) {
         LOG_INFO("[INIT] Step 1: Initializing IPC");
@@ -1149,8 +1266,8 @@ int hyprlax_init(hyprlax_context_t *ctx, int argc, char **argv) {
         return ret;
     }
 
-    /* 6. Create EGL surfaces for all monitors now that renderer exists */
-    LOG_INFO("[INIT] Step 6: Creating EGL surfaces for monitors");
+    /* 6. Create render surfaces for all monitors now that renderer exists */
+    LOG_INFO("[INIT] Step 6: Creating render surfaces for monitors");
     /* Ensure monitors are realized if outputs are already known */
     if (ctx->platform && ctx->platform->ops && ctx->platform->ops->realize_monitors) {
         ctx->platform->ops->realize_monitors();
@@ -1158,13 +1275,8 @@ int hyprlax_init(hyprlax_context_t *ctx, int argc, char **argv) {
     if (ctx->monitors) {
         monitor_instance_t *monitor = ctx->monitors->head;
         while (monitor) {
-            if (monitor->wl_egl_window && !monitor->egl_surface) {
-                monitor->egl_surface = gles2_create_monitor_surface(monitor->wl_egl_window);
-                if (monitor->egl_surface) {
-                    LOG_DEBUG("Created EGL surface for monitor %s", monitor->name);
-                } else {
-                    LOG_ERROR("Failed to create EGL surface for monitor %s", monitor->name);
-                }
+            if (hyprlax_create_monitor_surface(ctx, monitor) != HYPRLAX_SUCCESS) {
+                LOG_ERROR("Failed to create render surface for monitor %s", monitor->name);
             }
             monitor = monitor->next;
         }
@@ -1184,6 +1296,11 @@ int hyprlax_init(hyprlax_context_t *ctx, int argc, char **argv) {
     /* 8. Setup epoll/timerfd event loop */
     hyprlax_setup_epoll(ctx);
 
+    /* 9. Optionally hand drawing and presenting to a render thread */
+    if (ctx->config.render_threaded) {
+        render_thread_start(ctx);
+    }
+
     ctx->state = APP_STATE_RUNNING;
     ctx->running = true;
 
@@ -1213,20 +1330,16 @@ int hyprlax_add_layer(hyprlax_context_t *ctx, const char *image_path,
     /* Apply global scale factor from config (already has good default from layer_create) */
     new_layer->content_scale = ctx->config.scale_factor;
     new_layer->scale_is_custom = false;
+    new_layer->blur_amount = blur;
 
-    /* Load texture if OpenGL is initialized */
+    /* Config and IPC set fit, overflow, tiling and shifts after this, and
+     * the texture's crop, downscale and sharing key follow from them: the
+     * image is queued on the next frame. It decodes on the decode pool and
+     * uploads over the frames after, and the layer shows up once both are
+     * complete. */
     if (ctx->renderer && ctx->renderer->initialized) {
-        int img_width, img_height;
-        GLuint texture = load_texture(image_path, &img_width, &img_height);
-        if (texture != 0) {
-            new_layer->texture_id = texture;
-            new_layer->width = img_width;
-            new_layer->height = img_height;
-            new_layer->texture_width = img_width;
-            new_layer->texture_height = img_height;
-        }
+        ctx->texture_loads = true;
     }
-    new_layer->blur_amount = blur;
 
     /* Assign default z-index if not explicitly set elsewhere:
      * - First layer is assigned z=0
@@ -1240,6 +1353,7 @@ int hyprlax_add_layer(hyprlax_context_t *ctx, const char *image_path,
 
     ctx->layers = layer_list_add(ctx->layers, new_layer);
     ctx->layer_count = layer_list_count(ctx->layers);
+    hyprlax_mark_layers_changed(ctx);
 
     LOG_DEBUG("Added layer: %s (shift=%.1f, opacity=%.1f, blur=%.1f)",
                 image_path, shift_multiplier, opacity, blur);
@@ -1247,19 +1361,43 @@ int hyprlax_add_layer(hyprlax_context_t *ctx, const char *image_path,
     return HYPRLAX_SUCCESS;
 }
 
+/* Id lookup through the layer store's index */
+static parallax_layer_t* hyprlax_find_layer(hyprlax_context_t *ctx, uint32_t layer_id) {
+    if (layer_store_refresh(&ctx->layer_store, ctx->layers) != HYPRLAX_SUCCESS) {
+        return layer_list_find(ctx->layers, layer_id);
+    }
+    return layer_store_find(&ctx->layer_store, layer_id);
+}
+
 /* Remove a layer by ID */
 void hyprlax_remove_layer(hyprlax_context_t *ctx, uint32_t layer_id) {
     if (!ctx) return;
-    /* Find layer to allow GL cleanup */
-    parallax_layer_t *layer = layer_list_find(ctx->layers, layer_id);
+    /* Find layer to allow texture cleanup; shared textures stay while
+     * another layer uses them */
+    parallax_layer_t *layer = hyprlax_find_layer(ctx, layer_id);
     if (layer && layer->texture_id != 0) {
-        GLuint tid = (GLuint)layer->texture_id;
-        glDeleteTextures(1, &tid);
+        texture_registry_release(ctx->textures, layer->texture_id);
         layer->texture_id = 0;
     }
+    if (layer && layer->pending.texture != 0) {
+        texture_registry_release(ctx->textures, layer->pending.texture);
+        layer->pending.texture = 0;
+    }
+    if (layer && layer->decode_ticket) {
+        /* Still decoding: drop it rather than upload an orphan */
+        decode_pool_cancel(ctx->decode_pool, layer->decode_ticket);
+        layer->decode_ticket = 0;
+    }
+    if (layer) {
+        virtual_texture_destroy(layer->tiles);
+        virtual_texture_destroy(layer->pending.tiles);
+        layer->tiles = layer->pending.tiles = NULL;
+        layer->tile_ids = NULL;
+    }
     /* Remove from linked list and update count */
     ctx->layers = layer_list_remove(ctx->layers, layer_id);
     ctx->layer_count = layer_list_count(ctx->layers);
+    hyprlax_mark_layers_changed(ctx);
 }
 
 /* moved to core/render_core.c: hyprlax_load_layer_textures */
@@ -1317,16 +1455,11 @@ void hyprlax_handle_workspace_change(hyprlax_context_t *ctx, int new_workspace)
            target_x, target_y, shift_pixels, ctx->config.shift_percent);
 
     /* Update all layers with animation */
-    parallax_layer_t *layer = ctx->layers;
-    while (layer) {
-        float layer_target_x = target_x * layer->shift_multiplier;
-        float layer_target_y = target_y * layer->shift_multiplier;
-
-        layer_update_offset(layer, layer_target_x, layer_target_y,
-                          ctx->config.animation_duration,
-                          ctx->config.default_easing);
-
-        layer = layer->next;
+    layer_store_t *store = &ctx->layer_store;
+    layer_store_refresh(store, ctx->layers);
+    for (int i = 0; i < store->count; i++) {
+        layer_store_animate_to(store, i, target_x * store->shift[i], target_y * store->shift[i],
+                               ctx->config.animation_duration, ctx->config.default_easing);
     }
 
     ctx->workspace_offset_x = target_x;
@@ -1358,16 +1491,11 @@ void hyprlax_handle_workspace_change_2d(hyprlax_context_t *ctx,
            target_x, target_y, shift_pixels, ctx->config.shift_percent);
 
     /* Update all layers with animation for both axes */
-    parallax_layer_t *layer = ctx->layers;
-    while (layer) {
-        float layer_target_x = target_x * layer->shift_multiplier;
-        float layer_target_y = target_y * layer->shift_multiplier;
-
-        layer_update_offset(layer, layer_target_x, layer_target_y,
-                          ctx->config.animation_duration,
-                          ctx->config.default_easing);
-
-        layer = layer->next;
+    layer_store_t *store = &ctx->layer_store;
+    layer_store_refresh(store, ctx->layers);
+    for (int i = 0; i < store->count; i++) {
+        layer_store_animate_to(store, i, target_x * store->shift[i], target_y * store->shift[i],
+                               ctx->config.animation_duration, ctx->config.default_easing);
     }
 
     ctx->workspace_offset_x = target_x;
@@ -1380,13 +1508,19 @@ void hyprlax_handle_workspace_change_2d(hyprlax_context_t *ctx,
 void hyprlax_update_layers(hyprlax_context_t *ctx, double current_time) {
     if (!ctx) return;
 
-    parallax_layer_t *layer = ctx->layers;
-    while (layer) {
-        layer_tick(layer, current_time);
-        layer = layer->next;
+    layer_store_refresh(&ctx->layer_store, ctx->layers);
+    if (layer_store_tick(&ctx->layer_store, current_time)) {
+        monitor_list_mark_dirty(ctx->monitors);
     }
 }
 
+void hyprlax_mark_layers_changed(hyprlax_context_t *ctx) {
+    if (!ctx) return;
+    layer_store_invalidate(&ctx->layer_store);
+    monitor_list_mark_layers_changed(ctx->monitors);
+    ctx->texture_fit_dirty = true;
+}
+
 /* hyprlax_render_frame moved to core/render_core.c */
 
 /* has_active_animations removed (handled in core/event_loop.c) */
@@ -1394,12 +1528,25 @@ void hyprlax_update_layers(hyprlax_context_t *ctx, double current_time) {
 /* no-op (run loop lives in core/event_loop.c) */
 
 /* Handle resize */
+typedef struct {
+    const renderer_ops_t *ops;
+    int width, height;
+} resize_job_t;
+
+static void resize_job(void *arg) {
+    resize_job_t *job = arg;
+    job->ops->resize(job->width, job->height);
+}
+
 void hyprlax_handle_resize(hyprlax_context_t *ctx, int width, int height) {
     if (!ctx || !ctx->renderer) return;
 
     if (ctx->renderer->ops->resize) {
-        ctx->renderer->ops->resize(width, height);
+        /* On the render thread when there is one */
+        resize_job_t job = { ctx->renderer->ops, width, height };
+        renderer_run(resize_job, &job);
     }
+    hyprlax_mark_layers_changed(ctx);
 
     if (ctx->config.debug) {
         LOG_INFO("Window resized: %dx%d", width, height);
@@ -1413,16 +1560,29 @@ void hyprlax_shutdown(hyprlax_context_t *ctx) {
     ctx->state = APP_STATE_SHUTTING_DOWN;
     ctx->running = false;
 
+    /* The render thread draws from layers and outputs freed below */
+    render_thread_stop(ctx);
+    /* Decodes in flight would hand their images to freed layers */
+    hyprlax_stop_texture_decodes(ctx);
+
     /* Close event loop FDs first */
     if (ctx->frame_timer_fd >= 0) { close(ctx->frame_timer_fd); ctx->frame_timer_fd = -1; }
     if (ctx->debounce_timer_fd >= 0) { close(ctx->debounce_timer_fd); ctx->debounce_timer_fd = -1; }
     if (ctx->epoll_fd >= 0) { close(ctx->epoll_fd); ctx->epoll_fd = -1; }
 
     /* Destroy layers */
+    layer_store_destroy(&ctx->layer_store);
     if (ctx->layers) {
+        /* Tiles hold the decoded images of streamed layers */
+        for (parallax_layer_t *l = ctx->layers; l; l = l->next) {
+            virtual_texture_destroy(l->tiles);
+            virtual_texture_destroy(l->pending.tiles);
+        }
         layer_list_destroy(ctx->layers);
         ctx->layers = NULL;
     }
+    texture_registry_destroy(ctx->textures);
+    ctx->textures = NULL;
 
     input_manager_destroy(&ctx->input);
 
@@ -1434,8 +1594,13 @@ void hyprlax_shutdown(hyprlax_context_t *ctx) {
         ctx->ipc_ctx = NULL;
     }
 
-    /* Renderer */
+    /* Renderer; outputs give back their targets while it is still current */
     if (ctx->renderer) {
+        if (ctx->monitors) {
+            for (monitor_instance_t *m = ctx->monitors->head; m; m = m->next) {
+                hyprlax_render_release_output(ctx, m);
+            }
+        }
         renderer_destroy(ctx->renderer);
         ctx->renderer = NULL;
     }
@@ -1472,6 +1637,9 @@ static bool parse_bool(const char *v) {
 
 int hyprlax_runtime_set_property(hyprlax_context_t *ctx, const char *property, const char *value) {
     if (!ctx || !property || !value) return -1;
+    /* Any property can change what the outputs show; unchanged frames are
+     * still dropped by the per-monitor frame hash in the render pass. */
+    hyprlax_mark_layers_changed(ctx);
 
     /* Per-layer property: layer.<id>.* */
     if (strncmp(property, "layer.", 6) == 0) {
@@ -1480,35 +1648,23 @@ int hyprlax_runtime_set_property(hyprlax_context_t *ctx, const char *property, c
         long lid = strtol(p, &endptr, 10);
         if (lid <= 0 || !endptr || *endptr != '.') return -1;
         const char *leaf = endptr + 1;
-        parallax_layer_t *layer = layer_list_find(ctx->layers, (uint32_t)lid);
+        parallax_layer_t *layer = hyprlax_find_layer(ctx, (uint32_t)lid);
         if (!layer) return -1;
         if (strcmp(leaf, "hidden") == 0) { layer->hidden = parse_bool_local(value); return 0; }
         if (strcmp(leaf, "path") == 0) {
             /* Update image path and reload texture if renderer is active */
             char *newpath = strdup(value);
             if (!newpath) return -1;
-            /* Attempt to load texture first to avoid losing old path on failure */
-            GLuint new_tex = 0; int w=0, h=0;
-            if (ctx->renderer && ctx->renderer->initialized) {
-                extern GLuint load_texture(const char *path, int *width, int *height); /* forward decl */
-                new_tex = load_texture(newpath, &w, &h);
-                if (new_tex == 0) { free(newpath); return -1; }
+            /* Attempt to load texture first to avoid losing old path on
+             * failure; the old image stays up until the new one is uploaded */
+            if (ctx->renderer && ctx->renderer->initialized &&
+                hyprlax_queue_layer_texture(ctx, layer, newpath) != HYPRLAX_SUCCESS) {
+                free(newpath);
+                return -1;
             }
             /* Replace path */
             if (layer->image_path) free(layer->image_path);
             layer->image_path = newpath;
-            /* Swap texture */
-            if (ctx->renderer && ctx->renderer->initialized) {
-                if (layer->texture_id) {
-                    GLuint tid = (GLuint)layer->texture_id;
-                    glDeleteTextures(1, &tid);
-                }
-                layer->texture_id = new_tex;
-                layer->width = w;
-                layer->height = h;
-                layer->texture_width = w;
-                layer->texture_height = h;
-            }
             return 0;
         }
         if (strcmp(leaf, "blur") == 0) { layer->blur_amount = atof(value); return 0; }
@@ -1628,6 +1784,17 @@ int hyprlax_runtime_set_property(hyprlax_context_t *ctx, const char *property, c
     if (strcmp(property, "render.tile.y") == 0) { ctx->config.render_tile_y = parse_bool_local(value) ? 1 : 0; return 0; }
     if (strcmp(property, "render.margin_px.x") == 0) { ctx->config.render_margin_px_x = atof(value); return 0; }
     if (strcmp(property, "render.margin_px.y") == 0) { ctx->config.render_margin_px_y = atof(value); return 0; }
+    /* Renderer tuning switches: render.<name> from render_options.h */
+    if (strncmp(property, "render.", 7) == 0) {
+        if (render_options_set(&ctx->config.render_options, property + 7, value) != 0) return -1;
+        if (ctx->renderer) {
+            renderer_set_options(&ctx->config.render_options);
+            /* render.blocking_present switches how outputs are paced */
+            ctx->nonblocking_present =
+                (ctx->renderer->ops->get_capabilities() & RENDERER_CAP_NONBLOCKING_PRESENT) != 0;
+        }
+        return 0;
+    }
     return -1;
 }
 
@@ -1639,7 +1806,7 @@ int hyprlax_runtime_get_property(hyprlax_context_t *ctx, const char *property, c
         const char *p = property + 6; char *end=NULL; long lid=strtol(p,&end,10);
         if (lid <= 0 || !end || *end != '.') return -1;
         const char *leaf = end+1;
-        parallax_layer_t *layer = layer_list_find(ctx->layers, (uint32_t)lid);
+        parallax_layer_t *layer = hyprlax_find_layer(ctx, (uint32_t)lid);
         if (!layer) return -1;
         if (strcmp(leaf, "hidden") == 0) { W("%s", layer->hidden?"true":"false"); return 0; }
         if (strcmp(leaf, "blur") == 0) { W("%.2f", layer->blur_amount); return 0; }
@@ -1719,6 +1886,9 @@ int hyprlax_runtime_get_property(hyprlax_context_t *ctx, const char *property, c
     if (strcmp(property, "render.tile.y") == 0) { W("%s", ctx->config.render_tile_y?"true":"false"); return 0; }
     if (strcmp(property, "render.margin_px.x") == 0) { W("%.1f", ctx->config.render_margin_px_x); return 0; }
     if (strcmp(property, "render.margin_px.y") == 0) { W("%.1f", ctx->config.render_margin_px_y); return 0; }
+    if (strncmp(property, "render.", 7) == 0) {
+        return render_options_get(&ctx->config.render_options, property + 7, out, out_size);
+    }
     #undef W
     return -1;
 }
@@ -9,6 +9,8 @@
 #define HYPRLAX_CORE_H
 
 #include "hyprlax_internal.h"
+#include "render_options.h"
+#include "virtual_texture.h"
 
 /* Easing function types */
 typedef enum {
@@ -47,6 +49,20 @@ typedef enum {
     LAYER_FIT_HEIGHT         /* Fit height exactly; crop or letterbox horizontally */
 } layer_fit_mode_t;
 
+/* Image whose upload is still running in bands (renderer_queue_texture);
+ * it replaces the layer's texture, size and alpha coverage once complete */
+typedef struct {
+    uint32_t texture;             /* 0 = nothing in flight */
+    int width;
+    int height;
+    int source_width;
+    int source_height;
+    float crop[4];
+    struct virtual_texture *tiles; /* Tiled image; texture is its fallback */
+    bool opaque;
+    int alpha_bbox[4];
+} layer_pending_texture_t;
+
 /* Layer definition - temporarily named differently to avoid conflict with ipc.h */
 typedef struct parallax_layer {
     uint32_t id;
@@ -86,10 +102,20 @@ typedef struct parallax_layer {
     int current_frame;
     double last_frame_time;
     void *gif_data; /* Opaque pointer to gd_GIF */
-    int width;       /* Texture width */
-    int height;      /* Texture height */
-    int texture_width;
+    int width;       /* Image width */
+    int height;      /* Image height */
+    int texture_width;            /* Texture size: the image downscaled and cropped on load */
     int texture_height;
+    float crop[4];                /* Image UV window the texture holds {u0, v0, u1, v1}; all 0 = whole */
+    /* Tiled (virtual) texture: texture_id is a low-resolution fallback of
+     * the whole texture, drawn until the tiles an output shows are resident */
+    struct virtual_texture *tiles; /* Main thread; NULL = one texture */
+    virtual_texture_grid_t tile_grid;
+    const uint32_t *tile_ids;     /* Drawable texture per tile (0 = not resident) */
+    bool opaque;                  /* Every texel (every GIF frame) has alpha 255 */
+    int alpha_bbox[4];            /* Texels with alpha > 0: {x, y, w, h}, top-left origin */
+    layer_pending_texture_t pending; /* Next image, not yet drawable */
+    uint32_t decode_ticket;       /* Image decoding on the decode pool (0 = none) */
 
     layer_fit_mode_t fit_mode;
     float content_scale;          /* Additional scale multiplier (1.0 = no change) */
@@ -116,6 +142,35 @@ typedef struct parallax_layer {
     struct parallax_layer *next;
 } parallax_layer_t;
 
+/* Structure-of-arrays mirror of the layer list. The list owns every layer
+ * (paths, textures, render params); the store packs the state touched on
+ * every tick into contiguous arrays, in list (z) order, plus an id -> slot
+ * index. Both axes of a layer animate with one start/duration/easing. */
+typedef struct layer_store {
+    int count;
+    int capacity;
+    bool valid;                       /* false: rebuild from the list */
+    parallax_layer_t **layers;        /* Slot -> owning list node */
+    uint32_t *ids;
+    float *current_x;
+    float *current_y;
+    float *shift;                     /* Legacy scalar multiplier */
+    float *shift_x;
+    float *shift_y;
+    float *aspect;                    /* Image height / width (1 if unknown) */
+    float *from_x;
+    float *from_y;
+    float *to_x;
+    float *to_y;
+    double *start;                    /* < 0: starts on first tick */
+    double *duration;
+    uint8_t *easing;                  /* easing_type_t */
+    uint8_t *active;
+    int active_count;                 /* Slots with a running animation */
+    int animated_gif_count;           /* Multi-frame GIF layers */
+    int32_t *index;                   /* Open addressing; -1 = empty */
+    int index_size;                   /* Power of two, >= 2 * count */
+} layer_store_t;
 
 /* Configuration structure */
 typedef struct {
@@ -168,6 +223,8 @@ typedef struct {
     /* Trails/accumulation effect */
     bool render_accumulate;       /* if true, accumulate previous frames */
     float render_trail_strength;  /* 0..1 fade amount per frame when accumulating */
+    bool render_threaded;         /* draw and present on a dedicated render thread */
+    render_options_t render_options; /* renderer tuning switches (render.<name>) */
 
     /* Cursor input configuration */
     float cursor_sensitivity_x;       /* multiplier on normalized input */
@@ -224,6 +281,18 @@ void layer_destroy(parallax_layer_t *layer);
 void layer_update_offset(parallax_layer_t *layer, float target_x, float target_y,
                         double duration, easing_type_t easing);
 void layer_tick(parallax_layer_t *layer, double current_time);
+void layer_analyze_alpha(const uint8_t *rgba, int width, int height,
+                         bool *opaque, int bbox[4]);
+
+/* Image processing */
+/* Resample RGBA8 pixels (alpha-weighted box pyramid, then Lanczos-3) into a
+ * new out_width x out_height buffer released with free; NULL on failure */
+uint8_t *image_resample_rgba(const uint8_t *rgba, int width, int height,
+                             int out_width, int out_height);
+/* Run the resampler's inner loops on an instruction set (scalar, sse2,
+ * avx2), or NULL for the widest the CPU has; returns the name of the set
+ * in use, NULL if isa is not available. Every set gives the same pixels. */
+const char *image_resample_use(const char *isa);
 
 /* Layer list management */
 parallax_layer_t* layer_list_add(parallax_layer_t *head, parallax_layer_t *new_layer);
@@ -233,6 +302,17 @@ void layer_list_destroy(parallax_layer_t *head);
 int layer_list_count(parallax_layer_t *head);
 parallax_layer_t* layer_list_sort_by_z(parallax_layer_t *head);
 
+/* Layer store (hot-state arrays over the list) */
+void layer_store_destroy(layer_store_t *store);
+void layer_store_invalidate(layer_store_t *store);
+int layer_store_refresh(layer_store_t *store, parallax_layer_t *head);
+int layer_store_slot(const layer_store_t *store, uint32_t layer_id);
+parallax_layer_t* layer_store_find(const layer_store_t *store, uint32_t layer_id);
+void layer_store_animate_to(layer_store_t *store, int slot, float target_x, float target_y,
+                            double duration, easing_type_t easing);
+bool layer_store_tick(layer_store_t *store, double current_time);
+bool layer_store_animating(const layer_store_t *store);
+
 /* Configuration parsing */
 int config_parse_args(config_t *cfg, int argc, char **argv);
 int config_load_file(config_t *cfg, const char *path);
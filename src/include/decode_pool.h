@@ -0,0 +1,49 @@
+/*
+ * decode_pool.h - Worker threads for image decoding
+ *
+ * Decoding and resampling a large image takes long enough to stall
+ * animation and IPC, so image loads run here instead. Jobs are opaque:
+ * run() executes on a worker, and the finished job is handed back to the
+ * main thread by decode_pool_take(), which does the GL half (uploads go
+ * through the renderer, and so to the render thread when there is one).
+ *
+ * Each job has a ticket. Cancelling one that has not started drops it at
+ * once; one that is running finishes, then is discarded instead of being
+ * handed back. Finished jobs signal an eventfd the main loop can wait on.
+ *
+ * Submit, take, cancel and wait are main-thread only.
+ */
+
+#ifndef HYPRLAX_DECODE_POOL_H
+#define HYPRLAX_DECODE_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct decode_pool decode_pool_t;
+
+typedef void (*decode_pool_fn)(void *arg);
+
+/* threads workers (at least 1); NULL on failure */
+decode_pool_t *decode_pool_create(int threads);
+/* Cancels every job, joins the workers and discards what they hand back */
+void decode_pool_destroy(decode_pool_t *pool);
+
+int decode_pool_threads(const decode_pool_t *pool);
+/* Readable while finished jobs wait to be taken (EFD_NONBLOCK) */
+int decode_pool_event_fd(const decode_pool_t *pool);
+
+/* Queue run(arg) on a worker; discard(arg) releases a job that is
+ * cancelled or never taken. Returns its ticket (never 0), or 0 on failure. */
+uint32_t decode_pool_submit(decode_pool_t *pool, decode_pool_fn run, decode_pool_fn discard, void *arg);
+/* Oldest finished job, in completion order; NULL if there is none. The
+ * caller owns arg from here on. */
+void *decode_pool_take(decode_pool_t *pool, uint32_t *ticket);
+/* Drop a job; false if the ticket is unknown or already taken */
+bool decode_pool_cancel(decode_pool_t *pool, uint32_t ticket);
+/* Block until no job is queued or running */
+void decode_pool_wait(decode_pool_t *pool);
+/* Jobs queued, running or finished but not yet taken */
+int decode_pool_pending(const decode_pool_t *pool);
+
+#endif /* HYPRLAX_DECODE_POOL_H */
@@ -8,6 +8,9 @@
 /* Frame & FPS */
 #define HYPRLAX_DEFAULT_FPS 60
 #define HYPRLAX_MAX_ALLOWED_FPS 999
+#define HYPRLAX_FRAME_CLOCK_SMOOTHING 0.1  /* weight of a new refresh interval sample */
+#define HYPRLAX_FRAME_CLOCK_IDLE_GAP 4.0   /* intervals between presents that count as idle */
+#define HYPRLAX_RENDER_THREAD_RETRY_MS 1   /* render thread re-poll while the GPU is busy */
 
 /* Shift & scaling defaults */
 #define HYPRLAX_DEFAULT_SHIFT_PERCENT 1.0f
@@ -68,6 +71,39 @@
 #define HYPRLAX_BLUR_WEIGHT_FALLOFF 0.15f
 #define HYPRLAX_SHADER_BUFFER_SIZE 4096
 #define HYPRLAX_FADE_ALPHA_MIN 0.0001f
+#define HYPRLAX_MAX_RENDER_TARGETS 16
+#define HYPRLAX_COMPOSITE_MAX_LAYERS 16    /* layers blended per single-pass draw */
+#define HYPRLAX_GEOMETRY_SLOTS 64         /* quads kept in the persistent vertex buffer */
+#define HYPRLAX_BLUR_DOWNSCALE_MAX 15     /* render.blur_downscale upper bound */
+#define HYPRLAX_KAWASE_MAX_LEVELS 6      /* dual-Kawase blur pyramid depth */
+#define HYPRLAX_KAWASE_MIN_SIZE 8         /* ...smallest level's short side (px) */
+#define HYPRLAX_KAWASE_MAX_OFFSET 4.0f    /* ...tap spread per level before quality drops */
+#define HYPRLAX_BLUR_CACHE_ENTRIES 32     /* blurred layer textures kept */
+#define HYPRLAX_BLUR_CACHE_BUDGET_MB 256  /* ...and the VRAM they may hold */
+#define HYPRLAX_BLUR_CACHE_STALE_FRAMES 120 /* unused this long, a superseded blur is freed */
+#define HYPRLAX_UPLOAD_BUDGET_US 2000     /* render.upload_budget default: image upload time per frame */
+#define HYPRLAX_UPLOAD_BUDGET_MAX_US 100000 /* ...upper bound */
+#define HYPRLAX_UPLOAD_BAND_BYTES (1 << 20) /* rows uploaded per step; smaller images go at once */
+#define HYPRLAX_UPLOAD_QUEUE_MAX 32       /* images with uploads in flight */
+#define HYPRLAX_DOWNSCALE_MIN_SAVING 0.25f /* resample on load only if it drops this share of texels */
+#define HYPRLAX_CROP_MIN_SAVING 0.10f     /* crop on load only if it drops this share of pixels */
+#define HYPRLAX_CROP_MARGIN 0.02f         /* UV kept past the reachable window on each side */
+#define HYPRLAX_TILE_SIZE 2048            /* virtual texture tile edge, in texels (gutters included) */
+#define HYPRLAX_TILE_GUTTER 2             /* texels around each tile copied from its neighbours */
+#define HYPRLAX_TILE_BUDGET_MB 256        /* VRAM for resident tiles (render.tile_budget) */
+#define HYPRLAX_TILE_BUDGET_MAX_MB 65536  /* ...upper bound */
+#define HYPRLAX_TILE_PREFETCH 0.25f       /* share of the shown window streamed in past each edge */
+#define HYPRLAX_DECODE_THREADS 4          /* render.decode_threads default (capped at the CPU count) */
+#define HYPRLAX_DECODE_THREADS_MAX 64     /* ...upper bound */
+#define HYPRLAX_IMAGE_CACHE_MB 1024       /* render.image_cache default: decoded images kept on disk */
+#define HYPRLAX_IMAGE_CACHE_MAX_MB 1048576 /* ...upper bound */
+#define HYPRLAX_GL_STATE_TEXTURES 256     /* textures whose sampler state is shadowed */
+#define HYPRLAX_GL_STATE_UNIFORMS 256     /* program uniforms whose values are shadowed */
+#define HYPRLAX_GL_STATE_UNIFORM_ARRAYS 64 /* ...of which uniform arrays */
+#define HYPRLAX_DAMAGE_HISTORY 4          /* frames of damage kept for buffer age */
+#define HYPRLAX_MAX_PRESENT_SURFACES 16   /* surfaces with swap interval/fence state */
+#define HYPRLAX_SW_BUFFERS 2              /* software renderer: shm buffers per output */
+#define HYPRLAX_SW_MAX_BUFFERS 3          /* ...grown to while the compositor holds both */
 
 /* Sizes and buffers */
 #define HYPRLAX_MONITOR_NAME_MAX 64
@@ -80,6 +116,10 @@
 #define HYPRLAX_DEFAULT_WINDOW_FULLSCREEN 1
 #define HYPRLAX_DEFAULT_WINDOW_BORDERLESS 1
 
+/* Headless replay (--headless) */
+#define HYPRLAX_HEADLESS_DEFAULT_FRAMES 600
+#define HYPRLAX_HEADLESS_MONITOR_NAME "HEADLESS-1"
+
 /* Paths/logging */
 #define HYPRLAX_STDERR_LOG_PATH "/tmp/hyprlax-stderr.log"
 #define HYPRLAX_STARTUP_LOG_PATH "/tmp/hyprlax-exec.log"
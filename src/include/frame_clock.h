@@ -0,0 +1,67 @@
+/*
+ * frame_clock.h - Per-output presentation clock
+ *
+ * Tracks when an output's frames actually reach the screen and predicts
+ * when the next one will, so animations are sampled at the moment the
+ * frame is shown instead of whenever the loop happened to run. Fed by
+ * wp_presentation feedback when the compositor supports it, by frame
+ * callbacks otherwise; without either, predictions fall back to "now".
+ *
+ * All times are seconds on CLOCK_MONOTONIC.
+ */
+
+#ifndef HYPRLAX_FRAME_CLOCK_H
+#define HYPRLAX_FRAME_CLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    FRAME_CLOCK_NONE,           /* No feedback yet: timer pacing */
+    FRAME_CLOCK_CALLBACK,       /* wl_surface.frame done events */
+    FRAME_CLOCK_PRESENTATION,   /* wp_presentation feedback */
+} frame_clock_source_t;
+
+typedef struct {
+    frame_clock_source_t source;
+    double nominal_interval;    /* From the output's refresh rate */
+    double interval;            /* Measured refresh interval (smoothed) */
+    double last_present;        /* Last presentation (or frame done) time */
+    uint64_t last_msc;          /* Refresh counter of last_present (presentation only) */
+    bool has_msc;
+    double pending_target;      /* Prediction the last submitted frame was sampled at */
+
+    /* Totals since startup */
+    uint32_t presented;
+    uint32_t missed;            /* Shown at least half an interval after the prediction */
+    uint32_t discarded;         /* Replaced before reaching the screen */
+
+    /* Present-to-present intervals since the last frame_clock_reset_window() */
+    double interval_sum;
+    uint32_t interval_count;
+} frame_clock_t;
+
+void frame_clock_init(frame_clock_t *clock, int refresh_hz);
+void frame_clock_set_refresh(frame_clock_t *clock, int refresh_hz);
+
+/* A frame sampled at `target` (a frame_clock_predict result) was committed */
+void frame_clock_submitted(frame_clock_t *clock, double target);
+
+/* Presentation feedback: `refresh` is the compositor's interval in seconds
+ * (0 if unknown); msc is the output's refresh counter when has_msc */
+void frame_clock_presented(frame_clock_t *clock, double time, double refresh,
+                           uint64_t msc, bool has_msc);
+void frame_clock_discarded(frame_clock_t *clock);
+/* Frame callback fallback, ignored once presentation feedback arrived */
+void frame_clock_frame_done(frame_clock_t *clock, double time);
+
+/* Predicted time of the first refresh after `now`, or `now` without data */
+double frame_clock_predict(const frame_clock_t *clock, double now);
+/* Refresh interval to use for pacing (measured when known) */
+double frame_clock_interval(const frame_clock_t *clock);
+/* Average measured present interval in the current window, 0 if none */
+double frame_clock_average_interval(const frame_clock_t *clock);
+void frame_clock_reset_window(frame_clock_t *clock);
+const char* frame_clock_source_name(frame_clock_source_t source);
+
+#endif /* HYPRLAX_FRAME_CLOCK_H */
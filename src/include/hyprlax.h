@@ -27,11 +27,45 @@ typedef enum {
 
 /* Backend selection */
 typedef struct {
-    const char *renderer_backend;    /* "gles2", "gl3", "vulkan", "auto" */
+    const char *renderer_backend;    /* "gles3", "gles2", "software", "auto" */
     const char *platform_backend;    /* "wayland", "auto" */
     const char *compositor_backend;  /* "hyprland", "sway", "generic", "auto" */
 } backend_config_t;
 
+/* Render counters accumulated between debug stats lines */
+typedef struct {
+    uint64_t damaged_px;    /* Pixels reported to the compositor as damaged */
+    uint64_t surface_px;    /* Pixels of the surfaces that were presented */
+    uint64_t monitors_skipped; /* Clean monitors the render pass did not redraw */
+    uint64_t monitors_throttled; /* Dirty monitors held back by an in-flight frame */
+    uint64_t outputs_presented; /* Output frames drawn and presented */
+    uint64_t gl_calls;      /* Tracked GL state changes and draws issued */
+    uint64_t gl_calls_elided; /* Redundant state changes the renderer skipped */
+} render_stats_t;
+
+/* Per-output frame inputs, resolved on the main thread before an output
+ * is drawn: its predicted present time and the cursor and window offsets
+ * blended from the input sources, in pixels */
+typedef struct {
+    double present_target;
+    float workspace_weight;
+    float cursor_x, cursor_y;
+    float window_x, window_y;
+} render_inputs_t;
+
+struct render_thread;
+struct decode_pool;
+struct texture_registry;
+
+/* Offscreen replay (--headless), see core/headless.c */
+typedef struct {
+    bool enabled;
+    int frames;             /* frames to render */
+    int width, height;      /* virtual output size */
+    char *trace_path;       /* events to replay (--trace=FILE), or NULL */
+    char *dump_path;        /* PNG of the last frame (--dump), or NULL */
+} headless_options_t;
+
 /* Main application context */
 typedef struct hyprlax_context {
     /* Configuration */
@@ -51,11 +85,16 @@ typedef struct hyprlax_context {
     /* Layers */
     parallax_layer_t *layers;
     int layer_count;
+    layer_store_t layer_store;         /* Hot per-layer state, see layer_store.c */
 
     /* Timing */
     double last_frame_time;
     double delta_time;
     double fps;
+    double frame_target_time;          /* Predicted present time the current frame is sampled at */
+    bool nonblocking_present;          /* Presents do not wait for vblank; outputs are gated by frame callbacks */
+    render_stats_t render_stats;
+    struct render_thread *render_thread; /* Draws and presents when render.threaded, see render_thread.h */
 
     /* Multi-monitor support */
     monitor_list_t *monitors;           /* All active monitors */
@@ -101,6 +140,17 @@ typedef struct hyprlax_context {
 
     /* Internal: request an immediate retry render (e.g., pending texture load) */
     bool deferred_render_needed;
+    bool texture_uploads;      /* Some layer has a pending texture */
+    bool texture_fit_dirty;    /* Layers changed: recheck downscaled images */
+    bool texture_loads;        /* Layers added without a texture: load them next frame */
+    uint64_t texture_fit_key;  /* Output sizes the images were last checked against */
+    float workspace_reach_px[2]; /* Largest workspace offset applied so far, per axis */
+    uint64_t tile_stamp;       /* Tile streaming passes so far (virtual texture LRU clock) */
+    struct decode_pool *decode_pool; /* Image decode workers, created on first load */
+    struct texture_registry *textures; /* Layer textures shared by content, created on first load */
+
+    /* Headless replay instead of a window system */
+    headless_options_t headless;
 
 } hyprlax_context_t;
 
@@ -117,11 +167,20 @@ int hyprlax_init_platform(hyprlax_context_t *ctx);
 int hyprlax_init_compositor(hyprlax_context_t *ctx);
 int hyprlax_init_renderer(hyprlax_context_t *ctx);
 
-/* Layer management */
+/* Headless replay: offscreen renderer and virtual output instead of
+ * platform/compositor, then a fixed number of frames on a simulated clock */
+int hyprlax_init_headless(hyprlax_context_t *ctx);
+int hyprlax_run_headless(hyprlax_context_t *ctx);
+
+/* Layer management. A layer added once the renderer is up loads its image
+ * on the next frame (or hyprlax_load_layer_textures), after the caller has
+ * set the properties its texture is planned from. */
 int hyprlax_add_layer(hyprlax_context_t *ctx, const char *image_path,
                      float shift_multiplier, float opacity, float blur);
 void hyprlax_remove_layer(hyprlax_context_t *ctx, uint32_t layer_id);
 void hyprlax_update_layers(hyprlax_context_t *ctx, double current_time);
+/* Layers, their properties or textures changed: rebuild derived state */
+void hyprlax_mark_layers_changed(hyprlax_context_t *ctx);
 
 /* Event handling */
 void hyprlax_handle_workspace_change(hyprlax_context_t *ctx, int new_workspace);
@@ -132,9 +191,39 @@ void hyprlax_handle_resize(hyprlax_context_t *ctx, int width, int height);
 
 /* Rendering */
 void hyprlax_render_frame(hyprlax_context_t *ctx);
+/* The halves of a frame. Main thread: advance easing, GIF frames and input
+ * samples, mark outputs dirty and resolve their inputs. Then, on whichever
+ * thread owns the renderer, draw and present one output; false if it could
+ * not be drawn and stays dirty. */
+void hyprlax_render_prepare(hyprlax_context_t *ctx);
+void hyprlax_render_inputs(hyprlax_context_t *ctx, monitor_instance_t *monitor, render_inputs_t *out);
+bool hyprlax_render_output(hyprlax_context_t *ctx, monitor_instance_t *monitor,
+                           const render_inputs_t *inputs, bool recompile);
+/* Give back the renderer targets an output holds; the context must be current */
+void hyprlax_render_release_output(hyprlax_context_t *ctx, monitor_instance_t *monitor);
+/* A dirty output must wait for its previous frame (non-blocking presents) */
+bool hyprlax_render_blocked(hyprlax_context_t *ctx, monitor_instance_t *monitor);
+/* Create the renderer's surface for a monitor's platform surface */
+int hyprlax_create_monitor_surface(hyprlax_context_t *ctx, monitor_instance_t *monitor);
 int hyprlax_load_layer_textures(hyprlax_context_t *ctx);
-/* Texture loading helper */
+/* Texture loading helpers; the _ex variant records the image's alpha
+ * coverage (opaque flag, alpha bounding box) on the given layer */
 unsigned int load_texture(const char *path, int *width, int *height);
+unsigned int load_texture_ex(const char *path, int *width, int *height, parallax_layer_t *layer);
+void unload_texture(unsigned int texture);
+/* Decode path as the layer's next image (on the decode pool unless
+ * render.decode_threads is 0) and queue its upload; the layer keeps drawing
+ * its current texture (or nothing) until the upload is complete, when
+ * hyprlax_poll_texture_uploads swaps it in. Fails at once only if path is
+ * not a readable image; a later decode failure is logged. */
+int hyprlax_queue_layer_texture(hyprlax_context_t *ctx, parallax_layer_t *layer, const char *path);
+/* Queue uploads of finished decodes and swap in completed uploads; true
+ * while some uploads are still in flight */
+bool hyprlax_poll_texture_uploads(hyprlax_context_t *ctx);
+/* Block until every queued decode is finished and its upload queued */
+void hyprlax_finish_texture_decodes(hyprlax_context_t *ctx);
+/* Release the decode pool, dropping decodes still in flight */
+void hyprlax_stop_texture_decodes(hyprlax_context_t *ctx);
 
 /* Control interface */
 int hyprlax_ctl_main(int argc, char **argv);
@@ -99,6 +99,12 @@ typedef struct platform_ops {
     /* Optional helpers */
     void (*get_window_size)(int *width, int *height);
     void (*commit_monitor_surface)(monitor_instance_t *monitor);
+    /* Optional: mark a logical-pixel rect of the monitor surface opaque
+     * (takes effect on the next commit; w or h <= 0 clears it) */
+    void (*set_opaque_region)(monitor_instance_t *monitor, int x, int y, int w, int h);
+    /* Optional: report when the next commit of the monitor surface reaches
+     * the screen (feeds monitor->clock); call before presenting */
+    void (*request_present_feedback)(monitor_instance_t *monitor);
     bool (*get_cursor_global)(double *x, double *y);
     void (*realize_monitors)(void);
     void (*set_context)(struct hyprlax_context *ctx);
@@ -0,0 +1,59 @@
+/*
+ * render_options.h - Renderer tuning switches
+ *
+ * Resolved once at startup from defaults, [global.render] in the TOML
+ * config and HYPRLAX_RENDER_<NAME> environment variables (the historical
+ * variable names are still honoured), and changeable at runtime through
+ * the IPC render.<name> properties. Hot paths read the fields directly;
+ * nothing on a draw path consults the environment.
+ */
+
+#ifndef HYPRLAX_RENDER_OPTIONS_H
+#define HYPRLAX_RENDER_OPTIONS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "defaults.h"
+
+typedef struct render_options {
+    bool uniform_offset;    /* Scale parallax offsets by 1/content_scale */
+    bool separable_blur;    /* Two-pass FBO blur instead of the single-pass kernel */
+    int blur_downscale;     /* Separable blur resolution divisor (0/1 = full) */
+    bool blur_cache;        /* Blur static layers once into a texture */
+    bool kawase_blur;       /* Dual-Kawase pyramid for blurs drawn every frame */
+    int upload_budget;      /* Per-frame image upload time in us (0 = whole images at once) */
+    bool image_downscale;   /* Resample images on load to the largest size an output shows */
+    bool image_crop;        /* Upload only the image region parallax can bring on screen */
+    int tile_budget;        /* MiB of streamed tiles; larger images are tiled (0 = only over the GPU limit) */
+    int decode_threads;     /* Image decode workers (0 = decode on the main thread) */
+    int image_cache;        /* MiB of decoded images cached on disk (0 = off) */
+    bool gl_finish;         /* glFinish before present when fences are unavailable */
+    bool single_pass;       /* Fold runs of layers into one composite draw */
+    bool tint;              /* Apply per-layer tint */
+    bool tint_on_blur;      /* ...on blurred layers too */
+    bool frame_callback;    /* Pace frames with Wayland frame callbacks */
+    bool blocking_present;  /* Wait for vblank on every swap instead of fences and frame callbacks */
+    bool debug;             /* Verbose renderer tracing on stderr */
+    bool profile;           /* Per-frame draw/present timings */
+} render_options_t;
+
+#define RENDER_OPTIONS_DEFAULTS { \
+    .uniform_offset = true, .blur_cache = true, .kawase_blur = true, .gl_finish = true, \
+    .upload_budget = HYPRLAX_UPLOAD_BUDGET_US, .image_downscale = true, .image_crop = true, \
+    .tile_budget = HYPRLAX_TILE_BUDGET_MB, .decode_threads = HYPRLAX_DECODE_THREADS, \
+    .image_cache = HYPRLAX_IMAGE_CACHE_MB, .single_pass = true, .tint = true, .tint_on_blur = true }
+
+/* Overlay HYPRLAX_RENDER_<NAME> variables, and the legacy names they replace */
+void render_options_apply_env(render_options_t *opts);
+
+/* Option names (without the "render." prefix), NULL past the last one */
+const char *render_options_name(int index);
+/* true if the option takes an integer rather than a boolean */
+bool render_options_is_int(const char *name);
+
+/* Set/get one option by name; 0 on success, -1 for an unknown name or a
+ * value out of range */
+int render_options_set(render_options_t *opts, const char *name, const char *value);
+int render_options_get(const render_options_t *opts, const char *name, char *out, size_t out_size);
+
+#endif /* HYPRLAX_RENDER_OPTIONS_H */
@@ -0,0 +1,92 @@
+/*
+ * render_thread.h - Optional dedicated render thread
+ *
+ * With render.threaded the renderer's context moves to one render thread.
+ * The main thread keeps handling epoll, IPC and compositor events and, once
+ * per frame, publishes an immutable snapshot of everything a frame draws
+ * from: config, layer copies with their current offsets, and each output's
+ * present target and blended input offsets. Snapshots travel through a
+ * lock-free triple buffer, so neither side ever waits for the other to
+ * finish with one; the render thread always draws the newest and skips any
+ * it was too slow for.
+ *
+ * What cannot be snapshotted is serialized instead:
+ *  - Texture uploads and deletes run on the render thread as synchronous
+ *    jobs (renderer_set_dispatch), since only it may touch the context;
+ *    images queued for banded upload are pumped before each pass.
+ *  - Outputs and Wayland objects are shared: the render thread holds the
+ *    output lock while it draws and presents one output, and the main
+ *    thread holds it while dispatching platform events (hotplug, configure,
+ *    frame callbacks, presentation feedback).
+ */
+
+#ifndef HYPRLAX_RENDER_THREAD_H
+#define HYPRLAX_RENDER_THREAD_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "hyprlax.h"
+
+/* Single-writer single-reader triple buffer over three slot indices. The
+ * writer fills triple_buffer_back() and publishes it; the reader acquires
+ * the newest published slot and reads triple_buffer_front() until its next
+ * acquire. */
+typedef struct {
+    _Atomic unsigned int middle;   /* Slot in hand-off, TRIPLE_BUFFER_FRESH if unread */
+    unsigned int back;             /* Writer-owned */
+    unsigned int front;            /* Reader-owned */
+} triple_buffer_t;
+
+#define TRIPLE_BUFFER_FRESH 4u
+
+void triple_buffer_init(triple_buffer_t *tb);
+static inline unsigned int triple_buffer_back(const triple_buffer_t *tb) { return tb->back; }
+static inline unsigned int triple_buffer_front(const triple_buffer_t *tb) { return tb->front; }
+/* Writer: hand the back slot over and take the middle one */
+void triple_buffer_publish(triple_buffer_t *tb);
+/* Reader: swap in the newest published slot; false if nothing new */
+bool triple_buffer_acquire(triple_buffer_t *tb);
+
+/* Per-output part of a snapshot */
+typedef struct {
+    uint32_t monitor_id;
+    uint64_t dirty_serial;     /* Snapshot that last dirtied the output */
+    uint64_t stale_serial;     /* Snapshot that last invalidated its draws */
+    render_inputs_t inputs;
+} render_snapshot_output_t;
+
+typedef struct {
+    uint64_t seq;
+    double frame_time;
+    config_t config;
+    parallax_layer_t *layers;      /* Copies, linked in list order */
+    int layer_count;
+    int layer_capacity;
+    uint32_t *tile_ids;            /* Drawable tile textures the copies point into */
+    int tile_id_capacity;
+    render_snapshot_output_t *outputs;
+    int output_count;
+    int output_capacity;
+} render_snapshot_t;
+
+typedef struct render_thread render_thread_t;
+
+/* Start/stop the render thread for ctx's renderer; the caller's thread must
+ * own the renderer context when starting and owns it again after stopping */
+int render_thread_start(hyprlax_context_t *ctx);
+void render_thread_stop(hyprlax_context_t *ctx);
+
+/* Main thread: snapshot ctx (after hyprlax_render_prepare) and publish it */
+void render_thread_publish(render_thread_t *rt, hyprlax_context_t *ctx);
+
+/* Main thread: hold off the render thread while outputs change */
+void render_thread_lock_outputs(render_thread_t *rt);
+void render_thread_unlock_outputs(render_thread_t *rt);
+/* Main thread: something a held-back output waits on may have happened */
+void render_thread_kick(render_thread_t *rt);
+
+/* Move the render thread's counters into stats (adds, then resets) */
+void render_thread_take_stats(render_thread_t *rt, render_stats_t *stats);
+
+#endif /* HYPRLAX_RENDER_THREAD_H */
@@ -11,12 +11,14 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "hyprlax_internal.h"
+#include "render_options.h"
 
 /* Renderer capability flags */
 typedef enum {
     RENDERER_CAP_BLUR = 1 << 0,
     RENDERER_CAP_VSYNC = 1 << 1,
     RENDERER_CAP_MULTISAMPLING = 1 << 2,
+    RENDERER_CAP_NONBLOCKING_PRESENT = 1 << 3,  /* Presents never wait for vblank */
 } renderer_capability_t;
 
 /* Texture format */
@@ -59,6 +61,7 @@ typedef struct renderer_layer_params {
     int tile_y;         /* 1 = repeat in Y regardless of overflow */
     float auto_safe_norm_x; /* additional normalized shrink based on max offset */
     float auto_safe_norm_y;
+    float crop[4];      /* Source UV window the texture holds {u0, v0, u1, v1}; all 0 = whole image */
     /* Per-layer tint */
     float tint_r;
     float tint_g;
@@ -66,6 +69,57 @@ typedef struct renderer_layer_params {
     float tint_strength;
 } renderer_layer_params_t;
 
+/* Shader program a compiled draw resolves to */
+typedef enum {
+    RENDERER_PROGRAM_BASIC,
+    RENDERER_PROGRAM_BLUR,
+    RENDERER_PROGRAM_BLUR_SEPARABLE,
+    RENDERER_PROGRAM_BLUR_CACHED,   /* Basic draw of a blurred copy of the texture */
+    RENDERER_PROGRAM_BLUR_KAWASE,   /* Dual-Kawase pyramid, blurred every draw */
+} renderer_program_t;
+
+/* Backend-neutral wrap modes, before a backend maps them */
+typedef enum {
+    RENDERER_WRAP_CLAMP,
+    RENDERER_WRAP_REPEAT,
+} renderer_wrap_t;
+
+/* Precompiled layer draw. Depends only on layer params, texture size and
+ * viewport; the per-frame draw supplies the texture id and offset. */
+typedef struct renderer_draw_packet {
+    float vertices[16];     /* x, y, u, v per corner (triangle strip) */
+    float bounds[4];        /* Screen extent in NDC {x0, y0, x1, y1} */
+    float offset_scale[2];  /* Applied to the parallax offset (1 / content_scale, / crop size) */
+    float opacity;
+    float blur_amount;
+    float tint[3];
+    float tint_strength;
+    float mask[2];          /* Per axis, 0 or discard texcoords outside [1 - mask, mask]: 1 for
+                             * overflow none, less to keep a tile's gutter out */
+    int wrap_s;             /* Backend wrap modes */
+    int wrap_t;
+    int program;            /* renderer_program_t */
+    int tex_width;
+    int tex_height;
+    int geometry;           /* Backend vertex slot the quad was stored in (a hint) */
+    bool uniform_offset;    /* Offset via uniform rather than texcoords */
+    bool has_params;        /* Built from extended params (mask/wrap apply) */
+} renderer_draw_packet_t;
+
+/* A compiled draw with this frame's inputs */
+typedef struct renderer_packet_draw {
+    const renderer_draw_packet_t *packet;
+    uint32_t texture_id;
+    float x;
+    float y;
+} renderer_packet_draw_t;
+
+/* GL call counters (renderer_ops_t.take_stats) */
+typedef struct renderer_stats {
+    uint64_t gl_calls;          /* Tracked state changes and draws that reached GL */
+    uint64_t gl_calls_elided;   /* Redundant state changes that were skipped */
+} renderer_stats_t;
+
 /* Renderer operations interface */
 typedef struct renderer_ops {
     /* Lifecycle */
@@ -93,6 +147,44 @@ typedef struct renderer_ops {
                          float opacity, float blur_amount,
                          const renderer_layer_params_t *params);
 
+    /* Optional offscreen render targets (used by the idle composite cache).
+     * Handles are renderer-owned and non-zero; target 0 is the window surface. */
+    uint32_t (*create_target)(int width, int height);
+    void (*destroy_target)(uint32_t target);
+    void (*bind_target)(uint32_t target);
+    /* Copy a target's contents over the bound surface (no blending) */
+    void (*blit_target)(uint32_t target);
+
+    /* Optional precompiled draws: compile_layer resolves fit geometry, UVs,
+     * wrap modes and shader once; draw_packet issues it each frame */
+    void (*compile_layer)(const texture_t *texture, float opacity, float blur_amount,
+                          const renderer_layer_params_t *params,
+                          renderer_draw_packet_t *out);
+    void (*draw_packet)(const renderer_draw_packet_t *packet, uint32_t texture_id,
+                        float x, float y);
+    /* Optional: blend a bottom-up run of draws in a single pass. Returns how
+     * many draws from the front were consumed; 0 means the first draw is not
+     * eligible and must go through draw_packet. */
+    int (*draw_packet_batch)(const renderer_packet_draw_t *draws, int count);
+
+    /* Optional damage tracking. Rects are {x, y, w, h} in surface pixels
+     * with a bottom-left origin. */
+    /* Age of the back buffer in frames (0 = unknown/undefined contents) */
+    int (*get_buffer_age)(void);
+    /* Restrict this frame's rendering to rect; call before the first draw */
+    void (*set_damage_region)(const int rect[4]);
+    /* Present reporting only rect as changed; returns false if the full
+     * surface had to be damaged instead */
+    bool (*present_damage)(const int rect[4]);
+
+    /* Optional: the GPU has not finished the last frame presented to surface
+     * (EGLSurface, or a create_surface handle). Never blocks; callers skip
+     * the output rather than queue another frame behind it. */
+    bool (*gpu_busy)(void *surface);
+
+    /* Optional: toggle blending for draws that replace what is under them */
+    void (*set_blend)(bool enabled);
+
     /* Configuration */
     void (*resize)(int width, int height);
     void (*set_vsync)(bool enabled);
@@ -101,6 +193,47 @@ typedef struct renderer_ops {
     /* Debug */
     const char* (*get_name)(void);
     const char* (*get_version)(void);
+
+    /* Optional: read back the current surface as RGBA8, bottom-left origin */
+    int (*read_pixels)(int x, int y, int width, int height, uint8_t *rgba);
+
+    /* Image uploads for the layer loaders: straight-alpha RGBA8, top row
+     * first. Returns a non-zero texture id, 0 on failure. */
+    uint32_t (*upload_texture)(const uint8_t *rgba, int width, int height);
+    void (*delete_texture)(uint32_t id);
+
+    /* Optional banded uploads for renderer_queue_texture: begin_upload
+     * allocates an image's storage, upload_rows fills rows [y, y + rows)
+     * from that many rows of the same format, and finish_upload builds
+     * whatever the texture samples besides level 0 once the last band is in */
+    uint32_t (*begin_upload)(int width, int height);
+    void (*upload_rows)(uint32_t id, const uint8_t *rgba, int width, int y, int rows);
+    void (*finish_upload)(uint32_t id, int width, int height);
+    /* Optional: largest texture width/height the GPU accepts */
+    int (*max_texture_size)(void);
+
+    /* Optional renderer-owned output surfaces, for backends that do not
+     * present through EGL. native_surface is the platform surface
+     * (wl_surface), NULL for an offscreen surface. When absent, outputs use
+     * gles2_create_monitor_surface/gles2_make_current. */
+    void* (*create_surface)(void *native_surface, int width, int height);
+    /* Bind a surface for this frame at the output's current pixel size */
+    int (*make_current)(void *surface, int width, int height);
+
+    /* Optional, for contexts bound to one thread at a time: detach the
+     * context from the calling thread, and attach it to the calling thread
+     * (on the surface it was last bound to) */
+    void (*release_context)(void);
+    int (*bind_context)(void);
+
+    /* Optional: render options changed at runtime (renderer_set_options).
+     * Called on the renderer's thread; backends rebuild whatever the
+     * options select (shaders, blur targets) before the next frame. */
+    void (*apply_options)(const render_options_t *options);
+
+    /* Optional: add the GL call counters since the last call to stats and
+     * reset them. Called on the renderer's thread. */
+    void (*take_stats)(renderer_stats_t *stats);
 } renderer_ops_t;
 
 /* Renderer instance */
@@ -115,6 +248,64 @@ typedef struct renderer {
 int renderer_create(renderer_t **renderer, const char *backend_name);
 void renderer_destroy(renderer_t *renderer);
 
+/* Texture uploads from the image loaders, routed to the renderer that was
+ * created last (there is one per process) */
+uint32_t renderer_upload_texture(const uint8_t *rgba, int width, int height);
+void renderer_delete_texture(uint32_t id);
+
+/* Time-sliced uploads: the image is uploaded in row bands by
+ * renderer_pump_uploads, at most render.upload_budget microseconds per
+ * frame. Takes ownership of rgba (malloc'd, freed once uploaded). Small
+ * images, a zero budget and backends without banded uploads go at once.
+ * Returns the texture id (0 on failure); nothing may sample it before
+ * renderer_texture_ready reports it complete. Deleting it cancels the rest. */
+uint32_t renderer_queue_texture(uint8_t *rgba, int width, int height);
+/* The same for pixels the caller owns (e.g. a mapped file): they must stay
+ * valid until release(release_arg) runs, on the renderer's thread, once the
+ * upload completes or fails */
+typedef void (*renderer_release_fn)(void *arg);
+uint32_t renderer_queue_texture_with(const uint8_t *rgba, int width, int height,
+                                     renderer_release_fn release, void *release_arg);
+/* false while a queued texture still has bands to upload; any thread */
+bool renderer_texture_ready(uint32_t id);
+/* Renderer thread, once per frame: upload bands for up to the budget;
+ * returns true while uploads remain */
+bool renderer_pump_uploads(void);
+/* Upload everything that is queued now (e.g. before a headless replay) */
+void renderer_finish_uploads(void);
+/* Bytes still to upload; any thread */
+uint64_t renderer_upload_pending_bytes(void);
+/* Largest texture side the renderer accepts, 0 if it sets no limit */
+int renderer_max_texture_size(void);
+
+/* Runs a job on the thread that owns the renderer and returns once it has
+ * run. Installed by the render thread; NULL restores direct calls. */
+typedef void (*renderer_dispatch_fn)(void (*job)(void *arg), void *arg);
+void renderer_set_dispatch(renderer_dispatch_fn dispatch);
+/* Run job on the renderer's thread (directly without a dispatcher) */
+void renderer_run(void (*job)(void *arg), void *arg);
+
+/* Render options the backends read on their hot paths. Set before
+ * renderer init and again on every runtime change; the update runs as a
+ * renderer_run job, so draws never see a half-written struct. */
+const render_options_t *renderer_get_options(void);
+void renderer_set_options(const render_options_t *options);
+
+/* Fit geometry, UVs, masks and tint shared by every backend's
+ * compile_layer; wrap_s/wrap_t are left as renderer_wrap_t */
+void renderer_compile_layer_geometry(int viewport_width, int viewport_height,
+                                     const texture_t *texture, float opacity,
+                                     float blur_amount,
+                                     const renderer_layer_params_t *params,
+                                     renderer_draw_packet_t *out);
+
+/* Dual-Kawase pyramid for a blur amount at a viewport size: levels to
+ * downsample through (each halves the resolution and roughly doubles the
+ * radius) and the per-level tap offset. The pass count grows with log2 of
+ * the radius; the taps per pass stay fixed. */
+void renderer_kawase_plan(float blur_amount, int viewport_width, int viewport_height,
+                          int *levels, float *offset);
+
 /* Convenience macros for calling renderer operations */
 #define RENDERER_INIT(r, display, window, config) \
     ((r)->ops->init((display), (window), (config)))
@@ -131,16 +322,24 @@ void renderer_destroy(renderer_t *renderer);
 
 /* Available renderer backends */
 extern const renderer_ops_t renderer_gles2_ops;
-/* Future: renderer_gl3_ops, renderer_vulkan_ops */
+extern const renderer_ops_t renderer_headless_ops;  /* GLES2 on EGL pbuffers */
+extern const renderer_ops_t renderer_gles3_ops;     /* GLES2 paths on an ES 3.0 context, instanced batches */
+extern const renderer_ops_t renderer_headless_gles3_ops;
+extern const renderer_ops_t renderer_software_ops;  /* CPU compositing into wl_shm */
+/* Future: renderer_vulkan_ops */
 
 /* Multi-monitor support functions for GLES2 backend */
 #ifdef __EGL_H__
 EGLSurface gles2_create_monitor_surface(void *native_window);
+EGLSurface gles2_create_offscreen_surface(int width, int height);
 int gles2_make_current(EGLSurface surface);
 #else
 /* Forward declaration for when EGL types aren't available */
 void* gles2_create_monitor_surface(void *native_window);
+void* gles2_create_offscreen_surface(int width, int height);
 int gles2_make_current(void *surface);
 #endif
+/* Full-surface viewport for the current GLES2 surface */
+void gles2_set_viewport(int width, int height);
 
 #endif /* HYPRLAX_RENDERER_H */
@@ -31,6 +31,13 @@ typedef struct shader_program {
     int loc_u_resolution;
     int loc_u_offset;
     int loc_u_mask_outside;
+    int loc_u_tint;
+    int loc_u_tint_strength;
+    int loc_u_direction;
+    int loc_u_color;
+    int loc_u_rect;         /* Composite pass arrays */
+    int loc_u_uv;
+    int loc_u_mask;
     bool cache_ready;
 } shader_program_t;
 
@@ -56,6 +63,10 @@ int shader_compile(shader_program_t *program,
 int shader_compile_blur(shader_program_t *program);
 int shader_compile_separable_blur(shader_program_t *program);
 int shader_compile_separable_blur_with_vertex(shader_program_t *program, const char *vertex_src);
+/* Dual-Kawase pyramid passes (premultiplied in and out) */
+int shader_compile_kawase_blur(shader_program_t *down, shader_program_t *up);
+/* Straight-alpha directional blur for offscreen blur caching */
+int shader_compile_blur_pass(shader_program_t *program);
 
 void shader_use(const shader_program_t *program);
 void shader_set_uniform_float(const shader_program_t *program,
@@ -81,8 +92,16 @@ extern const char *shader_vertex_basic_offset;
 extern const char *shader_fragment_basic;
 extern const char *shader_fragment_fill;
 extern const char *shader_fragment_blur;
+extern const char *shader_vertex_composite;
 
 /* Shader builder for dynamic blur shaders */
 char* shader_build_blur_fragment(float blur_amount, int kernel_size);
 
+/* Single-pass multi-texture composite for a fixed layer count */
+char* shader_build_composite_fragment(int layers);
+
+/* GLSL ES 3.00 instanced layer draw for up to `layers` textures (GLES3
+ * backend); the caller frees both sources */
+int shader_build_instanced(int layers, char **vertex_src, char **fragment_src);
+
 #endif /* HYPRLAX_SHADER_H */
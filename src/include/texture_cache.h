@@ -0,0 +1,75 @@
+/*
+ * texture_cache.h - Decoded images kept on disk between runs
+ *
+ * Decoding a PNG or JPEG and resampling it to the outputs costs far more
+ * than reading the result back, and every start and reload repeats it.
+ * Entries hold an image as it is uploaded (cropped and downscaled RGBA8,
+ * straight alpha, as the loaders produce it) behind a small header, one
+ * file per entry under $XDG_CACHE_HOME/hyprlax (~/.cache/hyprlax without
+ * it). A hit maps the file and the pixels are uploaded from the mapping.
+ *
+ * Keys hash the image's real path, device, inode, size and mtime with the
+ * bytes that describe how it was processed, so an edited file or another
+ * output size misses. Headers and pixels carry checksums; an entry that
+ * fails them is removed and counts as a miss. The directory is kept under
+ * a byte budget by deleting the least recently used entries (hits touch
+ * the file's mtime).
+ *
+ * Everything here is safe to call from several threads at once, and from
+ * several processes sharing the directory: entries are written to a
+ * temporary file and renamed into place.
+ */
+
+#ifndef HYPRLAX_TEXTURE_CACHE_H
+#define HYPRLAX_TEXTURE_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* What an entry says about its pixels */
+typedef struct {
+    int width;                  /* Stored pixels, RGBA8 rows without padding */
+    int height;
+    int source_width;           /* The image they were made from */
+    int source_height;
+    float crop[4];              /* UV window of the image they cover */
+    bool opaque;
+    int alpha_bbox[4];
+} texture_cache_info_t;
+
+typedef struct texture_cache_entry texture_cache_entry_t;
+
+typedef struct {
+    int entries;
+    uint64_t bytes;             /* On disk, headers included */
+    /* This process since it started */
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+    uint64_t evictions;
+} texture_cache_stats_t;
+
+/* The cache directory; false if neither variable gives one */
+bool texture_cache_dir(char *out, size_t size);
+
+/* Key for the file at path as it is now, processed as variant describes;
+ * 0 if the file cannot be examined */
+uint64_t texture_cache_key(const char *path, const void *variant, size_t variant_size);
+
+/* Map the entry for key; NULL on a miss */
+texture_cache_entry_t *texture_cache_open(uint64_t key, texture_cache_info_t *info);
+const uint8_t *texture_cache_pixels(const texture_cache_entry_t *entry);
+/* Unmaps the entry (a renderer_release_fn) */
+void texture_cache_close(void *entry);
+
+/* Write rgba (info->width x info->height) as the entry for key */
+int texture_cache_store(uint64_t key, const texture_cache_info_t *info, const uint8_t *rgba);
+/* Delete least recently used entries until the rest fit budget bytes;
+ * returns how many went */
+int texture_cache_trim(uint64_t budget);
+/* Delete every entry; returns how many went, or -1 without a directory */
+int texture_cache_clear(void);
+int texture_cache_stats(texture_cache_stats_t *stats);
+
+#endif /* HYPRLAX_TEXTURE_CACHE_H */
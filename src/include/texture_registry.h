@@ -0,0 +1,50 @@
+/*
+ * texture_registry.h - Layer textures shared by content
+ *
+ * Layers that show the same file, processed the same way, draw from one
+ * texture. Textures are registered under the key texture_cache_key gives
+ * for the file and its processing (so an edited file gets a new texture),
+ * and counted: each layer that draws or waits on one holds a reference,
+ * and the last release deletes it.
+ *
+ * A hold keeps textures nobody references until it ends, so a config
+ * reload can remove every layer and add them back without uploading the
+ * images it keeps again.
+ *
+ * Main thread only. Textures go through the renderer's upload and delete
+ * calls, so they reach the render thread when there is one.
+ */
+
+#ifndef HYPRLAX_TEXTURE_REGISTRY_H
+#define HYPRLAX_TEXTURE_REGISTRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "texture_cache.h"
+
+typedef struct texture_registry texture_registry_t;
+
+texture_registry_t *texture_registry_create(void);
+/* Frees the bookkeeping; the textures go with the renderer */
+void texture_registry_destroy(texture_registry_t *reg);
+
+/* A new reference to the texture registered under key, and what it holds;
+ * false if there is none */
+bool texture_registry_acquire(texture_registry_t *reg, uint64_t key, uint32_t *texture,
+                              texture_cache_info_t *info);
+/* Register a texture under key with one reference (the caller's) */
+int texture_registry_add(texture_registry_t *reg, uint64_t key, uint32_t texture,
+                         const texture_cache_info_t *info);
+/* Drop a reference; a texture the registry does not know (or a NULL
+ * registry) is deleted at once */
+void texture_registry_release(texture_registry_t *reg, uint32_t texture);
+
+/* Keep unreferenced textures until the matching unhold, which deletes
+ * those still unreferenced and returns how many went */
+void texture_registry_hold(texture_registry_t *reg);
+int texture_registry_unhold(texture_registry_t *reg);
+
+/* Registered textures, and the references to them (either may be NULL) */
+void texture_registry_stats(const texture_registry_t *reg, int *textures, int *refs);
+
+#endif /* HYPRLAX_TEXTURE_REGISTRY_H */
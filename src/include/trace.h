@@ -0,0 +1,53 @@
+/*
+ * trace.h - Recorded event traces for headless replay
+ *
+ * A trace is a text file with one timestamped event per line:
+ *
+ *   # seconds  event        arguments
+ *   0.50       workspace    2 [monitor]
+ *   1.75       workspace2d  0 0 1 0 [monitor]
+ *   3.00       set          render.overflow repeat
+ *
+ * Blank lines and '#' comments are ignored. Events are replayed in time
+ * order; events sharing a timestamp keep their file order.
+ */
+
+#ifndef HYPRLAX_TRACE_H
+#define HYPRLAX_TRACE_H
+
+#include <stdbool.h>
+
+#define HYPRLAX_TRACE_MAX_LINE 512
+
+typedef enum {
+    TRACE_EVENT_WORKSPACE,      /* linear workspace switch */
+    TRACE_EVENT_WORKSPACE_2D,   /* grid workspace switch */
+    TRACE_EVENT_SET,            /* runtime property (as `hyprlax ctl set`) */
+} trace_event_type_t;
+
+typedef struct {
+    double time;                /* seconds since replay start */
+    trace_event_type_t type;
+    int workspace;              /* TRACE_EVENT_WORKSPACE */
+    int from_x, from_y;         /* TRACE_EVENT_WORKSPACE_2D */
+    int to_x, to_y;
+    char monitor[64];           /* optional target output, "" for primary */
+    char property[64];          /* TRACE_EVENT_SET */
+    char value[256];
+} trace_event_t;
+
+typedef struct {
+    trace_event_t *events;
+    int count;
+    int capacity;
+} trace_t;
+
+/* Parse one line. Returns 1 if an event was parsed, 0 for blank/comment
+ * lines and HYPRLAX_ERROR_INVALID_ARGS for malformed lines. */
+int trace_parse_line(const char *line, trace_event_t *event);
+
+/* Load and time-sort a trace file; stops at the first malformed line */
+int trace_load(const char *path, trace_t *trace);
+void trace_free(trace_t *trace);
+
+#endif /* HYPRLAX_TRACE_H */
@@ -0,0 +1,65 @@
+/*
+ * virtual_texture.h - Images drawn from a grid of streamed tiles
+ *
+ * Images larger than the GPU's texture limit, or than the tile budget,
+ * are split into square tiles that are uploaded only while some output
+ * can show them. The decoded pixels stay in memory to stream from;
+ * textures are uploaded through renderer_queue_texture (in bands, within
+ * render.upload_budget) and evicted least recently wanted first once the
+ * tiles of every virtual texture exceed the budget.
+ *
+ * Each tile's texture also holds a gutter of texels from its neighbours
+ * (the edge texels repeated at the image border), so filtering across a
+ * tile edge samples what a single texture would; draws keep the gutter
+ * out with an inset mask.
+ *
+ * Main thread only. The drawable id table is what draws read; frame
+ * snapshots copy it, never the virtual texture itself.
+ */
+
+#ifndef HYPRLAX_VIRTUAL_TEXTURE_H
+#define HYPRLAX_VIRTUAL_TEXTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Tile layout; plain values, safe to copy into frame snapshots */
+typedef struct {
+    int width;              /* Image size in pixels */
+    int height;
+    int tile_size;          /* Edge of a full tile; the last row/column may be smaller */
+    int cols;
+    int rows;
+    int gutter;             /* Texels around each tile in its texture */
+} virtual_texture_grid_t;
+
+typedef struct virtual_texture virtual_texture_t;
+
+/* Takes ownership of rgba (malloc'd RGBA8, top row first); tile textures
+ * are tile_size plus a gutter on each side. NULL on failure. */
+virtual_texture_t *virtual_texture_create(uint8_t *rgba, int width, int height, int tile_size);
+/* Deletes resident tiles and frees the pixels */
+void virtual_texture_destroy(virtual_texture_t *vt);
+
+const virtual_texture_grid_t *virtual_texture_grid(const virtual_texture_t *vt);
+/* Pixel rect {x, y, w, h} of tile index (row-major, top row first),
+ * without the gutter */
+void virtual_texture_tile_rect(const virtual_texture_grid_t *grid, int index, int rect[4]);
+/* Texture to draw each tile with, 0 while it is not resident */
+const uint32_t *virtual_texture_ids(const virtual_texture_t *vt);
+
+/* Mark every tile under the UV window {u0, v0, u1, v1} (image UV, v down)
+ * wanted at stamp and queue uploads for those not resident; returns how
+ * many were queued */
+int virtual_texture_request(virtual_texture_t *vt, const float uv[4], uint64_t stamp);
+/* Make finished uploads drawable; returns true if any became so. pending,
+ * if given, receives the number of tiles still uploading. */
+bool virtual_texture_poll(virtual_texture_t *vt, int *pending);
+/* Texture bytes of resident and uploading tiles */
+uint64_t virtual_texture_resident_bytes(const virtual_texture_t *vt);
+/* Evict tiles of vts, least recently wanted first, until they fit budget
+ * bytes; tiles wanted at stamp are kept even over budget. Returns the
+ * number evicted. */
+int virtual_texture_trim(virtual_texture_t *const *vts, int count, uint64_t budget, uint64_t stamp);
+
+#endif /* HYPRLAX_VIRTUAL_TEXTURE_H */
@@ -20,6 +20,12 @@ void wayland_get_window_size(int *width, int *height);
 /* Commit a specific monitor surface (frame pacing + wl_surface_commit) */
 void wayland_commit_monitor_surface(monitor_instance_t *monitor);
 
+/* Set a monitor surface's opaque region (logical pixels; empty clears it) */
+void wayland_set_monitor_opaque_region(monitor_instance_t *monitor, int x, int y, int w, int h);
+
+/* Request wp_presentation feedback for the monitor surface's next commit */
+void wayland_request_present_feedback(monitor_instance_t *monitor);
+
 /* Force realization of monitors based on discovered outputs if none exist yet. */
 void wayland_realize_monitors_now(void);
 
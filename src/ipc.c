@@ -9,6 +9,8 @@
 #include "include/log.h"
 #include "compositor/workspace_models.h"
 #include "include/config_toml.h"
+#include "include/texture_cache.h"
+#include "include/texture_registry.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -25,6 +27,9 @@
 #include <math.h>
 #include "include/defaults.h"
 
+/* Longest path echoed in a reply; the rest of the reply must still fit */
+#define IPC_PATH_SHOWN 1024
+
 /* stb_image prototypes (implementation is compiled in hyprlax_main.c) */
 extern int stbi_info(const char *filename, int *x, int *y, int *comp);
 extern const char *stbi_failure_reason(void);
@@ -286,6 +291,23 @@ __attribute__((weak)) bool workspace_detect_capabilities(int compositor_type,
     return false;
 }
 
+/* Weak stub for the frame clock name used in status JSON */
+__attribute__((weak)) const char* frame_clock_source_name(frame_clock_source_t source) {
+    (void)source; return "timer";
+}
+
+/* Weak stub for the upload backlog reported by status */
+__attribute__((weak)) uint64_t renderer_upload_pending_bytes(void) {
+    return 0;
+}
+
+/* Weak stub for the shared texture counts reported by status */
+__attribute__((weak)) void texture_registry_stats(const texture_registry_t *reg, int *textures, int *refs) {
+    (void)reg;
+    if (textures) *textures = 0;
+    if (refs) *refs = 0;
+}
+
 static void format_parallax_inputs(const config_t *cfg, char *out, size_t out_sz) {
     if (!out || out_sz == 0) return;
     out[0] = '\0';
@@ -353,6 +375,7 @@ static ipc_command_t parse_command(const char* cmd) {
     if (strcmp(cmd, "get") == 0) return IPC_CMD_GET_PROPERTY;
     if (strcmp(cmd, "diag") == 0) return IPC_CMD_DIAG;
     if (strcmp(cmd, "computed") == 0 || strcmp(cmd, "calc") == 0 || strcmp(cmd, "calculate") == 0) return IPC_CMD_COMPUTED;
+    if (strcmp(cmd, "cache") == 0) return IPC_CMD_CACHE;
     return IPC_CMD_UNKNOWN;
 }
 
@@ -876,6 +899,9 @@ bool ipc_process_commands(ipc_context_t* ctx) {
                 double fps = app ? app->fps : 0.0;
                 bool vsync = app ? app->config.vsync : false;
                 bool debug = app ? app->config.debug : false;
+                unsigned long long upload_bytes = app ? (unsigned long long)renderer_upload_pending_bytes() : 0;
+                int textures = 0, texture_refs = 0;
+                texture_registry_stats(app ? app->textures : NULL, &textures, &texture_refs);
                 if (json) {
                     size_t off = 0; response[0] = '\0';
                     /* Top-level compositor capabilities (detected) */
@@ -884,8 +910,8 @@ bool ipc_process_commands(ipc_context_t* ctx) {
                     (void)workspace_detect_capabilities(ctype, &tcaps);
 
                     off += snprintf(response + off, sizeof(response) - off,
-                        "{\"running\":true,\"layers\":%d,\"target_fps\":%d,\"fps\":%.2f,\"parallax_input\":\"%s\",\"compositor\":\"%s\",\"socket\":\"%s\",\"vsync\":%s,\"debug\":%s,\"caps\":{\"steal\":%s,\"move\":%s,\"split\":%s,\"wsets\":%s,\"tags\":%s,\"vstack\":%s},\"monitors\":[",
-                        layers, target_fps, fps, parallax_inputs, comp, ctx->socket_path, vsync?"true":"false", debug?"true":"false",
+                        "{\"running\":true,\"layers\":%d,\"target_fps\":%d,\"fps\":%.2f,\"parallax_input\":\"%s\",\"compositor\":\"%s\",\"socket\":\"%s\",\"vsync\":%s,\"debug\":%s,\"upload_pending_bytes\":%llu,\"textures\":%d,\"texture_refs\":%d,\"caps\":{\"steal\":%s,\"move\":%s,\"split\":%s,\"wsets\":%s,\"tags\":%s,\"vstack\":%s},\"monitors\":[",
+                        layers, target_fps, fps, parallax_inputs, comp, ctx->socket_path, vsync?"true":"false", debug?"true":"false", upload_bytes, textures, texture_refs,
                         tcaps.can_steal_workspace?"true":"false",
                         tcaps.supports_workspace_move?"true":"false",
                         tcaps.has_split_plugin?"true":"false",
@@ -899,8 +925,10 @@ bool ipc_process_commands(ipc_context_t* ctx) {
                             if (!first) { response[off++] = ','; }
                             first = false;
                             off += snprintf(response + off, sizeof(response) - off,
-                                "{\"name\":\"%s\",\"size\":[%d,%d],\"pos\":[%d,%d],\"scale\":%d,\"refresh\":%d,\"caps\":{\"steal\":%s,\"move\":%s,\"split\":%s,\"wsets\":%s,\"tags\":%s,\"vstack\":%s}}",
+                                "{\"name\":\"%s\",\"size\":[%d,%d],\"pos\":[%d,%d],\"scale\":%d,\"refresh\":%d,\"present\":{\"clock\":\"%s\",\"interval_ms\":%.3f,\"presented\":%u,\"missed\":%u,\"discarded\":%u},\"caps\":{\"steal\":%s,\"move\":%s,\"split\":%s,\"wsets\":%s,\"tags\":%s,\"vstack\":%s}}",
                                 m->name, m->width, m->height, m->global_x, m->global_y, m->scale, m->refresh_rate,
+                                frame_clock_source_name(m->clock.source), m->clock.interval * 1000.0,
+                                m->clock.presented, m->clock.missed, m->clock.discarded,
                                 m->capabilities.can_steal_workspace?"true":"false",
                                 m->capabilities.supports_workspace_move?"true":"false",
                                 m->capabilities.has_split_plugin?"true":"false",
@@ -913,8 +941,9 @@ bool ipc_process_commands(ipc_context_t* ctx) {
                     if (off + 2 < sizeof(response)) { response[off++] = ']'; response[off++]='}'; response[off++]='\n'; response[off]='\0'; }
                 } else {
                     snprintf(response, sizeof(response),
-                             "Status: Active\nhyprlax running\nLayers: %d\nTarget FPS: %d\nFPS: %.1f\nParallax Inputs: %s\nMonitors: %d\nCompositor: %s\nSocket: %s\n",
-                             layers, target_fps, fps, parallax_inputs, monitors, comp, ctx->socket_path);
+                             "Status: Active\nhyprlax running\nLayers: %d\nTarget FPS: %d\nFPS: %.1f\nParallax Inputs: %s\nMonitors: %d\nCompositor: %s\nSocket: %s\nPending uploads: %llu bytes\nShared textures: %d (%d layer references)\n",
+                             layers, target_fps, fps, parallax_inputs, monitors, comp, ctx->socket_path, upload_bytes,
+                             textures, texture_refs);
                 }
                 success = true;
                 break;
@@ -1141,6 +1170,39 @@ bool ipc_process_commands(ipc_context_t* ctx) {
             (void)n; success = true; break;
         }
 
+        case IPC_CMD_CACHE: {
+            char *sub = strtok(NULL, " \n");
+            if (!sub) { snprintf(response, sizeof(response), "Error: Usage: cache stats|clear\n"); break; }
+            char dir[PATH_MAX];
+            if (!texture_cache_dir(dir, sizeof(dir))) {
+                snprintf(response, sizeof(response), "Error: No cache directory (set XDG_CACHE_HOME or HOME)\n");
+                break;
+            }
+            if (strcmp(sub, "stats") == 0) {
+                texture_cache_stats_t st;
+                texture_cache_stats(&st);
+                hyprlax_context_t *app = (hyprlax_context_t*)ctx->app_context;
+                int budget_mb = app ? app->config.render_options.image_cache : 0;
+                snprintf(response, sizeof(response),
+                         "Image cache: %.*s\n"
+                         "Entries: %d (%.1f MiB of %d MiB%s)\n"
+                         "Hits: %llu  Misses: %llu  Stored: %llu  Evicted: %llu\n",
+                         IPC_PATH_SHOWN, dir, st.entries, (double)st.bytes / (1024.0 * 1024.0), budget_mb,
+                         budget_mb ? "" : ", disabled",
+                         (unsigned long long)st.hits, (unsigned long long)st.misses,
+                         (unsigned long long)st.stores, (unsigned long long)st.evictions);
+                success = true;
+            } else if (strcmp(sub, "clear") == 0) {
+                int removed = texture_cache_clear();
+                if (removed < 0) { snprintf(response, sizeof(response), "Error: Cannot clear %.*s\n", IPC_PATH_SHOWN, dir); break; }
+                snprintf(response, sizeof(response), "Removed %d cached image%s\n", removed, removed == 1 ? "" : "s");
+                success = true;
+            } else {
+                snprintf(response, sizeof(response), "Error: Unknown cache subcommand '%s'\n", sub);
+            }
+            break;
+        }
+
         default:
             ipc_errorf(response, sizeof(response), 1002, "Unknown command '%s'\n", cmd);
             break;
@@ -1270,8 +1332,9 @@ char* ipc_list_layers(ipc_context_t* ctx) {
     char *out = malloc(IPC_MAX_MESSAGE_SIZE); if (!out) return NULL; out[0] = '\0'; size_t off = 0;
                 int guard2 = 0; for (parallax_layer_t *it = app->layers; it && guard2 < (app->layer_count + 4); it = it->next, guard2++) {
                     int w = snprintf(out + off, IPC_MAX_MESSAGE_SIZE - off,
-                         "ID: %u | Path: %s | Shift: %.2f | Opacity: %.2f | Z: %d\n",
-                         it->id, it->image_path ? it->image_path : "<memory>", it->shift_multiplier, it->opacity, it->z_index);
+                         "ID: %u | Path: %s | Shift: %.2f | Opacity: %.2f | Z: %d%s\n",
+                         it->id, it->image_path ? it->image_path : "<memory>", it->shift_multiplier, it->opacity, it->z_index,
+                         it->decode_ticket ? " | Loading" : "");
         if (w < 0 || off + (size_t)w >= IPC_MAX_MESSAGE_SIZE)
             break;
         off += (size_t)w;
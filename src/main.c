@@ -88,13 +88,20 @@ int main(int argc, char **argv) {
             printf("  -e, --easing <type>       Easing function (default: cubic)\n");
             printf("  -c, --config <file>       Load configuration from file\n");
             printf("  -D, --debug               Enable debug output\n");
-            printf("  -r, --renderer <backend>  Renderer backend (gles2, auto)\n");
+            printf("  -r, --renderer <backend>  Renderer backend (gles3, gles2, auto)\n");
             printf("  -p, --platform <backend>  Platform backend (wayland, auto)\n");
             printf("  -C, --compositor <backend> Compositor (hyprland, sway, generic, auto)\n");
             printf("\nMulti-monitor options:\n");
             printf("  --primary-only            Only use primary monitor\n");
             printf("  --monitor <name>          Use specific monitor(s)\n");
             printf("  --disable-monitor <name>  Exclude specific monitor\n");
+            printf("\nHeadless mode (benchmarks, golden images):\n");
+            printf("  --headless                Render offscreen, no compositor needed\n");
+            printf("  --frames <n>              Frames to render (default: %d)\n", HYPRLAX_HEADLESS_DEFAULT_FRAMES);
+            printf("  --headless-size <WxH>     Virtual output size (default: %dx%d)\n",
+                   HYPRLAX_DEFAULT_WINDOW_W, HYPRLAX_DEFAULT_WINDOW_H);
+            printf("  --trace <events.log>      Replay workspace/property events\n");
+            printf("  --dump <file.png>         Write the last frame as PNG\n");
             printf("\nControl Commands:\n");
             printf("  ctl add <image> [shift] [opacity] [blur]  Add a layer\n");
             printf("  ctl remove <id>                           Remove a layer\n");
@@ -21,6 +21,7 @@
 #include "../include/defaults.h"
 #include "../include/renderer.h"
 #include "../../protocols/wlr-layer-shell-client-protocol.h"
+#include "../../protocols/presentation-time-client-protocol.h"
 #include "../include/hyprlax.h"
 #include "../core/monitor.h"
 #include "../include/wayland_api.h"
@@ -53,6 +54,10 @@ typedef struct {
     int output_count;
     hyprlax_context_t *ctx;              /* Back reference to context */
 
+    /* Presentation timing (optional) */
+    struct wp_presentation *presentation;
+    clockid_t presentation_clock;        /* Clock of feedback timestamps */
+
     /* Layer shell protocol */
     struct zwlr_layer_shell_v1 *layer_shell;
     struct zwlr_layer_surface_v1 *layer_surface;  /* Legacy single surface */
@@ -110,6 +115,12 @@ static const struct wl_pointer_listener pointer_listener = {
 /* Global instance (simplified for now) */
 static wayland_data_t *g_wayland_data = NULL;
 
+static double wl_monotonic_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
 /* Frame callback handling for pacing */
 static void frame_done(void *data, struct wl_callback *cb, uint32_t time) {
     monitor_instance_t *monitor = (monitor_instance_t *)data;
@@ -117,6 +128,8 @@ static void frame_done(void *data, struct wl_callback *cb, uint32_t time) {
         monitor_frame_done(monitor);
         /* time is in ms; store seconds for consistency if needed elsewhere */
         monitor->last_frame_time = time / 1000.0;
+        /* The callback's own timestamp has an unspecified base */
+        frame_clock_frame_done(&monitor->clock, wl_monotonic_now());
     }
     if (cb) {
         wl_callback_destroy(cb);
@@ -127,6 +140,55 @@ static const struct wl_callback_listener frame_listener = {
     .done = frame_done,
 };
 
+/* Presentation feedback: when a committed frame actually reached the screen */
+static void presentation_clock_id(void *data, struct wp_presentation *presentation, uint32_t clk_id) {
+    (void)presentation;
+    wayland_data_t *wl_data = (wayland_data_t *)data;
+    wl_data->presentation_clock = (clockid_t)clk_id;
+}
+
+static const struct wp_presentation_listener presentation_listener = {
+    .clock_id = presentation_clock_id,
+};
+
+static void feedback_sync_output(void *data, struct wp_presentation_feedback *feedback,
+                                 struct wl_output *output) {
+    (void)data;
+    (void)feedback;
+    (void)output;
+}
+
+static void feedback_presented(void *data, struct wp_presentation_feedback *feedback,
+                               uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec,
+                               uint32_t refresh, uint32_t seq_hi, uint32_t seq_lo, uint32_t flags) {
+    (void)flags;
+    monitor_instance_t *monitor = (monitor_instance_t *)data;
+    double time = (double)(((uint64_t)tv_sec_hi << 32) | tv_sec_lo) + tv_nsec / 1000000000.0;
+    clockid_t clk = g_wayland_data ? g_wayland_data->presentation_clock : CLOCK_MONOTONIC;
+    if (clk != CLOCK_MONOTONIC) {
+        struct timespec ts;
+        clock_gettime(clk, &ts);
+        time += wl_monotonic_now() - (ts.tv_sec + ts.tv_nsec / 1000000000.0);
+    }
+    uint64_t msc = ((uint64_t)seq_hi << 32) | seq_lo;
+    frame_clock_presented(&monitor->clock, time, refresh / 1000000000.0, msc, msc != 0);
+    monitor->presentation_feedback = NULL;
+    wp_presentation_feedback_destroy(feedback);
+}
+
+static void feedback_discarded(void *data, struct wp_presentation_feedback *feedback) {
+    monitor_instance_t *monitor = (monitor_instance_t *)data;
+    frame_clock_discarded(&monitor->clock);
+    monitor->presentation_feedback = NULL;
+    wp_presentation_feedback_destroy(feedback);
+}
+
+static const struct wp_presentation_feedback_listener feedback_listener = {
+    .sync_output = feedback_sync_output,
+    .presented = feedback_presented,
+    .discarded = feedback_discarded,
+};
+
 /* Forward for monitor surface creation */
 int wayland_create_monitor_surface(monitor_instance_t *monitor);
 
@@ -207,8 +269,11 @@ static void registry_global(void *data, struct wl_registry *registry,
     wayland_data_t *wl_data = (wayland_data_t *)data;
 
     if (strcmp(interface, "wl_compositor") == 0) {
+        /* v4 surfaces accept wl_surface.damage_buffer; EGL's swap-with-damage
+         * falls back to damaging the whole surface on older versions. */
         wl_data->compositor = wl_registry_bind(registry, id,
-                                              &wl_compositor_interface, 1);
+                                              &wl_compositor_interface,
+                                              version < 4 ? version : 4);
     } else if (strcmp(interface, "wl_output") == 0) {
         /* Bind to ALL outputs for multi-monitor support */
         struct wl_output *output = wl_registry_bind(registry, id,
@@ -240,6 +305,11 @@ static void registry_global(void *data, struct wl_registry *registry,
 } else if (strcmp(interface, "zwlr_layer_shell_v1") == 0) {
     wl_data->layer_shell = wl_registry_bind(registry, id,
                                            &zwlr_layer_shell_v1_interface, 1);
+} else if (strcmp(interface, "wp_presentation") == 0) {
+    wl_data->presentation = wl_registry_bind(registry, id, &wp_presentation_interface, 1);
+    if (wl_data->presentation) {
+        wp_presentation_add_listener(wl_data->presentation, &presentation_listener, wl_data);
+    }
 } else if (strcmp(interface, "wl_seat") == 0) {
     wl_data->seat = wl_registry_bind(registry, id, &wl_seat_interface, 5);
     if (wl_data->seat) {
@@ -363,6 +433,7 @@ static int wayland_connect(const char *display_name) {
     if (!g_wayland_data) {
         return HYPRLAX_ERROR_NO_MEMORY;
     }
+    g_wayland_data->presentation_clock = CLOCK_MONOTONIC;
 
     /* Try to connect to Wayland display with retries for startup race condition */
     int max_retries = WAYLAND_CONNECT_MAX_RETRIES;  /* retries */
@@ -419,6 +490,10 @@ static void wayland_disconnect(void) {
     if (g_wayland_data->ctx && g_wayland_data->ctx->monitors) {
         monitor_instance_t *mon = g_wayland_data->ctx->monitors->head;
         while (mon) {
+            if (mon->presentation_feedback) {
+                wp_presentation_feedback_destroy(mon->presentation_feedback);
+                mon->presentation_feedback = NULL;
+            }
             if (mon->wl_egl_window) {
                 wl_egl_window_destroy(mon->wl_egl_window);
                 mon->wl_egl_window = NULL;
@@ -454,6 +529,10 @@ static void wayland_disconnect(void) {
         zwlr_layer_shell_v1_destroy(g_wayland_data->layer_shell);
     }
 
+    if (g_wayland_data->presentation) {
+        wp_presentation_destroy(g_wayland_data->presentation);
+    }
+
     if (g_wayland_data->compositor) {
         wl_compositor_destroy(g_wayland_data->compositor);
     }
@@ -685,15 +764,10 @@ int wayland_create_monitor_surface(monitor_instance_t *monitor) {
             return HYPRLAX_ERROR_NO_MEMORY;
         }
 
-        /* Create EGL surface for this monitor if we have a renderer context */
+        /* Create the render surface for this monitor if we have a renderer context */
         if (g_wayland_data->ctx && g_wayland_data->ctx->renderer) {
-            /* Get the EGL surface creation function from renderer */
-            monitor->egl_surface = gles2_create_monitor_surface(monitor->wl_egl_window);
-
-            if (monitor->egl_surface) {
-                LOG_DEBUG("Created EGL surface for monitor %s", monitor->name);
-            } else {
-                LOG_WARN("Failed to create EGL surface for monitor %s", monitor->name);
+            if (hyprlax_create_monitor_surface(g_wayland_data->ctx, monitor) != HYPRLAX_SUCCESS) {
+                LOG_WARN("Failed to create render surface for monitor %s", monitor->name);
             }
         }
     }
@@ -1140,9 +1214,11 @@ static const char* wayland_get_backend_name(void) {
 /* Commit a monitor's Wayland surface */
 void wayland_commit_monitor_surface(monitor_instance_t *monitor) {
     if (monitor && monitor->wl_surface) {
-        /* Request a frame callback to pace the next frame if not already pending */
-        const char *use_fc = getenv("HYPRLAX_FRAME_CALLBACK");
-        if (use_fc && *use_fc && !monitor->frame_pending) {
+        /* Request a frame callback to pace the next frame if not already pending;
+         * non-blocking presents rely on it to gate each output */
+        bool use_fc = renderer_get_options()->frame_callback;
+        bool nonblocking = g_wayland_data && g_wayland_data->ctx && g_wayland_data->ctx->nonblocking_present;
+        if ((use_fc || nonblocking) && !monitor->frame_pending) {
             struct wl_callback *cb = wl_surface_frame(monitor->wl_surface);
             if (cb) {
                 monitor->frame_callback = cb;
@@ -1157,6 +1233,32 @@ void wayland_commit_monitor_surface(monitor_instance_t *monitor) {
     }
 }
 
+/* One feedback in flight per monitor is enough to keep the clock's phase */
+void wayland_request_present_feedback(monitor_instance_t *monitor) {
+    if (!monitor || !monitor->wl_surface || monitor->presentation_feedback) return;
+    if (!g_wayland_data || !g_wayland_data->presentation) return;
+    monitor->presentation_feedback = wp_presentation_feedback(g_wayland_data->presentation,
+                                                              monitor->wl_surface);
+    if (monitor->presentation_feedback) {
+        wp_presentation_feedback_add_listener(monitor->presentation_feedback,
+                                              &feedback_listener, monitor);
+    }
+}
+
+/* Let the compositor skip what lies beneath the opaque part of a monitor surface */
+void wayland_set_monitor_opaque_region(monitor_instance_t *monitor, int x, int y, int w, int h) {
+    if (!monitor || !monitor->wl_surface || !g_wayland_data || !g_wayland_data->compositor) return;
+    if (w <= 0 || h <= 0) {
+        wl_surface_set_opaque_region(monitor->wl_surface, NULL);
+        return;
+    }
+    struct wl_region *region = wl_compositor_create_region(g_wayland_data->compositor);
+    if (!region) return;
+    wl_region_add(region, x, y, w, h);
+    wl_surface_set_opaque_region(monitor->wl_surface, region);
+    wl_region_destroy(region);
+}
+
 /* Wayland platform operations */
 const platform_ops_t platform_wayland_ops = {
     .init = wayland_init,
@@ -1176,6 +1278,8 @@ const platform_ops_t platform_wayland_ops = {
     .get_native_window = wayland_get_native_window,
     .get_window_size = wayland_get_window_size,
     .commit_monitor_surface = wayland_commit_monitor_surface,
+    .set_opaque_region = wayland_set_monitor_opaque_region,
+    .request_present_feedback = wayland_request_present_feedback,
     .get_cursor_global = wayland_get_cursor_global,
     .realize_monitors = wayland_realize_monitors_now,
     .set_context = wayland_set_context,
@@ -8,16 +8,31 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <GLES2/gl2.h>
 #include "../include/renderer.h"
 #include "../include/shader.h"
 #include "../include/hyprlax_internal.h"
 #include "../include/log.h"
 #include "../include/defaults.h"
+#include "gles2_state.h"
+#include "gles3.h"
 
 /* STB_IMAGE is already implemented in hyprlax.c, just need declarations */
 
+/* Fixed geometry slots; layer quads fill the rest */
+enum {
+    GEOMETRY_QUAD,          /* Fullscreen unit quad */
+    GEOMETRY_BLIT,          /* Same quad sampling a render target */
+    GEOMETRY_FIXED,
+};
+
+/* Attribute locations whose pointers are tracked */
+enum { GLES2_TRACKED_ATTRIBS = 16 };
+enum { GEOMETRY_ATTRIB_NONE, GEOMETRY_ATTRIB_POSITION, GEOMETRY_ATTRIB_TEXCOORD };
+
 /* Private renderer data */
 typedef struct {
     /* EGL context */
@@ -34,12 +49,21 @@ typedef struct {
     shader_program_t *blur_shader;
     shader_program_t *blur_sep_shader;
     shader_program_t *fill_shader;
-
-    /* Vertex buffer for quad rendering */
+    /* Single-pass composites, compiled on first use per layer count */
+    shader_program_t *composite_shaders[HYPRLAX_COMPOSITE_MAX_LAYERS + 1];
+    bool composite_failed[HYPRLAX_COMPOSITE_MAX_LAYERS + 1];
+    int composite_max;      /* Layers per composite draw (0 = disabled) */
+    int composite_limit;    /* ...as far as texture units and uniforms allow */
+
+    /* Persistent geometry: every quad drawn lives in one long-lived vertex
+     * buffer, four vertices per slot (see gles2_geometry_slot) */
     GLuint vbo;
-    GLuint ebo;
-    GLuint position_attrib;
-    GLuint texcoord_attrib;
+    GLfloat geometry[HYPRLAX_GEOMETRY_SLOTS][16];
+    uint32_t geometry_used[HYPRLAX_GEOMETRY_SLOTS];  /* LRU stamps */
+    uint32_t geometry_clock;
+    int geometry_count;
+    /* What each attribute location is pointed at (GEOMETRY_ATTRIB_*) */
+    int attrib_role[GLES2_TRACKED_ATTRIBS];
 
     /* Current state */
     int width;
@@ -51,11 +75,63 @@ typedef struct {
     int blur_downscale; /* 0/1 = full res; >1 = downscale factor */
     int blur_w;
     int blur_h;
+    /* Blurred copies of layer textures, rendered once and drawn with the
+     * basic shader (see gles2_blur_cache_get) */
+    shader_program_t *blur_pass_shader;
+    GLuint blur_cache_fbo;
+    struct {
+        GLuint tex;         /* 0 = free */
+        GLuint source;
+        int width;
+        int height;
+        float spread[2];    /* Kernel spread per axis, in cache texels */
+        uint32_t used;      /* Frame stamp */
+    } blur_cache[HYPRLAX_BLUR_CACHE_ENTRIES];
+    size_t blur_cache_bytes;
+    uint32_t frame_clock;
+    /* Dual-Kawase pyramid for blurs drawn every frame: level 0 holds the
+     * layer at the renderer's size, each further level half the one above
+     * (see gles2_draw_kawase) */
+    shader_program_t *kawase_down_shader;
+    shader_program_t *kawase_up_shader;
+    GLuint kawase_fbo[HYPRLAX_KAWASE_MAX_LEVELS + 1];
+    GLuint kawase_tex[HYPRLAX_KAWASE_MAX_LEVELS + 1];
+    int kawase_w[HYPRLAX_KAWASE_MAX_LEVELS + 1];
+    int kawase_h[HYPRLAX_KAWASE_MAX_LEVELS + 1];
+    /* Offscreen render targets (composite cache); handle = index + 1 */
+    struct {
+        GLuint fbo;
+        GLuint tex;
+        int width;
+        int height;
+    } targets[HYPRLAX_MAX_RENDER_TARGETS];
+    GLuint target_fbo;  /* framebuffer draws resolve to (0 = surface) */
+    /* Damage extensions (NULL/false when unavailable) */
+    PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC swap_with_damage;
+    PFNEGLSETDAMAGEREGIONKHRPROC set_damage_region;
+    bool has_buffer_age;
+    /* Non-blocking presentation: swap interval 0 on every surface, outputs
+     * paced by frame callbacks, fences instead of glFinish. Window surfaces
+     * only; render.blocking_present turns it off. */
+    bool windowed;
+    bool nonblocking;
+    PFNEGLCREATESYNCKHRPROC create_sync;
+    PFNEGLDESTROYSYNCKHRPROC destroy_sync;
+    PFNEGLCLIENTWAITSYNCKHRPROC client_wait_sync;
+    struct {
+        EGLSurface surface;
+        EGLSyncKHR fence;   /* Completion of the last frame presented to it */
+    } surfaces[HYPRLAX_MAX_PRESENT_SURFACES];
+    int surface_count;
 } gles2_renderer_data_t;
 
 /* Global instance */
 static gles2_renderer_data_t *g_gles2_data = NULL;
 static void gles2_create_blur_target(int width, int height);
+static void gles2_apply_options(const render_options_t *options);
+static void gles2_blur_cache_drop(GLuint source);
+static void gles2_blur_cache_flush(void);
+static void gles2_kawase_free(void);
 
 /* Quad vertices for layer rendering */
 static const GLfloat quad_vertices[] = {
@@ -66,9 +142,36 @@ static const GLfloat quad_vertices[] = {
      1.0f,  1.0f,  1.0f, 0.0f,
 };
 
-/* Initialize OpenGL ES 2.0 renderer */
-static int gles2_init(void *native_display, void *native_window,
-                     const renderer_config_t *config) {
+/* Same quad sampling a render target (FBO textures have bottom-left origin) */
+static const GLfloat blit_vertices[] = {
+    -1.0f, -1.0f,  0.0f, 0.0f,
+     1.0f, -1.0f,  1.0f, 0.0f,
+    -1.0f,  1.0f,  0.0f, 1.0f,
+     1.0f,  1.0f,  1.0f, 1.0f,
+};
+
+/* Exact token match within a space-separated EGL extension string */
+static bool egl_has_extension(const char *list, const char *name) {
+    if (!list || !name) return false;
+    size_t len = strlen(name);
+    const char *p = list;
+    while ((p = strstr(p, name)) != NULL) {
+        if ((p == list || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0')) return true;
+        p += len;
+    }
+    return false;
+}
+
+static int gles2_init_gl(gles2_renderer_data_t *data, const renderer_config_t *config);
+
+/* EGL renderable type for a client API version */
+static EGLint gles2_renderable_bit(int es_version) {
+    return es_version >= 3 ? EGL_OPENGL_ES3_BIT_KHR : EGL_OPENGL_ES2_BIT;
+}
+
+/* Initialize an OpenGL ES context of the given major version on a window */
+static int gles2_init_version(void *native_display, void *native_window,
+                              const renderer_config_t *config, int es_version) {
     if (!native_display || !native_window || !config) {
         return HYPRLAX_ERROR_INVALID_ARGS;
     }
@@ -77,6 +180,8 @@ static int gles2_init(void *native_display, void *native_window,
     if (!data) {
         return HYPRLAX_ERROR_NO_MEMORY;
     }
+    data->windowed = true;
+    data->nonblocking = !renderer_get_options()->blocking_present;
 
     /* Initialize EGL */
     data->egl_display = eglGetDisplay((EGLNativeDisplayType)native_display);
@@ -98,13 +203,13 @@ static int gles2_init(void *native_display, void *native_window,
         EGL_GREEN_SIZE, 8,
         EGL_BLUE_SIZE, 8,
         EGL_ALPHA_SIZE, 8,
-        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+        EGL_RENDERABLE_TYPE, gles2_renderable_bit(es_version),
         EGL_NONE
     };
 
-    EGLint num_configs;
+    EGLint num_configs = 0;
     if (!eglChooseConfig(data->egl_display, config_attribs,
-                        &data->egl_config, 1, &num_configs)) {
+                        &data->egl_config, 1, &num_configs) || num_configs < 1) {
         eglTerminate(data->egl_display);
         free(data);
         return HYPRLAX_ERROR_GL_INIT;
@@ -112,7 +217,7 @@ static int gles2_init(void *native_display, void *native_window,
 
     /* Create EGL context */
     EGLint context_attribs[] = {
-        EGL_CONTEXT_CLIENT_VERSION, 2,
+        EGL_CONTEXT_CLIENT_VERSION, es_version,
         EGL_NONE
     };
 
@@ -144,25 +249,62 @@ static int gles2_init(void *native_display, void *native_window,
         return HYPRLAX_ERROR_GL_INIT;
     }
 
-    /* Set up OpenGL state */
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-    glViewport(0, 0, config->width, config->height);
+    return gles2_init_gl(data, config);
+}
+
+/* Initialize OpenGL ES 2.0 renderer */
+static int gles2_init(void *native_display, void *native_window,
+                     const renderer_config_t *config) {
+    return gles2_init_version(native_display, native_window, config, 2);
+}
+
+/* Shared GL setup once a context is current: extensions, buffers, shaders */
+static int gles2_init_gl(gles2_renderer_data_t *data, const renderer_config_t *config) {
+    /* Damage extensions: without them every present damages the full surface */
+    const char *egl_exts = eglQueryString(data->egl_display, EGL_EXTENSIONS);
+    if (egl_has_extension(egl_exts, "EGL_KHR_swap_buffers_with_damage")) {
+        data->swap_with_damage = (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)eglGetProcAddress("eglSwapBuffersWithDamageKHR");
+    } else if (egl_has_extension(egl_exts, "EGL_EXT_swap_buffers_with_damage")) {
+        data->swap_with_damage = (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)eglGetProcAddress("eglSwapBuffersWithDamageEXT");
+    }
+    if (egl_has_extension(egl_exts, "EGL_KHR_partial_update")) {
+        data->set_damage_region = (PFNEGLSETDAMAGEREGIONKHRPROC)eglGetProcAddress("eglSetDamageRegionKHR");
+    }
+    data->has_buffer_age = data->set_damage_region != NULL ||
+                           egl_has_extension(egl_exts, "EGL_EXT_buffer_age");
+    if (data->windowed && egl_has_extension(egl_exts, "EGL_KHR_fence_sync")) {
+        data->create_sync = (PFNEGLCREATESYNCKHRPROC)eglGetProcAddress("eglCreateSyncKHR");
+        data->destroy_sync = (PFNEGLDESTROYSYNCKHRPROC)eglGetProcAddress("eglDestroySyncKHR");
+        data->client_wait_sync = (PFNEGLCLIENTWAITSYNCKHRPROC)eglGetProcAddress("eglClientWaitSyncKHR");
+        if (!data->create_sync || !data->destroy_sync || !data->client_wait_sync) {
+            data->create_sync = NULL;
+        }
+    }
+    LOG_DEBUG("gles2: swap_with_damage=%s partial_update=%s buffer_age=%s nonblocking=%s fence_sync=%s",
+              data->swap_with_damage ? "yes" : "no",
+              data->set_damage_region ? "yes" : "no",
+              data->has_buffer_age ? "yes" : "no",
+              data->nonblocking ? "yes" : "no",
+              data->create_sync ? "yes" : "no");
 
-    /* Create vertex buffer */
+    /* Set up OpenGL state; a new context starts with nothing shadowed */
+    gles2_state_reset();
+    gles2_state_blend(true);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    gles2_state_viewport(0, 0, config->width, config->height);
+
+    /* Persistent vertex buffer: allocated once with the fixed quads, layer
+     * quads are written into free slots as draws are compiled. It stays
+     * bound for the context's lifetime. */
+    memcpy(data->geometry[GEOMETRY_QUAD], quad_vertices, sizeof(quad_vertices));
+    memcpy(data->geometry[GEOMETRY_BLIT], blit_vertices, sizeof(blit_vertices));
+    data->geometry_count = GEOMETRY_FIXED;
     glGenBuffers(1, &data->vbo);
     glBindBuffer(GL_ARRAY_BUFFER, data->vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices),
-                 quad_vertices, GL_STATIC_DRAW);
-
-    /* Create element buffer for indices */
-    GLushort indices[] = {0, 1, 2, 1, 3, 2};
-    glGenBuffers(1, &data->ebo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data->ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(data->geometry), data->geometry, GL_DYNAMIC_DRAW);
 
     /* Compile shaders */
-    if (getenv("HYPRLAX_DEBUG")) {
+    if (renderer_get_options()->debug) {
         fprintf(stderr, "[DEBUG] Compiling basic shader\n");
     }
     data->basic_shader = shader_create_program("basic");
@@ -172,12 +314,12 @@ static int gles2_init(void *native_display, void *native_window,
                       shader_fragment_basic) != HYPRLAX_SUCCESS) {
         fprintf(stderr, "Failed to compile basic shader\n");
         /* Continue anyway - we need at least basic rendering */
-    } else if (getenv("HYPRLAX_DEBUG")) {
+    } else if (renderer_get_options()->debug) {
         fprintf(stderr, "[DEBUG] Basic shader compiled successfully, id=%u\n", data->basic_shader->id);
     }
 
     /* Compile fill shader for fullscreen color overlay */
-    if (getenv("HYPRLAX_DEBUG")) {
+    if (renderer_get_options()->debug) {
         fprintf(stderr, "[DEBUG] Compiling fill shader\n");
     }
     data->fill_shader = shader_create_program("fill");
@@ -185,29 +327,19 @@ static int gles2_init(void *native_display, void *native_window,
         fprintf(stderr, "Failed to compile fill shader\n");
     }
 
-    /* Compile blur shader */
-    if (getenv("HYPRLAX_DEBUG")) {
-        fprintf(stderr, "[DEBUG] Compiling blur shader\n");
-    }
-    const char *use_separable = getenv("HYPRLAX_SEPARABLE_BLUR");
-    const char *down_env = getenv("HYPRLAX_BLUR_DOWNSCALE");
-    if (down_env && *down_env) {
-        int f = atoi(down_env);
-        if (f > 1 && f < 16) data->blur_downscale = f; /* sanity bounds */
-    }
-    if (use_separable && *use_separable) {
-        data->blur_sep_shader = shader_create_program("blur_separable");
-        /* Always compile separable blur with offset-capable vertex shader so u_offset is available */
-        if (shader_compile_separable_blur_with_vertex(data->blur_sep_shader, shader_vertex_basic_offset) != HYPRLAX_SUCCESS) {
-            fprintf(stderr, "Warning: Failed to compile separable blur shader\n");
-            shader_destroy_program(data->blur_sep_shader);
-            data->blur_sep_shader = NULL;
-        } else if (getenv("HYPRLAX_DEBUG")) {
-            fprintf(stderr, "[DEBUG] Separable blur shader compiled successfully, id=%u\n",
-                    data->blur_sep_shader->id);
-        }
-        if (data->blur_sep_shader) {
-            gles2_create_blur_target(config->width, config->height);
+    /* Single-pass composite: limited by texture units and by uniform space
+     * (four vectors per layer); render.single_pass switches it off */
+    {
+        GLint units = 0, vectors = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &units);
+        glGetIntegerv(GL_MAX_FRAGMENT_UNIFORM_VECTORS, &vectors);
+        int max = units;
+        if (vectors / 4 < max) max = vectors / 4;
+        if (max > HYPRLAX_COMPOSITE_MAX_LAYERS) max = HYPRLAX_COMPOSITE_MAX_LAYERS;
+        data->composite_limit = max >= 2 ? max : 0;
+        if (renderer_get_options()->debug) {
+            fprintf(stderr, "[DEBUG] Single-pass composite: up to %d layers (units=%d, vectors=%d)\n",
+                    data->composite_limit, units, vectors);
         }
     }
 
@@ -217,7 +349,7 @@ static int gles2_init(void *native_display, void *native_window,
     if (shader_compile_blur_with_vertex(data->blur_shader, shader_vertex_basic_offset) != HYPRLAX_SUCCESS) {
         shader_destroy_program(data->blur_shader);
         data->blur_shader = NULL;
-    } else if (getenv("HYPRLAX_DEBUG")) {
+    } else if (renderer_get_options()->debug) {
         fprintf(stderr, "[DEBUG] Blur shader compiled successfully, id=%u\n",
                 data->blur_shader->id);
     }
@@ -227,15 +359,191 @@ static int gles2_init(void *native_display, void *native_window,
     data->height = config->height;
     data->vsync_enabled = config->vsync;
 
-    /* Set vsync if requested (default off to prevent GPU blocking when idle) */
-    eglSwapInterval(data->egl_display, config->vsync ? 1 : 0);
+    /* Set vsync if requested (default off to prevent GPU blocking when idle);
+     * monitor surfaces get theirs in gles2_track_surface */
+    eglSwapInterval(data->egl_display, (config->vsync && !data->nonblocking) ? 1 : 0);
 
     /* Store private data globally */
     g_gles2_data = data;
 
+    /* Separable blur and composite limits follow the render options */
+    gles2_apply_options(renderer_get_options());
+
     return HYPRLAX_SUCCESS;
 }
 
+/* Rebuild what the render options select. The separable blur shader is
+ * compiled the first time it is enabled and kept; compile_layer stops
+ * choosing it while the option is off. */
+static void gles2_apply_options(const render_options_t *options) {
+    gles2_renderer_data_t *data = g_gles2_data;
+    if (!data || !options) return;
+
+    data->composite_max = options->single_pass ? data->composite_limit : 0;
+
+    bool nonblocking = data->windowed && !options->blocking_present;
+    if (nonblocking != data->nonblocking) {
+        data->nonblocking = nonblocking;
+        /* Forget the surfaces so each gets its swap interval again on its
+         * next bind; fences only pace non-blocking presents */
+        for (int i = 0; i < data->surface_count; i++) {
+            if (data->surfaces[i].fence != EGL_NO_SYNC_KHR) {
+                data->destroy_sync(data->egl_display, data->surfaces[i].fence);
+            }
+        }
+        data->surface_count = 0;
+        eglSwapInterval(data->egl_display, (data->vsync_enabled && !nonblocking) ? 1 : 0);
+    }
+
+    int downscale = options->blur_downscale > 1 ? options->blur_downscale : 0;
+    bool resize_target = downscale != data->blur_downscale;
+    data->blur_downscale = downscale;
+
+    if (options->separable_blur && !data->blur_sep_shader) {
+        if (options->debug) {
+            fprintf(stderr, "[DEBUG] Compiling separable blur shader\n");
+        }
+        data->blur_sep_shader = shader_create_program("blur_separable");
+        /* Always compile separable blur with offset-capable vertex shader so u_offset is available */
+        if (shader_compile_separable_blur_with_vertex(data->blur_sep_shader, shader_vertex_basic_offset) != HYPRLAX_SUCCESS) {
+            fprintf(stderr, "Warning: Failed to compile separable blur shader\n");
+            shader_destroy_program(data->blur_sep_shader);
+            data->blur_sep_shader = NULL;
+        } else if (options->debug) {
+            fprintf(stderr, "[DEBUG] Separable blur shader compiled successfully, id=%u\n",
+                    data->blur_sep_shader->id);
+        }
+        resize_target = data->blur_sep_shader != NULL;
+    }
+    if (resize_target && data->blur_sep_shader) {
+        gles2_create_blur_target(data->width, data->height);
+    }
+
+    if (options->blur_cache && !data->blur_pass_shader) {
+        data->blur_pass_shader = shader_create_program("blur_pass");
+        if (shader_compile_blur_pass(data->blur_pass_shader) != HYPRLAX_SUCCESS) {
+            fprintf(stderr, "Warning: Failed to compile blur cache shader, blurring every frame\n");
+            shader_destroy_program(data->blur_pass_shader);
+            data->blur_pass_shader = NULL;
+        }
+    }
+    if (!options->blur_cache) gles2_blur_cache_flush();
+
+    if (options->kawase_blur && !data->kawase_down_shader) {
+        data->kawase_down_shader = shader_create_program("kawase_down");
+        data->kawase_up_shader = shader_create_program("kawase_up");
+        if (shader_compile_kawase_blur(data->kawase_down_shader, data->kawase_up_shader) != HYPRLAX_SUCCESS) {
+            fprintf(stderr, "Warning: Failed to compile Kawase blur shaders\n");
+            shader_destroy_program(data->kawase_down_shader);
+            shader_destroy_program(data->kawase_up_shader);
+            data->kawase_down_shader = NULL;
+            data->kawase_up_shader = NULL;
+        }
+    }
+    if (!options->kawase_blur) gles2_kawase_free();
+}
+
+/* Initialize the headless variant: EGL on Mesa's surfaceless platform when
+ * available (falling back to the default display) with a pbuffer surface,
+ * so no window system or compositor is needed. Monitors render into their
+ * own pbuffers (gles2_create_offscreen_surface). */
+static int gles2_headless_init_version(const renderer_config_t *config, int es_version) {
+    if (!config || config->width <= 0 || config->height <= 0) {
+        return HYPRLAX_ERROR_INVALID_ARGS;
+    }
+
+    gles2_renderer_data_t *data = calloc(1, sizeof(gles2_renderer_data_t));
+    if (!data) {
+        return HYPRLAX_ERROR_NO_MEMORY;
+    }
+
+    data->egl_display = EGL_NO_DISPLAY;
+    const char *client_exts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (egl_has_extension(client_exts, "EGL_MESA_platform_surfaceless")) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (get_platform_display) {
+            data->egl_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        }
+    }
+    if (data->egl_display == EGL_NO_DISPLAY) {
+        data->egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (data->egl_display == EGL_NO_DISPLAY) {
+        free(data);
+        return HYPRLAX_ERROR_NO_DISPLAY;
+    }
+
+    EGLint major, minor;
+    if (!eglInitialize(data->egl_display, &major, &minor)) {
+        free(data);
+        return HYPRLAX_ERROR_GL_INIT;
+    }
+
+    EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_RENDERABLE_TYPE, gles2_renderable_bit(es_version),
+        EGL_NONE
+    };
+    EGLint num_configs = 0;
+    if (!eglChooseConfig(data->egl_display, config_attribs, &data->egl_config, 1, &num_configs) ||
+        num_configs < 1) {
+        eglTerminate(data->egl_display);
+        free(data);
+        return HYPRLAX_ERROR_GL_INIT;
+    }
+
+    EGLint context_attribs[] = {
+        EGL_CONTEXT_CLIENT_VERSION, es_version,
+        EGL_NONE
+    };
+    data->egl_context = eglCreateContext(data->egl_display, data->egl_config,
+                                         EGL_NO_CONTEXT, context_attribs);
+    if (data->egl_context == EGL_NO_CONTEXT) {
+        eglTerminate(data->egl_display);
+        free(data);
+        return HYPRLAX_ERROR_GL_INIT;
+    }
+
+    EGLint pbuffer_attribs[] = {
+        EGL_WIDTH, config->width,
+        EGL_HEIGHT, config->height,
+        EGL_NONE
+    };
+    data->egl_surface = eglCreatePbufferSurface(data->egl_display, data->egl_config, pbuffer_attribs);
+    if (data->egl_surface == EGL_NO_SURFACE ||
+        !eglMakeCurrent(data->egl_display, data->egl_surface, data->egl_surface, data->egl_context)) {
+        if (data->egl_surface != EGL_NO_SURFACE) eglDestroySurface(data->egl_display, data->egl_surface);
+        eglDestroyContext(data->egl_display, data->egl_context);
+        eglTerminate(data->egl_display);
+        free(data);
+        return HYPRLAX_ERROR_GL_INIT;
+    }
+    data->current_surface = data->egl_surface;
+    LOG_DEBUG("headless: EGL %d.%d, GL renderer %s", major, minor,
+              (const char *)glGetString(GL_RENDERER));
+
+    int ret = gles2_init_gl(data, config);
+    if (ret == HYPRLAX_SUCCESS) {
+        /* Pbuffers are never shown: always redraw and "present" in full */
+        data->swap_with_damage = NULL;
+        data->set_damage_region = NULL;
+        data->has_buffer_age = false;
+    }
+    return ret;
+}
+
+static int gles2_headless_init(void *native_display, void *native_window,
+                               const renderer_config_t *config) {
+    (void)native_display;
+    (void)native_window;
+    return gles2_headless_init_version(config, 2);
+}
+
 /* Destroy renderer */
 static void gles2_destroy(void) {
     if (!g_gles2_data) return;
@@ -253,13 +561,39 @@ static void gles2_destroy(void) {
     if (g_gles2_data->blur_sep_shader) {
         shader_destroy_program(g_gles2_data->blur_sep_shader);
     }
+    if (g_gles2_data->blur_pass_shader) {
+        shader_destroy_program(g_gles2_data->blur_pass_shader);
+    }
+    gles2_blur_cache_flush();
+    if (g_gles2_data->blur_cache_fbo) {
+        glDeleteFramebuffers(1, &g_gles2_data->blur_cache_fbo);
+    }
+    gles2_kawase_free();
+    if (g_gles2_data->kawase_down_shader) {
+        shader_destroy_program(g_gles2_data->kawase_down_shader);
+    }
+    if (g_gles2_data->kawase_up_shader) {
+        shader_destroy_program(g_gles2_data->kawase_up_shader);
+    }
+    for (int i = 0; i <= HYPRLAX_COMPOSITE_MAX_LAYERS; i++) {
+        if (g_gles2_data->composite_shaders[i]) {
+            shader_destroy_program(g_gles2_data->composite_shaders[i]);
+        }
+    }
 
     if (g_gles2_data->vbo) {
         glDeleteBuffers(1, &g_gles2_data->vbo);
     }
 
-    if (g_gles2_data->ebo) {
-        glDeleteBuffers(1, &g_gles2_data->ebo);
+    for (int i = 0; i < HYPRLAX_MAX_RENDER_TARGETS; i++) {
+        if (g_gles2_data->targets[i].tex) glDeleteTextures(1, &g_gles2_data->targets[i].tex);
+        if (g_gles2_data->targets[i].fbo) glDeleteFramebuffers(1, &g_gles2_data->targets[i].fbo);
+    }
+
+    for (int i = 0; i < g_gles2_data->surface_count; i++) {
+        if (g_gles2_data->surfaces[i].fence != EGL_NO_SYNC_KHR) {
+            g_gles2_data->destroy_sync(g_gles2_data->egl_display, g_gles2_data->surfaces[i].fence);
+        }
     }
 
     if (g_gles2_data->egl_surface != EGL_NO_SURFACE) {
@@ -283,11 +617,13 @@ static void gles2_destroy(void) {
 
     free(g_gles2_data);
     g_gles2_data = NULL;
+    gles2_state_reset();
 }
 
 /* Begin frame */
 static void gles2_begin_frame(void) {
-    /* Nothing special needed for GLES2 */
+    /* Ages blur cache entries */
+    if (g_gles2_data) g_gles2_data->frame_clock++;
 }
 
 /* End frame */
@@ -296,126 +632,165 @@ static void gles2_end_frame(void) {
     glFlush();
 }
 
-/* Present frame */
-static void gles2_present(void) {
-    if (!g_gles2_data) return;
-
-    /* Use current surface for multi-monitor support */
-    EGLSurface surface = g_gles2_data->current_surface ?
-                        g_gles2_data->current_surface :
-                        g_gles2_data->egl_surface;
+/* Surface presents go to (multi-monitor aware) */
+static EGLSurface gles2_present_surface(void) {
+    return g_gles2_data->current_surface ?
+           g_gles2_data->current_surface :
+           g_gles2_data->egl_surface;
+}
 
-    /* Allow skipping glFinish via env for performance testing */
-    const char *no_finish = getenv("HYPRLAX_NO_GLFINISH");
-    if (!no_finish || strcmp(no_finish, "0") == 0) {
-        glFinish();
+/* Index of a surface's presentation state, -1 if untracked */
+static int gles2_find_surface(EGLSurface surface) {
+    for (int i = 0; i < g_gles2_data->surface_count; i++) {
+        if (g_gles2_data->surfaces[i].surface == surface) return i;
     }
-    eglSwapBuffers(g_gles2_data->egl_display, surface);
+    return -1;
 }
 
-/* Fullscreen fade overlay (blended) */
-static void gles2_fade_frame(float r, float g, float b, float a) {
-    if (!g_gles2_data || !g_gles2_data->fill_shader) return;
-    if (a <= HYPRLAX_FADE_ALPHA_MIN) return;
-
-    /* Use fill shader */
-    shader_use(g_gles2_data->fill_shader);
-    GLint loc_col = shader_get_uniform_location(g_gles2_data->fill_shader, "u_color");
-    if (loc_col != -1) glUniform4f(loc_col, r, g, b, a);
-
-    /* Prepare vertices: fullscreen quad (-1..1), dummy texcoords (not used) */
-    GLfloat vertices[] = {
-        -1.0f, -1.0f,  0.0f, 1.0f,
-         1.0f, -1.0f,  1.0f, 1.0f,
-        -1.0f,  1.0f,  0.0f, 0.0f,
-         1.0f,  1.0f,  1.0f, 0.0f
-    };
-
-    GLuint vbo = 0; glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+/* First bind of a surface: swap interval is per-surface state in EGL */
+static void gles2_track_surface(EGLSurface surface) {
+    if (surface == EGL_NO_SURFACE || gles2_find_surface(surface) >= 0) return;
+    if (g_gles2_data->surface_count >= HYPRLAX_MAX_PRESENT_SURFACES) return;
+    int i = g_gles2_data->surface_count++;
+    g_gles2_data->surfaces[i].surface = surface;
+    g_gles2_data->surfaces[i].fence = EGL_NO_SYNC_KHR;
+    eglSwapInterval(g_gles2_data->egl_display,
+                    (g_gles2_data->vsync_enabled && !g_gles2_data->nonblocking) ? 1 : 0);
+}
 
-    GLint pos_attrib = shader_get_attrib_location(g_gles2_data->fill_shader, "a_position");
-    GLint tex_attrib = shader_get_attrib_location(g_gles2_data->fill_shader, "a_texcoord");
-    if (pos_attrib >= 0) {
-        glEnableVertexAttribArray(pos_attrib);
-        glVertexAttribPointer(pos_attrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)0);
+static void gles2_pre_swap(void) {
+    /* Fence the frame so the next one can check the GPU without stalling */
+    int i = g_gles2_data->nonblocking && g_gles2_data->create_sync ?
+            gles2_find_surface(gles2_present_surface()) : -1;
+    if (i >= 0) {
+        if (g_gles2_data->surfaces[i].fence != EGL_NO_SYNC_KHR) {
+            g_gles2_data->destroy_sync(g_gles2_data->egl_display, g_gles2_data->surfaces[i].fence);
+        }
+        g_gles2_data->surfaces[i].fence =
+            g_gles2_data->create_sync(g_gles2_data->egl_display, EGL_SYNC_FENCE_KHR, NULL);
+        return;
     }
-    if (tex_attrib >= 0) {
-        glEnableVertexAttribArray(tex_attrib);
-        glVertexAttribPointer(tex_attrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)(2 * sizeof(GLfloat)));
+    /* render.gl_finish=false skips it for performance testing */
+    if (renderer_get_options()->gl_finish) {
+        glFinish();
     }
+}
 
-    /* Draw blended overlay */
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+/* The GPU is still working on the last frame presented to surface */
+static bool gles2_gpu_busy(void *surface) {
+    if (!g_gles2_data || !g_gles2_data->create_sync) return false;
+    int i = gles2_find_surface((EGLSurface)surface);
+    if (i < 0 || g_gles2_data->surfaces[i].fence == EGL_NO_SYNC_KHR) return false;
+    EGLint status = g_gles2_data->client_wait_sync(g_gles2_data->egl_display,
+                                                   g_gles2_data->surfaces[i].fence, 0, 0);
+    if (status == EGL_TIMEOUT_EXPIRED_KHR) return true;
+    g_gles2_data->destroy_sync(g_gles2_data->egl_display, g_gles2_data->surfaces[i].fence);
+    g_gles2_data->surfaces[i].fence = EGL_NO_SYNC_KHR;
+    return false;
+}
 
-    if (pos_attrib >= 0) glDisableVertexAttribArray(pos_attrib);
-    if (tex_attrib >= 0) glDisableVertexAttribArray(tex_attrib);
-    glDeleteBuffers(1, &vbo);
+/* Present frame */
+static void gles2_present(void) {
+    if (!g_gles2_data) return;
+    gles2_pre_swap();
+    eglSwapBuffers(g_gles2_data->egl_display, gles2_present_surface());
 }
 
-/* Helpers for extended draw */
-static void compute_fit_params(int vw, int vh, int tw, int th, int fit_mode,
-                               float content_scale, float align_x, float align_y,
-                               float *pos_w, float *pos_h,
-                               float *u0, float *v0, float *u1, float *v1) {
-    /* Defaults: STRETCH */
-    *pos_w = 2.0f; /* NDC width span */
-    *pos_h = 2.0f; /* NDC height span */
-    *u0 = 0.0f; *v0 = 0.0f; *u1 = 1.0f; *v1 = 1.0f;
+/* Present with a damage rect; falls back to a full swap */
+static bool gles2_present_damage(const int rect[4]) {
+    if (!g_gles2_data) return false;
+    gles2_pre_swap();
+    EGLSurface surface = gles2_present_surface();
+    if (rect && g_gles2_data->swap_with_damage) {
+        EGLint r[4] = { rect[0], rect[1], rect[2], rect[3] };
+        if (g_gles2_data->swap_with_damage(g_gles2_data->egl_display, surface, r, 1)) {
+            return true;
+        }
+    }
+    eglSwapBuffers(g_gles2_data->egl_display, surface);
+    return false;
+}
 
-    float vw_f = (float)vw, vh_f = (float)vh;
-    float tw_f = (float)tw, th_f = (float)th;
-    if (vw <= 0 || vh <= 0 || tw <= 0 || th <= 0) return;
+static int gles2_get_buffer_age(void) {
+    if (!g_gles2_data || !g_gles2_data->has_buffer_age) return 0;
+    EGLint age = 0;
+    if (!eglQuerySurface(g_gles2_data->egl_display, gles2_present_surface(),
+                         EGL_BUFFER_AGE_KHR, &age)) {
+        return 0;
+    }
+    return age;
+}
 
-    float scale = content_scale;
-    if (scale <= 0.0f) scale = 1.0f;
+static void gles2_set_damage_region(const int rect[4]) {
+    if (!g_gles2_data || !g_gles2_data->set_damage_region || !rect) return;
+    EGLint r[4] = { rect[0], rect[1], rect[2], rect[3] };
+    g_gles2_data->set_damage_region(g_gles2_data->egl_display, gles2_present_surface(), r, 1);
+}
 
-    if (fit_mode == 0) {
-        /* STRETCH: defaults suffice */
-        return;
+/* Slot holding a quad (x, y, u, v per corner). Quads not in the buffer yet
+ * are written into a free slot, or over the least recently used layer quad;
+ * nothing is ever reallocated. hint is where the caller last found the quad
+ * (-1 = unknown) and is checked before searching. */
+static int gles2_geometry_slot(const GLfloat vertices[16], int hint) {
+    gles2_renderer_data_t *data = g_gles2_data;
+    const size_t size = sizeof(data->geometry[0]);
+    int slot = -1;
+    if (hint >= 0 && hint < data->geometry_count && !memcmp(data->geometry[hint], vertices, size)) {
+        slot = hint;
+    }
+    for (int i = 0; slot < 0 && i < data->geometry_count; i++) {
+        if (!memcmp(data->geometry[i], vertices, size)) slot = i;
+    }
+    if (slot < 0) {
+        if (data->geometry_count < HYPRLAX_GEOMETRY_SLOTS) {
+            slot = data->geometry_count++;
+        } else {
+            slot = GEOMETRY_FIXED;
+            for (int i = GEOMETRY_FIXED + 1; i < HYPRLAX_GEOMETRY_SLOTS; i++) {
+                if (data->geometry_used[i] < data->geometry_used[slot]) slot = i;
+            }
+        }
+        memcpy(data->geometry[slot], vertices, size);
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(slot * size), (GLsizeiptr)size, vertices);
     }
+    data->geometry_used[slot] = ++data->geometry_clock;
+    return slot;
+}
 
-    if (fit_mode == 1 /* COVER */ || fit_mode == 3 /* FIT_WIDTH */ || fit_mode == 4 /* FIT_HEIGHT */) {
-        float sx = vw_f / tw_f;
-        float sy = vh_f / th_f;
-        float s = sx;
-        if (fit_mode == 1) s = (sx > sy ? sx : sy); /* cover */
-        else if (fit_mode == 4) s = sy; /* fit height */
-        else s = sx; /* fit width */
-        s *= scale;
-        /* uv window to sample */
-        float uvw = vw_f / (s * tw_f);
-        float uvh = vh_f / (s * th_f);
-        if (uvw > 1.0f) uvw = 1.0f;
-        if (uvh > 1.0f) uvh = 1.0f;
-        *u0 = (1.0f - uvw) * (align_x < 0.0f ? 0.0f : (align_x > 1.0f ? 1.0f : align_x));
-        *v0 = (1.0f - uvh) * (align_y < 0.0f ? 0.0f : (align_y > 1.0f ? 1.0f : align_y));
-        *u1 = *u0 + uvw;
-        *v1 = *v0 + uvh;
-        /* positions cover full screen */
-        *pos_w = 2.0f;
-        *pos_h = 2.0f;
-        return;
+/* Draw one slot of the persistent buffer with a program. GLES2 has no vertex
+ * array objects, so attribute pointers are global: a location is only
+ * (re)pointed when it last fed a different attribute. */
+static void gles2_draw_geometry(shader_program_t *shader, int slot) {
+    const GLint locations[2] = {
+        shader_get_attrib_location(shader, "a_position"),
+        shader_get_attrib_location(shader, "a_texcoord"),
+    };
+    for (int a = 0; a < 2; a++) {
+        GLint loc = locations[a];
+        int role = a == 0 ? GEOMETRY_ATTRIB_POSITION : GEOMETRY_ATTRIB_TEXCOORD;
+        if (loc < 0) continue;
+        if (loc < GLES2_TRACKED_ATTRIBS) {
+            if (g_gles2_data->attrib_role[loc] == role) continue;
+            g_gles2_data->attrib_role[loc] = role;
+        }
+        glEnableVertexAttribArray(loc);
+        glVertexAttribPointer(loc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat),
+                              (void*)(a * 2 * sizeof(GLfloat)));
     }
+    gles2_state_draw_arrays(GL_TRIANGLE_STRIP, slot * 4, 4);
+}
 
-    if (fit_mode == 2 /* CONTAIN */) {
-        float sx = vw_f / tw_f;
-        float sy = vh_f / th_f;
-        float s = (sx < sy ? sx : sy);
-        s *= scale;
-        /* pos size in NDC to letterbox */
-        float screen_w_px = s * tw_f;
-        float screen_h_px = s * th_f;
-        float nx = (screen_w_px / vw_f) * 2.0f; /* full screen = 2.0 */
-        float ny = (screen_h_px / vh_f) * 2.0f;
-        if (nx > 2.0f) nx = 2.0f;
-        if (ny > 2.0f) ny = 2.0f;
-        *pos_w = nx;
-        *pos_h = ny;
-        *u0 = 0.0f; *v0 = 0.0f; *u1 = 1.0f; *v1 = 1.0f;
-        return;
-    }
+/* Fullscreen fade overlay (blended) */
+static void gles2_fade_frame(float r, float g, float b, float a) {
+    if (!g_gles2_data || !g_gles2_data->fill_shader) return;
+    if (a <= HYPRLAX_FADE_ALPHA_MIN) return;
+
+    /* Use fill shader */
+    gles2_state_use_program(g_gles2_data->fill_shader->id);
+    gles2_state_uniform4f(g_gles2_data->fill_shader->loc_u_color, r, g, b, a);
+
+    /* Draw blended overlay over the fullscreen quad */
+    gles2_draw_geometry(g_gles2_data->fill_shader, GEOMETRY_QUAD);
 }
 
 /* Clear screen */
@@ -438,13 +813,11 @@ static texture_t* gles2_create_texture(const void *data, int width, int height,
 
     GLuint tex_id;
     glGenTextures(1, &tex_id);
-    glBindTexture(GL_TEXTURE_2D, tex_id);
+    gles2_state_bind_texture(0, tex_id);
 
     /* Set texture parameters */
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gles2_state_tex_filter(tex_id, GL_LINEAR, GL_LINEAR);
+    gles2_state_tex_wrap(tex_id, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
 
     /* Upload texture data */
     GLenum gl_format = GL_RGBA;
@@ -476,480 +849,722 @@ static void gles2_destroy_texture(texture_t *texture) {
     if (texture->id) {
         GLuint tex_id = texture->id;
         glDeleteTextures(1, &tex_id);
+        gles2_state_forget_texture(tex_id);
+        gles2_blur_cache_drop(tex_id);
     }
 
     free(texture);
 }
 
-/* Bind texture */
+/* Bind texture (redundant binds are dropped by the state tracker) */
 static void gles2_bind_texture(const texture_t *texture, int unit) {
     if (!texture) return;
+    gles2_state_bind_texture(unit, texture->id);
+}
 
-    /* Track last active unit and bound texture to avoid redundant state changes */
-    enum { MAX_TRACKED_UNITS = 8 };
-    static int s_active_unit = -1;
-    static GLuint s_bound_tex[MAX_TRACKED_UNITS] = {0};
+/* Sampling setup of a bound layer image; power-of-two images get mipmaps */
+static void gles2_finish_texture(GLuint tex_id, int width, int height) {
+    bool pow2 = (width & (width - 1)) == 0 && (height & (height - 1)) == 0;
+    if (pow2) glGenerateMipmap(GL_TEXTURE_2D);
+    gles2_state_tex_filter(tex_id, pow2 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR, GL_LINEAR);
+    gles2_state_tex_wrap(tex_id, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+}
 
-    if (unit < 0 || unit >= MAX_TRACKED_UNITS) unit = 0;
+/* Upload a layer image */
+static uint32_t gles2_upload_texture(const uint8_t *rgba, int width, int height) {
+    if (!rgba || width <= 0 || height <= 0) return 0;
 
-    if (s_active_unit != unit) {
-        glActiveTexture(GL_TEXTURE0 + unit);
-        s_active_unit = unit;
-    }
-    if (s_bound_tex[unit] != texture->id) {
-        glBindTexture(GL_TEXTURE_2D, texture->id);
-        s_bound_tex[unit] = texture->id;
-    }
+    GLuint tex_id = 0;
+    glGenTextures(1, &tex_id);
+    if (!tex_id) return 0;
+    gles2_state_bind_texture(0, tex_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    gles2_finish_texture(tex_id, width, height);
+    return tex_id;
 }
 
-/* Draw layer */
-static void gles2_draw_layer_internal(const texture_t *texture, float x, float y,
-                            float opacity, float blur_amount,
-                            const renderer_layer_params_t *params) {
-    static int draw_count = 0;
-    if (draw_count < 5 && getenv("HYPRLAX_DEBUG")) {
-        fprintf(stderr, "[DEBUG] gles2_draw_layer %d: tex=%u, x=%.3f, opacity=%.3f, blur=%.3f\n",
-                draw_count, texture ? texture->id : 0, x, opacity, blur_amount);
+/* Banded uploads: storage first, then glTexSubImage2D per band of rows */
+static uint32_t gles2_begin_upload(int width, int height) {
+    if (width <= 0 || height <= 0) return 0;
+    GLuint tex_id = 0;
+    glGenTextures(1, &tex_id);
+    if (!tex_id) return 0;
+    gles2_state_bind_texture(0, tex_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    return tex_id;
+}
+
+static void gles2_upload_rows(uint32_t id, const uint8_t *rgba, int width, int y, int rows) {
+    if (!id || !rgba || rows <= 0) return;
+    gles2_state_bind_texture(0, id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+}
+
+static void gles2_finish_upload(uint32_t id, int width, int height) {
+    if (!id) return;
+    gles2_state_bind_texture(0, id);
+    gles2_finish_texture(id, width, height);
+}
+
+static int gles2_max_texture_size(void) {
+    GLint size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &size);
+    return size;
+}
+
+static void gles2_delete_texture(uint32_t id) {
+    if (!id) return;
+    GLuint tex_id = id;
+    glDeleteTextures(1, &tex_id);
+    gles2_state_forget_texture(tex_id);
+    gles2_blur_cache_drop(tex_id);
+}
+
+/* ---- Blur cache -----------------------------------------------------------
+ * A layer's image never changes while it animates, only its offset does, so
+ * a blurred layer is rendered once into a texture (two directional passes
+ * through an FBO) and then drawn like any unblurred layer. Entries are keyed
+ * by source texture, resolution and kernel spread, so a changed blur amount,
+ * fit or output size (all of which recompile the draw) renders a new entry;
+ * the one it supersedes is freed once it has gone unused for a while, and
+ * all of a texture's entries go when the texture is deleted. */
+
+static void gles2_blur_cache_free(int i) {
+    if (!g_gles2_data->blur_cache[i].tex) return;
+    GLuint tex = g_gles2_data->blur_cache[i].tex;
+    glDeleteTextures(1, &tex);
+    gles2_state_forget_texture(tex);
+    g_gles2_data->blur_cache_bytes -= (size_t)g_gles2_data->blur_cache[i].width *
+                                      (size_t)g_gles2_data->blur_cache[i].height * 4;
+    memset(&g_gles2_data->blur_cache[i], 0, sizeof(g_gles2_data->blur_cache[i]));
+}
+
+static void gles2_blur_cache_drop(GLuint source) {
+    if (!g_gles2_data) return;
+    for (int i = 0; i < HYPRLAX_BLUR_CACHE_ENTRIES; i++) {
+        if (g_gles2_data->blur_cache[i].source == source) gles2_blur_cache_free(i);
     }
+}
 
-    if (!texture || !g_gles2_data || !g_gles2_data->basic_shader) {
-        if (draw_count < 5 && getenv("HYPRLAX_DEBUG")) {
-            fprintf(stderr, "[DEBUG] gles2_draw_layer: Missing %s\n",
-                    !texture ? "texture" : !g_gles2_data ? "gles2_data" : "shader");
+static void gles2_blur_cache_flush(void) {
+    if (!g_gles2_data) return;
+    for (int i = 0; i < HYPRLAX_BLUR_CACHE_ENTRIES; i++) gles2_blur_cache_free(i);
+}
+
+/* Cache resolution for a draw: the texture's on-screen size, never more than
+ * the texture itself, divided by render.blur_downscale. The spread is scaled
+ * so the blur radius stays in screen pixels whatever the resolution. */
+static void gles2_blur_cache_key(const renderer_draw_packet_t *packet, int *width, int *height,
+                                 float spread[2]) {
+    int tex_size[2] = { packet->tex_width, packet->tex_height };
+    int screen[2] = { g_gles2_data->width, g_gles2_data->height };
+    int factor = g_gles2_data->blur_downscale > 1 ? g_gles2_data->blur_downscale : 1;
+    int size[2];
+    for (int axis = 0; axis < 2; axis++) {
+        float extent = (packet->bounds[axis + 2] - packet->bounds[axis]) * 0.5f * (float)screen[axis];
+        float span = fabsf(packet->vertices[12 + axis + 2] - packet->vertices[axis + 2]);
+        float shown = span > 1e-6f ? extent / span : (float)tex_size[axis];
+        if (shown < 1.0f) shown = 1.0f;
+        float res = fminf(shown, (float)tex_size[axis]) / (float)factor;
+        size[axis] = res < 1.0f ? 1 : (int)res;
+        spread[axis] = packet->blur_amount * (float)size[axis] / shown;
+    }
+    *width = size[0];
+    *height = size[1];
+}
+
+/* Render source blurred into a new width x height texture; 0 on failure */
+static GLuint gles2_blur_cache_render(GLuint source, int width, int height, const float spread[2]) {
+    shader_program_t *shader = g_gles2_data->blur_pass_shader;
+    if (!g_gles2_data->blur_cache_fbo) glGenFramebuffers(1, &g_gles2_data->blur_cache_fbo);
+
+    /* Horizontal pass into scratch, vertical pass into the result */
+    GLuint tex[2] = { 0, 0 };
+    glGenTextures(2, tex);
+    for (int i = 0; i < 2; i++) {
+        gles2_state_bind_texture(0, tex[i]);
+        gles2_state_tex_filter(tex[i], GL_LINEAR, GL_LINEAR);
+        gles2_state_tex_wrap(tex[i], GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    }
+
+    GLint prev_viewport[4];
+    gles2_state_get_viewport(prev_viewport);
+    bool blend_was_enabled = gles2_state_blend_enabled();
+    gles2_state_blend(false);
+    gles2_state_viewport(0, 0, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, g_gles2_data->blur_cache_fbo);
+
+    gles2_state_use_program(shader->id);
+    gles2_state_uniform1i(shader->loc_u_texture, 0);
+    gles2_state_uniform2f(shader->loc_u_resolution, (float)width, (float)height);
+
+    /* Each pass through the unit quad flips V, so two leave the result
+     * upright like the source */
+    GLenum status = GL_FRAMEBUFFER_COMPLETE;
+    const GLuint inputs[2] = { source, tex[0] };
+    for (int pass = 0; pass < 2 && status == GL_FRAMEBUFFER_COMPLETE; pass++) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex[pass], 0);
+        status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE) break;
+        gles2_state_bind_texture(0, inputs[pass]);
+        gles2_state_uniform2f(shader->loc_u_direction, pass == 0 ? 1.0f : 0.0f, pass == 0 ? 0.0f : 1.0f);
+        gles2_state_uniform1f(shader->loc_u_blur_amount, spread[pass]);
+        gles2_draw_geometry(shader, GEOMETRY_QUAD);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, g_gles2_data->target_fbo);
+    gles2_state_viewport(prev_viewport[0], prev_viewport[1], prev_viewport[2], prev_viewport[3]);
+    gles2_state_blend(blend_was_enabled);
+
+    glDeleteTextures(1, &tex[0]);
+    gles2_state_forget_texture(tex[0]);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        LOG_WARN("gles2: blur cache target %dx%d incomplete (0x%x)", width, height, status);
+        glDeleteTextures(1, &tex[1]);
+        gles2_state_forget_texture(tex[1]);
+        return 0;
+    }
+    return tex[1];
+}
+
+/* Blurred copy of source for a compiled draw, rendered on first use; 0 if
+ * caching is off or the blur cannot be cached (the draw then blurs live) */
+static GLuint gles2_blur_cache_get(GLuint source, const renderer_draw_packet_t *packet) {
+    if (!g_gles2_data->blur_pass_shader || !renderer_get_options()->blur_cache) return 0;
+
+    int width, height;
+    float spread[2];
+    gles2_blur_cache_key(packet, &width, &height, spread);
+    uint32_t now = g_gles2_data->frame_clock;
+    for (int i = 0; i < HYPRLAX_BLUR_CACHE_ENTRIES; i++) {
+        if (g_gles2_data->blur_cache[i].tex && g_gles2_data->blur_cache[i].source == source &&
+            g_gles2_data->blur_cache[i].width == width && g_gles2_data->blur_cache[i].height == height &&
+            g_gles2_data->blur_cache[i].spread[0] == spread[0] &&
+            g_gles2_data->blur_cache[i].spread[1] == spread[1]) {
+            g_gles2_data->blur_cache[i].used = now;
+            return g_gles2_data->blur_cache[i].tex;
         }
-        draw_count++;
-        return;
     }
 
-    /* Setup vertices for quad; will adjust according to fit params */
-    GLfloat vertices[] = {
-        -1.0f, -1.0f,  0.0f, 1.0f,
-         1.0f, -1.0f,  1.0f, 1.0f,
-        -1.0f,  1.0f,  0.0f, 0.0f,
-         1.0f,  1.0f,  1.0f, 0.0f
-    };
-
-    float u0=0.0f, v0=0.0f, u1=1.0f, v1=1.0f;
-    float pos_w = 2.0f, pos_h = 2.0f;
-    if (params && g_gles2_data) {
-        compute_fit_params(g_gles2_data->width, g_gles2_data->height,
-                           texture->width, texture->height,
-                           params->fit_mode, params->content_scale,
-                           params->align_x, params->align_y,
-                           &pos_w, &pos_h, &u0, &v0, &u1, &v1);
-
-        /* Apply only base UV offset (do not add parallax here) */
-        float du = params->base_uv_x;
-        float dv = params->base_uv_y;
-        u0 += du; u1 += du; v0 += dv; v1 += dv;
-
-        /* Apply UV margins (safe area) if provided */
-        float uv_margin_x = 0.0f, uv_margin_y = 0.0f;
-        if (params->margin_px_x > 0.0f || params->margin_px_y > 0.0f) {
-            uv_margin_x += params->margin_px_x / (float)g_gles2_data->width;
-            uv_margin_y += params->margin_px_y / (float)g_gles2_data->height;
+    /* Entries this one supersedes (same texture, older blur or size), unless
+     * another output still draws them */
+    for (int i = 0; i < HYPRLAX_BLUR_CACHE_ENTRIES; i++) {
+        if (g_gles2_data->blur_cache[i].source == source &&
+            now - g_gles2_data->blur_cache[i].used > HYPRLAX_BLUR_CACHE_STALE_FRAMES) {
+            gles2_blur_cache_free(i);
         }
-        /* Add auto safe area when overflow=none and not tiling that axis */
-        if (params->overflow_mode == 4) {
-            uv_margin_x += params->auto_safe_norm_x;
-            uv_margin_y += params->auto_safe_norm_y;
+    }
+
+    /* Make room, least recently used first; never evict this frame's */
+    size_t bytes = (size_t)width * (size_t)height * 4;
+    size_t budget = (size_t)HYPRLAX_BLUR_CACHE_BUDGET_MB << 20;
+    if (bytes > budget) return 0;
+    int slot = -1;
+    for (;;) {
+        int lru = -1;
+        slot = -1;
+        for (int i = 0; i < HYPRLAX_BLUR_CACHE_ENTRIES; i++) {
+            if (!g_gles2_data->blur_cache[i].tex) {
+                if (slot < 0) slot = i;
+            } else if (g_gles2_data->blur_cache[i].used != now &&
+                       (lru < 0 || now - g_gles2_data->blur_cache[i].used >
+                                   now - g_gles2_data->blur_cache[lru].used)) {
+                lru = i;
+            }
         }
-        if (uv_margin_x > 0.0f || uv_margin_y > 0.0f) {
-            u0 += uv_margin_x; u1 -= uv_margin_x;
-            v0 += uv_margin_y; v1 -= uv_margin_y;
-            if (u0 < 0.0f) u0 = 0.0f; if (u1 > 1.0f) u1 = 1.0f; if (u1 < u0) u1 = u0;
-            if (v0 < 0.0f) v0 = 0.0f; if (v1 > 1.0f) v1 = 1.0f; if (v1 < v0) v1 = v0;
+        if (slot >= 0 && g_gles2_data->blur_cache_bytes + bytes <= budget) break;
+        if (lru < 0) return 0;
+        gles2_blur_cache_free(lru);
+    }
+
+    GLuint tex = gles2_blur_cache_render(source, width, height, spread);
+    if (!tex) return 0;
+    g_gles2_data->blur_cache[slot].tex = tex;
+    g_gles2_data->blur_cache[slot].source = source;
+    g_gles2_data->blur_cache[slot].width = width;
+    g_gles2_data->blur_cache[slot].height = height;
+    g_gles2_data->blur_cache[slot].spread[0] = spread[0];
+    g_gles2_data->blur_cache[slot].spread[1] = spread[1];
+    g_gles2_data->blur_cache[slot].used = now;
+    g_gles2_data->blur_cache_bytes += bytes;
+    LOG_DEBUG("gles2: blurred texture %u at %dx%d (blur cache %.1f MB)", source, width, height,
+              (double)g_gles2_data->blur_cache_bytes / (1024.0 * 1024.0));
+    return tex;
+}
+
+/* ---- Dual-Kawase blur ------------------------------------------------------
+ * Blurs that cannot be cached (animated images, layers redrawn over trails)
+ * go through a downsample/upsample pyramid instead of a wide kernel: each
+ * level halves the resolution, so a handful of fixed 5- and 8-tap passes
+ * reach radii that would take dozens of taps per pixel at full size.
+ * renderer_kawase_plan picks the depth from the blur amount and the output
+ * size. */
+
+static void gles2_kawase_free(void) {
+    if (!g_gles2_data) return;
+    for (int i = 0; i <= HYPRLAX_KAWASE_MAX_LEVELS; i++) {
+        if (g_gles2_data->kawase_tex[i]) {
+            glDeleteTextures(1, &g_gles2_data->kawase_tex[i]);
+            gles2_state_forget_texture(g_gles2_data->kawase_tex[i]);
         }
+        if (g_gles2_data->kawase_fbo[i]) glDeleteFramebuffers(1, &g_gles2_data->kawase_fbo[i]);
+    }
+    memset(g_gles2_data->kawase_fbo, 0, sizeof(g_gles2_data->kawase_fbo));
+    memset(g_gles2_data->kawase_tex, 0, sizeof(g_gles2_data->kawase_tex));
+    memset(g_gles2_data->kawase_w, 0, sizeof(g_gles2_data->kawase_w));
+    memset(g_gles2_data->kawase_h, 0, sizeof(g_gles2_data->kawase_h));
+}
 
-        /* Compute quad extents (clamped to viewport) */
-        float hx = pos_w * 0.5f; if (hx > 1.0f) hx = 1.0f;
-        float hy = pos_h * 0.5f; if (hy > 1.0f) hy = 1.0f;
-
-        /* Base alignment translation within letterboxed area */
-        float remx = 2.0f - (hx * 2.0f);
-        float remy = 2.0f - (hy * 2.0f);
-        float tx_ndc = (params->align_x - 0.5f) * remx;
-        float ty_ndc = (params->align_y - 0.5f) * remy;
-
-        /* Parallax translation in NDC: input x/y are normalized to viewport */
-        /* Allow debugging path to force uniform-driven offset (no geometry translation) */
-        /* Extended path: avoid geometry translation; use uniform offset instead */
-        float dx_ndc = 0.0f;
-        float dy_ndc = 0.0f;
-
-        /* Final vertex positions: aligned base + parallax translation */
-        vertices[0] = -hx + tx_ndc + dx_ndc; vertices[1] = -hy + ty_ndc + dy_ndc;
-        vertices[4] =  hx + tx_ndc + dx_ndc; vertices[5] = -hy + ty_ndc + dy_ndc;
-        vertices[8] = -hx + tx_ndc + dx_ndc; vertices[9] =  hy + ty_ndc + dy_ndc;
-        vertices[12]=  hx + tx_ndc + dx_ndc; vertices[13]=  hy + ty_ndc + dy_ndc;
-
-        /* Set texcoords (base UV only) */
-        vertices[2] = u0; vertices[3] = v1;   /* bottom-left */
-        vertices[6] = u1; vertices[7] = v1;   /* bottom-right */
-        vertices[10]= u0; vertices[11]= v0;   /* top-left */
-        vertices[14]= u1; vertices[15]= v0;   /* top-right */
-
-        if (getenv("HYPRLAX_DEBUG")) {
-            fprintf(stderr,
-                    "[DEBUG] draw_ex: hx=%.3f hy=%.3f tx=%.3f ty=%.3f dx=%.3f dy=%.3f du=%.3f dv=%.3f\n",
-                    hx, hy, tx_ndc, ty_ndc, dx_ndc, dy_ndc, du, dv);
+/* Allocate levels 0..levels for the renderer size; existing levels are kept
+ * until the size changes. false if a level cannot be rendered to. */
+static bool gles2_kawase_levels(int levels) {
+    gles2_renderer_data_t *data = g_gles2_data;
+    if (data->kawase_w[0] != data->width || data->kawase_h[0] != data->height) gles2_kawase_free();
+
+    bool ok = true;
+    for (int i = 0; i <= levels && ok; i++) {
+        if (data->kawase_tex[i]) continue;
+        int w = data->width >> i, h = data->height >> i;
+        data->kawase_w[i] = w < 1 ? 1 : w;
+        data->kawase_h[i] = h < 1 ? 1 : h;
+        glGenTextures(1, &data->kawase_tex[i]);
+        gles2_state_bind_texture(0, data->kawase_tex[i]);
+        gles2_state_tex_filter(data->kawase_tex[i], GL_LINEAR, GL_LINEAR);
+        gles2_state_tex_wrap(data->kawase_tex[i], GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, data->kawase_w[i], data->kawase_h[i], 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glGenFramebuffers(1, &data->kawase_fbo[i]);
+        glBindFramebuffer(GL_FRAMEBUFFER, data->kawase_fbo[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, data->kawase_tex[i], 0);
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            LOG_WARN("gles2: Kawase level %d (%dx%d) incomplete (0x%x)", i,
+                     data->kawase_w[i], data->kawase_h[i], status);
+            ok = false;
         }
     }
+    glBindFramebuffer(GL_FRAMEBUFFER, data->target_fbo);
+    if (!ok) gles2_kawase_free();
+    return ok;
+}
+
+/* One pyramid pass: sample level src into level dst (-1 = the active
+ * target at the saved viewport) */
+static void gles2_kawase_pass(shader_program_t *shader, int src, int dst, const GLint viewport[4]) {
+    gles2_renderer_data_t *data = g_gles2_data;
+    if (dst >= 0) {
+        glBindFramebuffer(GL_FRAMEBUFFER, data->kawase_fbo[dst]);
+        gles2_state_viewport(0, 0, data->kawase_w[dst], data->kawase_h[dst]);
+    } else {
+        glBindFramebuffer(GL_FRAMEBUFFER, data->target_fbo);
+        gles2_state_viewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    }
+    gles2_state_bind_texture(0, data->kawase_tex[src]);
+    gles2_state_uniform2f(shader->loc_u_resolution, (float)data->kawase_w[src], (float)data->kawase_h[src]);
+    gles2_draw_geometry(shader, GEOMETRY_BLIT);
+}
+
+/* Draw a layer blurred through the pyramid; false if the pyramid is
+ * unavailable (the caller then uses the single-pass kernel) */
+static bool gles2_draw_kawase(const renderer_draw_packet_t *packet, GLuint texture_id, int slot,
+                              float offset_x, float offset_y) {
+    gles2_renderer_data_t *data = g_gles2_data;
+    if (!data->kawase_down_shader || !data->kawase_up_shader) return false;
+    int levels;
+    float offset;
+    renderer_kawase_plan(packet->blur_amount, data->width, data->height, &levels, &offset);
+    if (!gles2_kawase_levels(levels)) return false;
+
+    GLint prev_viewport[4];
+    gles2_state_get_viewport(prev_viewport);
+    bool blend_was_enabled = gles2_state_blend_enabled();
+    gles2_state_blend(false);
+
+    /* The layer itself, unblurred and premultiplied, into level 0 */
+    shader_program_t *shader = data->basic_shader;
+    glBindFramebuffer(GL_FRAMEBUFFER, data->kawase_fbo[0]);
+    gles2_state_viewport(0, 0, data->kawase_w[0], data->kawase_h[0]);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    gles2_state_use_program(shader->id);
+    gles2_state_uniform1i(shader->loc_u_texture, 0);
+    gles2_state_bind_texture(0, texture_id);
+    gles2_state_uniform1f(shader->loc_u_opacity, 1.0f);
+    gles2_state_uniform1f(shader->loc_u_tint_strength, 0.0f);
+    gles2_state_uniform2f(shader->loc_u_offset, offset_x, offset_y);
+    if (packet->has_params) {
+        gles2_state_uniform2f(shader->loc_u_mask_outside, packet->mask[0], packet->mask[1]);
+        gles2_state_tex_wrap(texture_id, packet->wrap_s, packet->wrap_t);
+    }
+    gles2_draw_geometry(shader, slot);
+
+    /* Down to the smallest level, back up to level 1 */
+    shader = data->kawase_down_shader;
+    gles2_state_use_program(shader->id);
+    gles2_state_uniform1i(shader->loc_u_texture, 0);
+    gles2_state_uniform1f(shader->loc_u_blur_amount, offset);
+    for (int i = 0; i < levels; i++) gles2_kawase_pass(shader, i, i + 1, prev_viewport);
+
+    shader = data->kawase_up_shader;
+    gles2_state_use_program(shader->id);
+    gles2_state_uniform1i(shader->loc_u_texture, 0);
+    gles2_state_uniform1f(shader->loc_u_blur_amount, offset);
+    gles2_state_uniform1f(shader->loc_u_opacity, 1.0f);
+    gles2_state_uniform1f(shader->loc_u_tint_strength, 0.0f);
+    for (int i = levels; i > 1; i--) gles2_kawase_pass(shader, i, i - 1, prev_viewport);
+
+    /* Last upsample resolves onto the target with the layer's look */
+    gles2_state_blend(blend_was_enabled);
+    gles2_state_uniform1f(shader->loc_u_opacity, packet->opacity);
+    gles2_state_uniform3f(shader->loc_u_tint, packet->tint[0], packet->tint[1], packet->tint[2]);
+    gles2_state_uniform1f(shader->loc_u_tint_strength, packet->tint_strength);
+    gles2_kawase_pass(shader, 1, -1, prev_viewport);
+    return true;
+}
+
+/* Shader program a compiled draw resolves to */
+static shader_program_t* gles2_packet_shader(const renderer_draw_packet_t *packet) {
+    if (packet->program == RENDERER_PROGRAM_BLUR_SEPARABLE && g_gles2_data->blur_sep_shader) {
+        return g_gles2_data->blur_sep_shader;
+    }
+    if ((packet->program == RENDERER_PROGRAM_BLUR || packet->program == RENDERER_PROGRAM_BLUR_KAWASE) &&
+        g_gles2_data->blur_shader) {
+        return g_gles2_data->blur_shader;
+    }
+    return g_gles2_data->basic_shader;
+}
 
-    /* Adjust coordinates based on mode */
-    /* Default to uniform-offset; user can disable with HYPRLAX_UNIFORM_OFFSET=0 */
-    int uniform_offset_mode = 1;
-    const char *use_uniform_offset_env = getenv("HYPRLAX_UNIFORM_OFFSET");
-    if (use_uniform_offset_env && *use_uniform_offset_env) {
-        if (!strcmp(use_uniform_offset_env, "0") || !strcasecmp(use_uniform_offset_env, "false")) uniform_offset_mode = 0;
-    }
-    bool using_params = (params != NULL);
-    if (!using_params) {
-        /* Legacy path: encode offset into texcoords over full screen */
-        vertices[2] = x;
-        vertices[3] = 1.0f - y;
-        vertices[6] = 1.0f + x;
-        vertices[7] = 1.0f - y;
-        vertices[10] = x;
-        vertices[11] = 0.0f - y;
-        vertices[14] = 1.0f + x;
-        vertices[15] = 0.0f - y;
-    } else if (!uniform_offset_mode) {
-        /* Extended params path but drive offset via texcoord translation (legacy behavior)
-           so tiling works identically without relying on u_offset. */
-        vertices[2]  += x;  vertices[3]  += -y;  /* bottom-left */
-        vertices[6]  += x;  vertices[7]  += -y;  /* bottom-right */
-        vertices[10] += x;  vertices[11] += -y;  /* top-left */
-        vertices[14] += x;  vertices[15] += -y;  /* top-right */
+/* Resolve fit geometry, UVs, wrap modes and shader for a layer draw.
+ * Depends only on params, texture size and viewport, so callers keep the
+ * packet until one of those changes. */
+static void gles2_compile_layer(const texture_t *texture, float opacity, float blur_amount,
+                                const renderer_layer_params_t *params,
+                                renderer_draw_packet_t *out) {
+    if (!g_gles2_data) {
+        renderer_compile_layer_geometry(0, 0, NULL, opacity, blur_amount, params, out);
+        out->wrap_s = GL_CLAMP_TO_EDGE;
+        out->wrap_t = GL_CLAMP_TO_EDGE;
+        return;
+    }
+    renderer_compile_layer_geometry(g_gles2_data->width, g_gles2_data->height,
+                                    texture, opacity, blur_amount, params, out);
+    out->wrap_s = out->wrap_s == RENDERER_WRAP_REPEAT ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+    out->wrap_t = out->wrap_t == RENDERER_WRAP_REPEAT ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+    if (!texture) {
+        out->geometry = GEOMETRY_QUAD;
+        return;
     }
 
     /* Choose shader based on blur amount */
-    shader_program_t *shader = g_gles2_data->basic_shader;
-    int use_sep_blur = 0;
     if (blur_amount > 0.01f) {
-        if (g_gles2_data->blur_sep_shader && g_gles2_data->blur_fbo && getenv("HYPRLAX_SEPARABLE_BLUR")) {
-            shader = g_gles2_data->blur_sep_shader;
-            use_sep_blur = 1;
-            /* Re-initialize vertices to default texcoords for separable path */
-            GLfloat full_vertices[] = {
-                -1.0f, -1.0f,  0.0f, 1.0f,
-                 1.0f, -1.0f,  1.0f, 1.0f,
-                -1.0f,  1.0f,  0.0f, 0.0f,
-                 1.0f,  1.0f,  1.0f, 0.0f,
-            };
-            memcpy(vertices, full_vertices, sizeof(full_vertices));
+        if (renderer_get_options()->blur_cache && g_gles2_data->blur_pass_shader) {
+            /* Drawn like an unblurred layer, from a blurred copy */
+            out->program = RENDERER_PROGRAM_BLUR_CACHED;
+        } else if (renderer_get_options()->separable_blur &&
+            g_gles2_data->blur_sep_shader && g_gles2_data->blur_fbo) {
+            /* Separable path resolves through a fullscreen quad with default
+             * texcoords and always offsets via u_offset */
+            out->program = RENDERER_PROGRAM_BLUR_SEPARABLE;
+            memcpy(out->vertices, quad_vertices, sizeof(out->vertices));
+            out->bounds[0] = -1.0f; out->bounds[1] = -1.0f;
+            out->bounds[2] = 1.0f; out->bounds[3] = 1.0f;
+        } else if (renderer_get_options()->kawase_blur && g_gles2_data->kawase_down_shader) {
+            /* Keeps the fitted quad, but the blur spills past it */
+            out->program = RENDERER_PROGRAM_BLUR_KAWASE;
+            out->bounds[0] = -1.0f; out->bounds[1] = -1.0f;
+            out->bounds[2] = 1.0f; out->bounds[3] = 1.0f;
         } else if (g_gles2_data->blur_shader) {
-            shader = g_gles2_data->blur_shader;
+            out->program = RENDERER_PROGRAM_BLUR;
         }
-        if (draw_count < 5 && getenv("HYPRLAX_DEBUG")) {
+        if (renderer_get_options()->debug) {
             fprintf(stderr, "[DEBUG] Using %s blur (amount=%.3f)\n",
-                    use_sep_blur ? "separable" : (shader == g_gles2_data->blur_shader ? "single-pass" : "none"),
+                    out->program == RENDERER_PROGRAM_BLUR_CACHED ? "cached" :
+                    out->program == RENDERER_PROGRAM_BLUR_SEPARABLE ? "separable" :
+                    out->program == RENDERER_PROGRAM_BLUR_KAWASE ? "Kawase" :
+                    (out->program == RENDERER_PROGRAM_BLUR ? "single-pass" : "none"),
                     blur_amount);
         }
     }
 
-    /* Use selected shader */
-    shader_use(shader);
-
-    /* Set sampler uniform only when program changes */
-    {
-        static uint32_t s_sampler_prog = 0;
-        if (shader && shader->id != s_sampler_prog) {
-            GLint loc = shader_get_uniform_location(shader, "u_texture");
-            if (loc != -1) {
-                glUniform1i(loc, 0);
-            }
-            s_sampler_prog = shader ? shader->id : 0;
-        }
-    }
-
-    /* Ensure the layer texture is bound before changing sampler state */
-    gles2_bind_texture(texture, 0);
-
-    /* Set uniforms */
-    shader_set_uniform_float(shader, "u_opacity", opacity);
+    /* Write the quad into the persistent buffer now so drawing never has to */
+    out->geometry = gles2_geometry_slot(out->vertices, -1);
 
-    /* Per-layer tint (defaults to no tint if params missing) */
+    /* Per-layer tint overrides */
     {
-        static int s_env_checked = 0;
-        static int s_disable_tint = 0;              /* HYPRLAX_DISABLE_TINT */
-        static int s_tint_on_blur = 1;              /* HYPRLAX_TINT_ON_BLUR (default ON; set 0 to disable) */
-        if (!s_env_checked) {
-            const char *dt = getenv("HYPRLAX_DISABLE_TINT");
-            if (dt && *dt && strcmp(dt, "0") != 0 && strcasecmp(dt, "false") != 0) s_disable_tint = 1;
-            const char *tb = getenv("HYPRLAX_TINT_ON_BLUR");
-            if (tb && *tb) {
-                if ((strcmp(tb, "0") == 0) || !strcasecmp(tb, "false")) s_tint_on_blur = 0; else s_tint_on_blur = 1;
-            }
-            s_env_checked = 1;
-        }
-        float tr = 1.0f, tg = 1.0f, tb = 1.0f, ts = 0.0f;
-        if (params) {
-            tr = params->tint_r; tg = params->tint_g; tb = params->tint_b; ts = params->tint_strength;
-        }
-        if (s_disable_tint) {
-            ts = 0.0f;
+        const render_options_t *options = renderer_get_options();
+        if (!options->tint) {
+            out->tint_strength = 0.0f;
         }
         /* Optionally disable tint on blur programs to isolate driver issues */
-        if (!s_tint_on_blur && (shader == g_gles2_data->blur_shader || shader == g_gles2_data->blur_sep_shader)) {
-            ts = 0.0f;
+        if (!options->tint_on_blur && out->program != RENDERER_PROGRAM_BASIC) {
+            out->tint_strength = 0.0f;
         }
-        GLint loc_tint = shader_get_uniform_location(shader, "u_tint");
-        GLint loc_ts   = shader_get_uniform_location(shader, "u_tint_strength");
-        if (loc_tint != -1) glUniform3f(loc_tint, tr, tg, tb);
-        if (loc_ts != -1)   glUniform1f(loc_ts, ts);
-        if (getenv("HYPRLAX_DEBUG")) {
+        if (options->debug) {
             static int tint_debug_once = 0;
             if (!tint_debug_once) {
-                fprintf(stderr, "[DEBUG] tint uniforms: program=%u loc_tint=%d loc_ts=%d tr=%.3f tg=%.3f tb=%.3f ts=%.3f (on_blur=%d)\n",
-                        shader ? shader->id : 0, loc_tint, loc_ts, tr, tg, tb, ts, s_tint_on_blur);
+                fprintf(stderr, "[DEBUG] tint: program=%d tr=%.3f tg=%.3f tb=%.3f ts=%.3f (on_blur=%d)\n",
+                        out->program, out->tint[0], out->tint[1], out->tint[2],
+                        out->tint_strength, options->tint_on_blur);
                 tint_debug_once = 1;
             }
         }
     }
+}
 
-    /* Legacy blur uniforms */
-    if (shader == g_gles2_data->blur_shader) {
-        shader_set_uniform_float(shader, "u_blur_amount", blur_amount);
-        shader_set_uniform_vec2(shader, "u_resolution",
-                               (float)g_gles2_data->width, (float)g_gles2_data->height);
+
+/* Issue a compiled draw with this frame's texture and parallax offset */
+static void gles2_draw_packet(const renderer_draw_packet_t *packet, uint32_t texture_id,
+                              float x, float y) {
+    static int draw_count = 0;
+    if (draw_count < 5 && renderer_get_options()->debug) {
+        fprintf(stderr, "[DEBUG] gles2_draw_layer %d: tex=%u, x=%.3f, opacity=%.3f, blur=%.3f\n",
+                draw_count, texture_id, x, packet ? packet->opacity : 0.0f,
+                packet ? packet->blur_amount : 0.0f);
     }
 
-    /* If shader supports u_offset, set it (use uniform-offset by default). */
-    {
-        /* Default to uniform-offset; allow opting out with HYPRLAX_UNIFORM_OFFSET=0 */
-        int uniform_offset_mode = 1;
-        const char *env_uo = getenv("HYPRLAX_UNIFORM_OFFSET");
-        if (env_uo && *env_uo) {
-            if (!strcmp(env_uo, "0") || !strcasecmp(env_uo, "false")) uniform_offset_mode = 0;
-        }
-        GLint u_off = shader_get_uniform_location(shader, "u_offset");
-        if (u_off != -1) {
-            if (using_params && uniform_offset_mode) {
-                /* Scale the offset by content_scale to compensate for scaled image */
-                float scale = (params && params->content_scale > 0.0f) ? params->content_scale : 1.0f;
-                float offset_x = x / scale;
-                float offset_y = -y / scale;
-                LOG_DEBUG("Setting u_offset: x=%.3f y=%.3f scale=%.2f -> offset=(%.3f, %.3f)",
-                          x, y, scale, offset_x, offset_y);
-                glUniform2f(u_off, offset_x, offset_y);
-            } else {
-                glUniform2f(u_off, 0.0f, 0.0f);
-            }
-        } else {
-            LOG_DEBUG("WARNING: u_offset uniform not found in shader!");
+    if (!packet || !texture_id || !g_gles2_data || !g_gles2_data->basic_shader) {
+        if (draw_count < 5 && renderer_get_options()->debug) {
+            fprintf(stderr, "[DEBUG] gles2_draw_layer: Missing %s\n",
+                    !packet ? "packet" : !texture_id ? "texture" : !g_gles2_data ? "gles2_data" : "shader");
         }
+        draw_count++;
+        return;
     }
 
-    /* Set u_mask_outside for overflow=none on non-tiled axes */
-    if (using_params) {
-        GLint u_mo = shader_get_uniform_location(shader, "u_mask_outside");
-        if (u_mo != -1) {
-            float mask_x = (params->overflow_mode == 4 && !params->tile_x) ? 1.0f : 0.0f;
-            float mask_y = (params->overflow_mode == 4 && !params->tile_y) ? 1.0f : 0.0f;
-            glUniform2f(u_mo, mask_x, mask_y);
-        }
+    shader_program_t *shader = gles2_packet_shader(packet);
+    bool kawase = packet->program == RENDERER_PROGRAM_BLUR_KAWASE;
+    if (packet->program == RENDERER_PROGRAM_BLUR_CACHED) {
+        GLuint blurred = gles2_blur_cache_get(texture_id, packet);
+        if (blurred) texture_id = blurred;
+        else if (g_gles2_data->kawase_down_shader && renderer_get_options()->kawase_blur) kawase = true;
+        else if (g_gles2_data->blur_shader) shader = g_gles2_data->blur_shader;
     }
+    bool sep_blur = (shader == g_gles2_data->blur_sep_shader);
+    texture_t texture = { .id = texture_id, .width = packet->tex_width, .height = packet->tex_height };
 
-    /* Set texture wrap modes based on overflow (affects currently bound texture) */
-    if (using_params) {
-        GLenum wrap_s = GL_CLAMP_TO_EDGE;
-        GLenum wrap_t = GL_CLAMP_TO_EDGE;
-        if (params->tile_x) wrap_s = GL_REPEAT;
-        if (params->tile_y) wrap_t = GL_REPEAT;
-        if (!params->tile_x) {
-            /* Non-tiled X uses overflow mode (currently clamp for all) */
-            /* Placeholder: extend when 'none/transparent' implemented */
-        }
-        if (!params->tile_y) {
-            /* Non-tiled Y uses overflow mode (currently clamp for all) */
+    /* Geometry is static: the offset always goes through u_offset, which
+     * adds to the texcoords exactly as translating them would */
+    int slot = gles2_geometry_slot(packet->vertices, packet->geometry);
+    float offset_x = x, offset_y = -y;
+    if (packet->uniform_offset || sep_blur) {
+        offset_x *= packet->offset_scale[0];
+        offset_y *= packet->offset_scale[1];
+    }
+
+    if (kawase) {
+        if (gles2_draw_kawase(packet, texture_id, slot, offset_x, offset_y)) {
+            draw_count++;
+            return;
         }
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t);
+        if (g_gles2_data->blur_shader) shader = g_gles2_data->blur_shader;
+    }
+
+    /* Program, texture, sampler and uniform changes all go through the
+     * state tracker: only values that differ from the last draw reach GL */
+    gles2_state_use_program(shader->id);
+    gles2_state_uniform1i(shader->loc_u_texture, 0);
+
+    /* Ensure the layer texture is bound before changing sampler state */
+    gles2_bind_texture(&texture, 0);
+
+    gles2_state_uniform1f(shader->loc_u_opacity, packet->opacity);
+    gles2_state_uniform3f(shader->loc_u_tint, packet->tint[0], packet->tint[1], packet->tint[2]);
+    gles2_state_uniform1f(shader->loc_u_tint_strength, packet->tint_strength);
+
+    /* Legacy blur uniforms */
+    if (shader == g_gles2_data->blur_shader) {
+        gles2_state_uniform1f(shader->loc_u_blur_amount, packet->blur_amount);
+        gles2_state_uniform2f(shader->loc_u_resolution,
+                              (float)g_gles2_data->width, (float)g_gles2_data->height);
+    }
+
+    gles2_state_uniform2f(shader->loc_u_offset, offset_x, offset_y);
+
+    if (packet->has_params) {
+        gles2_state_uniform2f(shader->loc_u_mask_outside, packet->mask[0], packet->mask[1]);
+        /* Wrap modes belong to the (bound) texture */
+        gles2_state_tex_wrap(texture_id, packet->wrap_s, packet->wrap_t);
     }
 
     /* Separable blur path: two passes (horizontal to FBO, vertical to default) */
-    if (use_sep_blur) {
-        GLint loc_amt = shader_get_uniform_location(shader, "u_blur_amount");
-        if (loc_amt != -1) glUniform1f(loc_amt, blur_amount);
-        GLint loc_res = shader_get_uniform_location(shader, "u_resolution");
+    if (sep_blur) {
+        gles2_state_uniform1f(shader->loc_u_blur_amount, packet->blur_amount);
         /* First pass samples the source layer texture: use texture resolution */
-        if (loc_res != -1) glUniform2f(loc_res, (float)texture->width, (float)texture->height);
-        GLint loc_dir = shader_get_uniform_location(shader, "u_direction");
-        /* Always apply layer offset via u_offset for separable blur pass 1 */
-        {
-            GLint u_off = shader_get_uniform_location(shader, "u_offset");
-            if (u_off != -1) {
-                /* Scale the offset by content_scale to compensate for scaled image */
-                float scale = (params && params->content_scale > 0.0f) ? params->content_scale : 1.0f;
-                glUniform2f(u_off, x / scale, -y / scale);
-            }
-        }
+        gles2_state_uniform2f(shader->loc_u_resolution, (float)texture.width, (float)texture.height);
         /* Save viewport and blend state */
         GLint prev_viewport[4];
-        glGetIntegerv(GL_VIEWPORT, prev_viewport);
-        GLboolean blend_was_enabled = glIsEnabled(GL_BLEND);
-        if (blend_was_enabled) glDisable(GL_BLEND);
+        gles2_state_get_viewport(prev_viewport);
+        bool blend_was_enabled = gles2_state_blend_enabled();
+        gles2_state_blend(false);
 
         /* First pass: horizontal to downscaled FBO (always use default texcoords + u_offset) */
-        if (loc_dir != -1) glUniform2f(loc_dir, 1.0f, 0.0f);
+        gles2_state_uniform2f(shader->loc_u_direction, 1.0f, 0.0f);
         glBindFramebuffer(GL_FRAMEBUFFER, g_gles2_data->blur_fbo);
-        glViewport(0, 0, g_gles2_data->blur_w, g_gles2_data->blur_h);
-        gles2_bind_texture(texture, 0);
-
-        /* Setup vertex data */
-        const char *persist_vbo = getenv("HYPRLAX_PERSISTENT_VBO");
-        GLuint vbo = 0;
-        if (persist_vbo && *persist_vbo && g_gles2_data->vbo) {
-            glBindBuffer(GL_ARRAY_BUFFER, g_gles2_data->vbo);
-            /* Use precomputed vertices (pos+texcoords) */
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        } else {
-            glGenBuffers(1, &vbo);
-            glBindBuffer(GL_ARRAY_BUFFER, vbo);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-        }
-
-        GLint pos_attrib = shader_get_attrib_location(shader, "a_position");
-        GLint tex_attrib = shader_get_attrib_location(shader, "a_texcoord");
-        if (pos_attrib >= 0) {
-            glEnableVertexAttribArray(pos_attrib);
-            glVertexAttribPointer(pos_attrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)0);
-        }
-        if (tex_attrib >= 0) {
-            glEnableVertexAttribArray(tex_attrib);
-            glVertexAttribPointer(tex_attrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)(2 * sizeof(GLfloat)));
-        }
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        gles2_state_viewport(0, 0, g_gles2_data->blur_w, g_gles2_data->blur_h);
+        gles2_draw_geometry(shader, slot);
 
-        /* Second pass: vertical to default framebuffer (upsampling) */
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        /* Second pass: vertical to the active target (upsampling) */
+        glBindFramebuffer(GL_FRAMEBUFFER, g_gles2_data->target_fbo);
         /* Restore full-screen viewport & blend before drawing to default framebuffer */
-        glViewport(prev_viewport[0], prev_viewport[1], prev_viewport[2], prev_viewport[3]);
-        if (blend_was_enabled) glEnable(GL_BLEND);
+        gles2_state_viewport(prev_viewport[0], prev_viewport[1], prev_viewport[2], prev_viewport[3]);
+        gles2_state_blend(blend_was_enabled);
         /* Vertical sampling resolution: use downscaled if enabled, else screen */
-        if (loc_res != -1) {
-            if (g_gles2_data->blur_downscale > 1)
-                glUniform2f(loc_res, (float)g_gles2_data->blur_w, (float)g_gles2_data->blur_h);
-            else
-                glUniform2f(loc_res, (float)g_gles2_data->width, (float)g_gles2_data->height);
-        }
-        if (loc_dir != -1) glUniform2f(loc_dir, 0.0f, 1.0f);
+        if (g_gles2_data->blur_downscale > 1)
+            gles2_state_uniform2f(shader->loc_u_resolution, (float)g_gles2_data->blur_w, (float)g_gles2_data->blur_h);
+        else
+            gles2_state_uniform2f(shader->loc_u_resolution, (float)g_gles2_data->width, (float)g_gles2_data->height);
+        gles2_state_uniform2f(shader->loc_u_direction, 0.0f, 1.0f);
         /* Ensure we don't apply layer offset again on the second pass */
-        {
-            GLint u_off = shader_get_uniform_location(shader, "u_offset");
-            if (u_off != -1) glUniform2f(u_off, 0.0f, 0.0f);
-        }
+        gles2_state_uniform2f(shader->loc_u_offset, 0.0f, 0.0f);
         texture_t tmp = { .id = g_gles2_data->blur_tex };
         gles2_bind_texture(&tmp, 0);
-        /* Rebind vertex data and attrib pointers to be explicit for second pass */
-        if (persist_vbo && *persist_vbo && g_gles2_data->vbo) {
-            glBindBuffer(GL_ARRAY_BUFFER, g_gles2_data->vbo);
-            /* For separable path, sample the FBO texture; flip V for FBO sampling */
-            GLfloat v2[] = {
-                vertices[0], vertices[1], vertices[2], 1.0f - vertices[3],
-                vertices[4], vertices[5], vertices[6], 1.0f - vertices[7],
-                vertices[8], vertices[9], vertices[10],1.0f - vertices[11],
-                vertices[12],vertices[13],vertices[14],1.0f - vertices[15]
-            };
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(v2), v2);
-        } else {
-            glBindBuffer(GL_ARRAY_BUFFER, vbo);
-            GLfloat v2[] = {
-                vertices[0], vertices[1], vertices[2], 1.0f - vertices[3],
-                vertices[4], vertices[5], vertices[6], 1.0f - vertices[7],
-                vertices[8], vertices[9], vertices[10],1.0f - vertices[11],
-                vertices[12],vertices[13],vertices[14],1.0f - vertices[15]
-            };
-            glBufferData(GL_ARRAY_BUFFER, sizeof(v2), v2, GL_STATIC_DRAW);
-        }
-        if (pos_attrib >= 0) {
-            glEnableVertexAttribArray(pos_attrib);
-            glVertexAttribPointer(pos_attrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)0);
-        }
-        if (tex_attrib >= 0) {
-            glEnableVertexAttribArray(tex_attrib);
-            glVertexAttribPointer(tex_attrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)(2 * sizeof(GLfloat)));
-        }
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-
-        if (pos_attrib >= 0) glDisableVertexAttribArray(pos_attrib);
-        if (tex_attrib >= 0) glDisableVertexAttribArray(tex_attrib);
-        if (!(persist_vbo && *persist_vbo)) {
-            glDeleteBuffers(1, &vbo);
-        }
-
-        goto done;
+        /* Sample the FBO texture: the fullscreen quad with V flipped */
+        slot = GEOMETRY_BLIT;
     }
 
-    /* Texture already bound earlier when setting wrap state */
+    /* Draw quad */
+    gles2_draw_geometry(shader, slot);
 
-    /* If uniform-offset mode, set u_offset */
-    if (uniform_offset_mode) {
-        GLint u_off = shader_get_uniform_location(shader, "u_offset");
-        /* When uniform-offset is enabled, always drive offset via uniform to debug path. */
-        if (u_off != -1) {
-            /* Scale the offset by content_scale to compensate for scaled image */
-            float scale = (params && params->content_scale > 0.0f) ? params->content_scale : 1.0f;
-            glUniform2f(u_off, x / scale, -y / scale);
+    /* Check for GL errors */
+    if (draw_count < 5 && renderer_get_options()->debug) {
+        GLenum err = glGetError();
+        if (err != GL_NO_ERROR) {
+            fprintf(stderr, "[DEBUG] GL Error after draw: 0x%x\n", err);
         }
+        fprintf(stderr, "[DEBUG] gles2_draw_layer %d: Complete\n", draw_count);
     }
 
-    /* Setup vertex data */
-    const char *persist_vbo = getenv("HYPRLAX_PERSISTENT_VBO");
-    GLuint vbo = 0;
-    if (persist_vbo && *persist_vbo && g_gles2_data->vbo) {
-        glBindBuffer(GL_ARRAY_BUFFER, g_gles2_data->vbo);
-        /* If using uniform-offset or separable blur, keep default texcoords; otherwise update texcoords */
-        if (!uniform_offset_mode && !use_sep_blur) {
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        }
-    } else {
-        glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    draw_count++;
+}
+
+/* Composite program for a layer count, compiled on first use */
+static shader_program_t* gles2_composite_shader(int layers) {
+    if (layers < 2 || layers > g_gles2_data->composite_max) return NULL;
+    if (g_gles2_data->composite_shaders[layers]) return g_gles2_data->composite_shaders[layers];
+    if (g_gles2_data->composite_failed[layers]) return NULL;
+
+    char *fragment_src = shader_build_composite_fragment(layers);
+    shader_program_t *shader = fragment_src ? shader_create_program("composite") : NULL;
+    if (!shader || shader_compile(shader, shader_vertex_composite, fragment_src) != HYPRLAX_SUCCESS) {
+        fprintf(stderr, "Warning: Failed to compile %d-layer composite shader, using multi-pass\n", layers);
+        if (shader) shader_destroy_program(shader);
+        free(fragment_src);
+        g_gles2_data->composite_failed[layers] = true;
+        return NULL;
     }
+    free(fragment_src);
 
-    GLint pos_attrib = shader_get_attrib_location(shader, "a_position");
-    GLint tex_attrib = shader_get_attrib_location(shader, "a_texcoord");
+    /* Samplers never change: unit i feeds layer i */
+    GLint samplers[HYPRLAX_COMPOSITE_MAX_LAYERS];
+    for (int i = 0; i < layers; i++) samplers[i] = i;
+    gles2_state_use_program(shader->id);
+    GLint loc = shader_get_uniform_location(shader, "u_tex");
+    if (loc == -1) loc = shader_get_uniform_location(shader, "u_tex[0]");
+    if (loc != -1) glUniform1iv(loc, layers, samplers);
 
-    if (draw_count < 5 && getenv("HYPRLAX_DEBUG")) {
-        fprintf(stderr, "[DEBUG] Attrib locations: pos=%d, tex=%d\n", pos_attrib, tex_attrib);
-    }
+    g_gles2_data->composite_shaders[layers] = shader;
+    return shader;
+}
 
-    if (pos_attrib >= 0) {
-        glEnableVertexAttribArray(pos_attrib);
-        glVertexAttribPointer(pos_attrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)0);
+/* Can a draw be folded into a composite pass? Live blurs need their own
+ * passes (cached ones are plain images); a texture shared by draws with
+ * different wrap modes cannot carry both on its sampler state. */
+static bool gles2_packet_batchable(const renderer_packet_draw_t *draws, int index) {
+    const renderer_packet_draw_t *d = &draws[index];
+    const renderer_draw_packet_t *p = d->packet;
+    if (!p || !d->texture_id) return false;
+    if (p->program != RENDERER_PROGRAM_BASIC && p->program != RENDERER_PROGRAM_BLUR_CACHED) return false;
+    if (p->bounds[2] <= p->bounds[0] || p->bounds[3] <= p->bounds[1]) return false;
+    for (int j = 0; j < index; j++) {
+        const renderer_draw_packet_t *q = draws[j].packet;
+        if (draws[j].texture_id == d->texture_id && p->has_params && q->has_params &&
+            (q->wrap_s != p->wrap_s || q->wrap_t != p->wrap_t)) {
+            return false;
+        }
     }
+    return true;
+}
 
-    if (tex_attrib >= 0) {
-        glEnableVertexAttribArray(tex_attrib);
-        glVertexAttribPointer(tex_attrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)(2 * sizeof(GLfloat)));
+int gles2_batch_textures(const renderer_packet_draw_t *draws, int count,
+                         GLuint textures[HYPRLAX_COMPOSITE_MAX_LAYERS]) {
+    if (!draws || !g_gles2_data || g_gles2_data->composite_max < 2) return 0;
+
+    /* Texture each draw samples: its own, or its cached blur */
+    int n = 0;
+    while (n < count && n < g_gles2_data->composite_max && gles2_packet_batchable(draws, n)) {
+        textures[n] = draws[n].texture_id;
+        if (draws[n].packet->program == RENDERER_PROGRAM_BLUR_CACHED) {
+            textures[n] = gles2_blur_cache_get(draws[n].texture_id, draws[n].packet);
+            if (!textures[n]) break;
+        }
+        n++;
     }
+    return n;
+}
 
-    /* Draw quad */
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+GLuint gles2_geometry_buffer(void) {
+    return g_gles2_data ? g_gles2_data->vbo : 0;
+}
 
-    /* Check for GL errors */
-    if (draw_count < 5 && getenv("HYPRLAX_DEBUG")) {
-        GLenum err = glGetError();
-        if (err != GL_NO_ERROR) {
-            fprintf(stderr, "[DEBUG] GL Error after draw: 0x%x\n", err);
+/* Blend a run of basic draws in one fullscreen pass with one texture unit
+ * per layer; equivalent to drawing them bottom-up with the basic shader */
+static int gles2_draw_packet_batch(const renderer_packet_draw_t *draws, int count) {
+    GLuint textures[HYPRLAX_COMPOSITE_MAX_LAYERS];
+    int n = gles2_batch_textures(draws, count, textures);
+    if (n < 2) return 0;
+
+    shader_program_t *shader = gles2_composite_shader(n);
+    if (!shader) return 0;
+
+    GLfloat rect[HYPRLAX_COMPOSITE_MAX_LAYERS * 4];
+    GLfloat uv[HYPRLAX_COMPOSITE_MAX_LAYERS * 4];
+    GLfloat color[HYPRLAX_COMPOSITE_MAX_LAYERS * 4];
+    GLfloat mask[HYPRLAX_COMPOSITE_MAX_LAYERS * 2];
+    for (int i = 0; i < n; i++) {
+        const renderer_draw_packet_t *p = draws[i].packet;
+        float ox = draws[i].x, oy = -draws[i].y;
+        if (p->uniform_offset) {
+            ox *= p->offset_scale[0];
+            oy *= p->offset_scale[1];
         }
-    }
-
-    /* Cleanup */
-    if (pos_attrib >= 0) glDisableVertexAttribArray(pos_attrib);
-    if (tex_attrib >= 0) glDisableVertexAttribArray(tex_attrib);
-    if (!(persist_vbo && *persist_vbo)) {
-        glDeleteBuffers(1, &vbo);
-    }
+        memcpy(&rect[i * 4], p->bounds, 4 * sizeof(GLfloat));
+        /* Texcoords at the bottom-left and top-right corners */
+        uv[i * 4 + 0] = p->vertices[2] + ox;
+        uv[i * 4 + 1] = p->vertices[3] + oy;
+        uv[i * 4 + 2] = p->vertices[14] + ox;
+        uv[i * 4 + 3] = p->vertices[15] + oy;
+        float ts = p->tint_strength < 0.0f ? 0.0f : (p->tint_strength > 1.0f ? 1.0f : p->tint_strength);
+        for (int c = 0; c < 3; c++) color[i * 4 + c] = 1.0f + (p->tint[c] - 1.0f) * ts;
+        color[i * 4 + 3] = p->opacity;
+        mask[i * 2 + 0] = p->mask[0];
+        mask[i * 2 + 1] = p->mask[1];
+
+        texture_t texture = { .id = textures[i], .width = p->tex_width, .height = p->tex_height };
+        gles2_bind_texture(&texture, i);
+        if (p->has_params) gles2_state_tex_wrap(texture.id, p->wrap_s, p->wrap_t);
+    }
+    /* Leave unit 0 active for code that binds textures directly */
+    gles2_state_active_unit(0);
+
+    gles2_state_use_program(shader->id);
+    gles2_state_uniformfv(shader->loc_u_rect, 4, n, rect);
+    gles2_state_uniformfv(shader->loc_u_uv, 4, n, uv);
+    gles2_state_uniformfv(shader->loc_u_color, 4, n, color);
+    gles2_state_uniformfv(shader->loc_u_mask, 2, n, mask);
+
+    gles2_draw_geometry(shader, GEOMETRY_QUAD);
+    return n;
+}
 
-    if (draw_count < 5 && getenv("HYPRLAX_DEBUG")) {
-        fprintf(stderr, "[DEBUG] gles2_draw_layer %d: Complete\n", draw_count);
-    }
-done:
-    draw_count++;
+/* Draw layer (compiles a throwaway packet; the render loop keeps its own) */
+static void gles2_draw_layer_internal(const texture_t *texture, float x, float y,
+                            float opacity, float blur_amount,
+                            const renderer_layer_params_t *params) {
+    if (!texture) return;
+    renderer_draw_packet_t packet;
+    gles2_compile_layer(texture, opacity, blur_amount, params, &packet);
+    gles2_draw_packet(&packet, texture->id, x, y);
 }
 
 static void gles2_draw_layer(const texture_t *texture, float x, float y,
@@ -963,9 +1578,106 @@ static void gles2_draw_layer_ex(const texture_t *texture, float x, float y,
     gles2_draw_layer_internal(texture, x, y, opacity, blur_amount, params);
 }
 
+/* Blending on/off; draws with opaque texels at full opacity do not need it */
+static void gles2_set_blend(bool enabled) {
+    gles2_state_blend(enabled);
+}
+
+/* Create an offscreen RGBA render target; returns 0 on failure */
+static uint32_t gles2_create_target(int width, int height) {
+    if (!g_gles2_data || width <= 0 || height <= 0) return 0;
+
+    int slot = -1;
+    for (int i = 0; i < HYPRLAX_MAX_RENDER_TARGETS; i++) {
+        if (!g_gles2_data->targets[i].fbo) { slot = i; break; }
+    }
+    if (slot < 0) {
+        LOG_WARN("gles2: no free render target slots");
+        return 0;
+    }
+
+    GLuint tex = 0, fbo = 0;
+    glGenTextures(1, &tex);
+    gles2_state_bind_texture(0, tex);
+    gles2_state_tex_filter(tex, GL_LINEAR, GL_LINEAR);
+    gles2_state_tex_wrap(tex, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, g_gles2_data->target_fbo);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        LOG_WARN("gles2: render target %dx%d incomplete (0x%x)", width, height, status);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteTextures(1, &tex);
+        gles2_state_forget_texture(tex);
+        return 0;
+    }
+
+    g_gles2_data->targets[slot].fbo = fbo;
+    g_gles2_data->targets[slot].tex = tex;
+    g_gles2_data->targets[slot].width = width;
+    g_gles2_data->targets[slot].height = height;
+    return (uint32_t)slot + 1;
+}
+
+static void gles2_destroy_target(uint32_t target) {
+    if (!g_gles2_data || target == 0 || target > HYPRLAX_MAX_RENDER_TARGETS) return;
+    int slot = (int)target - 1;
+    if (g_gles2_data->target_fbo == g_gles2_data->targets[slot].fbo) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        g_gles2_data->target_fbo = 0;
+    }
+    if (g_gles2_data->targets[slot].tex) {
+        glDeleteTextures(1, &g_gles2_data->targets[slot].tex);
+        gles2_state_forget_texture(g_gles2_data->targets[slot].tex);
+    }
+    if (g_gles2_data->targets[slot].fbo) glDeleteFramebuffers(1, &g_gles2_data->targets[slot].fbo);
+    memset(&g_gles2_data->targets[slot], 0, sizeof(g_gles2_data->targets[slot]));
+}
+
+/* Redirect subsequent draws to a target (0 = window surface) */
+static void gles2_bind_target(uint32_t target) {
+    if (!g_gles2_data) return;
+    GLuint fbo = 0;
+    if (target > 0 && target <= HYPRLAX_MAX_RENDER_TARGETS) {
+        fbo = g_gles2_data->targets[target - 1].fbo;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    g_gles2_data->target_fbo = fbo;
+}
+
+/* Copy a target over the current framebuffer with blending disabled */
+static void gles2_blit_target(uint32_t target) {
+    if (!g_gles2_data || !g_gles2_data->basic_shader) return;
+    if (target == 0 || target > HYPRLAX_MAX_RENDER_TARGETS) return;
+    if (!g_gles2_data->targets[target - 1].tex) return;
+
+    shader_program_t *shader = g_gles2_data->basic_shader;
+    gles2_state_use_program(shader->id);
+    gles2_state_uniform1i(shader->loc_u_texture, 0);
+    gles2_state_uniform1f(shader->loc_u_opacity, 1.0f);
+    gles2_state_uniform2f(shader->loc_u_offset, 0.0f, 0.0f);
+    gles2_state_uniform2f(shader->loc_u_mask_outside, 0.0f, 0.0f);
+    gles2_state_uniform1f(shader->loc_u_tint_strength, 0.0f);
+
+    texture_t tex = { .id = g_gles2_data->targets[target - 1].tex };
+    gles2_bind_texture(&tex, 0);
+
+    bool blend_was_enabled = gles2_state_blend_enabled();
+    gles2_state_blend(false);
+
+    gles2_draw_geometry(shader, GEOMETRY_BLIT);
+
+    gles2_state_blend(blend_was_enabled);
+}
+
 /* Resize viewport */
 static void gles2_resize(int width, int height) {
-    glViewport(0, 0, width, height);
+    gles2_state_viewport(0, 0, width, height);
     /* Store new size in private data */
     if (g_gles2_data) {
         g_gles2_data->width = width;
@@ -979,14 +1691,17 @@ static void gles2_resize(int width, int height) {
 /* Set vsync */
 static void gles2_set_vsync(bool enabled) {
     if (g_gles2_data && g_gles2_data->egl_display != EGL_NO_DISPLAY) {
-        eglSwapInterval(g_gles2_data->egl_display, enabled ? 1 : 0);
+        /* Non-blocking presents are paced by frame callbacks instead */
+        if (!g_gles2_data->nonblocking) eglSwapInterval(g_gles2_data->egl_display, enabled ? 1 : 0);
         g_gles2_data->vsync_enabled = enabled;
     }
 }
 
 /* Get capabilities */
 static uint32_t gles2_get_capabilities(void) {
-    return RENDERER_CAP_BLUR | RENDERER_CAP_VSYNC;
+    uint32_t caps = RENDERER_CAP_BLUR | RENDERER_CAP_VSYNC;
+    if (g_gles2_data && g_gles2_data->nonblocking) caps |= RENDERER_CAP_NONBLOCKING_PRESENT;
+    return caps;
 }
 
 /* Get renderer name */
@@ -1012,6 +1727,30 @@ EGLSurface gles2_create_monitor_surface(void *native_window) {
     return surface;
 }
 
+/* Create an offscreen (pbuffer) surface for a headless monitor */
+EGLSurface gles2_create_offscreen_surface(int width, int height) {
+    if (!g_gles2_data || width <= 0 || height <= 0) {
+        return EGL_NO_SURFACE;
+    }
+
+    EGLint attribs[] = {
+        EGL_WIDTH, width,
+        EGL_HEIGHT, height,
+        EGL_NONE
+    };
+    return eglCreatePbufferSurface(g_gles2_data->egl_display, g_gles2_data->egl_config, attribs);
+}
+
+/* Read back the current surface as RGBA8 (bottom-left origin) */
+static int gles2_read_pixels(int x, int y, int width, int height, uint8_t *rgba) {
+    if (!g_gles2_data || !rgba || width <= 0 || height <= 0) {
+        return HYPRLAX_ERROR_INVALID_ARGS;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    return glGetError() == GL_NO_ERROR ? HYPRLAX_SUCCESS : HYPRLAX_ERROR_GL_INIT;
+}
+
 /* Make a monitor's EGL surface current */
 int gles2_make_current(EGLSurface surface) {
     if (!g_gles2_data) {
@@ -1024,10 +1763,36 @@ int gles2_make_current(EGLSurface surface) {
 
     /* Track current surface for present */
     g_gles2_data->current_surface = surface;
+    gles2_track_surface(surface);
 
     return HYPRLAX_SUCCESS;
 }
 
+void gles2_set_viewport(int width, int height) {
+    gles2_state_viewport(0, 0, width, height);
+}
+
+static void gles2_take_stats(renderer_stats_t *stats) {
+    gles2_state_stats_t counts = {0};
+    gles2_state_take_stats(&counts);
+    if (!stats) return;
+    stats->gl_calls += counts.calls;
+    stats->gl_calls_elided += counts.elided;
+}
+
+/* Hand the context to another thread: EGL binds it to one at a time */
+static void gles2_release_context(void) {
+    if (!g_gles2_data) return;
+    eglMakeCurrent(g_gles2_data->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+static int gles2_bind_context(void) {
+    if (!g_gles2_data) return HYPRLAX_ERROR_INVALID_ARGS;
+    EGLSurface surface = g_gles2_data->current_surface != EGL_NO_SURFACE ?
+                         g_gles2_data->current_surface : g_gles2_data->egl_surface;
+    return gles2_make_current(surface);
+}
+
 /* OpenGL ES 2.0 renderer operations */
 const renderer_ops_t renderer_gles2_ops = {
     .init = gles2_init,
@@ -1042,11 +1807,204 @@ const renderer_ops_t renderer_gles2_ops = {
     .fade_frame = gles2_fade_frame,
     .draw_layer = gles2_draw_layer,
     .draw_layer_ex = gles2_draw_layer_ex,
+    .create_target = gles2_create_target,
+    .destroy_target = gles2_destroy_target,
+    .bind_target = gles2_bind_target,
+    .blit_target = gles2_blit_target,
+    .compile_layer = gles2_compile_layer,
+    .draw_packet = gles2_draw_packet,
+    .draw_packet_batch = gles2_draw_packet_batch,
+    .get_buffer_age = gles2_get_buffer_age,
+    .set_damage_region = gles2_set_damage_region,
+    .present_damage = gles2_present_damage,
+    .gpu_busy = gles2_gpu_busy,
+    .set_blend = gles2_set_blend,
     .resize = gles2_resize,
     .set_vsync = gles2_set_vsync,
     .get_capabilities = gles2_get_capabilities,
     .get_name = gles2_get_name,
     .get_version = gles2_get_version,
+    .read_pixels = gles2_read_pixels,
+    .upload_texture = gles2_upload_texture,
+    .delete_texture = gles2_delete_texture,
+    .begin_upload = gles2_begin_upload,
+    .upload_rows = gles2_upload_rows,
+    .finish_upload = gles2_finish_upload,
+    .max_texture_size = gles2_max_texture_size,
+    .release_context = gles2_release_context,
+    .bind_context = gles2_bind_context,
+    .apply_options = gles2_apply_options,
+    .take_stats = gles2_take_stats,
+};
+
+static const char* gles2_headless_get_name(void) {
+    return "OpenGL ES 2.0 (headless)";
+}
+
+/* Headless variant: same GL paths, pbuffer surfaces, no damage extensions */
+const renderer_ops_t renderer_headless_ops = {
+    .init = gles2_headless_init,
+    .destroy = gles2_destroy,
+    .begin_frame = gles2_begin_frame,
+    .end_frame = gles2_end_frame,
+    .present = gles2_present,
+    .create_texture = gles2_create_texture,
+    .destroy_texture = gles2_destroy_texture,
+    .bind_texture = gles2_bind_texture,
+    .clear = gles2_clear,
+    .fade_frame = gles2_fade_frame,
+    .draw_layer = gles2_draw_layer,
+    .draw_layer_ex = gles2_draw_layer_ex,
+    .create_target = gles2_create_target,
+    .destroy_target = gles2_destroy_target,
+    .bind_target = gles2_bind_target,
+    .blit_target = gles2_blit_target,
+    .compile_layer = gles2_compile_layer,
+    .draw_packet = gles2_draw_packet,
+    .draw_packet_batch = gles2_draw_packet_batch,
+    .present_damage = gles2_present_damage,
+    .gpu_busy = gles2_gpu_busy,
+    .set_blend = gles2_set_blend,
+    .resize = gles2_resize,
+    .set_vsync = gles2_set_vsync,
+    .get_capabilities = gles2_get_capabilities,
+    .get_name = gles2_headless_get_name,
+    .get_version = gles2_get_version,
+    .read_pixels = gles2_read_pixels,
+    .upload_texture = gles2_upload_texture,
+    .delete_texture = gles2_delete_texture,
+    .begin_upload = gles2_begin_upload,
+    .upload_rows = gles2_upload_rows,
+    .finish_upload = gles2_finish_upload,
+    .max_texture_size = gles2_max_texture_size,
+    .apply_options = gles2_apply_options,
+    .take_stats = gles2_take_stats,
+};
+
+/* ---- OpenGL ES 3.0 ---------------------------------------------------------
+ * The same backend on an ES 3.0 context: everything above runs unchanged
+ * (GLSL ES 1.00 programs and the default vertex array still work there),
+ * while gles3.c replaces texture uploads and layer batches with immutable
+ * mipmapped storage and instanced draws. */
+
+/* ES3-only setup on a freshly initialised context; undone on failure */
+static int gles3_finish_init(int ret) {
+    if (ret != HYPRLAX_SUCCESS) return ret;
+    if (gles3_setup() != HYPRLAX_SUCCESS) {
+        gles2_destroy();
+        return HYPRLAX_ERROR_GL_INIT;
+    }
+    return HYPRLAX_SUCCESS;
+}
+
+static int gles3_init(void *native_display, void *native_window,
+                      const renderer_config_t *config) {
+    return gles3_finish_init(gles2_init_version(native_display, native_window, config, 3));
+}
+
+static int gles3_headless_init(void *native_display, void *native_window,
+                               const renderer_config_t *config) {
+    (void)native_display;
+    (void)native_window;
+    return gles3_finish_init(gles2_headless_init_version(config, 3));
+}
+
+static void gles3_destroy(void) {
+    if (!g_gles2_data) return;
+    gles3_teardown();
+    gles2_destroy();
+}
+
+static const char* gles3_get_name(void) {
+    return "OpenGL ES 3.0";
+}
+
+static const char* gles3_headless_get_name(void) {
+    return "OpenGL ES 3.0 (headless)";
+}
+
+const renderer_ops_t renderer_gles3_ops = {
+    .init = gles3_init,
+    .destroy = gles3_destroy,
+    .begin_frame = gles2_begin_frame,
+    .end_frame = gles2_end_frame,
+    .present = gles2_present,
+    .create_texture = gles3_create_texture,
+    .destroy_texture = gles2_destroy_texture,
+    .bind_texture = gles2_bind_texture,
+    .clear = gles2_clear,
+    .fade_frame = gles2_fade_frame,
+    .draw_layer = gles2_draw_layer,
+    .draw_layer_ex = gles2_draw_layer_ex,
+    .create_target = gles2_create_target,
+    .destroy_target = gles2_destroy_target,
+    .bind_target = gles2_bind_target,
+    .blit_target = gles2_blit_target,
+    .compile_layer = gles2_compile_layer,
+    .draw_packet = gles2_draw_packet,
+    .draw_packet_batch = gles3_draw_packet_batch,
+    .get_buffer_age = gles2_get_buffer_age,
+    .set_damage_region = gles2_set_damage_region,
+    .present_damage = gles2_present_damage,
+    .gpu_busy = gles2_gpu_busy,
+    .set_blend = gles2_set_blend,
+    .resize = gles2_resize,
+    .set_vsync = gles2_set_vsync,
+    .get_capabilities = gles2_get_capabilities,
+    .get_name = gles3_get_name,
+    .get_version = gles2_get_version,
+    .read_pixels = gles2_read_pixels,
+    .upload_texture = gles3_upload_texture,
+    .delete_texture = gles2_delete_texture,
+    .begin_upload = gles3_begin_upload,
+    .upload_rows = gles3_upload_rows,
+    .finish_upload = gles3_finish_upload,
+    .max_texture_size = gles2_max_texture_size,
+    .release_context = gles2_release_context,
+    .bind_context = gles2_bind_context,
+    .apply_options = gles2_apply_options,
+    .take_stats = gles2_take_stats,
+};
+
+
+/* Headless variant on an ES 3.0 context */
+const renderer_ops_t renderer_headless_gles3_ops = {
+    .init = gles3_headless_init,
+    .destroy = gles3_destroy,
+    .begin_frame = gles2_begin_frame,
+    .end_frame = gles2_end_frame,
+    .present = gles2_present,
+    .create_texture = gles3_create_texture,
+    .destroy_texture = gles2_destroy_texture,
+    .bind_texture = gles2_bind_texture,
+    .clear = gles2_clear,
+    .fade_frame = gles2_fade_frame,
+    .draw_layer = gles2_draw_layer,
+    .draw_layer_ex = gles2_draw_layer_ex,
+    .create_target = gles2_create_target,
+    .destroy_target = gles2_destroy_target,
+    .bind_target = gles2_bind_target,
+    .blit_target = gles2_blit_target,
+    .compile_layer = gles2_compile_layer,
+    .draw_packet = gles2_draw_packet,
+    .draw_packet_batch = gles3_draw_packet_batch,
+    .present_damage = gles2_present_damage,
+    .gpu_busy = gles2_gpu_busy,
+    .set_blend = gles2_set_blend,
+    .resize = gles2_resize,
+    .set_vsync = gles2_set_vsync,
+    .get_capabilities = gles2_get_capabilities,
+    .get_name = gles3_headless_get_name,
+    .get_version = gles2_get_version,
+    .read_pixels = gles2_read_pixels,
+    .upload_texture = gles3_upload_texture,
+    .delete_texture = gles2_delete_texture,
+    .begin_upload = gles3_begin_upload,
+    .upload_rows = gles3_upload_rows,
+    .finish_upload = gles3_finish_upload,
+    .max_texture_size = gles2_max_texture_size,
+    .apply_options = gles2_apply_options,
+    .take_stats = gles2_take_stats,
 };
 /* Create or recreate separable blur render target */
 static void gles2_create_blur_target(int width, int height) {
@@ -1056,14 +2014,13 @@ static void gles2_create_blur_target(int width, int height) {
     }
     if (g_gles2_data->blur_tex) {
         glDeleteTextures(1, &g_gles2_data->blur_tex);
+        gles2_state_forget_texture(g_gles2_data->blur_tex);
         g_gles2_data->blur_tex = 0;
     }
     glGenTextures(1, &g_gles2_data->blur_tex);
-    glBindTexture(GL_TEXTURE_2D, g_gles2_data->blur_tex);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gles2_state_bind_texture(0, g_gles2_data->blur_tex);
+    gles2_state_tex_filter(g_gles2_data->blur_tex, GL_LINEAR, GL_LINEAR);
+    gles2_state_tex_wrap(g_gles2_data->blur_tex, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
     int factor = g_gles2_data->blur_downscale > 1 ? g_gles2_data->blur_downscale : 1;
     g_gles2_data->blur_w = width / factor;
     g_gles2_data->blur_h = height / factor;
@@ -1072,5 +2029,5 @@ static void gles2_create_blur_target(int width, int height) {
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, g_gles2_data->blur_w, g_gles2_data->blur_h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
     glBindFramebuffer(GL_FRAMEBUFFER, g_gles2_data->blur_fbo);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_gles2_data->blur_tex, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, g_gles2_data->target_fbo);
 }
@@ -0,0 +1,287 @@
+/*
+ * gles2_state.c - GL state tracker for the GLES2 backend (see gles2_state.h)
+ */
+
+#include <string.h>
+#include "gles2_state.h"
+#include "../include/defaults.h"
+
+enum { MAX_TRACKED_UNITS = 32 };
+#define UNKNOWN_NAME ((GLuint)-1)
+
+/* Sampler parameters, 0 = unknown (every GL enum is non-zero) */
+typedef struct {
+    GLuint texture;
+    bool used;
+    GLint min_filter;
+    GLint mag_filter;
+    GLint wrap_s;
+    GLint wrap_t;
+} gl_texture_state_t;
+
+/* Last value uploaded to a program's uniform; values over 16 bytes live in
+ * the array pool */
+typedef struct {
+    GLuint program;
+    GLint location;
+    bool used;
+    bool valid;
+    int size;
+    int array;              /* Index into s_array_values, -1 = inline */
+    uint32_t value[4];
+} gl_uniform_state_t;
+
+static GLuint s_program = UNKNOWN_NAME;
+static int s_active_unit = -1;
+static GLuint s_bound[MAX_TRACKED_UNITS];
+static int s_blend = -1;
+static bool s_viewport_known = false;
+static GLint s_viewport[4];
+static gl_texture_state_t s_textures[HYPRLAX_GL_STATE_TEXTURES];
+static gl_uniform_state_t s_uniforms[HYPRLAX_GL_STATE_UNIFORMS];
+static GLfloat s_array_values[HYPRLAX_GL_STATE_UNIFORM_ARRAYS][HYPRLAX_COMPOSITE_MAX_LAYERS * 4];
+static int s_array_count = 0;
+static gles2_state_stats_t s_stats;
+
+void gles2_state_reset(void) {
+    s_program = UNKNOWN_NAME;
+    s_active_unit = -1;
+    for (int i = 0; i < MAX_TRACKED_UNITS; i++) s_bound[i] = UNKNOWN_NAME;
+    s_blend = -1;
+    s_viewport_known = false;
+    memset(s_textures, 0, sizeof(s_textures));
+    memset(s_uniforms, 0, sizeof(s_uniforms));
+    s_array_count = 0;
+}
+
+/* ---- Programs and uniforms ------------------------------------------------ */
+
+void gles2_state_use_program(GLuint program) {
+    if (program == s_program) {
+        s_stats.elided++;
+        return;
+    }
+    glUseProgram(program);
+    s_program = program;
+    s_stats.calls++;
+}
+
+void gles2_state_forget_program(GLuint program) {
+    for (int i = 0; i < HYPRLAX_GL_STATE_UNIFORMS; i++) {
+        if (s_uniforms[i].used && s_uniforms[i].program == program) s_uniforms[i].valid = false;
+    }
+    if (s_program == program) s_program = UNKNOWN_NAME;
+}
+
+/* Entry for a uniform of the program in use; NULL when the table is full
+ * (the uniform is then simply not shadowed) */
+static gl_uniform_state_t *uniform_slot(GLint location) {
+    uint32_t h = (uint32_t)s_program * 2654435761u ^ (uint32_t)location * 40503u;
+    for (int i = 0; i < HYPRLAX_GL_STATE_UNIFORMS; i++) {
+        gl_uniform_state_t *u = &s_uniforms[(h + (uint32_t)i) % HYPRLAX_GL_STATE_UNIFORMS];
+        if (!u->used) {
+            *u = (gl_uniform_state_t){ .program = s_program, .location = location, .used = true, .array = -1 };
+            return u;
+        }
+        if (u->program == s_program && u->location == location) return u;
+    }
+    return NULL;
+}
+
+/* Record a uniform value; false if it is already in effect */
+static bool uniform_changed(GLint location, const void *value, int size) {
+    if (s_program == UNKNOWN_NAME) return true;
+    gl_uniform_state_t *u = uniform_slot(location);
+    if (!u) return true;
+    void *stored = u->value;
+    if (size > (int)sizeof(u->value)) {
+        if (size > (int)sizeof(s_array_values[0])) return true;
+        if (u->array < 0) {
+            if (s_array_count >= HYPRLAX_GL_STATE_UNIFORM_ARRAYS) return true;
+            u->array = s_array_count++;
+        }
+        stored = s_array_values[u->array];
+    }
+    if (u->valid && u->size == size && !memcmp(stored, value, (size_t)size)) {
+        s_stats.elided++;
+        return false;
+    }
+    memcpy(stored, value, (size_t)size);
+    u->size = size;
+    u->valid = true;
+    s_stats.calls++;
+    return true;
+}
+
+void gles2_state_uniform1i(GLint location, GLint v) {
+    if (location != -1 && uniform_changed(location, &v, sizeof(v))) glUniform1i(location, v);
+}
+
+void gles2_state_uniform1f(GLint location, GLfloat v) {
+    if (location != -1 && uniform_changed(location, &v, sizeof(v))) glUniform1f(location, v);
+}
+
+void gles2_state_uniform2f(GLint location, GLfloat x, GLfloat y) {
+    const GLfloat v[2] = { x, y };
+    if (location != -1 && uniform_changed(location, v, sizeof(v))) glUniform2f(location, x, y);
+}
+
+void gles2_state_uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z) {
+    const GLfloat v[3] = { x, y, z };
+    if (location != -1 && uniform_changed(location, v, sizeof(v))) glUniform3f(location, x, y, z);
+}
+
+void gles2_state_uniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+    const GLfloat v[4] = { x, y, z, w };
+    if (location != -1 && uniform_changed(location, v, sizeof(v))) glUniform4f(location, x, y, z, w);
+}
+
+void gles2_state_uniformfv(GLint location, int components, GLsizei count, const GLfloat *v) {
+    if (location == -1 || !v || count <= 0) return;
+    if (!uniform_changed(location, v, (int)(components * count * (GLsizei)sizeof(GLfloat)))) return;
+    if (components == 4) glUniform4fv(location, count, v);
+    else glUniform2fv(location, count, v);
+}
+
+/* ---- Textures ------------------------------------------------------------- */
+
+void gles2_state_active_unit(int unit) {
+    if (unit == s_active_unit) {
+        s_stats.elided++;
+        return;
+    }
+    glActiveTexture(GL_TEXTURE0 + (GLenum)unit);
+    s_active_unit = unit;
+    s_stats.calls++;
+}
+
+void gles2_state_bind_texture(int unit, GLuint texture) {
+    if (unit < 0 || unit >= MAX_TRACKED_UNITS) unit = 0;
+    gles2_state_active_unit(unit);
+    if (s_bound[unit] == texture) {
+        s_stats.elided++;
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    s_bound[unit] = texture;
+    s_stats.calls++;
+}
+
+void gles2_state_texture_bound(GLuint texture) {
+    if (s_active_unit >= 0) {
+        s_bound[s_active_unit] = texture;
+    } else {
+        for (int i = 0; i < MAX_TRACKED_UNITS; i++) s_bound[i] = UNKNOWN_NAME;
+    }
+}
+
+static gl_texture_state_t *texture_slot(GLuint texture) {
+    uint32_t h = (uint32_t)texture * 2654435761u;
+    for (int i = 0; i < HYPRLAX_GL_STATE_TEXTURES; i++) {
+        gl_texture_state_t *t = &s_textures[(h + (uint32_t)i) % HYPRLAX_GL_STATE_TEXTURES];
+        if (!t->used) {
+            *t = (gl_texture_state_t){ .texture = texture, .used = true };
+            return t;
+        }
+        if (t->texture == texture) return t;
+    }
+    return NULL;
+}
+
+void gles2_state_forget_texture(GLuint texture) {
+    /* Deleted names unbind themselves; a recycled name must rebind */
+    for (int i = 0; i < MAX_TRACKED_UNITS; i++) {
+        if (s_bound[i] == texture) s_bound[i] = 0;
+    }
+    /* The entry keeps its key: the next texture with this name reuses it */
+    for (int i = 0; i < HYPRLAX_GL_STATE_TEXTURES; i++) {
+        gl_texture_state_t *t = &s_textures[i];
+        if (t->used && t->texture == texture) {
+            t->min_filter = t->mag_filter = t->wrap_s = t->wrap_t = 0;
+            break;
+        }
+    }
+}
+
+static void tex_parameter(GLint *shadow, GLenum pname, GLint value) {
+    if (shadow && *shadow == value) {
+        s_stats.elided++;
+        return;
+    }
+    glTexParameteri(GL_TEXTURE_2D, pname, value);
+    if (shadow) *shadow = value;
+    s_stats.calls++;
+}
+
+void gles2_state_tex_filter(GLuint texture, GLint min_filter, GLint mag_filter) {
+    gl_texture_state_t *t = texture_slot(texture);
+    tex_parameter(t ? &t->min_filter : NULL, GL_TEXTURE_MIN_FILTER, min_filter);
+    tex_parameter(t ? &t->mag_filter : NULL, GL_TEXTURE_MAG_FILTER, mag_filter);
+}
+
+void gles2_state_tex_wrap(GLuint texture, GLint wrap_s, GLint wrap_t) {
+    gl_texture_state_t *t = texture_slot(texture);
+    tex_parameter(t ? &t->wrap_s : NULL, GL_TEXTURE_WRAP_S, wrap_s);
+    tex_parameter(t ? &t->wrap_t : NULL, GL_TEXTURE_WRAP_T, wrap_t);
+}
+
+/* ---- Fixed-function state ------------------------------------------------- */
+
+void gles2_state_blend(bool enabled) {
+    if (s_blend == (int)enabled) {
+        s_stats.elided++;
+        return;
+    }
+    if (enabled) glEnable(GL_BLEND);
+    else glDisable(GL_BLEND);
+    s_blend = enabled;
+    s_stats.calls++;
+}
+
+bool gles2_state_blend_enabled(void) {
+    if (s_blend < 0) {
+        s_blend = glIsEnabled(GL_BLEND) ? 1 : 0;
+        s_stats.calls++;
+    }
+    return s_blend == 1;
+}
+
+void gles2_state_viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    if (s_viewport_known && s_viewport[0] == x && s_viewport[1] == y &&
+        s_viewport[2] == width && s_viewport[3] == height) {
+        s_stats.elided++;
+        return;
+    }
+    glViewport(x, y, width, height);
+    s_viewport[0] = x; s_viewport[1] = y; s_viewport[2] = width; s_viewport[3] = height;
+    s_viewport_known = true;
+    s_stats.calls++;
+}
+
+void gles2_state_get_viewport(GLint out[4]) {
+    if (!s_viewport_known) {
+        glGetIntegerv(GL_VIEWPORT, s_viewport);
+        s_viewport_known = true;
+        s_stats.calls++;
+    }
+    memcpy(out, s_viewport, sizeof(s_viewport));
+}
+
+/* ---- Draws and stats ------------------------------------------------------ */
+
+void gles2_state_draw_arrays(GLenum mode, GLint first, GLsizei count) {
+    glDrawArrays(mode, first, count);
+    s_stats.calls++;
+}
+
+void gles2_state_count_call(void) {
+    s_stats.calls++;
+}
+
+void gles2_state_take_stats(gles2_state_stats_t *stats) {
+    if (stats) {
+        stats->calls += s_stats.calls;
+        stats->elided += s_stats.elided;
+    }
+    memset(&s_stats, 0, sizeof(s_stats));
+}
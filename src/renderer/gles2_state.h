@@ -0,0 +1,65 @@
+/*
+ * gles2_state.h - GL state tracker for the GLES2 backend
+ *
+ * Shadows the context state the backend changes on its draw paths (program,
+ * texture units, per-texture sampler parameters, blending, viewport and
+ * per-program uniform values) so that setting a value that is already in
+ * effect issues no GL call. Everything runs on the thread that owns the
+ * context. State changed behind the tracker's back must be reported with
+ * the forget/reset calls, or the shadow goes stale.
+ */
+
+#ifndef HYPRLAX_GLES2_STATE_H
+#define HYPRLAX_GLES2_STATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <GLES2/gl2.h>
+
+/* GL calls since the last gles2_state_take_stats */
+typedef struct {
+    uint64_t calls;     /* Tracked state changes and draws that reached GL */
+    uint64_t elided;    /* Redundant state changes that did not */
+} gles2_state_stats_t;
+
+/* Forget all shadowed state (new context, or GL used behind the tracker) */
+void gles2_state_reset(void);
+
+void gles2_state_use_program(GLuint program);
+/* The program was deleted: its uniform values are no longer known */
+void gles2_state_forget_program(GLuint program);
+
+void gles2_state_active_unit(int unit);
+void gles2_state_bind_texture(int unit, GLuint texture);
+/* A texture was bound on the active unit without the tracker */
+void gles2_state_texture_bound(GLuint texture);
+/* The texture was deleted: unbind it from the shadow and forget its
+ * sampler parameters (GL recycles names) */
+void gles2_state_forget_texture(GLuint texture);
+
+/* Sampler parameters of a texture; it must be bound on the active unit */
+void gles2_state_tex_filter(GLuint texture, GLint min_filter, GLint mag_filter);
+void gles2_state_tex_wrap(GLuint texture, GLint wrap_s, GLint wrap_t);
+
+void gles2_state_blend(bool enabled);
+bool gles2_state_blend_enabled(void);
+void gles2_state_viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+void gles2_state_get_viewport(GLint out[4]);
+
+/* Uniforms of the program in use; location -1 is ignored */
+void gles2_state_uniform1i(GLint location, GLint v);
+void gles2_state_uniform1f(GLint location, GLfloat v);
+void gles2_state_uniform2f(GLint location, GLfloat x, GLfloat y);
+void gles2_state_uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z);
+void gles2_state_uniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+/* vec2/vec4 arrays (components = 2 or 4) */
+void gles2_state_uniformfv(GLint location, int components, GLsizei count, const GLfloat *v);
+
+void gles2_state_draw_arrays(GLenum mode, GLint first, GLsizei count);
+/* Count a GL call issued outside the tracker (ES3 draws and buffer updates) */
+void gles2_state_count_call(void);
+
+/* Add the counters to stats and reset them */
+void gles2_state_take_stats(gles2_state_stats_t *stats);
+
+#endif /* HYPRLAX_GLES2_STATE_H */
@@ -0,0 +1,311 @@
+/*
+ * gles3.c - OpenGL ES 3.0 paths of the GL backend (see gles3.h)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <GLES3/gl3.h>
+#include "gles3.h"
+#include "gles2_state.h"
+#include "../include/shader.h"
+#include "../include/hyprlax_internal.h"
+#include "../include/log.h"
+
+/* Uniform buffer binding point of the per-layer block */
+enum { GLES3_LAYER_BINDING = 0 };
+
+/* Per-instance vertex: the layer's quad in NDC, its texcoords at the
+ * bottom-left/top-right corners and its index in the batch */
+typedef struct {
+    GLfloat rect[4];
+    GLfloat uv[4];
+    GLfloat layer;
+} gles3_instance_t;
+
+/* The shader's std140 "Layers" block: per layer, parallax offset and mask
+ * (place), tint and opacity (color) */
+typedef struct {
+    GLfloat place[HYPRLAX_COMPOSITE_MAX_LAYERS][4];
+    GLfloat color[HYPRLAX_COMPOSITE_MAX_LAYERS][4];
+} gles3_layer_block_t;
+
+static struct {
+    bool ready;
+    shader_program_t *program;
+    int max_layers;
+    GLuint vao;
+    GLuint corner_vbo;
+    GLuint instance_vbo;
+    GLuint ubo;
+    /* What the buffers hold: only changes are uploaded */
+    gles3_instance_t instances[HYPRLAX_COMPOSITE_MAX_LAYERS];
+    int instance_count;
+    gles3_layer_block_t block;
+    GLuint upload_pbo;              /* Staging for banded uploads, made on first use */
+} g_gles3;
+
+/* Unit-square corners in triangle-strip order, shared by every instance */
+static const GLfloat k_corners[] = { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+
+int gles3_setup(void) {
+    const char *version = (const char *)glGetString(GL_VERSION);
+    if (!version || strncmp(version, "OpenGL ES 3", 11) != 0) {
+        LOG_WARN("gles3: context is '%s', not OpenGL ES 3.x", version ? version : "unknown");
+        return HYPRLAX_ERROR_GL_INIT;
+    }
+    memset(&g_gles3, 0, sizeof(g_gles3));
+
+    /* One texture unit per layer in a batch */
+    GLint units = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &units);
+    g_gles3.max_layers = units < HYPRLAX_COMPOSITE_MAX_LAYERS ? units : HYPRLAX_COMPOSITE_MAX_LAYERS;
+    if (g_gles3.max_layers < 2) return HYPRLAX_ERROR_GL_INIT;
+
+    char *vertex_src = NULL, *fragment_src = NULL;
+    int ret = shader_build_instanced(g_gles3.max_layers, &vertex_src, &fragment_src);
+    if (ret != HYPRLAX_SUCCESS) return ret;
+    g_gles3.program = shader_create_program("instanced");
+    ret = g_gles3.program ? shader_compile(g_gles3.program, vertex_src, fragment_src) : HYPRLAX_ERROR_NO_MEMORY;
+    free(vertex_src);
+    free(fragment_src);
+    if (ret != HYPRLAX_SUCCESS) {
+        LOG_WARN("gles3: failed to build the instanced layer program");
+        gles3_teardown();
+        return HYPRLAX_ERROR_GL_INIT;
+    }
+
+    GLuint program = g_gles3.program->id;
+    GLuint block = glGetUniformBlockIndex(program, "Layers");
+    if (block == GL_INVALID_INDEX) {
+        LOG_WARN("gles3: instanced program has no Layers block");
+        gles3_teardown();
+        return HYPRLAX_ERROR_GL_INIT;
+    }
+    glUniformBlockBinding(program, block, GLES3_LAYER_BINDING);
+
+    /* Samplers never change: unit i feeds layer i */
+    GLint samplers[HYPRLAX_COMPOSITE_MAX_LAYERS];
+    for (int i = 0; i < g_gles3.max_layers; i++) samplers[i] = i;
+    gles2_state_use_program(program);
+    GLint loc = shader_get_uniform_location(g_gles3.program, "u_tex");
+    if (loc == -1) loc = shader_get_uniform_location(g_gles3.program, "u_tex[0]");
+    if (loc != -1) glUniform1iv(loc, g_gles3.max_layers, samplers);
+
+    /* The block's buffer stays bound to its binding point, and to the
+     * generic GL_UNIFORM_BUFFER target for updates; nothing else uses it */
+    glGenBuffers(1, &g_gles3.ubo);
+    glBindBufferBase(GL_UNIFORM_BUFFER, GLES3_LAYER_BINDING, g_gles3.ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(g_gles3.block), &g_gles3.block, GL_DYNAMIC_DRAW);
+
+    /* Vertex array: attribute 0 walks the corners, 1-3 advance per instance */
+    glGenVertexArrays(1, &g_gles3.vao);
+    glBindVertexArray(g_gles3.vao);
+    glGenBuffers(1, &g_gles3.corner_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, g_gles3.corner_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(k_corners), k_corners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void *)0);
+
+    glGenBuffers(1, &g_gles3.instance_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, g_gles3.instance_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(g_gles3.instances), NULL, GL_DYNAMIC_DRAW);
+    const struct { GLuint index; GLint size; size_t offset; } attribs[] = {
+        { 1, 4, offsetof(gles3_instance_t, rect) },
+        { 2, 4, offsetof(gles3_instance_t, uv) },
+        { 3, 1, offsetof(gles3_instance_t, layer) },
+    };
+    for (size_t i = 0; i < sizeof(attribs) / sizeof(attribs[0]); i++) {
+        glEnableVertexAttribArray(attribs[i].index);
+        glVertexAttribPointer(attribs[i].index, attribs[i].size, GL_FLOAT, GL_FALSE,
+                              sizeof(gles3_instance_t), (void *)attribs[i].offset);
+        glVertexAttribDivisor(attribs[i].index, 1);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, gles2_geometry_buffer());
+
+    g_gles3.ready = true;
+    LOG_DEBUG("gles3: %s, up to %d layers per instanced draw", version, g_gles3.max_layers);
+    return HYPRLAX_SUCCESS;
+}
+
+void gles3_teardown(void) {
+    if (g_gles3.program) {
+        gles2_state_forget_program(g_gles3.program->id);
+        shader_destroy_program(g_gles3.program);
+    }
+    if (g_gles3.vao) glDeleteVertexArrays(1, &g_gles3.vao);
+    if (g_gles3.corner_vbo) glDeleteBuffers(1, &g_gles3.corner_vbo);
+    if (g_gles3.instance_vbo) glDeleteBuffers(1, &g_gles3.instance_vbo);
+    if (g_gles3.ubo) glDeleteBuffers(1, &g_gles3.ubo);
+    if (g_gles3.upload_pbo) glDeleteBuffers(1, &g_gles3.upload_pbo);
+    memset(&g_gles3, 0, sizeof(g_gles3));
+}
+
+/* ---- Textures ---------------------------------------------------------------
+ * Immutable storage with the full mip chain, whatever the image size: ES 3.0
+ * mipmaps non-power-of-two textures, so wallpapers scaled down for a smaller
+ * output (or by content_scale) are minified without shimmering. */
+
+static int gles3_mip_levels(int width, int height) {
+    int levels = 1;
+    for (int size = width > height ? width : height; size > 1; size >>= 1) levels++;
+    return levels;
+}
+
+/* Mip chain and sampling setup of a bound texture whose level 0 is in */
+static void gles3_finish_texture(GLuint tex, int width, int height) {
+    int levels = gles3_mip_levels(width, height);
+    if (levels > 1) glGenerateMipmap(GL_TEXTURE_2D);
+    gles2_state_tex_filter(tex, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR, GL_LINEAR);
+    gles2_state_tex_wrap(tex, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+}
+
+/* Bound, uninitialized storage (0 on failure) */
+static GLuint gles3_texture_alloc(int width, int height, GLenum internal_format) {
+    GLuint tex = 0;
+    glGenTextures(1, &tex);
+    if (!tex) return 0;
+    gles2_state_bind_texture(0, tex);
+    glTexStorage2D(GL_TEXTURE_2D, gles3_mip_levels(width, height), internal_format, width, height);
+    return tex;
+}
+
+static GLuint gles3_texture_storage(const void *pixels, int width, int height,
+                                    GLenum internal_format, GLenum format) {
+    GLuint tex = gles3_texture_alloc(width, height, internal_format);
+    if (!tex) return 0;
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, pixels);
+    gles3_finish_texture(tex, width, height);
+    return tex;
+}
+
+texture_t* gles3_create_texture(const void *data, int width, int height, texture_format_t format) {
+    if (!data || width <= 0 || height <= 0) return NULL;
+    texture_t *texture = calloc(1, sizeof(texture_t));
+    if (!texture) return NULL;
+
+    bool rgb = format == TEXTURE_FORMAT_RGB;
+    texture->id = gles3_texture_storage(data, width, height, rgb ? GL_RGB8 : GL_RGBA8, rgb ? GL_RGB : GL_RGBA);
+    if (!texture->id) {
+        free(texture);
+        return NULL;
+    }
+    texture->width = width;
+    texture->height = height;
+    texture->format = format;
+    return texture;
+}
+
+uint32_t gles3_upload_texture(const uint8_t *rgba, int width, int height) {
+    if (!rgba || width <= 0 || height <= 0) return 0;
+    return gles3_texture_storage(rgba, width, height, GL_RGBA8, GL_RGBA);
+}
+
+/* Bands are copied into an orphaned pixel unpack buffer and the texture is
+ * filled from it, so the copy into the texture's layout runs on the
+ * driver's schedule instead of stalling the frame that submits it */
+uint32_t gles3_begin_upload(int width, int height) {
+    if (width <= 0 || height <= 0) return 0;
+    return gles3_texture_alloc(width, height, GL_RGBA8);
+}
+
+void gles3_upload_rows(uint32_t id, const uint8_t *rgba, int width, int y, int rows) {
+    if (!id || !rgba || rows <= 0) return;
+    GLsizeiptr size = (GLsizeiptr)width * rows * 4;
+    if (!g_gles3.upload_pbo) glGenBuffers(1, &g_gles3.upload_pbo);
+    gles2_state_bind_texture(0, id);
+
+    void *staging = NULL;
+    if (g_gles3.upload_pbo) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, g_gles3.upload_pbo);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+        staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    }
+    if (staging) {
+        memcpy(staging, rgba, (size_t)size);
+        /* A lost mapping leaves the buffer undefined: fall back to client memory */
+        if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, (const void *)0);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return;
+        }
+    }
+    if (g_gles3.upload_pbo) glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+}
+
+void gles3_finish_upload(uint32_t id, int width, int height) {
+    if (!id) return;
+    gles2_state_bind_texture(0, id);
+    gles3_finish_texture(id, width, height);
+}
+
+/* ---- Instanced layer batches -----------------------------------------------
+ * A run of basic draws becomes one instanced draw of the unit quad: each
+ * instance places one layer from the per-instance buffer (static while the
+ * scene is, so it is rewritten only when draws are recompiled) and reads its
+ * offset, mask, tint and opacity from the uniform block, which is the only
+ * thing a parallax frame updates. Instances blend in order, so the result
+ * matches drawing the layers one by one with the basic shader. */
+
+int gles3_draw_packet_batch(const renderer_packet_draw_t *draws, int count) {
+    if (!g_gles3.ready || !draws) return 0;
+    GLuint textures[HYPRLAX_COMPOSITE_MAX_LAYERS];
+    int n = gles2_batch_textures(draws, count < g_gles3.max_layers ? count : g_gles3.max_layers, textures);
+    if (n < 2) return 0;
+
+    gles3_instance_t instances[HYPRLAX_COMPOSITE_MAX_LAYERS];
+    gles3_layer_block_t block = g_gles3.block;
+    for (int i = 0; i < n; i++) {
+        const renderer_draw_packet_t *p = draws[i].packet;
+        float ox = draws[i].x, oy = -draws[i].y;
+        if (p->uniform_offset) {
+            ox *= p->offset_scale[0];
+            oy *= p->offset_scale[1];
+        }
+        memcpy(instances[i].rect, p->bounds, sizeof(instances[i].rect));
+        instances[i].uv[0] = p->vertices[2];
+        instances[i].uv[1] = p->vertices[3];
+        instances[i].uv[2] = p->vertices[14];
+        instances[i].uv[3] = p->vertices[15];
+        instances[i].layer = (GLfloat)i;
+
+        block.place[i][0] = ox;
+        block.place[i][1] = oy;
+        block.place[i][2] = p->mask[0];
+        block.place[i][3] = p->mask[1];
+        float ts = p->tint_strength < 0.0f ? 0.0f : (p->tint_strength > 1.0f ? 1.0f : p->tint_strength);
+        for (int c = 0; c < 3; c++) block.color[i][c] = 1.0f + (p->tint[c] - 1.0f) * ts;
+        block.color[i][3] = p->opacity;
+
+        gles2_state_bind_texture(i, textures[i]);
+        if (p->has_params) gles2_state_tex_wrap(textures[i], p->wrap_s, p->wrap_t);
+    }
+    /* Leave unit 0 active for code that binds textures directly */
+    gles2_state_active_unit(0);
+
+    size_t instance_bytes = (size_t)n * sizeof(instances[0]);
+    if (n != g_gles3.instance_count || memcmp(instances, g_gles3.instances, instance_bytes)) {
+        glBindBuffer(GL_ARRAY_BUFFER, g_gles3.instance_vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)instance_bytes, instances);
+        glBindBuffer(GL_ARRAY_BUFFER, gles2_geometry_buffer());
+        memcpy(g_gles3.instances, instances, instance_bytes);
+        g_gles3.instance_count = n;
+        for (int i = 0; i < 3; i++) gles2_state_count_call();
+    }
+    if (memcmp(&block, &g_gles3.block, sizeof(block))) {
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+        g_gles3.block = block;
+        gles2_state_count_call();
+    }
+
+    gles2_state_use_program(g_gles3.program->id);
+    glBindVertexArray(g_gles3.vao);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, n);
+    glBindVertexArray(0);
+    for (int i = 0; i < 3; i++) gles2_state_count_call();
+    return n;
+}
@@ -0,0 +1,43 @@
+/*
+ * gles3.h - OpenGL ES 3.0 paths of the GL backend
+ *
+ * renderer_gles3_ops is the GLES2 backend on an ES 3.0 context with the
+ * parts ES 3.0 does better swapped in: immutable, fully mipmapped texture
+ * storage for any image size, image bands staged through a pixel buffer
+ * object, and layer batches drawn as one instanced draw from a vertex
+ * array object, with per-layer parameters in a uniform buffer. Private to
+ * src/renderer.
+ */
+
+#ifndef HYPRLAX_GLES3_H
+#define HYPRLAX_GLES3_H
+
+#include <GLES2/gl2.h>
+#include "../include/renderer.h"
+#include "../include/defaults.h"
+
+/* ---- Provided by gles3.c -------------------------------------------------- */
+
+/* ES3 objects and programs, once the shared GL setup is done; fails if the
+ * context is not ES 3.0 or the instanced program does not build */
+int gles3_setup(void);
+void gles3_teardown(void);
+
+texture_t* gles3_create_texture(const void *data, int width, int height, texture_format_t format);
+uint32_t gles3_upload_texture(const uint8_t *rgba, int width, int height);
+/* Banded uploads staged through a pixel unpack buffer */
+uint32_t gles3_begin_upload(int width, int height);
+void gles3_upload_rows(uint32_t id, const uint8_t *rgba, int width, int y, int rows);
+void gles3_finish_upload(uint32_t id, int width, int height);
+int gles3_draw_packet_batch(const renderer_packet_draw_t *draws, int count);
+
+/* ---- Provided by gles2.c -------------------------------------------------- */
+
+/* Leading draws that can share one batched draw, and the texture each one
+ * samples (its own or its cached blur); 0 when batching is off */
+int gles2_batch_textures(const renderer_packet_draw_t *draws, int count,
+                         GLuint textures[HYPRLAX_COMPOSITE_MAX_LAYERS]);
+/* The persistent vertex buffer, which must stay bound to GL_ARRAY_BUFFER */
+GLuint gles2_geometry_buffer(void);
+
+#endif /* HYPRLAX_GLES3_H */
@@ -7,8 +7,38 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <time.h>
 #include "../include/renderer.h"
 #include "../include/hyprlax_internal.h"
+#include "../include/log.h"
+#include "../include/defaults.h"
+
+/* Backend that owns the textures the layer loaders create */
+static const renderer_ops_t *g_texture_ops = NULL;
+/* Set while another thread owns the renderer's context */
+static renderer_dispatch_fn g_dispatch = NULL;
+/* Written only from renderer_run jobs */
+static render_options_t g_options = RENDER_OPTIONS_DEFAULTS;
+
+/* Image whose bands are still being uploaded */
+typedef struct {
+    uint32_t id;
+    const uint8_t *rgba;
+    int width, height;
+    int next_row;
+    renderer_release_fn release;    /* Gives rgba back once uploaded */
+    void *release_arg;
+} upload_entry_t;
+
+/* Upload queue, oldest first. Only the renderer's thread changes it (from
+ * renderer_run jobs and the pump), under the lock so that other threads
+ * can ask for progress; the GL work itself runs outside the lock. */
+static pthread_mutex_t g_upload_lock = PTHREAD_MUTEX_INITIALIZER;
+static upload_entry_t g_uploads[HYPRLAX_UPLOAD_QUEUE_MAX];
+static int g_upload_count = 0;
+static uint64_t g_upload_pending = 0;
 
 /* Create renderer instance */
 int renderer_create(renderer_t **out_renderer, const char *backend_name) {
@@ -26,6 +56,20 @@ int renderer_create(renderer_t **out_renderer, const char *backend_name) {
     if (!backend_name || strcmp(backend_name, "gles2") == 0) {
         /* Default to OpenGL ES 2.0 */
         renderer->ops = &renderer_gles2_ops;
+    } else if (strcmp(backend_name, "gles3") == 0) {
+        /* Same paths on an ES 3.0 context: mipmapped storage, instancing */
+        renderer->ops = &renderer_gles3_ops;
+    } else if (strcmp(backend_name, "headless") == 0) {
+        /* Offscreen EGL pbuffers for benchmarks and golden images */
+        renderer->ops = &renderer_headless_ops;
+    } else if (strcmp(backend_name, "headless-gles3") == 0) {
+        renderer->ops = &renderer_headless_gles3_ops;
+    } else
+#endif
+#ifdef ENABLE_WAYLAND
+    if (backend_name && (strcmp(backend_name, "software") == 0 || strcmp(backend_name, "cpu") == 0)) {
+        /* CPU compositing into wl_shm buffers, for GPU-less systems */
+        renderer->ops = &renderer_software_ops;
     } else
 #endif
     {
@@ -38,6 +82,7 @@ int renderer_create(renderer_t **out_renderer, const char *backend_name) {
 
     renderer->initialized = false;
     *out_renderer = renderer;
+    g_texture_ops = renderer->ops;
 
     return HYPRLAX_SUCCESS;
 }
@@ -49,6 +94,434 @@ void renderer_destroy(renderer_t *renderer) {
     if (renderer->initialized && renderer->ops && renderer->ops->destroy) {
         renderer->ops->destroy();
     }
+    if (g_texture_ops == renderer->ops) g_texture_ops = NULL;
+
+    /* The textures went with the context */
+    pthread_mutex_lock(&g_upload_lock);
+    for (int i = 0; i < g_upload_count; i++) g_uploads[i].release(g_uploads[i].release_arg);
+    g_upload_count = 0;
+    g_upload_pending = 0;
+    pthread_mutex_unlock(&g_upload_lock);
 
     free(renderer);
-}
\ No newline at end of file
+}
+
+void renderer_set_dispatch(renderer_dispatch_fn dispatch) {
+    g_dispatch = dispatch;
+}
+
+void renderer_run(void (*job)(void *arg), void *arg) {
+    if (!job) return;
+    if (g_dispatch) g_dispatch(job, arg);
+    else job(arg);
+}
+
+const render_options_t *renderer_get_options(void) {
+    return &g_options;
+}
+
+static void set_options_job(void *arg) {
+    g_options = *(const render_options_t *)arg;
+    if (g_texture_ops && g_texture_ops->apply_options) {
+        g_texture_ops->apply_options(&g_options);
+    }
+}
+
+void renderer_set_options(const render_options_t *options) {
+    if (!options) return;
+    render_options_t copy = *options;
+    renderer_run(set_options_job, &copy);
+}
+
+typedef struct {
+    const uint8_t *rgba;
+    int width, height;
+    uint32_t id;
+    renderer_release_fn release;
+    void *release_arg;
+} texture_job_t;
+
+static void upload_texture_job(void *arg) {
+    texture_job_t *job = arg;
+    job->id = g_texture_ops->upload_texture(job->rgba, job->width, job->height);
+}
+
+/* Drop the queue entry at index; caller holds the lock */
+static void upload_remove(int index) {
+    upload_entry_t *e = &g_uploads[index];
+    g_upload_pending -= (uint64_t)(e->height - e->next_row) * (uint64_t)e->width * 4u;
+    e->release(e->release_arg);
+    memmove(e, e + 1, (size_t)(g_upload_count - index - 1) * sizeof(*e));
+    g_upload_count--;
+}
+
+static void delete_texture_job(void *arg) {
+    texture_job_t *job = arg;
+    pthread_mutex_lock(&g_upload_lock);
+    for (int i = 0; i < g_upload_count; i++) {
+        if (g_uploads[i].id == job->id) {
+            upload_remove(i);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_upload_lock);
+    g_texture_ops->delete_texture(job->id);
+}
+
+uint32_t renderer_upload_texture(const uint8_t *rgba, int width, int height) {
+    if (!rgba || width <= 0 || height <= 0) return 0;
+    if (!g_texture_ops || !g_texture_ops->upload_texture) {
+        LOG_ERROR("No renderer available for texture upload");
+        return 0;
+    }
+    texture_job_t job = { .rgba = rgba, .width = width, .height = height, .id = 0 };
+    renderer_run(upload_texture_job, &job);
+    return job.id;
+}
+
+void renderer_delete_texture(uint32_t id) {
+    if (id == 0 || !g_texture_ops || !g_texture_ops->delete_texture) return;
+    texture_job_t job = { .id = id };
+    renderer_run(delete_texture_job, &job);
+}
+
+static void queue_texture_job(void *arg) {
+    texture_job_t *job = arg;
+    const renderer_ops_t *ops = g_texture_ops;
+    uint64_t bytes = (uint64_t)job->width * (uint64_t)job->height * 4u;
+    bool banded = ops->begin_upload && ops->upload_rows && ops->finish_upload &&
+                  g_options.upload_budget > 0 && bytes > HYPRLAX_UPLOAD_BAND_BYTES &&
+                  g_upload_count < HYPRLAX_UPLOAD_QUEUE_MAX;
+    if (!banded) {
+        job->id = ops->upload_texture(job->rgba, job->width, job->height);
+        job->release(job->release_arg);
+        return;
+    }
+    job->id = ops->begin_upload(job->width, job->height);
+    if (!job->id) {
+        job->release(job->release_arg);
+        return;
+    }
+    pthread_mutex_lock(&g_upload_lock);
+    g_uploads[g_upload_count++] = (upload_entry_t){
+        .id = job->id, .rgba = job->rgba, .width = job->width, .height = job->height,
+        .release = job->release, .release_arg = job->release_arg,
+    };
+    g_upload_pending += bytes;
+    pthread_mutex_unlock(&g_upload_lock);
+}
+
+uint32_t renderer_queue_texture_with(const uint8_t *rgba, int width, int height,
+                                     renderer_release_fn release, void *release_arg) {
+    if (!rgba || width <= 0 || height <= 0 || !release) {
+        if (release) release(release_arg);
+        return 0;
+    }
+    if (!g_texture_ops || !g_texture_ops->upload_texture) {
+        LOG_ERROR("No renderer available for texture upload");
+        release(release_arg);
+        return 0;
+    }
+    texture_job_t job = {
+        .rgba = rgba, .width = width, .height = height, .id = 0,
+        .release = release, .release_arg = release_arg,
+    };
+    renderer_run(queue_texture_job, &job);
+    return job.id;
+}
+
+uint32_t renderer_queue_texture(uint8_t *rgba, int width, int height) {
+    return renderer_queue_texture_with(rgba, width, height, free, rgba);
+}
+
+bool renderer_texture_ready(uint32_t id) {
+    bool ready = true;
+    pthread_mutex_lock(&g_upload_lock);
+    for (int i = 0; i < g_upload_count && ready; i++) {
+        if (g_uploads[i].id == id) ready = false;
+    }
+    pthread_mutex_unlock(&g_upload_lock);
+    return ready;
+}
+
+uint64_t renderer_upload_pending_bytes(void) {
+    pthread_mutex_lock(&g_upload_lock);
+    uint64_t bytes = g_upload_pending;
+    pthread_mutex_unlock(&g_upload_lock);
+    return bytes;
+}
+
+static void max_texture_size_job(void *arg) {
+    *(int *)arg = g_texture_ops->max_texture_size();
+}
+
+int renderer_max_texture_size(void) {
+    int size = 0;
+    if (g_texture_ops && g_texture_ops->max_texture_size) renderer_run(max_texture_size_job, &size);
+    return size > 0 ? size : 0;
+}
+
+static double upload_clock_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+/* Upload bands, oldest image first, until the budget is spent (at least
+ * one band per call, so every image finishes); budget_us <= 0 drains */
+static bool pump_uploads(int budget_us) {
+    if (g_upload_count == 0 || !g_texture_ops) return false;
+    const renderer_ops_t *ops = g_texture_ops;
+    double start = upload_clock_us();
+    while (g_upload_count > 0) {
+        upload_entry_t *e = &g_uploads[0];
+        int rows = HYPRLAX_UPLOAD_BAND_BYTES / (e->width * 4);
+        if (rows < 1) rows = 1;
+        if (rows > e->height - e->next_row) rows = e->height - e->next_row;
+        ops->upload_rows(e->id, e->rgba + (size_t)e->next_row * (size_t)e->width * 4u,
+                         e->width, e->next_row, rows);
+        bool done = e->next_row + rows >= e->height;
+        if (done) ops->finish_upload(e->id, e->width, e->height);
+
+        pthread_mutex_lock(&g_upload_lock);
+        g_upload_pending -= (uint64_t)rows * (uint64_t)e->width * 4u;
+        e->next_row += rows;
+        if (done) upload_remove(0);
+        pthread_mutex_unlock(&g_upload_lock);
+
+        if (budget_us > 0 && upload_clock_us() - start >= (double)budget_us) break;
+    }
+    return g_upload_count > 0;
+}
+
+bool renderer_pump_uploads(void) {
+    return pump_uploads(g_options.upload_budget);
+}
+
+static void finish_uploads_job(void *arg) {
+    (void)arg;
+    pump_uploads(0);
+}
+
+void renderer_finish_uploads(void) {
+    renderer_run(finish_uploads_job, NULL);
+}
+
+/* Fullscreen quad: x, y, u, v per corner (triangle strip), V down */
+static const float renderer_quad_vertices[16] = {
+    -1.0f, -1.0f,  0.0f, 1.0f,
+     1.0f, -1.0f,  1.0f, 1.0f,
+    -1.0f,  1.0f,  0.0f, 0.0f,
+     1.0f,  1.0f,  1.0f, 0.0f,
+};
+
+/* Fit a texture into the viewport: quad size in NDC and the UV window */
+static void compute_fit_params(int vw, int vh, int tw, int th, int fit_mode,
+                               float content_scale, float align_x, float align_y,
+                               float *pos_w, float *pos_h,
+                               float *u0, float *v0, float *u1, float *v1) {
+    /* Defaults: STRETCH */
+    *pos_w = 2.0f; /* NDC width span */
+    *pos_h = 2.0f; /* NDC height span */
+    *u0 = 0.0f; *v0 = 0.0f; *u1 = 1.0f; *v1 = 1.0f;
+
+    float vw_f = (float)vw, vh_f = (float)vh;
+    float tw_f = (float)tw, th_f = (float)th;
+    if (vw <= 0 || vh <= 0 || tw <= 0 || th <= 0) return;
+
+    float scale = content_scale;
+    if (scale <= 0.0f) scale = 1.0f;
+
+    if (fit_mode == 0) {
+        /* STRETCH: defaults suffice */
+        return;
+    }
+
+    if (fit_mode == 1 /* COVER */ || fit_mode == 3 /* FIT_WIDTH */ || fit_mode == 4 /* FIT_HEIGHT */) {
+        float sx = vw_f / tw_f;
+        float sy = vh_f / th_f;
+        float s = sx;
+        if (fit_mode == 1) s = (sx > sy ? sx : sy); /* cover */
+        else if (fit_mode == 4) s = sy; /* fit height */
+        else s = sx; /* fit width */
+        s *= scale;
+        /* uv window to sample */
+        float uvw = vw_f / (s * tw_f);
+        float uvh = vh_f / (s * th_f);
+        if (uvw > 1.0f) uvw = 1.0f;
+        if (uvh > 1.0f) uvh = 1.0f;
+        *u0 = (1.0f - uvw) * (align_x < 0.0f ? 0.0f : (align_x > 1.0f ? 1.0f : align_x));
+        *v0 = (1.0f - uvh) * (align_y < 0.0f ? 0.0f : (align_y > 1.0f ? 1.0f : align_y));
+        *u1 = *u0 + uvw;
+        *v1 = *v0 + uvh;
+        /* positions cover full screen */
+        *pos_w = 2.0f;
+        *pos_h = 2.0f;
+        return;
+    }
+
+    if (fit_mode == 2 /* CONTAIN */) {
+        float sx = vw_f / tw_f;
+        float sy = vh_f / th_f;
+        float s = (sx < sy ? sx : sy);
+        s *= scale;
+        /* pos size in NDC to letterbox */
+        float screen_w_px = s * tw_f;
+        float screen_h_px = s * th_f;
+        float nx = (screen_w_px / vw_f) * 2.0f; /* full screen = 2.0 */
+        float ny = (screen_h_px / vh_f) * 2.0f;
+        if (nx > 2.0f) nx = 2.0f;
+        if (ny > 2.0f) ny = 2.0f;
+        *pos_w = nx;
+        *pos_h = ny;
+        *u0 = 0.0f; *v0 = 0.0f; *u1 = 1.0f; *v1 = 1.0f;
+        return;
+    }
+}
+
+/* Quad half-extents and alignment translation in NDC for a fitted layer */
+static void compute_quad_extents(float pos_w, float pos_h, float align_x, float align_y,
+                                 float *hx, float *hy, float *tx, float *ty) {
+    *hx = pos_w * 0.5f; if (*hx > 1.0f) *hx = 1.0f;
+    *hy = pos_h * 0.5f; if (*hy > 1.0f) *hy = 1.0f;
+
+    /* Base alignment translation within letterboxed area */
+    float remx = 2.0f - (*hx * 2.0f);
+    float remy = 2.0f - (*hy * 2.0f);
+    *tx = (align_x - 0.5f) * remx;
+    *ty = (align_y - 0.5f) * remy;
+}
+
+/* Backend-neutral part of compile_layer */
+void renderer_compile_layer_geometry(int viewport_width, int viewport_height,
+                                     const texture_t *texture, float opacity,
+                                     float blur_amount,
+                                     const renderer_layer_params_t *params,
+                                     renderer_draw_packet_t *out) {
+    memset(out, 0, sizeof(*out));
+    memcpy(out->vertices, renderer_quad_vertices, sizeof(out->vertices));
+    out->bounds[0] = -1.0f; out->bounds[1] = -1.0f;
+    out->bounds[2] = 1.0f; out->bounds[3] = 1.0f;
+    out->offset_scale[0] = 1.0f;
+    out->offset_scale[1] = 1.0f;
+    out->opacity = opacity;
+    out->blur_amount = blur_amount;
+    out->tint[0] = 1.0f; out->tint[1] = 1.0f; out->tint[2] = 1.0f;
+    out->wrap_s = RENDERER_WRAP_CLAMP;
+    out->wrap_t = RENDERER_WRAP_CLAMP;
+    out->program = RENDERER_PROGRAM_BASIC;
+    if (!texture) return;
+    out->tex_width = texture->width;
+    out->tex_height = texture->height;
+
+    float *vertices = out->vertices;
+    if (params) {
+        float u0=0.0f, v0=0.0f, u1=1.0f, v1=1.0f;
+        float pos_w = 2.0f, pos_h = 2.0f;
+        /* A cropped texture holds part of the source: fit the whole source,
+         * then map its UVs and offsets into the crop */
+        float crop_x = 0.0f, crop_y = 0.0f, crop_w = 1.0f, crop_h = 1.0f;
+        if (params->crop[2] > params->crop[0] && params->crop[3] > params->crop[1]) {
+            crop_x = params->crop[0];
+            crop_y = params->crop[1];
+            crop_w = params->crop[2] - params->crop[0];
+            crop_h = params->crop[3] - params->crop[1];
+        }
+        compute_fit_params(viewport_width, viewport_height,
+                           (int)((float)texture->width / crop_w + 0.5f),
+                           (int)((float)texture->height / crop_h + 0.5f),
+                           params->fit_mode, params->content_scale,
+                           params->align_x, params->align_y,
+                           &pos_w, &pos_h, &u0, &v0, &u1, &v1);
+
+        /* Apply only base UV offset (do not add parallax here) */
+        float du = params->base_uv_x;
+        float dv = params->base_uv_y;
+        u0 += du; u1 += du; v0 += dv; v1 += dv;
+
+        /* Apply UV margins (safe area) if provided */
+        float uv_margin_x = 0.0f, uv_margin_y = 0.0f;
+        if (params->margin_px_x > 0.0f || params->margin_px_y > 0.0f) {
+            uv_margin_x += params->margin_px_x / (float)viewport_width;
+            uv_margin_y += params->margin_px_y / (float)viewport_height;
+        }
+        /* Add auto safe area when overflow=none and not tiling that axis */
+        if (params->overflow_mode == 4) {
+            uv_margin_x += params->auto_safe_norm_x;
+            uv_margin_y += params->auto_safe_norm_y;
+        }
+        if (uv_margin_x > 0.0f || uv_margin_y > 0.0f) {
+            u0 += uv_margin_x; u1 -= uv_margin_x;
+            v0 += uv_margin_y; v1 -= uv_margin_y;
+            if (u0 < 0.0f) u0 = 0.0f; if (u1 > 1.0f) u1 = 1.0f; if (u1 < u0) u1 = u0;
+            if (v0 < 0.0f) v0 = 0.0f; if (v1 > 1.0f) v1 = 1.0f; if (v1 < v0) v1 = v0;
+        }
+        u0 = (u0 - crop_x) / crop_w; u1 = (u1 - crop_x) / crop_w;
+        v0 = (v0 - crop_y) / crop_h; v1 = (v1 - crop_y) / crop_h;
+
+        /* Compute quad extents (clamped to viewport); parallax is applied
+         * per frame via u_offset, never by translating geometry */
+        float hx, hy, tx_ndc, ty_ndc;
+        compute_quad_extents(pos_w, pos_h, params->align_x, params->align_y,
+                             &hx, &hy, &tx_ndc, &ty_ndc);
+
+        vertices[0] = -hx + tx_ndc; vertices[1] = -hy + ty_ndc;
+        vertices[4] =  hx + tx_ndc; vertices[5] = -hy + ty_ndc;
+        vertices[8] = -hx + tx_ndc; vertices[9] =  hy + ty_ndc;
+        vertices[12]=  hx + tx_ndc; vertices[13]=  hy + ty_ndc;
+
+        /* Set texcoords (base UV only) */
+        vertices[2] = u0; vertices[3] = v1;   /* bottom-left */
+        vertices[6] = u1; vertices[7] = v1;   /* bottom-right */
+        vertices[10]= u0; vertices[11]= v0;   /* top-left */
+        vertices[14]= u1; vertices[15]= v0;   /* top-right */
+
+        out->bounds[0] = -hx + tx_ndc; out->bounds[1] = -hy + ty_ndc;
+        out->bounds[2] =  hx + tx_ndc; out->bounds[3] =  hy + ty_ndc;
+
+        if (g_options.debug) {
+            fprintf(stderr,
+                    "[DEBUG] draw_ex: hx=%.3f hy=%.3f tx=%.3f ty=%.3f du=%.3f dv=%.3f\n",
+                    hx, hy, tx_ndc, ty_ndc, du, dv);
+        }
+
+        /* Scale the offset by content_scale to compensate for scaled image */
+        float offset_scale = params->content_scale > 0.0f ? 1.0f / params->content_scale : 1.0f;
+        out->offset_scale[0] = offset_scale / crop_w;
+        out->offset_scale[1] = offset_scale / crop_h;
+        out->tint[0] = params->tint_r;
+        out->tint[1] = params->tint_g;
+        out->tint[2] = params->tint_b;
+        out->tint_strength = params->tint_strength;
+        /* u_mask_outside for overflow=none on non-tiled axes */
+        out->mask[0] = (params->overflow_mode == 4 && !params->tile_x) ? 1.0f : 0.0f;
+        out->mask[1] = (params->overflow_mode == 4 && !params->tile_y) ? 1.0f : 0.0f;
+        /* Non-tiled axes clamp for every overflow mode */
+        if (params->tile_x) out->wrap_s = RENDERER_WRAP_REPEAT;
+        if (params->tile_y) out->wrap_t = RENDERER_WRAP_REPEAT;
+        out->has_params = true;
+
+        /* Uniform offset unless render.uniform_offset is off. The legacy
+         * path (no params) always translates texcoords. */
+        out->uniform_offset = g_options.uniform_offset;
+    }
+}
+
+void renderer_kawase_plan(float blur_amount, int viewport_width, int viewport_height,
+                          int *levels, float *offset) {
+    /* Same reach as the single-pass kernel: blur_amount * kernel size px */
+    float radius = blur_amount * HYPRLAX_BLUR_KERNEL_SIZE;
+    int short_side = viewport_width < viewport_height ? viewport_width : viewport_height;
+    int max_levels = 1;
+    while (max_levels < HYPRLAX_KAWASE_MAX_LEVELS &&
+           (short_side >> (max_levels + 1)) >= HYPRLAX_KAWASE_MIN_SIZE) {
+        max_levels++;
+    }
+    int n = 1;
+    while (n < max_levels && (float)(1 << (n + 1)) <= radius) n++;
+    float o = radius / (float)(1 << n);
+    if (o < 0.5f) o = 0.5f;
+    if (o > HYPRLAX_KAWASE_MAX_OFFSET) o = HYPRLAX_KAWASE_MAX_OFFSET;
+    if (levels) *levels = n;
+    if (offset) *offset = o;
+}
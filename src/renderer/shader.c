@@ -32,8 +32,8 @@ const char *shader_fragment_basic =
     "uniform vec3 u_tint;\n"
     "uniform float u_tint_strength;\n"
     "void main() {\n"
-    "    if ((u_mask_outside.x > 0.5 && (v_texcoord.x < 0.0 || v_texcoord.x > 1.0)) ||\n"
-    "        (u_mask_outside.y > 0.5 && (v_texcoord.y < 0.0 || v_texcoord.y > 1.0))) discard;\n"
+    "    if ((u_mask_outside.x > 0.5 && (v_texcoord.x < 1.0 - u_mask_outside.x || v_texcoord.x > u_mask_outside.x)) ||\n"
+    "        (u_mask_outside.y > 0.5 && (v_texcoord.y < 1.0 - u_mask_outside.y || v_texcoord.y > u_mask_outside.y))) discard;\n"
     "    vec4 color = texture2D(u_texture, v_texcoord);\n"
     "    vec3 effective = mix(vec3(1.0), u_tint, clamp(u_tint_strength, 0.0, 1.0));\n"
     "    vec3 rgb = color.rgb * effective;\n"
@@ -62,6 +62,152 @@ const char *shader_vertex_basic_offset =
     "    v_texcoord = a_texcoord + u_offset;\n"
     "}\n";
 
+/* Fullscreen pass for the single-pass composite; v_pos is the NDC position */
+const char *shader_vertex_composite =
+    "precision highp float;\n"
+    "attribute vec2 a_position;\n"
+    "varying vec2 v_pos;\n"
+    "void main() {\n"
+    "    gl_Position = vec4(a_position, 0.0, 1.0);\n"
+    "    v_pos = a_position;\n"
+    "}\n";
+
+/* Composite prologue; %d is the layer count. Per layer: u_rect is the quad
+ * in NDC, u_uv the texcoords at its bottom-left/top-right corners with the
+ * offset applied, u_color the tint (rgb) and opacity (a), u_mask the packet
+ * mask. Branch-free so
+ * texture2D stays in uniform control flow. */
+static const char *shader_fragment_composite_head =
+    "precision highp float;\n"
+    "varying vec2 v_pos;\n"
+    "uniform sampler2D u_tex[%d];\n"
+    "uniform vec4 u_rect[%d];\n"
+    "uniform vec4 u_uv[%d];\n"
+    "uniform vec4 u_color[%d];\n"
+    "uniform vec2 u_mask[%d];\n"
+    "vec4 layer_over(vec4 acc, sampler2D tex, vec4 rect, vec4 uv, vec4 color, vec2 mask) {\n"
+    "    vec2 s = (v_pos - rect.xy) / (rect.zw - rect.xy);\n"
+    "    vec2 t = mix(uv.xy, uv.zw, s);\n"
+    "    vec2 in_quad = step(vec2(0.0), s) * step(s, vec2(1.0));\n"
+    "    vec2 in_tex = step(vec2(1.0) - mask, t) * step(t, mask);\n"
+    "    vec2 keep = in_quad * (vec2(1.0) - step(vec2(0.5), mask) * (vec2(1.0) - in_tex));\n"
+    "    vec4 c = texture2D(tex, t);\n"
+    "    float a = c.a * color.a * keep.x * keep.y;\n"
+    "    return vec4(c.rgb * color.rgb * a, a) + acc * (1.0 - a);\n"
+    "}\n"
+    "void main() {\n"
+    "    vec4 acc = vec4(0.0);\n";
+
+/* Build the single-pass composite for a fixed layer count (bottom first) */
+char* shader_build_composite_fragment(int layers) {
+    if (layers <= 0) return NULL;
+    size_t size = strlen(shader_fragment_composite_head) + 64 + (size_t)layers * 96;
+    char *shader = malloc(size);
+    if (!shader) return NULL;
+
+    int len = snprintf(shader, size, shader_fragment_composite_head,
+                       layers, layers, layers, layers, layers);
+    for (int i = 0; i < layers && len > 0 && (size_t)len < size; i++) {
+        len += snprintf(shader + len, size - (size_t)len,
+                        "    acc = layer_over(acc, u_tex[%d], u_rect[%d], u_uv[%d], u_color[%d], u_mask[%d]);\n",
+                        i, i, i, i, i);
+    }
+    if (len > 0 && (size_t)len < size) {
+        len += snprintf(shader + len, size - (size_t)len, "    gl_FragColor = acc;\n}\n");
+    }
+    if (len <= 0 || (size_t)len >= size) {
+        free(shader);
+        return NULL;
+    }
+    return shader;
+}
+
+/* Instanced layer draw (GLSL ES 3.00); %d is the per-layer block size. Each
+ * instance is one layer's quad: a_rect in NDC and a_uv at its bottom-left
+ * and top-right corners, from the per-instance buffer; the block holds the
+ * per-frame offset and mask (u_place) and tint/opacity (u_color). */
+static const char *shader_vertex_instanced_template =
+    "#version 300 es\n"
+    "precision highp float;\n"
+    "layout(location = 0) in vec2 a_corner;\n"
+    "layout(location = 1) in vec4 a_rect;\n"
+    "layout(location = 2) in vec4 a_uv;\n"
+    "layout(location = 3) in float a_layer;\n"
+    "layout(std140) uniform Layers {\n"
+    "    vec4 u_place[%d];\n"
+    "    vec4 u_color[%d];\n"
+    "};\n"
+    "out vec2 v_texcoord;\n"
+    "flat out int v_layer;\n"
+    "flat out vec4 v_color;\n"
+    "flat out vec2 v_mask;\n"
+    "void main() {\n"
+    "    int i = int(a_layer);\n"
+    "    gl_Position = vec4(mix(a_rect.xy, a_rect.zw, a_corner), 0.0, 1.0);\n"
+    "    v_texcoord = mix(a_uv.xy, a_uv.zw, a_corner) + u_place[i].xy;\n"
+    "    v_mask = u_place[i].zw;\n"
+    "    v_color = u_color[i];\n"
+    "    v_layer = i;\n"
+    "}\n";
+
+/* Fragment prologue; %d is the layer count. Samplers can only be indexed by
+ * constants, so the layer's texture is picked by a branch on the (flat)
+ * instance index; gradients are taken outside it so mip selection stays
+ * defined. */
+static const char *shader_fragment_instanced_head =
+    "#version 300 es\n"
+    "precision highp float;\n"
+    "in vec2 v_texcoord;\n"
+    "flat in int v_layer;\n"
+    "flat in vec4 v_color;\n"
+    "flat in vec2 v_mask;\n"
+    "uniform sampler2D u_tex[%d];\n"
+    "out vec4 frag_color;\n"
+    "void main() {\n"
+    "    if ((v_mask.x > 0.5 && (v_texcoord.x < 1.0 - v_mask.x || v_texcoord.x > v_mask.x)) ||\n"
+    "        (v_mask.y > 0.5 && (v_texcoord.y < 1.0 - v_mask.y || v_texcoord.y > v_mask.y))) discard;\n"
+    "    vec2 dx = dFdx(v_texcoord);\n"
+    "    vec2 dy = dFdy(v_texcoord);\n"
+    "    vec4 c = vec4(0.0);\n";
+
+int shader_build_instanced(int layers, char **vertex_src, char **fragment_src) {
+    if (layers <= 0 || layers > HYPRLAX_COMPOSITE_MAX_LAYERS || !vertex_src || !fragment_src) {
+        return HYPRLAX_ERROR_INVALID_ARGS;
+    }
+    size_t vsize = strlen(shader_vertex_instanced_template) + 32;
+    size_t fsize = strlen(shader_fragment_instanced_head) + 160 + (size_t)layers * 96;
+    char *vertex = malloc(vsize);
+    char *fragment = malloc(fsize);
+    if (!vertex || !fragment) {
+        free(vertex);
+        free(fragment);
+        return HYPRLAX_ERROR_NO_MEMORY;
+    }
+    snprintf(vertex, vsize, shader_vertex_instanced_template,
+             HYPRLAX_COMPOSITE_MAX_LAYERS, HYPRLAX_COMPOSITE_MAX_LAYERS);
+
+    int len = snprintf(fragment, fsize, shader_fragment_instanced_head, layers);
+    for (int i = 0; i < layers && len > 0 && (size_t)len < fsize; i++) {
+        len += snprintf(fragment + len, fsize - (size_t)len,
+                        "    %sif (v_layer == %d) c = textureGrad(u_tex[%d], v_texcoord, dx, dy);\n",
+                        i ? "else " : "", i, i);
+    }
+    if (len > 0 && (size_t)len < fsize) {
+        len += snprintf(fragment + len, fsize - (size_t)len,
+                        "    float a = c.a * v_color.a;\n"
+                        "    frag_color = vec4(c.rgb * v_color.rgb * a, a);\n"
+                        "}\n");
+    }
+    if (len <= 0 || (size_t)len >= fsize) {
+        free(vertex);
+        free(fragment);
+        return HYPRLAX_ERROR_NO_MEMORY;
+    }
+    *vertex_src = vertex;
+    *fragment_src = fragment;
+    return HYPRLAX_SUCCESS;
+}
+
 /* Shader constants */
 #define BLUR_KERNEL_SIZE HYPRLAX_BLUR_KERNEL_SIZE
 #define BLUR_WEIGHT_FALLOFF HYPRLAX_BLUR_WEIGHT_FALLOFF
@@ -80,8 +226,8 @@ static const char *shader_fragment_blur_template =
     "uniform float u_tint_strength;\n"
     "\n"
     "void main() {\n"
-    "    if ((u_mask_outside.x > 0.5 && (v_texcoord.x < 0.0 || v_texcoord.x > 1.0)) ||\n"
-    "        (u_mask_outside.y > 0.5 && (v_texcoord.y < 0.0 || v_texcoord.y > 1.0))) discard;\n"
+    "    if ((u_mask_outside.x > 0.5 && (v_texcoord.x < 1.0 - u_mask_outside.x || v_texcoord.x > u_mask_outside.x)) ||\n"
+    "        (u_mask_outside.y > 0.5 && (v_texcoord.y < 1.0 - u_mask_outside.y || v_texcoord.y > u_mask_outside.y))) discard;\n"
     "    vec2 texel_size = 1.0 / u_resolution;\n"
     "    vec4 result = vec4(0.0);\n"
     "    float total_weight = 0.0;\n"
@@ -118,8 +264,8 @@ static const char *shader_fragment_blur_separable =
     "uniform float u_tint_strength;\n"
     "\n"
     "void main() {\n"
-    "    if ((u_mask_outside.x > 0.5 && (v_texcoord.x < 0.0 || v_texcoord.x > 1.0)) ||\n"
-    "        (u_mask_outside.y > 0.5 && (v_texcoord.y < 0.0 || v_texcoord.y > 1.0))) discard;\n"
+    "    if ((u_mask_outside.x > 0.5 && (v_texcoord.x < 1.0 - u_mask_outside.x || v_texcoord.x > u_mask_outside.x)) ||\n"
+    "        (u_mask_outside.y > 0.5 && (v_texcoord.y < 1.0 - u_mask_outside.y || v_texcoord.y > u_mask_outside.y))) discard;\n"
     "    vec2 texel = 1.0 / u_resolution;\n"
     "    float spread = max(u_blur_amount, 0.001);\n"
     "    vec4 sum = vec4(0.0);\n"
@@ -154,6 +300,15 @@ shader_program_t* shader_create_program(const char *name) {
     program->loc_u_opacity = -1;
     program->loc_u_blur_amount = -1;
     program->loc_u_resolution = -1;
+    program->loc_u_offset = -1;
+    program->loc_u_mask_outside = -1;
+    program->loc_u_tint = -1;
+    program->loc_u_tint_strength = -1;
+    program->loc_u_direction = -1;
+    program->loc_u_color = -1;
+    program->loc_u_rect = -1;
+    program->loc_u_uv = -1;
+    program->loc_u_mask = -1;
 
     return program;
 }
@@ -267,6 +422,13 @@ int shader_compile(shader_program_t *program,
     program->loc_u_resolution = glGetUniformLocation(program->id, "u_resolution");
     program->loc_u_offset = glGetUniformLocation(program->id, "u_offset");
     program->loc_u_mask_outside = glGetUniformLocation(program->id, "u_mask_outside");
+    program->loc_u_tint = glGetUniformLocation(program->id, "u_tint");
+    program->loc_u_tint_strength = glGetUniformLocation(program->id, "u_tint_strength");
+    program->loc_u_direction = glGetUniformLocation(program->id, "u_direction");
+    program->loc_u_color = glGetUniformLocation(program->id, "u_color");
+    program->loc_u_rect = glGetUniformLocation(program->id, "u_rect");
+    program->loc_u_uv = glGetUniformLocation(program->id, "u_uv");
+    program->loc_u_mask = glGetUniformLocation(program->id, "u_mask");
     program->cache_ready = true;
 
     return HYPRLAX_SUCCESS;
@@ -289,6 +451,79 @@ int shader_compile_blur(shader_program_t *program) {
     return result;
 }
 
+/* One direction of the cached blur: same kernel as the separable blur, but
+ * straight alpha in and out so the result can be drawn like an image */
+static const char *shader_fragment_blur_pass =
+    "precision highp float;\n"
+    "varying vec2 v_texcoord;\n"
+    "uniform sampler2D u_texture;\n"
+    "uniform vec2 u_resolution;\n"
+    "uniform float u_blur_amount;\n"
+    "uniform vec2 u_direction;\n"
+    "\n"
+    "void main() {\n"
+    "    vec2 texel = 1.0 / u_resolution;\n"
+    "    float spread = max(u_blur_amount, 0.001);\n"
+    "    vec4 sum = vec4(0.0);\n"
+    "    float total = 0.0;\n"
+    "    float sigma = 2.0;\n"
+    "    float denom = 2.0 * sigma * sigma;\n"
+    "    for (int i = -4; i <= 4; i++) {\n"
+    "        float fi = float(i) * spread;\n"
+    "        float w = exp(-(fi*fi) / denom);\n"
+    "        sum += texture2D(u_texture, v_texcoord + u_direction * texel * fi) * w;\n"
+    "        total += w;\n"
+    "    }\n"
+    "    gl_FragColor = sum / total;\n"
+    "}\n";
+
+/* Dual-Kawase downsample: centre plus four diagonal taps half a texel out
+ * (scaled by u_blur_amount), written to a level half the size. Inputs and
+ * outputs are premultiplied. */
+static const char *shader_fragment_kawase_down =
+    "precision highp float;\n"
+    "varying vec2 v_texcoord;\n"
+    "uniform sampler2D u_texture;\n"
+    "uniform vec2 u_resolution;\n"
+    "uniform float u_blur_amount;\n"
+    "\n"
+    "void main() {\n"
+    "    vec2 d = 0.5 / u_resolution * u_blur_amount;\n"
+    "    vec4 sum = texture2D(u_texture, v_texcoord) * 4.0;\n"
+    "    sum += texture2D(u_texture, v_texcoord - d);\n"
+    "    sum += texture2D(u_texture, v_texcoord + d);\n"
+    "    sum += texture2D(u_texture, v_texcoord + vec2(d.x, -d.y));\n"
+    "    sum += texture2D(u_texture, v_texcoord - vec2(d.x, -d.y));\n"
+    "    gl_FragColor = sum / 8.0;\n"
+    "}\n";
+
+/* Dual-Kawase upsample: eight taps on a ring one texel out, into a level
+ * twice the size. The last pass applies tint and opacity. */
+static const char *shader_fragment_kawase_up =
+    "precision highp float;\n"
+    "varying vec2 v_texcoord;\n"
+    "uniform sampler2D u_texture;\n"
+    "uniform vec2 u_resolution;\n"
+    "uniform float u_blur_amount;\n"
+    "uniform float u_opacity;\n"
+    "uniform vec3 u_tint;\n"
+    "uniform float u_tint_strength;\n"
+    "\n"
+    "void main() {\n"
+    "    vec2 d = 0.5 / u_resolution * u_blur_amount;\n"
+    "    vec4 sum = texture2D(u_texture, v_texcoord + vec2(-d.x * 2.0, 0.0));\n"
+    "    sum += texture2D(u_texture, v_texcoord + vec2(-d.x, d.y)) * 2.0;\n"
+    "    sum += texture2D(u_texture, v_texcoord + vec2(0.0, d.y * 2.0));\n"
+    "    sum += texture2D(u_texture, v_texcoord + vec2(d.x, d.y)) * 2.0;\n"
+    "    sum += texture2D(u_texture, v_texcoord + vec2(d.x * 2.0, 0.0));\n"
+    "    sum += texture2D(u_texture, v_texcoord + vec2(d.x, -d.y)) * 2.0;\n"
+    "    sum += texture2D(u_texture, v_texcoord + vec2(0.0, -d.y * 2.0));\n"
+    "    sum += texture2D(u_texture, v_texcoord + vec2(-d.x, -d.y)) * 2.0;\n"
+    "    vec4 result = sum / 12.0;\n"
+    "    vec3 effective = mix(vec3(1.0), u_tint, clamp(u_tint_strength, 0.0, 1.0));\n"
+    "    gl_FragColor = vec4(result.rgb * effective, result.a) * u_opacity;\n"
+    "}\n";
+
 /* Compile separable blur shader */
 int shader_compile_separable_blur(shader_program_t *program) {
     if (!program) return HYPRLAX_ERROR_INVALID_ARGS;
@@ -300,6 +535,20 @@ int shader_compile_separable_blur_with_vertex(shader_program_t *program, const c
     return shader_compile(program, vertex_src, shader_fragment_blur_separable);
 }
 
+/* Compile the dual-Kawase down/upsample passes */
+int shader_compile_kawase_blur(shader_program_t *down, shader_program_t *up) {
+    if (!down || !up) return HYPRLAX_ERROR_INVALID_ARGS;
+    int ret = shader_compile(down, shader_vertex_basic, shader_fragment_kawase_down);
+    if (ret != HYPRLAX_SUCCESS) return ret;
+    return shader_compile(up, shader_vertex_basic, shader_fragment_kawase_up);
+}
+
+/* Compile the offscreen pass that renders cached blurs */
+int shader_compile_blur_pass(shader_program_t *program) {
+    if (!program) return HYPRLAX_ERROR_INVALID_ARGS;
+    return shader_compile(program, shader_vertex_basic, shader_fragment_blur_pass);
+}
+
 /* Use shader program */
 void shader_use(const shader_program_t *program) {
     static uint32_t s_last_program = 0;
@@ -362,6 +611,14 @@ int shader_get_uniform_location(const shader_program_t *program, const char *nam
         if (strcmp(name, "u_blur_amount") == 0) return program->loc_u_blur_amount;
         if (strcmp(name, "u_resolution") == 0) return program->loc_u_resolution;
         if (strcmp(name, "u_offset") == 0) return program->loc_u_offset;
+        if (strcmp(name, "u_mask_outside") == 0) return program->loc_u_mask_outside;
+        if (strcmp(name, "u_tint") == 0) return program->loc_u_tint;
+        if (strcmp(name, "u_tint_strength") == 0) return program->loc_u_tint_strength;
+        if (strcmp(name, "u_direction") == 0) return program->loc_u_direction;
+        if (strcmp(name, "u_color") == 0) return program->loc_u_color;
+        if (strcmp(name, "u_rect") == 0) return program->loc_u_rect;
+        if (strcmp(name, "u_uv") == 0) return program->loc_u_uv;
+        if (strcmp(name, "u_mask") == 0) return program->loc_u_mask;
     }
     return glGetUniformLocation(program->id, name);
 }
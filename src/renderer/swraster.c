@@ -0,0 +1,481 @@
+/*
+ * swraster.c - CPU rasterizer for the software renderer
+ *
+ * A layer quad is axis-aligned and its UVs are linear in x and y
+ * separately, so a draw resolves texel columns and horizontal weights once
+ * (they are the same for every row) and each row only picks its two texel
+ * rows. The span kernels then do the per-pixel work: bilinear filter,
+ * opacity/tint modulation and the premultiplied "over" blend, in 16-bit
+ * lanes with 8-bit weights:
+ *
+ *   lerp(a, b, w) = ((a << 8) + (b - a) * w) >> 8     w in 0..256
+ *   over(s, d)    = s + ((d * (256 - s.a)) >> 8)
+ *
+ * Intermediate values never leave 0..65280, so the wrapping 16-bit SIMD
+ * multiplies give the same results as the scalar kernel.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "swraster.h"
+#include "../include/log.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SWRASTER_X86 1
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#define SWRASTER_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* Scalar reference kernel; also finishes the SIMD kernels' tails */
+static void span_scalar(uint32_t *dst, const uint32_t *row0, const uint32_t *row1,
+                        const swraster_columns_t *cols, int count,
+                        uint32_t fy, const uint16_t mod[4], bool blend) {
+    for (int i = 0; i < count; i++) {
+        uint32_t p00 = row0[cols->x0[i]], p01 = row0[cols->x1[i]];
+        uint32_t p10 = row1[cols->x0[i]], p11 = row1[cols->x1[i]];
+        int32_t fx = (int32_t)(cols->fx[i] & 0xffff);
+        uint32_t s[4];
+        for (int k = 0; k < 4; k++) {
+            int sh = k * 8;
+            int32_t a = (p00 >> sh) & 0xff, b = (p01 >> sh) & 0xff;
+            int32_t c = (p10 >> sh) & 0xff, d = (p11 >> sh) & 0xff;
+            int32_t top = ((a << 8) + (b - a) * fx) >> 8;
+            int32_t bot = ((c << 8) + (d - c) * fx) >> 8;
+            int32_t v = ((top << 8) + (bot - top) * (int32_t)fy) >> 8;
+            s[k] = ((uint32_t)v * mod[k]) >> 8;
+        }
+        if (blend) {
+            uint32_t ia = 256 - s[3];
+            uint32_t d = dst[i];
+            for (int k = 0; k < 4; k++) {
+                s[k] += (((d >> (k * 8)) & 0xff) * ia) >> 8;
+                if (s[k] > 255) s[k] = 255;
+            }
+        }
+        dst[i] = s[0] | (s[1] << 8) | (s[2] << 16) | (s[3] << 24);
+    }
+}
+
+/* Remaining pixels of a SIMD span */
+static void span_tail(uint32_t *dst, const uint32_t *row0, const uint32_t *row1,
+                      const swraster_columns_t *cols, int from, int count,
+                      uint32_t fy, const uint16_t mod[4], bool blend) {
+    if (from >= count) return;
+    swraster_columns_t rest = { cols->x0 + from, cols->x1 + from, cols->fx + from };
+    span_scalar(dst + from, row0, row1, &rest, count - from, fy, mod, blend);
+}
+
+#ifdef SWRASTER_X86
+__attribute__((target("sse2")))
+static inline __m128i sse2_lerp(__m128i a, __m128i b, __m128i w) {
+    return _mm_srli_epi16(_mm_add_epi16(_mm_slli_epi16(a, 8),
+                                        _mm_mullo_epi16(_mm_sub_epi16(b, a), w)), 8);
+}
+
+/* Two pixels in 16-bit lanes: filter, modulate, optionally blend over d */
+__attribute__((target("sse2")))
+static inline __m128i sse2_shade(__m128i a, __m128i b, __m128i c, __m128i d, __m128i wx,
+                                 __m128i wy, __m128i mod, __m128i dst, bool blend) {
+    __m128i s = sse2_lerp(sse2_lerp(a, b, wx), sse2_lerp(c, d, wx), wy);
+    s = _mm_srli_epi16(_mm_mullo_epi16(s, mod), 8);
+    if (!blend) return s;
+    __m128i sa = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)),
+                                     _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i ia = _mm_sub_epi16(_mm_set1_epi16(256), sa);
+    return _mm_add_epi16(s, _mm_srli_epi16(_mm_mullo_epi16(dst, ia), 8));
+}
+
+/* Four pixels per step; SSE2 has no gather, texels are loaded one by one */
+__attribute__((target("sse2")))
+static void span_sse2(uint32_t *dst, const uint32_t *row0, const uint32_t *row1,
+                      const swraster_columns_t *cols, int count,
+                      uint32_t fy, const uint16_t mod[4], bool blend) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i wy = _mm_set1_epi16((short)fy);
+    const __m128i m = _mm_set_epi16((short)mod[3], (short)mod[2], (short)mod[1], (short)mod[0],
+                                    (short)mod[3], (short)mod[2], (short)mod[1], (short)mod[0]);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const int32_t *x0 = cols->x0 + i, *x1 = cols->x1 + i;
+        __m128i a = _mm_set_epi32((int)row0[x0[3]], (int)row0[x0[2]], (int)row0[x0[1]], (int)row0[x0[0]]);
+        __m128i b = _mm_set_epi32((int)row0[x1[3]], (int)row0[x1[2]], (int)row0[x1[1]], (int)row0[x1[0]]);
+        __m128i c = _mm_set_epi32((int)row1[x0[3]], (int)row1[x0[2]], (int)row1[x0[1]], (int)row1[x0[0]]);
+        __m128i d = _mm_set_epi32((int)row1[x1[3]], (int)row1[x1[2]], (int)row1[x1[1]], (int)row1[x1[0]]);
+        __m128i w = _mm_loadu_si128((const __m128i *)(cols->fx + i));
+        __m128i out = blend ? _mm_loadu_si128((const __m128i *)(dst + i)) : zero;
+
+        __m128i lo = sse2_shade(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero),
+                                _mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(d, zero),
+                                _mm_unpacklo_epi32(w, w), wy, m,
+                                _mm_unpacklo_epi8(out, zero), blend);
+        __m128i hi = sse2_shade(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero),
+                                _mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(d, zero),
+                                _mm_unpackhi_epi32(w, w), wy, m,
+                                _mm_unpackhi_epi8(out, zero), blend);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    span_tail(dst, row0, row1, cols, i, count, fy, mod, blend);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i avx2_lerp(__m256i a, __m256i b, __m256i w) {
+    return _mm256_srli_epi16(_mm256_add_epi16(_mm256_slli_epi16(a, 8),
+                                              _mm256_mullo_epi16(_mm256_sub_epi16(b, a), w)), 8);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i avx2_shade(__m256i a, __m256i b, __m256i c, __m256i d, __m256i wx,
+                                 __m256i wy, __m256i mod, __m256i dst, bool blend) {
+    __m256i s = avx2_lerp(avx2_lerp(a, b, wx), avx2_lerp(c, d, wx), wy);
+    s = _mm256_srli_epi16(_mm256_mullo_epi16(s, mod), 8);
+    if (!blend) return s;
+    __m256i sa = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)),
+                                        _MM_SHUFFLE(3, 3, 3, 3));
+    __m256i ia = _mm256_sub_epi16(_mm256_set1_epi16(256), sa);
+    return _mm256_add_epi16(s, _mm256_srli_epi16(_mm256_mullo_epi16(dst, ia), 8));
+}
+
+/* Eight pixels per step with hardware gathers. Unpack and pack work within
+ * 128-bit lanes, so each half holds pixels {0,1,4,5} / {2,3,6,7} and the
+ * final pack restores the order. */
+__attribute__((target("avx2")))
+static void span_avx2(uint32_t *dst, const uint32_t *row0, const uint32_t *row1,
+                      const swraster_columns_t *cols, int count,
+                      uint32_t fy, const uint16_t mod[4], bool blend) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i wy = _mm256_set1_epi16((short)fy);
+    const __m256i m = _mm256_set1_epi64x((long long)((uint64_t)mod[0] | ((uint64_t)mod[1] << 16) |
+                                                     ((uint64_t)mod[2] << 32) | ((uint64_t)mod[3] << 48)));
+    const int *r0 = (const int *)row0, *r1 = (const int *)row1;
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i i0 = _mm256_loadu_si256((const __m256i *)(cols->x0 + i));
+        __m256i i1 = _mm256_loadu_si256((const __m256i *)(cols->x1 + i));
+        __m256i a = _mm256_i32gather_epi32(r0, i0, 4);
+        __m256i b = _mm256_i32gather_epi32(r0, i1, 4);
+        __m256i c = _mm256_i32gather_epi32(r1, i0, 4);
+        __m256i d = _mm256_i32gather_epi32(r1, i1, 4);
+        __m256i w = _mm256_loadu_si256((const __m256i *)(cols->fx + i));
+        __m256i out = blend ? _mm256_loadu_si256((const __m256i *)(dst + i)) : zero;
+
+        __m256i lo = avx2_shade(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero),
+                                _mm256_unpacklo_epi8(c, zero), _mm256_unpacklo_epi8(d, zero),
+                                _mm256_unpacklo_epi32(w, w), wy, m,
+                                _mm256_unpacklo_epi8(out, zero), blend);
+        __m256i hi = avx2_shade(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero),
+                                _mm256_unpackhi_epi8(c, zero), _mm256_unpackhi_epi8(d, zero),
+                                _mm256_unpackhi_epi32(w, w), wy, m,
+                                _mm256_unpackhi_epi8(out, zero), blend);
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+    span_tail(dst, row0, row1, cols, i, count, fy, mod, blend);
+}
+#endif /* SWRASTER_X86 */
+
+#ifdef SWRASTER_NEON
+static inline uint16x8_t neon_lerp(uint16x8_t a, uint16x8_t b, uint16x8_t w) {
+    return vshrq_n_u16(vaddq_u16(vshlq_n_u16(a, 8), vmulq_u16(vsubq_u16(b, a), w)), 8);
+}
+
+static inline uint16x8_t neon_shade(uint16x8_t a, uint16x8_t b, uint16x8_t c, uint16x8_t d,
+                                    uint16x8_t wx, uint16x8_t wy, uint16x8_t mod,
+                                    uint16x8_t dst, bool blend) {
+    uint16x8_t s = neon_lerp(neon_lerp(a, b, wx), neon_lerp(c, d, wx), wy);
+    s = vshrq_n_u16(vmulq_u16(s, mod), 8);
+    if (!blend) return s;
+    uint16x8_t sa = vcombine_u16(vdup_lane_u16(vget_low_u16(s), 3),
+                                 vdup_lane_u16(vget_high_u16(s), 3));
+    uint16x8_t ia = vsubq_u16(vdupq_n_u16(256), sa);
+    return vaddq_u16(s, vshrq_n_u16(vmulq_u16(dst, ia), 8));
+}
+
+static void span_neon(uint32_t *dst, const uint32_t *row0, const uint32_t *row1,
+                      const swraster_columns_t *cols, int count,
+                      uint32_t fy, const uint16_t mod[4], bool blend) {
+    const uint16x8_t wy = vdupq_n_u16((uint16_t)fy);
+    const uint16_t mod8[8] = { mod[0], mod[1], mod[2], mod[3], mod[0], mod[1], mod[2], mod[3] };
+    const uint16x8_t m = vld1q_u16(mod8);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const int32_t *x0 = cols->x0 + i, *x1 = cols->x1 + i;
+        uint32_t ta[4] = { row0[x0[0]], row0[x0[1]], row0[x0[2]], row0[x0[3]] };
+        uint32_t tb[4] = { row0[x1[0]], row0[x1[1]], row0[x1[2]], row0[x1[3]] };
+        uint32_t tc[4] = { row1[x0[0]], row1[x0[1]], row1[x0[2]], row1[x0[3]] };
+        uint32_t td[4] = { row1[x1[0]], row1[x1[1]], row1[x1[2]], row1[x1[3]] };
+        uint8x16_t a = vreinterpretq_u8_u32(vld1q_u32(ta));
+        uint8x16_t b = vreinterpretq_u8_u32(vld1q_u32(tb));
+        uint8x16_t c = vreinterpretq_u8_u32(vld1q_u32(tc));
+        uint8x16_t d = vreinterpretq_u8_u32(vld1q_u32(td));
+        uint32x4_t w = vld1q_u32(cols->fx + i);
+        uint32x4x2_t wz = vzipq_u32(w, w);
+        uint8x16_t out = blend ? vreinterpretq_u8_u32(vld1q_u32(dst + i)) : vdupq_n_u8(0);
+
+        uint16x8_t lo = neon_shade(vmovl_u8(vget_low_u8(a)), vmovl_u8(vget_low_u8(b)),
+                                   vmovl_u8(vget_low_u8(c)), vmovl_u8(vget_low_u8(d)),
+                                   vreinterpretq_u16_u32(wz.val[0]), wy, m,
+                                   vmovl_u8(vget_low_u8(out)), blend);
+        uint16x8_t hi = neon_shade(vmovl_u8(vget_high_u8(a)), vmovl_u8(vget_high_u8(b)),
+                                   vmovl_u8(vget_high_u8(c)), vmovl_u8(vget_high_u8(d)),
+                                   vreinterpretq_u16_u32(wz.val[1]), wy, m,
+                                   vmovl_u8(vget_high_u8(out)), blend);
+        vst1q_u32(dst + i, vreinterpretq_u32_u8(vcombine_u8(vqmovn_u16(lo), vqmovn_u16(hi))));
+    }
+    span_tail(dst, row0, row1, cols, i, count, fy, mod, blend);
+}
+#endif /* SWRASTER_NEON */
+
+static const char *s_isa_names[SWRASTER_ISA_COUNT] = { "scalar", "sse2", "avx2", "neon" };
+
+const char* swraster_isa_name(swraster_isa_t isa) {
+    return (isa >= 0 && isa < SWRASTER_ISA_COUNT) ? s_isa_names[isa] : "unknown";
+}
+
+swraster_span_fn swraster_get_span(swraster_isa_t isa) {
+    switch (isa) {
+        case SWRASTER_ISA_SCALAR:
+            return span_scalar;
+#ifdef SWRASTER_X86
+        case SWRASTER_ISA_SSE2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2") ? span_sse2 : NULL;
+        case SWRASTER_ISA_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") ? span_avx2 : NULL;
+#endif
+#ifdef SWRASTER_NEON
+        case SWRASTER_ISA_NEON:
+            return span_neon;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+static swraster_span_fn s_span = NULL;
+
+swraster_isa_t swraster_select(void) {
+    static const swraster_isa_t order[] = {
+        SWRASTER_ISA_AVX2, SWRASTER_ISA_NEON, SWRASTER_ISA_SSE2, SWRASTER_ISA_SCALAR
+    };
+    const char *force = getenv("HYPRLAX_SW_SIMD");
+    swraster_isa_t chosen = SWRASTER_ISA_SCALAR;
+    bool forced = false;
+    if (force && *force) {
+        for (int i = 0; i < SWRASTER_ISA_COUNT; i++) {
+            if (!strcasecmp(force, s_isa_names[i]) && swraster_get_span((swraster_isa_t)i)) {
+                chosen = (swraster_isa_t)i;
+                forced = true;
+                break;
+            }
+        }
+        if (!forced) LOG_WARN("HYPRLAX_SW_SIMD=%s not available; autodetecting", force);
+    }
+    for (size_t i = 0; !forced && i < sizeof(order) / sizeof(order[0]); i++) {
+        if (swraster_get_span(order[i])) {
+            chosen = order[i];
+            break;
+        }
+    }
+    s_span = swraster_get_span(chosen);
+    return chosen;
+}
+
+static inline uint32_t sw_to_byte(float v) {
+    if (!(v > 0.0f)) return 0;
+    if (v >= 1.0f) return 255;
+    return (uint32_t)(v * 255.0f + 0.5f);
+}
+
+uint32_t swraster_pack_color(float r, float g, float b, float a) {
+    return sw_to_byte(b) | (sw_to_byte(g) << 8) | (sw_to_byte(r) << 16) | (sw_to_byte(a) << 24);
+}
+
+void swraster_premultiply(const uint8_t *rgba, int count, uint32_t *out) {
+    for (int i = 0; i < count; i++, rgba += 4) {
+        uint32_t a = rgba[3];
+        uint32_t r = (rgba[0] * a + 127) / 255;
+        uint32_t g = (rgba[1] * a + 127) / 255;
+        uint32_t b = (rgba[2] * a + 127) / 255;
+        out[i] = b | (g << 8) | (r << 16) | (a << 24);
+    }
+}
+
+/* Intersect a clip rect with the image; false if nothing is left */
+static bool sw_clip(const sw_image_t *img, const int clip[4], int out[4]) {
+    int x0 = 0, y0 = 0, x1 = img->width, y1 = img->height;
+    if (clip) {
+        if (clip[0] > x0) x0 = clip[0];
+        if (clip[1] > y0) y0 = clip[1];
+        if (clip[0] + clip[2] < x1) x1 = clip[0] + clip[2];
+        if (clip[1] + clip[3] < y1) y1 = clip[1] + clip[3];
+    }
+    out[0] = x0; out[1] = y0; out[2] = x1; out[3] = y1;
+    return x1 > x0 && y1 > y0;
+}
+
+void swraster_fill(sw_image_t *dst, const int clip[4], uint32_t color) {
+    int r[4];
+    if (!dst || !dst->pixels || !sw_clip(dst, clip, r)) return;
+    for (int y = r[1]; y < r[3]; y++) {
+        uint32_t *row = dst->pixels + (size_t)y * dst->stride;
+        for (int x = r[0]; x < r[2]; x++) row[x] = color;
+    }
+}
+
+void swraster_fade(sw_image_t *dst, const int clip[4], uint32_t color) {
+    int r[4];
+    if (!dst || !dst->pixels || !sw_clip(dst, clip, r)) return;
+    uint32_t ia = 256 - (color >> 24);
+    for (int y = r[1]; y < r[3]; y++) {
+        uint32_t *row = dst->pixels + (size_t)y * dst->stride;
+        for (int x = r[0]; x < r[2]; x++) {
+            uint32_t d = row[x], out = 0;
+            for (int k = 0; k < 32; k += 8) {
+                uint32_t v = ((color >> k) & 0xff) + ((((d >> k) & 0xff) * ia) >> 8);
+                out |= (v > 255 ? 255 : v) << k;
+            }
+            row[x] = out;
+        }
+    }
+}
+
+void swraster_copy(sw_image_t *dst, const sw_image_t *src, const int clip[4]) {
+    int r[4];
+    if (!dst || !src || !dst->pixels || !src->pixels) return;
+    if (dst->width != src->width || dst->height != src->height) return;
+    if (!sw_clip(dst, clip, r)) return;
+    for (int y = r[1]; y < r[3]; y++) {
+        memcpy(dst->pixels + (size_t)y * dst->stride + r[0],
+               src->pixels + (size_t)y * src->stride + r[0],
+               (size_t)(r[2] - r[0]) * sizeof(uint32_t));
+    }
+}
+
+/* Texel index for wrap mode; i is a floor()ed texel coordinate */
+static inline int32_t sw_wrap(double i, int n, bool repeat) {
+    if (repeat) {
+        double m = fmod(i, (double)n);
+        if (m < 0.0) m += n;
+        int32_t t = (int32_t)m;
+        return t >= n ? 0 : t;
+    }
+    if (i < 0.0) return 0;
+    if (i > n - 1) return n - 1;
+    return (int32_t)i;
+}
+
+/* Texel pair and weight for a normalized coordinate (GL_LINEAR sampling) */
+static inline void sw_texel(double t, int n, bool repeat, int32_t *i0, int32_t *i1, uint32_t *w) {
+    double tc = t * n - 0.5;
+    double fl = floor(tc);
+    uint32_t f = (uint32_t)((tc - fl) * 256.0 + 0.5);
+    *w = f > 256 ? 256 : f;
+    *i0 = sw_wrap(fl, n, repeat);
+    *i1 = sw_wrap(fl + 1.0, n, repeat);
+}
+
+static inline uint16_t sw_mod(float v) {
+    if (!(v > 0.0f)) return 0;
+    if (v >= 1.0f) return 256;
+    return (uint16_t)(v * 256.0f + 0.5f);
+}
+
+/* Per-draw column tables, grown on demand */
+static struct {
+    int32_t *x0;
+    int32_t *x1;
+    uint32_t *fx;
+    int capacity;
+} s_cols;
+
+static bool sw_reserve_columns(int count) {
+    if (count <= s_cols.capacity) return true;
+    int32_t *x0 = realloc(s_cols.x0, (size_t)count * sizeof(int32_t));
+    if (x0) s_cols.x0 = x0;
+    int32_t *x1 = realloc(s_cols.x1, (size_t)count * sizeof(int32_t));
+    if (x1) s_cols.x1 = x1;
+    uint32_t *fx = realloc(s_cols.fx, (size_t)count * sizeof(uint32_t));
+    if (fx) s_cols.fx = fx;
+    if (!x0 || !x1 || !fx) return false;
+    s_cols.capacity = count;
+    return true;
+}
+
+void swraster_draw_packet(sw_image_t *dst, const int clip[4], const sw_image_t *texture,
+                          const renderer_draw_packet_t *packet, float x, float y, bool blend) {
+    int r[4];
+    if (!dst || !dst->pixels || !texture || !texture->pixels || !packet) return;
+    if (texture->width <= 0 || texture->height <= 0 || !sw_clip(dst, clip, r)) return;
+    if (!s_span) swraster_select();
+
+    /* Quad in pixels with GL's bottom-left origin; UVs at its edges */
+    const float *v = packet->vertices;
+    double qx0 = (v[0] + 1.0) * 0.5 * dst->width, qx1 = (v[4] + 1.0) * 0.5 * dst->width;
+    double qy0 = (v[1] + 1.0) * 0.5 * dst->height, qy1 = (v[9] + 1.0) * 0.5 * dst->height;
+    if (qx1 <= qx0 || qy1 <= qy0) return;
+    double ou = packet->uniform_offset ? x * packet->offset_scale[0] : x;
+    double ov = packet->uniform_offset ? -y * packet->offset_scale[1] : -y;
+    double u_l = v[2] + ou, u_r = v[6] + ou;
+    double v_b = v[3] + ov, v_t = v[11] + ov;
+
+    /* Pixels whose centres lie inside the quad (GL fill rule) */
+    int cx0 = (int)ceil(qx0 - 0.5), cx1 = (int)ceil(qx1 - 0.5);
+    int gy0 = (int)ceil(qy0 - 0.5), gy1 = (int)ceil(qy1 - 0.5);
+    int ry0 = dst->height - gy1, ry1 = dst->height - gy0;
+    if (cx0 < r[0]) cx0 = r[0];
+    if (cx1 > r[2]) cx1 = r[2];
+    if (ry0 < r[1]) ry0 = r[1];
+    if (ry1 > r[3]) ry1 = r[3];
+    if (cx1 <= cx0 || ry1 <= ry0) return;
+    if (!sw_reserve_columns(cx1 - cx0)) return;
+
+    bool repeat_s = packet->wrap_s == RENDERER_WRAP_REPEAT;
+    bool repeat_t = packet->wrap_t == RENDERER_WRAP_REPEAT;
+    bool mask_u = packet->mask[0] > 0.5f, mask_v = packet->mask[1] > 0.5f;
+    double keep_u = packet->mask[0], keep_v = packet->mask[1];
+
+    /* Columns: UV is linear in x, so masked (overflow none) columns can
+     * only trim the ends of the span */
+    int first = -1, last = -1;
+    for (int c = cx0; c < cx1; c++) {
+        double u = u_l + (u_r - u_l) * ((c + 0.5) - qx0) / (qx1 - qx0);
+        if (mask_u && (u < 1.0 - keep_u || u > keep_u)) continue;
+        int k = c - cx0;
+        uint32_t w;
+        sw_texel(u, texture->width, repeat_s, &s_cols.x0[k], &s_cols.x1[k], &w);
+        s_cols.fx[k] = w | (w << 16);
+        if (first < 0) first = k;
+        last = k;
+    }
+    if (first < 0) return;
+    swraster_columns_t cols = { s_cols.x0 + first, s_cols.x1 + first, s_cols.fx + first };
+    int count = last - first + 1;
+
+    /* Opacity and tint as per-byte factors (B, G, R, A) */
+    float tint[3];
+    for (int k = 0; k < 3; k++) {
+        tint[k] = 1.0f + (packet->tint[k] - 1.0f) * packet->tint_strength;
+    }
+    float opacity = packet->opacity;
+    uint16_t mod[4] = {
+        sw_mod(tint[2] * opacity), sw_mod(tint[1] * opacity), sw_mod(tint[0] * opacity), sw_mod(opacity)
+    };
+
+    for (int row = ry0; row < ry1; row++) {
+        double yc = dst->height - row - 0.5;
+        double t = v_b + (v_t - v_b) * (yc - qy0) / (qy1 - qy0);
+        if (mask_v && (t < 1.0 - keep_v || t > keep_v)) continue;
+        int32_t t0, t1;
+        uint32_t fy;
+        sw_texel(t, texture->height, repeat_t, &t0, &t1, &fy);
+        uint32_t *out = dst->pixels + (size_t)row * dst->stride + cx0 + first;
+        s_span(out, texture->pixels + (size_t)t0 * texture->stride,
+               texture->pixels + (size_t)t1 * texture->stride,
+               &cols, count, fy, mod, blend);
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ * swraster.h - CPU rasterizer for the software renderer
+ *
+ * Images are premultiplied ARGB8888 words (wl_shm's format: bytes B, G, R,
+ * A in memory) with a top-left origin. Layer draws are the axis-aligned
+ * quads of a compiled draw packet, sampled bilinearly; the inner loop is a
+ * span kernel picked at startup for the widest SIMD unit the CPU has.
+ * Every kernel uses the same integer arithmetic, so they are bit-exact.
+ */
+
+#ifndef HYPRLAX_SWRASTER_H
+#define HYPRLAX_SWRASTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../include/renderer.h"
+
+typedef struct {
+    uint32_t *pixels;
+    int width;
+    int height;
+    int stride;             /* Pixels per row */
+} sw_image_t;
+
+typedef enum {
+    SWRASTER_ISA_SCALAR,
+    SWRASTER_ISA_SSE2,
+    SWRASTER_ISA_AVX2,
+    SWRASTER_ISA_NEON,
+    SWRASTER_ISA_COUNT,
+} swraster_isa_t;
+
+/* Per-column sampling of a span: texel columns left/right of each sample
+ * and the horizontal weight (0..256) replicated in both 16-bit halves */
+typedef struct {
+    const int32_t *x0;
+    const int32_t *x1;
+    const uint32_t *fx;
+} swraster_columns_t;
+
+/* Sample count pixels bilinearly between texel rows row0/row1 (vertical
+ * weight fy, 0..256), scale each byte by mod (0..256, memory order) and
+ * store them, or blend them over dst when blend is set */
+typedef void (*swraster_span_fn)(uint32_t *dst, const uint32_t *row0, const uint32_t *row1,
+                                 const swraster_columns_t *cols, int count,
+                                 uint32_t fy, const uint16_t mod[4], bool blend);
+
+/* Kernel for an instruction set; NULL if the build or CPU lacks it */
+swraster_span_fn swraster_get_span(swraster_isa_t isa);
+/* Pick the widest available kernel for draws; HYPRLAX_SW_SIMD
+ * (scalar, sse2, avx2, neon) forces a narrower one */
+swraster_isa_t swraster_select(void);
+const char* swraster_isa_name(swraster_isa_t isa);
+
+/* Float color to an ARGB word as-is (callers pass premultiplied colors) */
+uint32_t swraster_pack_color(float r, float g, float b, float a);
+/* Straight-alpha RGBA8 bytes to premultiplied ARGB words */
+void swraster_premultiply(const uint8_t *rgba, int count, uint32_t *out);
+
+/* Clip rects are {x, y, w, h} with a top-left origin; NULL = whole image */
+void swraster_fill(sw_image_t *dst, const int clip[4], uint32_t color);
+/* Blend a premultiplied color over dst (trail fade) */
+void swraster_fade(sw_image_t *dst, const int clip[4], uint32_t color);
+/* Copy src over dst (no blending); images have the same size */
+void swraster_copy(sw_image_t *dst, const sw_image_t *src, const int clip[4]);
+/* Rasterize a compiled layer draw with this frame's offset */
+void swraster_draw_packet(sw_image_t *dst, const int clip[4], const sw_image_t *texture,
+                          const renderer_draw_packet_t *packet, float x, float y, bool blend);
+
+#endif /* HYPRLAX_SWRASTER_H */
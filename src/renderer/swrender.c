@@ -0,0 +1,563 @@
+/*
+ * swrender.c - CPU software renderer
+ *
+ * Composites layers on the CPU straight into wl_shm buffers, for systems
+ * without a usable GPU and for low-power setups where a mostly idle
+ * wallpaper should not keep the GPU awake. Draws come from the same
+ * compiled packets as the GLES2 backend (renderer_compile_layer_geometry),
+ * so fit, alignment, overflow and tint match; pixels are produced by the
+ * SIMD span kernels in swraster.c.
+ *
+ * Each output owns one shm pool with room for HYPRLAX_SW_MAX_BUFFERS
+ * buffers. Two are created up front and used alternately; a third is only
+ * created while the compositor still holds both. Buffers track their age
+ * like EGL_EXT_buffer_age, so render_core's damage tracking limits each
+ * frame's recomposition to the rects that changed since that buffer was
+ * last shown. Blur is not implemented: blurred layers are drawn sharp.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <wayland-client.h>
+#include "../include/renderer.h"
+#include "../include/hyprlax_internal.h"
+#include "../include/defaults.h"
+#include "../include/log.h"
+#include "swraster.h"
+
+typedef struct {
+    struct wl_buffer *wl_buffer;
+    sw_image_t image;
+    bool busy;              /* Attached and not yet released by the compositor */
+    int age;                /* Frames since last presented (0 = undefined contents) */
+} sw_buffer_t;
+
+typedef struct sw_surface {
+    struct wl_surface *wl_surface;  /* NULL for offscreen (headless) surfaces */
+    int width;
+    int height;
+    int fd;
+    void *map;
+    size_t map_size;
+    struct wl_shm_pool *pool;
+    sw_buffer_t buffers[HYPRLAX_SW_MAX_BUFFERS];
+    int buffer_count;
+    int back;               /* Buffer drawn this frame (-1 = none) */
+    struct sw_surface *next;
+} sw_surface_t;
+
+typedef struct {
+    struct wl_display *display;
+    struct wl_event_queue *queue;   /* Private queue: shm and buffer releases */
+    struct wl_registry *registry;
+    struct wl_shm *shm;
+    sw_surface_t *surfaces;
+    sw_surface_t *current;
+
+    /* Textures: id = index + 1, free slots have no pixels */
+    sw_image_t *textures;
+    int texture_count;
+    sw_image_t targets[HYPRLAX_MAX_RENDER_TARGETS];
+
+    sw_image_t *draw;       /* Back buffer or bound target */
+    bool draw_to_surface;
+    int scissor[4];         /* Damage region on the surface, top-left origin */
+    bool has_scissor;
+    bool blend;
+    int width;              /* Viewport the packets are compiled against */
+    int height;
+    swraster_isa_t isa;
+    char name[32];
+} sw_renderer_data_t;
+
+static sw_renderer_data_t *g_sw_data = NULL;
+
+static void sw_registry_global(void *data, struct wl_registry *registry,
+                               uint32_t id, const char *interface, uint32_t version) {
+    (void)data;
+    (void)version;
+    if (strcmp(interface, "wl_shm") == 0 && !g_sw_data->shm) {
+        g_sw_data->shm = wl_registry_bind(registry, id, &wl_shm_interface, 1);
+    }
+}
+
+static void sw_registry_global_remove(void *data, struct wl_registry *registry, uint32_t id) {
+    (void)data;
+    (void)registry;
+    (void)id;
+}
+
+static const struct wl_registry_listener sw_registry_listener = {
+    .global = sw_registry_global,
+    .global_remove = sw_registry_global_remove,
+};
+
+static void sw_buffer_release(void *data, struct wl_buffer *wl_buffer) {
+    (void)wl_buffer;
+    sw_buffer_t *buffer = data;
+    buffer->busy = false;
+}
+
+static const struct wl_buffer_listener sw_buffer_listener = {
+    .release = sw_buffer_release,
+};
+
+static void sw_surface_free_storage(sw_surface_t *s) {
+    for (int i = 0; i < s->buffer_count; i++) {
+        if (s->buffers[i].wl_buffer) wl_buffer_destroy(s->buffers[i].wl_buffer);
+    }
+    if (s->pool) wl_shm_pool_destroy(s->pool);
+    if (s->map) {
+        if (s->fd >= 0) munmap(s->map, s->map_size);
+        else free(s->map);
+    }
+    if (s->fd >= 0) close(s->fd);
+    memset(s->buffers, 0, sizeof(s->buffers));
+    s->buffer_count = 0;
+    s->pool = NULL;
+    s->map = NULL;
+    s->map_size = 0;
+    s->fd = -1;
+    s->back = -1;
+}
+
+/* Create buffer i of the pool */
+static bool sw_surface_add_buffer(sw_surface_t *s) {
+    if (s->buffer_count >= HYPRLAX_SW_MAX_BUFFERS) return false;
+    int i = s->buffer_count;
+    size_t size = (size_t)s->width * (size_t)s->height * 4;
+    sw_buffer_t *buffer = &s->buffers[i];
+    memset(buffer, 0, sizeof(*buffer));
+    buffer->image.pixels = (uint32_t *)((uint8_t *)s->map + size * (size_t)i);
+    buffer->image.width = s->width;
+    buffer->image.height = s->height;
+    buffer->image.stride = s->width;
+    if (s->pool) {
+        buffer->wl_buffer = wl_shm_pool_create_buffer(s->pool, (int32_t)(size * (size_t)i),
+                                                      s->width, s->height, s->width * 4,
+                                                      WL_SHM_FORMAT_ARGB8888);
+        if (!buffer->wl_buffer) return false;
+        wl_buffer_add_listener(buffer->wl_buffer, &sw_buffer_listener, buffer);
+    }
+    s->buffer_count++;
+    return true;
+}
+
+/* Size the pool for all buffers up front; pages are only committed once
+ * drawn, so the spare third buffer costs nothing until it is needed */
+static int sw_surface_alloc_storage(sw_surface_t *s, int width, int height) {
+    s->width = width;
+    s->height = height;
+    size_t size = (size_t)width * (size_t)height * 4;
+
+    if (!s->wl_surface) {
+        s->map = calloc(1, size);
+        s->map_size = size;
+        if (!s->map) return HYPRLAX_ERROR_NO_MEMORY;
+        sw_surface_add_buffer(s);
+        return HYPRLAX_SUCCESS;
+    }
+
+    s->map_size = size * HYPRLAX_SW_MAX_BUFFERS;
+    if (s->map_size > INT32_MAX) return HYPRLAX_ERROR_INVALID_ARGS;
+    s->fd = memfd_create("hyprlax-shm", MFD_CLOEXEC);
+    if (s->fd < 0 || ftruncate(s->fd, (off_t)s->map_size) < 0) {
+        LOG_ERROR("software: cannot allocate %zu bytes of shm: %s", s->map_size, strerror(errno));
+        return HYPRLAX_ERROR_NO_MEMORY;
+    }
+    void *map = mmap(NULL, s->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, s->fd, 0);
+    if (map == MAP_FAILED) {
+        LOG_ERROR("software: mmap failed: %s", strerror(errno));
+        return HYPRLAX_ERROR_NO_MEMORY;
+    }
+    s->map = map;
+    s->pool = wl_shm_create_pool(g_sw_data->shm, s->fd, (int32_t)s->map_size);
+    if (!s->pool) return HYPRLAX_ERROR_NO_MEMORY;
+    for (int i = 0; i < HYPRLAX_SW_BUFFERS; i++) {
+        if (!sw_surface_add_buffer(s)) return HYPRLAX_ERROR_NO_MEMORY;
+    }
+    return HYPRLAX_SUCCESS;
+}
+
+/* Free buffer to draw into, preferring the one presented most recently
+ * (smallest age, least to repaint) */
+static int sw_surface_pick_back(sw_surface_t *s) {
+    int best = -1;
+    for (int i = 0; i < s->buffer_count; i++) {
+        if (s->buffers[i].busy) continue;
+        if (best < 0) { best = i; continue; }
+        int age = s->buffers[i].age, best_age = s->buffers[best].age;
+        if (age > 0 && (best_age == 0 || age < best_age)) best = i;
+    }
+    if (best < 0 && sw_surface_add_buffer(s)) {
+        LOG_DEBUG("software: compositor holds %d buffers; added one", s->buffer_count - 1);
+        best = s->buffer_count - 1;
+    }
+    return best;
+}
+
+static void* sw_create_surface(void *native_surface, int width, int height) {
+    if (!g_sw_data) return NULL;
+    if (native_surface && !g_sw_data->shm) {
+        LOG_ERROR("software: no wl_shm to back output surfaces");
+        return NULL;
+    }
+    sw_surface_t *s = calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    s->wl_surface = native_surface;
+    s->fd = -1;
+    s->back = -1;
+    /* Outputs may not know their size yet; storage follows make_current */
+    if (width > 0 && height > 0 && sw_surface_alloc_storage(s, width, height) != HYPRLAX_SUCCESS) {
+        sw_surface_free_storage(s);
+        free(s);
+        return NULL;
+    }
+    s->next = g_sw_data->surfaces;
+    g_sw_data->surfaces = s;
+    return s;
+}
+
+static int sw_make_current(void *surface, int width, int height) {
+    sw_surface_t *s = surface;
+    if (!g_sw_data || !s || width <= 0 || height <= 0) return HYPRLAX_ERROR_INVALID_ARGS;
+
+    if (s->width != width || s->height != height || s->buffer_count == 0) {
+        /* Buffers still held by the compositor stay valid: wl_buffer and
+         * pool contents outlive our unmap until it releases them */
+        sw_surface_free_storage(s);
+        int ret = sw_surface_alloc_storage(s, width, height);
+        if (ret != HYPRLAX_SUCCESS) {
+            sw_surface_free_storage(s);
+            return ret;
+        }
+    }
+
+    if (g_sw_data->display && g_sw_data->queue) {
+        wl_display_dispatch_queue_pending(g_sw_data->display, g_sw_data->queue);
+    }
+    s->back = sw_surface_pick_back(s);
+    if (s->back < 0) return HYPRLAX_ERROR_NO_MEMORY;
+
+    g_sw_data->current = s;
+    g_sw_data->draw = &s->buffers[s->back].image;
+    g_sw_data->draw_to_surface = true;
+    g_sw_data->has_scissor = false;
+    g_sw_data->blend = true;
+    g_sw_data->width = width;
+    g_sw_data->height = height;
+    return HYPRLAX_SUCCESS;
+}
+
+/* Scissor applies to the surface only; targets are always drawn whole */
+static const int* sw_clip(void) {
+    return (g_sw_data->draw_to_surface && g_sw_data->has_scissor) ? g_sw_data->scissor : NULL;
+}
+
+static int sw_init(void *native_display, void *native_window, const renderer_config_t *config) {
+    (void)native_window;
+    if (g_sw_data) return HYPRLAX_SUCCESS;
+    g_sw_data = calloc(1, sizeof(*g_sw_data));
+    if (!g_sw_data) return HYPRLAX_ERROR_NO_MEMORY;
+    g_sw_data->width = config ? config->width : 0;
+    g_sw_data->height = config ? config->height : 0;
+    g_sw_data->blend = true;
+
+    /* Bind wl_shm on a private queue so buffer releases never depend on
+     * (or interfere with) the platform's dispatching */
+    if (native_display) {
+        struct wl_display *display = native_display;
+        g_sw_data->display = display;
+        g_sw_data->queue = wl_display_create_queue(display);
+        struct wl_display *wrapper = wl_proxy_create_wrapper(display);
+        if (!g_sw_data->queue || !wrapper) {
+            if (wrapper) wl_proxy_wrapper_destroy(wrapper);
+            free(g_sw_data);
+            g_sw_data = NULL;
+            return HYPRLAX_ERROR_NO_MEMORY;
+        }
+        wl_proxy_set_queue((struct wl_proxy *)wrapper, g_sw_data->queue);
+        g_sw_data->registry = wl_display_get_registry(wrapper);
+        wl_proxy_wrapper_destroy(wrapper);
+        wl_registry_add_listener(g_sw_data->registry, &sw_registry_listener, NULL);
+        wl_display_roundtrip_queue(display, g_sw_data->queue);
+        if (!g_sw_data->shm) {
+            LOG_ERROR("software: compositor does not offer wl_shm");
+            wl_registry_destroy(g_sw_data->registry);
+            wl_event_queue_destroy(g_sw_data->queue);
+            free(g_sw_data);
+            g_sw_data = NULL;
+            return HYPRLAX_ERROR_NO_COMPOSITOR;
+        }
+    }
+
+    g_sw_data->isa = swraster_select();
+    snprintf(g_sw_data->name, sizeof(g_sw_data->name), "Software (%s)", swraster_isa_name(g_sw_data->isa));
+    LOG_INFO("Software renderer using %s span kernels", swraster_isa_name(g_sw_data->isa));
+    return HYPRLAX_SUCCESS;
+}
+
+static void sw_destroy(void) {
+    if (!g_sw_data) return;
+    sw_surface_t *s = g_sw_data->surfaces;
+    while (s) {
+        sw_surface_t *next = s->next;
+        sw_surface_free_storage(s);
+        free(s);
+        s = next;
+    }
+    for (int i = 0; i < g_sw_data->texture_count; i++) free(g_sw_data->textures[i].pixels);
+    free(g_sw_data->textures);
+    for (int i = 0; i < HYPRLAX_MAX_RENDER_TARGETS; i++) free(g_sw_data->targets[i].pixels);
+    if (g_sw_data->shm) wl_shm_destroy(g_sw_data->shm);
+    if (g_sw_data->registry) wl_registry_destroy(g_sw_data->registry);
+    if (g_sw_data->queue) wl_event_queue_destroy(g_sw_data->queue);
+    free(g_sw_data);
+    g_sw_data = NULL;
+}
+
+static void sw_begin_frame(void) {
+}
+
+static void sw_end_frame(void) {
+}
+
+static int sw_get_buffer_age(void) {
+    if (!g_sw_data || !g_sw_data->current || g_sw_data->current->back < 0) return 0;
+    return g_sw_data->current->buffers[g_sw_data->current->back].age;
+}
+
+static void sw_set_damage_region(const int rect[4]) {
+    if (!g_sw_data || !g_sw_data->current || !rect) return;
+    g_sw_data->scissor[0] = rect[0];
+    g_sw_data->scissor[1] = g_sw_data->current->height - (rect[1] + rect[3]);
+    g_sw_data->scissor[2] = rect[2];
+    g_sw_data->scissor[3] = rect[3];
+    g_sw_data->has_scissor = true;
+}
+
+/* Attach the back buffer, report the damaged rect and age the others;
+ * the platform's commit_monitor_surface commits */
+static bool sw_present_damage(const int rect[4]) {
+    if (!g_sw_data || !g_sw_data->current || g_sw_data->current->back < 0) return false;
+    sw_surface_t *s = g_sw_data->current;
+    sw_buffer_t *back = &s->buffers[s->back];
+
+    for (int i = 0; i < s->buffer_count; i++) {
+        if (i != s->back && s->buffers[i].age > 0) s->buffers[i].age++;
+    }
+    back->age = 1;
+    if (!s->wl_surface) return true;
+
+    wl_surface_attach(s->wl_surface, back->wl_buffer, 0, 0);
+    back->busy = true;
+    bool partial = rect && rect[2] > 0 && rect[3] > 0;
+    int x = partial ? rect[0] : 0;
+    int y = partial ? s->height - (rect[1] + rect[3]) : 0;
+    int w = partial ? rect[2] : s->width;
+    int h = partial ? rect[3] : s->height;
+    if (wl_proxy_get_version((struct wl_proxy *)s->wl_surface) >= WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION) {
+        wl_surface_damage_buffer(s->wl_surface, x, y, w, h);
+    } else {
+        /* No buffer scale is set, so surface and buffer coordinates agree */
+        wl_surface_damage(s->wl_surface, x, y, w, h);
+    }
+    return partial;
+}
+
+static void sw_present(void) {
+    sw_present_damage(NULL);
+}
+
+static uint32_t sw_upload_texture(const uint8_t *rgba, int width, int height) {
+    if (!g_sw_data || !rgba || width <= 0 || height <= 0) return 0;
+    int slot = -1;
+    for (int i = 0; i < g_sw_data->texture_count; i++) {
+        if (!g_sw_data->textures[i].pixels) { slot = i; break; }
+    }
+    if (slot < 0) {
+        sw_image_t *grown = realloc(g_sw_data->textures,
+                                    (size_t)(g_sw_data->texture_count + 1) * sizeof(*grown));
+        if (!grown) return 0;
+        g_sw_data->textures = grown;
+        slot = g_sw_data->texture_count++;
+        memset(&g_sw_data->textures[slot], 0, sizeof(sw_image_t));
+    }
+    uint32_t *pixels = malloc((size_t)width * (size_t)height * sizeof(uint32_t));
+    if (!pixels) return 0;
+    swraster_premultiply(rgba, width * height, pixels);
+    g_sw_data->textures[slot] = (sw_image_t){ pixels, width, height, width };
+    return (uint32_t)slot + 1;
+}
+
+static void sw_delete_texture(uint32_t id) {
+    if (!g_sw_data || id == 0 || (int)id > g_sw_data->texture_count) return;
+    free(g_sw_data->textures[id - 1].pixels);
+    memset(&g_sw_data->textures[id - 1], 0, sizeof(sw_image_t));
+}
+
+static void sw_clear(float r, float g, float b, float a) {
+    if (!g_sw_data || !g_sw_data->draw) return;
+    swraster_fill(g_sw_data->draw, sw_clip(), swraster_pack_color(r, g, b, a));
+}
+
+static void sw_fade_frame(float r, float g, float b, float a) {
+    if (!g_sw_data || !g_sw_data->draw) return;
+    if (a <= HYPRLAX_FADE_ALPHA_MIN) return;
+    swraster_fade(g_sw_data->draw, sw_clip(), swraster_pack_color(r, g, b, a));
+}
+
+static void sw_compile_layer(const texture_t *texture, float opacity, float blur_amount,
+                             const renderer_layer_params_t *params,
+                             renderer_draw_packet_t *out) {
+    int w = g_sw_data ? g_sw_data->width : 0;
+    int h = g_sw_data ? g_sw_data->height : 0;
+    renderer_compile_layer_geometry(w, h, texture, opacity, blur_amount, params, out);
+    if (blur_amount > 0.01f) {
+        static bool s_warned = false;
+        if (!s_warned) {
+            LOG_WARN("software renderer: blur is not supported, drawing blurred layers sharp");
+            s_warned = true;
+        }
+    }
+}
+
+static void sw_draw_packet(const renderer_draw_packet_t *packet, uint32_t texture_id,
+                           float x, float y) {
+    if (!g_sw_data || !g_sw_data->draw || !packet) return;
+    if (texture_id == 0 || (int)texture_id > g_sw_data->texture_count) return;
+    const sw_image_t *texture = &g_sw_data->textures[texture_id - 1];
+    if (!texture->pixels) return;
+    swraster_draw_packet(g_sw_data->draw, sw_clip(), texture, packet, x, y, g_sw_data->blend);
+}
+
+static void sw_set_blend(bool enabled) {
+    if (g_sw_data) g_sw_data->blend = enabled;
+}
+
+static uint32_t sw_create_target(int width, int height) {
+    if (!g_sw_data || width <= 0 || height <= 0) return 0;
+    for (int i = 0; i < HYPRLAX_MAX_RENDER_TARGETS; i++) {
+        sw_image_t *t = &g_sw_data->targets[i];
+        if (t->pixels) continue;
+        t->pixels = calloc((size_t)width * (size_t)height, sizeof(uint32_t));
+        if (!t->pixels) return 0;
+        t->width = width;
+        t->height = height;
+        t->stride = width;
+        return (uint32_t)i + 1;
+    }
+    LOG_WARN("software: no free render target slots");
+    return 0;
+}
+
+static void sw_destroy_target(uint32_t target) {
+    if (!g_sw_data || target == 0 || target > HYPRLAX_MAX_RENDER_TARGETS) return;
+    sw_image_t *t = &g_sw_data->targets[target - 1];
+    if (g_sw_data->draw == t) {
+        g_sw_data->draw = NULL;
+        g_sw_data->draw_to_surface = false;
+    }
+    free(t->pixels);
+    memset(t, 0, sizeof(*t));
+}
+
+static void sw_bind_target(uint32_t target) {
+    if (!g_sw_data) return;
+    if (target > 0 && target <= HYPRLAX_MAX_RENDER_TARGETS && g_sw_data->targets[target - 1].pixels) {
+        g_sw_data->draw = &g_sw_data->targets[target - 1];
+        g_sw_data->draw_to_surface = false;
+        return;
+    }
+    sw_surface_t *s = g_sw_data->current;
+    g_sw_data->draw = (s && s->back >= 0) ? &s->buffers[s->back].image : NULL;
+    g_sw_data->draw_to_surface = g_sw_data->draw != NULL;
+}
+
+static void sw_blit_target(uint32_t target) {
+    if (!g_sw_data || !g_sw_data->draw || target == 0 || target > HYPRLAX_MAX_RENDER_TARGETS) return;
+    swraster_copy(g_sw_data->draw, &g_sw_data->targets[target - 1], sw_clip());
+}
+
+static void sw_resize(int width, int height) {
+    if (!g_sw_data) return;
+    g_sw_data->width = width;
+    g_sw_data->height = height;
+}
+
+static void sw_set_vsync(bool enabled) {
+    /* Presentation is paced by frame callbacks; nothing to swap */
+    (void)enabled;
+}
+
+static uint32_t sw_get_capabilities(void) {
+    /* Presenting is an attach; frame callbacks keep buffers from piling up */
+    return RENDERER_CAP_NONBLOCKING_PRESENT;
+}
+
+static const char* sw_get_name(void) {
+    return g_sw_data ? g_sw_data->name : "Software";
+}
+
+static const char* sw_get_version(void) {
+    return g_sw_data ? swraster_isa_name(g_sw_data->isa) : "unknown";
+}
+
+/* Read back the current back buffer as RGBA8 (bottom-left origin) */
+static int sw_read_pixels(int x, int y, int width, int height, uint8_t *rgba) {
+    if (!g_sw_data || !g_sw_data->current || g_sw_data->current->back < 0 || !rgba) {
+        return HYPRLAX_ERROR_INVALID_ARGS;
+    }
+    const sw_image_t *img = &g_sw_data->current->buffers[g_sw_data->current->back].image;
+    if (x < 0 || y < 0 || width <= 0 || height <= 0 ||
+        x + width > img->width || y + height > img->height) {
+        return HYPRLAX_ERROR_INVALID_ARGS;
+    }
+    for (int j = 0; j < height; j++) {
+        const uint32_t *row = img->pixels + (size_t)(img->height - 1 - (y + j)) * img->stride + x;
+        uint8_t *out = rgba + (size_t)j * (size_t)width * 4;
+        for (int i = 0; i < width; i++) {
+            out[i * 4 + 0] = (uint8_t)(row[i] >> 16);
+            out[i * 4 + 1] = (uint8_t)(row[i] >> 8);
+            out[i * 4 + 2] = (uint8_t)row[i];
+            out[i * 4 + 3] = (uint8_t)(row[i] >> 24);
+        }
+    }
+    return HYPRLAX_SUCCESS;
+}
+
+/* Software renderer operations */
+const renderer_ops_t renderer_software_ops = {
+    .init = sw_init,
+    .destroy = sw_destroy,
+    .begin_frame = sw_begin_frame,
+    .end_frame = sw_end_frame,
+    .present = sw_present,
+    .clear = sw_clear,
+    .fade_frame = sw_fade_frame,
+    .create_target = sw_create_target,
+    .destroy_target = sw_destroy_target,
+    .bind_target = sw_bind_target,
+    .blit_target = sw_blit_target,
+    .compile_layer = sw_compile_layer,
+    .draw_packet = sw_draw_packet,
+    .get_buffer_age = sw_get_buffer_age,
+    .set_damage_region = sw_set_damage_region,
+    .present_damage = sw_present_damage,
+    .set_blend = sw_set_blend,
+    .resize = sw_resize,
+    .set_vsync = sw_set_vsync,
+    .get_capabilities = sw_get_capabilities,
+    .get_name = sw_get_name,
+    .get_version = sw_get_version,
+    .read_pixels = sw_read_pixels,
+    .upload_texture = sw_upload_texture,
+    .delete_texture = sw_delete_texture,
+    .create_surface = sw_create_surface,
+    .make_current = sw_make_current,
+};
@@ -1,4 +1,6 @@
 #include "include/hyprlax.h"
+#include "include/decode_pool.h"
+#include "include/texture_registry.h"
 
 /* Minimal stub for load_texture used by runtime property tests. */
 unsigned int load_texture(const char *path, int *width, int *height) {
@@ -8,3 +10,60 @@ unsigned int load_texture(const char *path, int *width, int *height) {
     return 1; /* non-zero fake texture id */
 }
 
+unsigned int load_texture_ex(const char *path, int *width, int *height, parallax_layer_t *layer) {
+    (void)layer;
+    return load_texture(path, width, height);
+}
+
+void unload_texture(unsigned int texture) {
+    (void)texture;
+}
+
+void virtual_texture_destroy(virtual_texture_t *vt) {
+    (void)vt;
+}
+
+/* Images load synchronously through the stubs above: no decode pool */
+void hyprlax_stop_texture_decodes(hyprlax_context_t *ctx) {
+    (void)ctx;
+}
+
+bool decode_pool_cancel(decode_pool_t *pool, uint32_t ticket) {
+    (void)pool; (void)ticket;
+    return false;
+}
+
+int decode_pool_event_fd(const decode_pool_t *pool) {
+    (void)pool;
+    return -1;
+}
+
+/* Stub textures are never shared */
+void texture_registry_release(texture_registry_t *reg, uint32_t texture) {
+    (void)reg;
+    unload_texture(texture);
+}
+
+void texture_registry_hold(texture_registry_t *reg) {
+    (void)reg;
+}
+
+int texture_registry_unhold(texture_registry_t *reg) {
+    (void)reg;
+    return 0;
+}
+
+void texture_registry_destroy(texture_registry_t *reg) {
+    (void)reg;
+}
+
+/* Headless replay lives in core/headless.c, which needs a GL context */
+int hyprlax_init_headless(hyprlax_context_t *ctx) {
+    (void)ctx;
+    return HYPRLAX_ERROR_INVALID_ARGS;
+}
+
+int hyprlax_run_headless(hyprlax_context_t *ctx) {
+    (void)ctx;
+    return HYPRLAX_ERROR_INVALID_ARGS;
+}
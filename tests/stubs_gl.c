@@ -0,0 +1,282 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+#include "stubs_gl.h"
+
+/* Minimal EGL/GLES3 that accepts everything and counts what it is asked to
+ * do, so gles2.c can be driven without a display or GPU. */
+
+gl_stub_counts_t gl_stub_counts;
+int gl_stub_tex_sub_image_us = 0;
+int gl_stub_max_texture_size = 16384;
+void (*gl_stub_upload_hook)(int x, int y, int width, int height, const void *pixels) = NULL;
+
+static GLuint s_next_name = 1;
+static GLint s_viewport[4] = { 0, 0, 1, 1 };
+static GLboolean s_blend = GL_FALSE;
+static GLuint s_unpack_buffer = 0;
+static void *s_mapped = NULL;
+static size_t s_mapped_size = 0;
+
+#define GL_CALL() (gl_stub_counts.calls++)
+#define GL_UNIFORM() (gl_stub_counts.calls++, gl_stub_counts.uniforms++)
+
+/* ---- EGL ---------------------------------------------------------------- */
+
+EGLBoolean eglChooseConfig(EGLDisplay dpy, const EGLint *attrib_list, EGLConfig *configs,
+                           EGLint config_size, EGLint *num_config) {
+    (void)dpy; (void)attrib_list;
+    if (configs && config_size > 0) configs[0] = (EGLConfig)1;
+    if (num_config) *num_config = 1;
+    return EGL_TRUE;
+}
+EGLContext eglCreateContext(EGLDisplay dpy, EGLConfig config, EGLContext share, const EGLint *attribs) {
+    (void)dpy; (void)config; (void)share; (void)attribs;
+    return (EGLContext)1;
+}
+EGLSurface eglCreatePbufferSurface(EGLDisplay dpy, EGLConfig config, const EGLint *attribs) {
+    (void)dpy; (void)config; (void)attribs;
+    return (EGLSurface)1;
+}
+EGLSurface eglCreateWindowSurface(EGLDisplay dpy, EGLConfig config, EGLNativeWindowType win,
+                                  const EGLint *attribs) {
+    (void)dpy; (void)config; (void)win; (void)attribs;
+    return (EGLSurface)1;
+}
+EGLBoolean eglDestroyContext(EGLDisplay dpy, EGLContext ctx) { (void)dpy; (void)ctx; return EGL_TRUE; }
+EGLBoolean eglDestroySurface(EGLDisplay dpy, EGLSurface s) { (void)dpy; (void)s; return EGL_TRUE; }
+EGLDisplay eglGetDisplay(EGLNativeDisplayType id) { (void)id; return (EGLDisplay)1; }
+__eglMustCastToProperFunctionPointerType eglGetProcAddress(const char *name) { (void)name; return NULL; }
+EGLBoolean eglInitialize(EGLDisplay dpy, EGLint *major, EGLint *minor) {
+    (void)dpy;
+    if (major) *major = 1;
+    if (minor) *minor = 5;
+    return EGL_TRUE;
+}
+EGLBoolean eglMakeCurrent(EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx) {
+    (void)dpy; (void)draw; (void)read; (void)ctx;
+    return EGL_TRUE;
+}
+const char *eglQueryString(EGLDisplay dpy, EGLint name) { (void)dpy; (void)name; return ""; }
+EGLBoolean eglQuerySurface(EGLDisplay dpy, EGLSurface s, EGLint attribute, EGLint *value) {
+    (void)dpy; (void)s; (void)attribute;
+    if (value) *value = 0;
+    return EGL_TRUE;
+}
+EGLBoolean eglSwapBuffers(EGLDisplay dpy, EGLSurface s) { (void)dpy; (void)s; gl_stub_counts.swaps++; return EGL_TRUE; }
+EGLBoolean eglSwapInterval(EGLDisplay dpy, EGLint interval) {
+    (void)dpy;
+    gl_stub_counts.swap_interval = interval;
+    return EGL_TRUE;
+}
+EGLBoolean eglTerminate(EGLDisplay dpy) { (void)dpy; return EGL_TRUE; }
+
+/* ---- GLES2 -------------------------------------------------------------- */
+
+static void gen_names(GLsizei n, GLuint *names) {
+    for (GLsizei i = 0; i < n; i++) names[i] = s_next_name++;
+}
+
+void glActiveTexture(GLenum texture) { (void)texture; GL_CALL(); }
+void glAttachShader(GLuint program, GLuint shader) { (void)program; (void)shader; GL_CALL(); }
+void glBindBuffer(GLenum target, GLuint buffer) {
+    GL_CALL();
+    if (target == GL_PIXEL_UNPACK_BUFFER) s_unpack_buffer = buffer;
+}
+void glBindFramebuffer(GLenum target, GLuint fb) { (void)target; GL_CALL(); if (fb) gl_stub_counts.target_binds++; }
+void glBindTexture(GLenum target, GLuint texture) { (void)target; (void)texture; GL_CALL(); }
+void glBlendFunc(GLenum s, GLenum d) { (void)s; (void)d; GL_CALL(); }
+void glBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage) {
+    (void)target; (void)size; (void)data; (void)usage;
+    GL_CALL();
+    gl_stub_counts.buffer_data++;
+}
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) {
+    (void)target; (void)offset; (void)size; (void)data;
+    GL_CALL();
+    gl_stub_counts.buffer_sub_data++;
+}
+GLenum glCheckFramebufferStatus(GLenum target) { (void)target; GL_CALL(); return GL_FRAMEBUFFER_COMPLETE; }
+void glClear(GLbitfield mask) { (void)mask; GL_CALL(); gl_stub_counts.clears++; }
+void glClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) { (void)r; (void)g; (void)b; (void)a; GL_CALL(); }
+void glCompileShader(GLuint shader) { (void)shader; GL_CALL(); }
+GLuint glCreateProgram(void) { GL_CALL(); return s_next_name++; }
+GLuint glCreateShader(GLenum type) { (void)type; GL_CALL(); return s_next_name++; }
+void glDeleteBuffers(GLsizei n, const GLuint *b) { (void)n; (void)b; GL_CALL(); gl_stub_counts.delete_buffers++; }
+void glDeleteFramebuffers(GLsizei n, const GLuint *f) { (void)n; (void)f; GL_CALL(); }
+void glDeleteProgram(GLuint program) { (void)program; GL_CALL(); }
+void glDeleteShader(GLuint shader) { (void)shader; GL_CALL(); }
+void glDeleteTextures(GLsizei n, const GLuint *t) { (void)t; GL_CALL(); gl_stub_counts.delete_textures += n; }
+void glDisable(GLenum cap) { GL_CALL(); if (cap == GL_BLEND) s_blend = GL_FALSE; }
+void glDisableVertexAttribArray(GLuint index) { (void)index; GL_CALL(); }
+void glDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    (void)mode; (void)first; (void)count;
+    GL_CALL();
+    gl_stub_counts.draws++;
+}
+void glEnable(GLenum cap) { GL_CALL(); if (cap == GL_BLEND) s_blend = GL_TRUE; }
+void glEnableVertexAttribArray(GLuint index) { (void)index; GL_CALL(); }
+void glFinish(void) { GL_CALL(); }
+void glFlush(void) { GL_CALL(); }
+void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {
+    (void)target; (void)attachment; (void)textarget; (void)texture; (void)level;
+    GL_CALL();
+}
+void glGenBuffers(GLsizei n, GLuint *buffers) { GL_CALL(); gl_stub_counts.gen_buffers += n; gen_names(n, buffers); }
+void glGenFramebuffers(GLsizei n, GLuint *fbs) { GL_CALL(); gen_names(n, fbs); }
+void glGenTextures(GLsizei n, GLuint *textures) { GL_CALL(); gen_names(n, textures); }
+void glGenerateMipmap(GLenum target) { (void)target; GL_CALL(); }
+GLint glGetAttribLocation(GLuint program, const GLchar *name) {
+    (void)program;
+    GL_CALL();
+    if (!strcmp(name, "a_position")) return 0;
+    if (!strcmp(name, "a_texcoord")) return 1;
+    return -1;
+}
+GLenum glGetError(void) { GL_CALL(); return GL_NO_ERROR; }
+void glGetIntegerv(GLenum pname, GLint *data) {
+    GL_CALL();
+    gl_stub_counts.state_queries++;
+    switch (pname) {
+        case GL_VIEWPORT: memcpy(data, s_viewport, sizeof(s_viewport)); break;
+        case GL_MAX_TEXTURE_IMAGE_UNITS: *data = 16; break;
+        case GL_MAX_FRAGMENT_UNIFORM_VECTORS: *data = 256; break;
+        case GL_MAX_TEXTURE_SIZE: *data = gl_stub_max_texture_size; break;
+        default: *data = 0; break;
+    }
+}
+void glGetProgramInfoLog(GLuint program, GLsizei size, GLsizei *length, GLchar *log) {
+    (void)program;
+    GL_CALL();
+    if (length) *length = 0;
+    if (log && size > 0) log[0] = '\0';
+}
+void glGetProgramiv(GLuint program, GLenum pname, GLint *params) {
+    (void)program;
+    GL_CALL();
+    *params = pname == GL_LINK_STATUS ? GL_TRUE : 0;
+}
+void glGetShaderInfoLog(GLuint shader, GLsizei size, GLsizei *length, GLchar *log) {
+    (void)shader;
+    GL_CALL();
+    if (length) *length = 0;
+    if (log && size > 0) log[0] = '\0';
+}
+void glGetShaderiv(GLuint shader, GLenum pname, GLint *params) {
+    (void)shader;
+    GL_CALL();
+    *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+const GLubyte *glGetString(GLenum name) {
+    GL_CALL();
+    return (const GLubyte *)(name == GL_VERSION ? "OpenGL ES 3.0 stub" : "stub");
+}
+GLint glGetUniformLocation(GLuint program, const GLchar *name) {
+    (void)program; (void)name;
+    GL_CALL();
+    return (GLint)(s_next_name++);
+}
+GLboolean glIsEnabled(GLenum cap) { GL_CALL(); gl_stub_counts.state_queries++; return cap == GL_BLEND ? s_blend : GL_FALSE; }
+void glLinkProgram(GLuint program) { (void)program; GL_CALL(); }
+void glPixelStorei(GLenum pname, GLint param) { (void)pname; (void)param; GL_CALL(); }
+void glReadPixels(GLint x, GLint y, GLsizei w, GLsizei h, GLenum format, GLenum type, void *pixels) {
+    (void)x; (void)y; (void)format; (void)type;
+    GL_CALL();
+    memset(pixels, 0, (size_t)w * (size_t)h * 4);
+}
+void glShaderSource(GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length) {
+    (void)shader; (void)count; (void)string; (void)length;
+    GL_CALL();
+}
+void glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+                  GLint border, GLenum format, GLenum type, const void *pixels) {
+    (void)target; (void)level; (void)internalformat; (void)width; (void)height;
+    (void)border; (void)format; (void)type;
+    GL_CALL();
+    gl_stub_counts.tex_images++;
+    if (pixels && !s_unpack_buffer && gl_stub_upload_hook) gl_stub_upload_hook(0, 0, width, height, pixels);
+}
+void glTexParameteri(GLenum target, GLenum pname, GLint param) {
+    (void)target; (void)pname; (void)param;
+    GL_CALL();
+    gl_stub_counts.tex_parameters++;
+}
+void glUniform1f(GLint loc, GLfloat v0) { (void)loc; (void)v0; GL_UNIFORM(); }
+void glUniform1i(GLint loc, GLint v0) { (void)loc; (void)v0; GL_UNIFORM(); }
+void glUniform1iv(GLint loc, GLsizei count, const GLint *v) { (void)loc; (void)count; (void)v; GL_UNIFORM(); }
+void glUniform2f(GLint loc, GLfloat v0, GLfloat v1) { (void)loc; (void)v0; (void)v1; GL_UNIFORM(); }
+void glUniform2fv(GLint loc, GLsizei count, const GLfloat *v) { (void)loc; (void)count; (void)v; GL_UNIFORM(); }
+void glUniform3f(GLint loc, GLfloat v0, GLfloat v1, GLfloat v2) { (void)loc; (void)v0; (void)v1; (void)v2; GL_UNIFORM(); }
+void glUniform4f(GLint loc, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {
+    (void)loc; (void)v0; (void)v1; (void)v2; (void)v3;
+    GL_UNIFORM();
+}
+void glUniform4fv(GLint loc, GLsizei count, const GLfloat *v) { (void)loc; (void)count; (void)v; GL_UNIFORM(); }
+void glUseProgram(GLuint program) { (void)program; GL_CALL(); }
+void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                           GLsizei stride, const void *pointer) {
+    (void)index; (void)size; (void)type; (void)normalized; (void)stride; (void)pointer;
+    GL_CALL();
+    gl_stub_counts.attrib_pointers++;
+}
+void glViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    GL_CALL();
+    s_viewport[0] = x; s_viewport[1] = y; s_viewport[2] = width; s_viewport[3] = height;
+}
+
+/* ---- GLES3 -------------------------------------------------------------- */
+
+void glBindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    (void)target; (void)index; (void)buffer;
+    GL_CALL();
+}
+void glBindVertexArray(GLuint array) { (void)array; GL_CALL(); }
+void glDeleteVertexArrays(GLsizei n, const GLuint *arrays) { (void)n; (void)arrays; GL_CALL(); }
+void glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount) {
+    (void)mode; (void)first; (void)count;
+    GL_CALL();
+    gl_stub_counts.draws++;
+    gl_stub_counts.instanced_draws++;
+    gl_stub_counts.instances += instancecount;
+}
+void glGenVertexArrays(GLsizei n, GLuint *arrays) { GL_CALL(); gen_names(n, arrays); }
+GLuint glGetUniformBlockIndex(GLuint program, const GLchar *name) {
+    (void)program; (void)name;
+    GL_CALL();
+    return 0;
+}
+void glTexStorage2D(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height) {
+    (void)target; (void)internalformat; (void)width; (void)height;
+    GL_CALL();
+    gl_stub_counts.tex_storage++;
+    gl_stub_counts.tex_storage_levels = levels;
+}
+void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
+                     GLsizei height, GLenum format, GLenum type, const void *pixels) {
+    (void)target; (void)level; (void)format; (void)type;
+    GL_CALL();
+    gl_stub_counts.tex_sub_images++;
+    gl_stub_counts.tex_sub_rows += height;
+    if (s_unpack_buffer) gl_stub_counts.unpack_uploads++;
+    else if (pixels && gl_stub_upload_hook) gl_stub_upload_hook(xoffset, yoffset, width, height, pixels);
+    if (gl_stub_tex_sub_image_us > 0) usleep((useconds_t)gl_stub_tex_sub_image_us);
+}
+void *glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    (void)target; (void)offset; (void)access;
+    GL_CALL();
+    gl_stub_counts.buffer_maps++;
+    if ((size_t)length > s_mapped_size) {
+        free(s_mapped);
+        s_mapped = malloc((size_t)length);
+        s_mapped_size = s_mapped ? (size_t)length : 0;
+    }
+    return s_mapped;
+}
+GLboolean glUnmapBuffer(GLenum target) { (void)target; GL_CALL(); return GL_TRUE; }
+void glUniformBlockBinding(GLuint program, GLuint index, GLuint binding) {
+    (void)program; (void)index; (void)binding;
+    GL_CALL();
+}
+void glVertexAttribDivisor(GLuint index, GLuint divisor) { (void)index; (void)divisor; GL_CALL(); }
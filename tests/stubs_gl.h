@@ -0,0 +1,40 @@
+/* Counting EGL/GLES2 stand-ins for renderer tests that run without a GPU */
+#ifndef HYPRLAX_TESTS_STUBS_GL_H
+#define HYPRLAX_TESTS_STUBS_GL_H
+
+typedef struct {
+    int calls;              /* Every GL entry point */
+    int gen_buffers;        /* Buffer objects created */
+    int delete_buffers;
+    int buffer_data;        /* Buffer (re)allocations */
+    int buffer_sub_data;    /* Writes into existing buffers */
+    int attrib_pointers;    /* glVertexAttribPointer */
+    int draws;
+    int tex_parameters;     /* glTexParameteri */
+    int uniforms;           /* glUniform* */
+    int state_queries;      /* glGetIntegerv/glIsEnabled */
+    int tex_images;         /* glTexImage2D (texture storage allocations) */
+    int delete_textures;    /* Texture names deleted */
+    int tex_storage;        /* glTexStorage2D (immutable allocations) */
+    int tex_storage_levels; /* ...mip levels of the last one */
+    int instanced_draws;    /* glDrawArraysInstanced (also counted in draws) */
+    int instances;          /* Instances drawn by them */
+    int tex_sub_images;     /* glTexSubImage2D */
+    int tex_sub_rows;       /* ...rows they wrote */
+    int unpack_uploads;     /* ...of which sourced from a pixel unpack buffer */
+    int buffer_maps;        /* glMapBufferRange */
+    int swaps;              /* eglSwapBuffers (presents) */
+    int clears;             /* glClear */
+    int target_binds;       /* glBindFramebuffer to a render target (not 0) */
+    int swap_interval;      /* Last eglSwapInterval value */
+} gl_stub_counts_t;
+
+extern gl_stub_counts_t gl_stub_counts;
+/* Simulated cost of each glTexSubImage2D, for time-budget tests */
+extern int gl_stub_tex_sub_image_us;
+/* GL_MAX_TEXTURE_SIZE reported to the renderer */
+extern int gl_stub_max_texture_size;
+/* Called with the RGBA rows of every texture upload from client memory */
+extern void (*gl_stub_upload_hook)(int x, int y, int width, int height, const void *pixels);
+
+#endif /* HYPRLAX_TESTS_STUBS_GL_H */
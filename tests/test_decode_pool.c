@@ -0,0 +1,153 @@
+// Tests for the image decode pool: jobs run on workers and come back in
+// completion order, cancelled jobs are discarded whether or not they have
+// started, and finished jobs signal the event fd
+#include <check.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "include/decode_pool.h"
+
+typedef struct {
+    int value;
+    int result;
+    atomic_bool *gate;          /* run() spins until set, if given */
+    atomic_bool started;
+    atomic_int *discarded;
+} test_job_t;
+
+static void job_run(void *arg) {
+    test_job_t *job = arg;
+    atomic_store(&job->started, true);
+    while (job->gate && !atomic_load(job->gate)) usleep(100);
+    job->result = job->value * 2;
+}
+
+static void job_discard(void *arg) {
+    test_job_t *job = arg;
+    atomic_fetch_add(job->discarded, 1);
+    free(job);
+}
+
+static test_job_t *make_job(int value, atomic_bool *gate, atomic_int *discarded) {
+    test_job_t *job = calloc(1, sizeof(*job));
+    ck_assert_ptr_nonnull(job);
+    job->value = value;
+    job->gate = gate;
+    job->discarded = discarded;
+    return job;
+}
+
+START_TEST(test_jobs_run_and_come_back)
+{
+    atomic_int discarded = 0;
+    decode_pool_t *pool = decode_pool_create(4);
+    ck_assert_ptr_nonnull(pool);
+    ck_assert_int_eq(decode_pool_threads(pool), 4);
+    uint32_t tickets[8];
+    for (int i = 0; i < 8; i++) {
+        tickets[i] = decode_pool_submit(pool, job_run, job_discard, make_job(i, NULL, &discarded));
+        ck_assert_uint_ne(tickets[i], 0);
+    }
+    decode_pool_wait(pool);
+    ck_assert_int_eq(decode_pool_pending(pool), 8);
+
+    struct pollfd pfd = { .fd = decode_pool_event_fd(pool), .events = POLLIN };
+    ck_assert_int_eq(poll(&pfd, 1, 0), 1);
+
+    int seen = 0;
+    uint32_t ticket;
+    test_job_t *job;
+    while ((job = decode_pool_take(pool, &ticket))) {
+        ck_assert_int_eq(job->result, job->value * 2);
+        ck_assert_uint_eq(ticket, tickets[job->value]);
+        seen |= 1 << job->value;
+        free(job);
+    }
+    ck_assert_int_eq(seen, 0xff);
+    ck_assert_int_eq(decode_pool_pending(pool), 0);
+    ck_assert_int_eq(atomic_load(&discarded), 0);
+    decode_pool_destroy(pool);
+}
+END_TEST
+
+START_TEST(test_cancel_queued_job)
+{
+    atomic_int discarded = 0;
+    atomic_bool gate = false;
+    decode_pool_t *pool = decode_pool_create(1);
+    test_job_t *blocker = make_job(1, &gate, &discarded);
+    decode_pool_submit(pool, job_run, job_discard, blocker);
+    uint32_t queued = decode_pool_submit(pool, job_run, job_discard, make_job(2, NULL, &discarded));
+
+    /* The only worker is busy: the second job has not started */
+    ck_assert(decode_pool_cancel(pool, queued));
+    ck_assert_int_eq(atomic_load(&discarded), 1);
+    ck_assert(!decode_pool_cancel(pool, queued));
+
+    atomic_store(&gate, true);
+    decode_pool_wait(pool);
+    test_job_t *job = decode_pool_take(pool, NULL);
+    ck_assert_ptr_eq(job, blocker);
+    free(job);
+    ck_assert_ptr_null(decode_pool_take(pool, NULL));
+    decode_pool_destroy(pool);
+}
+END_TEST
+
+START_TEST(test_cancel_running_job)
+{
+    atomic_int discarded = 0;
+    atomic_bool gate = false;
+    decode_pool_t *pool = decode_pool_create(2);
+    test_job_t *running = make_job(3, &gate, &discarded);
+    uint32_t ticket = decode_pool_submit(pool, job_run, job_discard, running);
+    while (!atomic_load(&running->started)) usleep(100);
+
+    ck_assert(decode_pool_cancel(pool, ticket));
+    atomic_store(&gate, true);
+    decode_pool_wait(pool);
+    ck_assert_ptr_null(decode_pool_take(pool, NULL));
+    ck_assert_int_eq(atomic_load(&discarded), 1);
+    ck_assert_int_eq(decode_pool_pending(pool), 0);
+    decode_pool_destroy(pool);
+}
+END_TEST
+
+START_TEST(test_destroy_discards_outstanding)
+{
+    atomic_int discarded = 0;
+    atomic_bool gate = false;
+    decode_pool_t *pool = decode_pool_create(1);
+    test_job_t *running = make_job(0, &gate, &discarded);
+    decode_pool_submit(pool, job_run, job_discard, running);
+    for (int i = 1; i < 4; i++) decode_pool_submit(pool, job_run, job_discard, make_job(i, NULL, &discarded));
+    while (!atomic_load(&running->started)) usleep(100);
+    atomic_store(&gate, true);
+    decode_pool_destroy(pool);
+    /* Every job is released exactly once, finished or not */
+    ck_assert_int_eq(atomic_load(&discarded), 4);
+}
+END_TEST
+
+Suite *decode_pool_suite(void) {
+    Suite *s = suite_create("DecodePool");
+    TCase *tc = tcase_create("Core");
+    tcase_add_test(tc, test_jobs_run_and_come_back);
+    tcase_add_test(tc, test_cancel_queued_job);
+    tcase_add_test(tc, test_cancel_running_job);
+    tcase_add_test(tc, test_destroy_discards_outstanding);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = decode_pool_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,118 @@
+// Tests for the per-output presentation clock
+#include <check.h>
+#include <stdlib.h>
+#include "include/frame_clock.h"
+
+START_TEST(test_predict_without_feedback)
+{
+    frame_clock_t clock;
+    frame_clock_init(&clock, 144);
+    ck_assert_int_eq(clock.source, FRAME_CLOCK_NONE);
+    ck_assert_double_eq_tol(frame_clock_predict(&clock, 5.0), 5.0, 1e-12);
+    ck_assert_double_eq_tol(frame_clock_interval(&clock), 1.0 / 144.0, 1e-12);
+}
+END_TEST
+
+START_TEST(test_predict_next_refresh)
+{
+    frame_clock_t clock;
+    frame_clock_init(&clock, 60);
+    double refresh = 1.0 / 60.0;
+    frame_clock_presented(&clock, 10.0, refresh, 600, true);
+
+    /* Mid-interval: the next edge */
+    ck_assert_double_eq_tol(frame_clock_predict(&clock, 10.005), 10.0 + refresh, 1e-9);
+    /* Several refreshes later: still phase-locked to the last present */
+    ck_assert_double_eq_tol(frame_clock_predict(&clock, 10.0 + 2.5 * refresh), 10.0 + 3.0 * refresh, 1e-9);
+}
+END_TEST
+
+START_TEST(test_interval_from_msc)
+{
+    /* Compositor does not report refresh: intervals come from msc deltas */
+    frame_clock_t clock;
+    frame_clock_init(&clock, 60);
+    double real = 1.0 / 75.0;
+    double t = 1.0;
+    for (int i = 0; i < 200; i++) {
+        frame_clock_presented(&clock, t, 0.0, 1000 + (uint64_t)i * 2, true);
+        t += 2.0 * real;
+    }
+    ck_assert_double_eq_tol(frame_clock_interval(&clock), real, 1e-6);
+    ck_assert_double_eq_tol(frame_clock_average_interval(&clock), 2.0 * real, 1e-6);
+
+    frame_clock_reset_window(&clock);
+    ck_assert_double_eq_tol(frame_clock_average_interval(&clock), 0.0, 1e-12);
+    ck_assert_uint_eq(clock.presented, 200);
+}
+END_TEST
+
+START_TEST(test_misses_and_discards)
+{
+    frame_clock_t clock;
+    frame_clock_init(&clock, 100);
+    frame_clock_presented(&clock, 1.00, 0.01, 100, true);
+
+    /* On time */
+    frame_clock_submitted(&clock, frame_clock_predict(&clock, 1.002));
+    frame_clock_presented(&clock, 1.01, 0.01, 101, true);
+    ck_assert_uint_eq(clock.missed, 0);
+
+    /* One refresh late */
+    frame_clock_submitted(&clock, frame_clock_predict(&clock, 1.012));
+    frame_clock_presented(&clock, 1.03, 0.01, 103, true);
+    ck_assert_uint_eq(clock.missed, 1);
+
+    frame_clock_submitted(&clock, frame_clock_predict(&clock, 1.032));
+    frame_clock_discarded(&clock);
+    ck_assert_uint_eq(clock.discarded, 1);
+    frame_clock_presented(&clock, 1.10, 0.01, 110, true);
+    ck_assert_uint_eq(clock.missed, 1);
+
+    /* A long idle gap is not a present interval */
+    ck_assert_double_eq_tol(frame_clock_average_interval(&clock), 0.015, 1e-9);
+}
+END_TEST
+
+START_TEST(test_frame_callback_fallback)
+{
+    frame_clock_t clock;
+    frame_clock_init(&clock, 60);
+    frame_clock_frame_done(&clock, 2.0);
+    ck_assert_int_eq(clock.source, FRAME_CLOCK_CALLBACK);
+    ck_assert_double_eq_tol(frame_clock_predict(&clock, 2.001), 2.0 + 1.0 / 60.0, 1e-9);
+
+    /* Callbacks are ignored once presentation feedback is available */
+    frame_clock_presented(&clock, 2.02, 0.0, 0, false);
+    frame_clock_frame_done(&clock, 2.5);
+    ck_assert_int_eq(clock.source, FRAME_CLOCK_PRESENTATION);
+    ck_assert_double_eq_tol(clock.last_present, 2.02, 1e-12);
+
+    /* Mode changes drop the measured interval */
+    frame_clock_set_refresh(&clock, 120);
+    ck_assert_double_eq_tol(frame_clock_interval(&clock), 1.0 / 120.0, 1e-12);
+}
+END_TEST
+
+Suite *frame_clock_suite(void) {
+    Suite *s = suite_create("FrameClock");
+    TCase *tc = tcase_create("Core");
+    tcase_add_test(tc, test_predict_without_feedback);
+    tcase_add_test(tc, test_predict_next_refresh);
+    tcase_add_test(tc, test_interval_from_msc);
+    tcase_add_test(tc, test_misses_and_discards);
+    tcase_add_test(tc, test_frame_callback_fallback);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = frame_clock_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_FORK);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
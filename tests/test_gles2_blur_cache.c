@@ -0,0 +1,164 @@
+// Tests for the GLES2 blur cache: a blurred layer is rendered once and then
+// costs the same per frame as an unblurred one
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/renderer.h"
+#include "include/defaults.h"
+#include "stubs_gl.h"
+
+#define TEST_W 1920
+#define TEST_H 1080
+
+static const renderer_ops_t *ops = &renderer_headless_ops;
+static const renderer_layer_params_t k_params = {
+    .fit_mode = 1, .content_scale = 1.5f, .align_x = 0.5f, .align_y = 0.5f,
+    .tint_r = 1.0f, .tint_g = 1.0f, .tint_b = 1.0f,
+};
+
+static void setup(void) {
+    render_options_t options = RENDER_OPTIONS_DEFAULTS;
+    renderer_set_options(&options);
+    renderer_config_t config = { .width = TEST_W, .height = TEST_H };
+    ck_assert_int_eq(ops->init(NULL, NULL, &config), HYPRLAX_SUCCESS);
+}
+
+static void teardown(void) {
+    ops->destroy();
+}
+
+static void draw_frame(const renderer_draw_packet_t *packet, uint32_t texture, float x) {
+    ops->begin_frame();
+    ops->clear(0.0f, 0.0f, 0.0f, 1.0f);
+    ops->draw_packet(packet, texture, x, 0.0f);
+    ops->end_frame();
+    ops->present();
+}
+
+START_TEST(test_blurred_layer_costs_the_same_as_unblurred)
+{
+    texture_t texture = { .id = 7, .width = 2560, .height = 1440 };
+    renderer_draw_packet_t sharp, blurred;
+    ops->compile_layer(&texture, 1.0f, 0.0f, &k_params, &sharp);
+    ops->compile_layer(&texture, 1.0f, 3.0f, &k_params, &blurred);
+    ck_assert_int_eq(blurred.program, RENDERER_PROGRAM_BLUR_CACHED);
+
+    /* First draw renders the blur: two passes into a new texture */
+    gl_stub_counts_t before = gl_stub_counts;
+    draw_frame(&blurred, texture.id, 0.0f);
+    ck_assert_int_eq(gl_stub_counts.draws - before.draws, 3);
+    ck_assert_int_eq(gl_stub_counts.tex_images - before.tex_images, 2);
+
+    gl_stub_counts_t sharp_before = gl_stub_counts;
+    draw_frame(&sharp, texture.id, 0.5f);
+    int sharp_draws = gl_stub_counts.draws - sharp_before.draws;
+
+    for (int frame = 1; frame <= 60; frame++) {
+        before = gl_stub_counts;
+        draw_frame(&blurred, texture.id, 0.01f * (float)frame);
+        ck_assert_int_eq(gl_stub_counts.draws - before.draws, sharp_draws);
+        ck_assert_int_eq(gl_stub_counts.tex_images - before.tex_images, 0);
+    }
+}
+END_TEST
+
+START_TEST(test_changed_blur_renders_a_new_entry)
+{
+    texture_t texture = { .id = 7, .width = 1920, .height = 1080 };
+    renderer_draw_packet_t packet;
+    ops->compile_layer(&texture, 1.0f, 2.0f, &k_params, &packet);
+    draw_frame(&packet, texture.id, 0.0f);
+
+    /* An IPC blur change recompiles the draw: blurred again, once */
+    ops->compile_layer(&texture, 1.0f, 4.0f, &k_params, &packet);
+    gl_stub_counts_t before = gl_stub_counts;
+    draw_frame(&packet, texture.id, 0.0f);
+    ck_assert_int_eq(gl_stub_counts.tex_images - before.tex_images, 2);
+    before = gl_stub_counts;
+    draw_frame(&packet, texture.id, 0.1f);
+    ck_assert_int_eq(gl_stub_counts.tex_images - before.tex_images, 0);
+
+    /* So does a new output size */
+    ops->resize(1280, 720);
+    ops->compile_layer(&texture, 1.0f, 4.0f, &k_params, &packet);
+    before = gl_stub_counts;
+    draw_frame(&packet, texture.id, 0.0f);
+    ck_assert_int_eq(gl_stub_counts.tex_images - before.tex_images, 2);
+}
+END_TEST
+
+START_TEST(test_superseded_entries_are_freed)
+{
+    texture_t texture = { .id = 7, .width = 1920, .height = 1080 };
+    renderer_draw_packet_t packet;
+    ops->compile_layer(&texture, 1.0f, 2.0f, &k_params, &packet);
+    draw_frame(&packet, texture.id, 0.0f);
+    ops->compile_layer(&texture, 1.0f, 3.0f, &k_params, &packet);
+    for (int frame = 0; frame <= HYPRLAX_BLUR_CACHE_STALE_FRAMES + 1; frame++) {
+        draw_frame(&packet, texture.id, 0.0f);
+    }
+
+    /* The next blur of this texture frees the long-unused first one */
+    gl_stub_counts_t before = gl_stub_counts;
+    ops->compile_layer(&texture, 1.0f, 4.0f, &k_params, &packet);
+    draw_frame(&packet, texture.id, 0.0f);
+    /* Scratch pass texture plus the superseded entry */
+    ck_assert_int_eq(gl_stub_counts.delete_textures - before.delete_textures, 2);
+}
+END_TEST
+
+START_TEST(test_deleting_source_frees_its_blurs)
+{
+    static uint8_t pixels[64 * 64 * 4];
+    uint32_t id = ops->upload_texture(pixels, 64, 64);
+    texture_t texture = { .id = id, .width = 64, .height = 64 };
+    renderer_draw_packet_t packet;
+    ops->compile_layer(&texture, 1.0f, 2.0f, &k_params, &packet);
+    draw_frame(&packet, id, 0.0f);
+
+    gl_stub_counts_t before = gl_stub_counts;
+    ops->delete_texture(id);
+    ck_assert_int_eq(gl_stub_counts.delete_textures - before.delete_textures, 2);
+}
+END_TEST
+
+START_TEST(test_cache_disabled_blurs_every_frame)
+{
+    render_options_t options = RENDER_OPTIONS_DEFAULTS;
+    options.blur_cache = false;
+    options.kawase_blur = false;
+    renderer_set_options(&options);
+
+    texture_t texture = { .id = 7, .width = 1920, .height = 1080 };
+    renderer_draw_packet_t packet;
+    ops->compile_layer(&texture, 1.0f, 2.0f, &k_params, &packet);
+    ck_assert_int_ne(packet.program, RENDERER_PROGRAM_BLUR_CACHED);
+    gl_stub_counts_t before = gl_stub_counts;
+    draw_frame(&packet, texture.id, 0.0f);
+    draw_frame(&packet, texture.id, 0.1f);
+    ck_assert_int_eq(gl_stub_counts.tex_images - before.tex_images, 0);
+}
+END_TEST
+
+Suite *gles2_blur_cache_suite(void) {
+    Suite *s = suite_create("GLES2BlurCache");
+    TCase *tc = tcase_create("Core");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, test_blurred_layer_costs_the_same_as_unblurred);
+    tcase_add_test(tc, test_changed_blur_renders_a_new_entry);
+    tcase_add_test(tc, test_superseded_entries_are_freed);
+    tcase_add_test(tc, test_deleting_source_frees_its_blurs);
+    tcase_add_test(tc, test_cache_disabled_blurs_every_frame);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = gles2_blur_cache_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,188 @@
+// Tests for the GLES2 backend's persistent geometry: no buffer objects are
+// created, reallocated or rewritten once a scene's draws are compiled
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/renderer.h"
+#include "include/defaults.h"
+#include "stubs_gl.h"
+
+#define TEST_W 1920
+#define TEST_H 1080
+#define TEST_LAYERS 4
+
+static const renderer_ops_t *ops = &renderer_headless_ops;
+
+static void setup(void) {
+    /* Cover the two-pass blur path as well */
+    render_options_t options = RENDER_OPTIONS_DEFAULTS;
+    options.separable_blur = true;
+    options.blur_cache = false;
+    renderer_set_options(&options);
+    renderer_config_t config = { .width = TEST_W, .height = TEST_H };
+    ck_assert_int_eq(ops->init(NULL, NULL, &config), HYPRLAX_SUCCESS);
+}
+
+static void teardown(void) {
+    ops->destroy();
+}
+
+static void compile_scene(renderer_draw_packet_t packets[TEST_LAYERS], texture_t textures[TEST_LAYERS]) {
+    for (int i = 0; i < TEST_LAYERS; i++) {
+        textures[i] = (texture_t){ .id = 10 + (uint32_t)i, .width = 800 + 300 * i, .height = 600 + 100 * i };
+        renderer_layer_params_t params = {
+            .fit_mode = i % 3,
+            .content_scale = 1.0f + 0.25f * (float)i,
+            .align_x = 0.5f,
+            .align_y = 0.25f * (float)i,
+            .tint_r = 1.0f, .tint_g = 1.0f, .tint_b = 1.0f,
+        };
+        /* The top layer is blurred */
+        float blur = i == TEST_LAYERS - 1 ? 2.0f : 0.0f;
+        ops->compile_layer(&textures[i], 1.0f, blur, &params, &packets[i]);
+    }
+}
+
+/* One frame the way render_core issues it: trails fade, a batch of the
+ * lower layers, single draws, a legacy draw and a composite blit */
+static void draw_frame(const renderer_draw_packet_t packets[TEST_LAYERS],
+                       const texture_t textures[TEST_LAYERS], int frame, uint32_t target) {
+    float x = 0.001f * (float)frame;
+    ops->begin_frame();
+    ops->clear(0.0f, 0.0f, 0.0f, 1.0f);
+    ops->fade_frame(0.0f, 0.0f, 0.0f, 0.12f);
+    if (target) ops->blit_target(target);
+
+    renderer_packet_draw_t draws[2];
+    for (int i = 0; i < 2; i++) {
+        draws[i] = (renderer_packet_draw_t){ &packets[i], textures[i].id, x * (float)i, 0.0f };
+    }
+    int used = ops->draw_packet_batch(draws, 2);
+    for (int i = used; i < TEST_LAYERS; i++) {
+        ops->draw_packet(&packets[i], textures[i].id, x * (float)i, -x);
+    }
+    renderer_layer_params_t params = { .fit_mode = 1, .content_scale = 1.0f, .align_x = 0.5f, .align_y = 0.5f };
+    ops->draw_layer_ex(&textures[0], x, 0.0f, 0.5f, 0.0f, &params);
+    ops->end_frame();
+    ops->present();
+}
+
+START_TEST(test_steady_state_creates_no_buffers)
+{
+    renderer_draw_packet_t packets[TEST_LAYERS];
+    texture_t textures[TEST_LAYERS];
+    compile_scene(packets, textures);
+    uint32_t target = ops->create_target(TEST_W, TEST_H);
+    ck_assert(target != 0);
+
+    /* The first frame may still point attributes at the buffer */
+    draw_frame(packets, textures, 0, target);
+
+    for (int frame = 1; frame <= 120; frame++) {
+        gl_stub_counts_t before = gl_stub_counts;
+        draw_frame(packets, textures, frame, target);
+        ck_assert_int_eq(gl_stub_counts.gen_buffers - before.gen_buffers, 0);
+        ck_assert_int_eq(gl_stub_counts.delete_buffers - before.delete_buffers, 0);
+        ck_assert_int_eq(gl_stub_counts.buffer_data - before.buffer_data, 0);
+        ck_assert_int_eq(gl_stub_counts.buffer_sub_data - before.buffer_sub_data, 0);
+        ck_assert_int_eq(gl_stub_counts.attrib_pointers - before.attrib_pointers, 0);
+        ck_assert(gl_stub_counts.draws - before.draws >= TEST_LAYERS);
+    }
+    ops->destroy_target(target);
+}
+END_TEST
+
+START_TEST(test_geometry_written_only_on_recompile)
+{
+    renderer_draw_packet_t packets[TEST_LAYERS];
+    texture_t textures[TEST_LAYERS];
+    compile_scene(packets, textures);
+    draw_frame(packets, textures, 0, 0);
+
+    /* Recompiling unchanged fit parameters reuses the stored quads */
+    gl_stub_counts_t before = gl_stub_counts;
+    compile_scene(packets, textures);
+    ck_assert_int_eq(gl_stub_counts.buffer_sub_data - before.buffer_sub_data, 0);
+
+    /* A new fit writes one quad into the existing buffer */
+    renderer_layer_params_t params = { .fit_mode = 1, .content_scale = 3.0f, .align_x = 0.1f, .align_y = 0.9f };
+    ops->compile_layer(&textures[0], 1.0f, 0.0f, &params, &packets[0]);
+    ck_assert_int_eq(gl_stub_counts.buffer_sub_data - before.buffer_sub_data, 1);
+    ck_assert_int_eq(gl_stub_counts.gen_buffers - before.gen_buffers, 0);
+    ck_assert_int_eq(gl_stub_counts.buffer_data - before.buffer_data, 0);
+
+    before = gl_stub_counts;
+    draw_frame(packets, textures, 1, 0);
+    ck_assert_int_eq(gl_stub_counts.buffer_sub_data - before.buffer_sub_data, 0);
+}
+END_TEST
+
+START_TEST(test_geometry_slots_recycle_without_reallocating)
+{
+    texture_t texture = { .id = 1, .width = 640, .height = 480 };
+    renderer_draw_packet_t packet;
+    gl_stub_counts_t before = gl_stub_counts;
+
+    /* More distinct quads than slots: old ones are overwritten in place */
+    for (int i = 0; i < 3 * HYPRLAX_GEOMETRY_SLOTS; i++) {
+        renderer_layer_params_t params = {
+            .fit_mode = 1, .content_scale = 1.0f + 0.01f * (float)i, .align_x = 0.5f, .align_y = 0.5f,
+        };
+        ops->compile_layer(&texture, 1.0f, 0.0f, &params, &packet);
+        ops->draw_packet(&packet, texture.id, 0.0f, 0.0f);
+    }
+    ck_assert_int_eq(gl_stub_counts.gen_buffers - before.gen_buffers, 0);
+    ck_assert_int_eq(gl_stub_counts.buffer_data - before.buffer_data, 0);
+    ck_assert_int_eq(gl_stub_counts.buffer_sub_data - before.buffer_sub_data, 3 * HYPRLAX_GEOMETRY_SLOTS);
+}
+END_TEST
+
+START_TEST(test_cropped_texture_maps_into_crop)
+{
+    /* A 4000x2000 image of which the middle half of each axis was uploaded */
+    texture_t whole = { .id = 1, .width = 4000, .height = 2000 };
+    texture_t cropped = { .id = 2, .width = 2000, .height = 1000 };
+    renderer_layer_params_t params = {
+        .fit_mode = 1, .content_scale = 1.25f, .align_x = 0.5f, .align_y = 0.5f, .overflow_mode = 4,
+    };
+    renderer_draw_packet_t full, part;
+    renderer_compile_layer_geometry(TEST_W, TEST_H, &whole, 1.0f, 0.0f, &params, &full);
+    params.crop[0] = 0.25f; params.crop[1] = 0.25f;
+    params.crop[2] = 0.75f; params.crop[3] = 0.75f;
+    renderer_compile_layer_geometry(TEST_W, TEST_H, &cropped, 1.0f, 0.0f, &params, &part);
+
+    /* Same quad, same image region */
+    for (int i = 0; i < 16; i += 4) {
+        ck_assert_float_eq_tol(part.vertices[i], full.vertices[i], 1e-5f);
+        ck_assert_float_eq_tol(part.vertices[i + 1], full.vertices[i + 1], 1e-5f);
+        ck_assert_float_eq_tol(part.vertices[i + 2], (full.vertices[i + 2] - 0.25f) / 0.5f, 1e-5f);
+        ck_assert_float_eq_tol(part.vertices[i + 3], (full.vertices[i + 3] - 0.25f) / 0.5f, 1e-5f);
+    }
+    /* An offset moves the same share of the image */
+    ck_assert_float_eq_tol(part.offset_scale[0], full.offset_scale[0] / 0.5f, 1e-5f);
+    ck_assert_float_eq_tol(part.offset_scale[1], full.offset_scale[1] / 0.5f, 1e-5f);
+    ck_assert_float_eq_tol(full.offset_scale[0], 1.0f / 1.25f, 1e-5f);
+}
+END_TEST
+
+Suite *gles2_geometry_suite(void) {
+    Suite *s = suite_create("GLES2Geometry");
+    TCase *tc = tcase_create("Core");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, test_steady_state_creates_no_buffers);
+    tcase_add_test(tc, test_geometry_written_only_on_recompile);
+    tcase_add_test(tc, test_geometry_slots_recycle_without_reallocating);
+    tcase_add_test(tc, test_cropped_texture_maps_into_crop);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = gles2_geometry_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,153 @@
+// Tests for the GLES2 dual-Kawase blur: the pyramid depth follows the blur
+// radius and output size, and a frame costs a fixed number of passes
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/renderer.h"
+#include "include/defaults.h"
+#include "stubs_gl.h"
+
+#define TEST_W 1920
+#define TEST_H 1080
+
+static const renderer_ops_t *ops = &renderer_headless_ops;
+static const renderer_layer_params_t k_params = {
+    .fit_mode = 1, .content_scale = 1.5f, .align_x = 0.5f, .align_y = 0.5f,
+    .tint_r = 1.0f, .tint_g = 1.0f, .tint_b = 1.0f,
+};
+
+static void setup(void) {
+    /* Uncacheable blurs: what animated layers get */
+    render_options_t options = RENDER_OPTIONS_DEFAULTS;
+    options.blur_cache = false;
+    renderer_set_options(&options);
+    renderer_config_t config = { .width = TEST_W, .height = TEST_H };
+    ck_assert_int_eq(ops->init(NULL, NULL, &config), HYPRLAX_SUCCESS);
+}
+
+static void teardown(void) {
+    ops->destroy();
+}
+
+static int draws_for_frame(const renderer_draw_packet_t *packet, uint32_t texture, float x) {
+    gl_stub_counts_t before = gl_stub_counts;
+    ops->begin_frame();
+    ops->clear(0.0f, 0.0f, 0.0f, 1.0f);
+    ops->draw_packet(packet, texture, x, 0.0f);
+    ops->end_frame();
+    ops->present();
+    return gl_stub_counts.draws - before.draws;
+}
+
+START_TEST(test_plan_follows_radius_and_resolution)
+{
+    int levels, prev = 0;
+    float offset;
+    for (float blur = 0.25f; blur <= 16.0f; blur *= 2.0f) {
+        renderer_kawase_plan(blur, TEST_W, TEST_H, &levels, &offset);
+        ck_assert_int_ge(levels, prev);
+        ck_assert_int_ge(levels, 1);
+        ck_assert_int_le(levels, HYPRLAX_KAWASE_MAX_LEVELS);
+        ck_assert(offset >= 0.5f && offset <= HYPRLAX_KAWASE_MAX_OFFSET);
+        prev = levels;
+    }
+    ck_assert_int_gt(prev, 1);
+
+    /* A small output cannot go as deep: the last level stays usable */
+    renderer_kawase_plan(16.0f, 160, 90, &levels, &offset);
+    ck_assert_int_le(levels, prev);
+    ck_assert_int_ge(90 >> levels, HYPRLAX_KAWASE_MIN_SIZE);
+}
+END_TEST
+
+START_TEST(test_uncached_blur_uses_pyramid)
+{
+    texture_t texture = { .id = 7, .width = 2560, .height = 1440 };
+    renderer_draw_packet_t packet;
+    ops->compile_layer(&texture, 1.0f, 3.0f, &k_params, &packet);
+    ck_assert_int_eq(packet.program, RENDERER_PROGRAM_BLUR_KAWASE);
+
+    int levels;
+    renderer_kawase_plan(packet.blur_amount, TEST_W, TEST_H, &levels, NULL);
+    /* Layer into level 0, down to the last level, back up onto the target */
+    ck_assert_int_eq(draws_for_frame(&packet, texture.id, 0.0f), 2 * levels + 1);
+
+    /* The pyramid is allocated once */
+    for (int frame = 1; frame <= 60; frame++) {
+        gl_stub_counts_t before = gl_stub_counts;
+        ck_assert_int_eq(draws_for_frame(&packet, texture.id, 0.01f * (float)frame), 2 * levels + 1);
+        ck_assert_int_eq(gl_stub_counts.tex_images - before.tex_images, 0);
+    }
+}
+END_TEST
+
+START_TEST(test_pass_count_grows_slowly_with_radius)
+{
+    texture_t texture = { .id = 7, .width = 1920, .height = 1080 };
+    renderer_draw_packet_t packet;
+    ops->compile_layer(&texture, 1.0f, 1.0f, &k_params, &packet);
+    int narrow = draws_for_frame(&packet, texture.id, 0.0f);
+    ops->compile_layer(&texture, 1.0f, 16.0f, &k_params, &packet);
+    int wide = draws_for_frame(&packet, texture.id, 0.0f);
+
+    /* Sixteen times the radius costs a few more small passes, not 16x */
+    ck_assert_int_ge(wide, narrow);
+    ck_assert_int_le(wide, 2 * HYPRLAX_KAWASE_MAX_LEVELS + 1);
+}
+END_TEST
+
+START_TEST(test_resize_reallocates_pyramid)
+{
+    texture_t texture = { .id = 7, .width = 1920, .height = 1080 };
+    renderer_draw_packet_t packet;
+    ops->compile_layer(&texture, 1.0f, 3.0f, &k_params, &packet);
+    draws_for_frame(&packet, texture.id, 0.0f);
+
+    ops->resize(1280, 720);
+    ops->compile_layer(&texture, 1.0f, 3.0f, &k_params, &packet);
+    int levels;
+    renderer_kawase_plan(packet.blur_amount, 1280, 720, &levels, NULL);
+    gl_stub_counts_t before = gl_stub_counts;
+    draws_for_frame(&packet, texture.id, 0.0f);
+    ck_assert_int_eq(gl_stub_counts.tex_images - before.tex_images, levels + 1);
+}
+END_TEST
+
+START_TEST(test_disabled_falls_back_to_kernel)
+{
+    render_options_t options = RENDER_OPTIONS_DEFAULTS;
+    options.blur_cache = false;
+    options.kawase_blur = false;
+    renderer_set_options(&options);
+    ops->apply_options(renderer_get_options());
+
+    texture_t texture = { .id = 7, .width = 1920, .height = 1080 };
+    renderer_draw_packet_t packet;
+    ops->compile_layer(&texture, 1.0f, 3.0f, &k_params, &packet);
+    ck_assert_int_eq(packet.program, RENDERER_PROGRAM_BLUR);
+    ck_assert_int_eq(draws_for_frame(&packet, texture.id, 0.0f), 1);
+}
+END_TEST
+
+Suite *gles2_kawase_suite(void) {
+    Suite *s = suite_create("GLES2Kawase");
+    TCase *tc = tcase_create("Core");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, test_plan_follows_radius_and_resolution);
+    tcase_add_test(tc, test_uncached_blur_uses_pyramid);
+    tcase_add_test(tc, test_pass_count_grows_slowly_with_radius);
+    tcase_add_test(tc, test_resize_reallocates_pyramid);
+    tcase_add_test(tc, test_disabled_falls_back_to_kernel);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = gles2_kawase_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
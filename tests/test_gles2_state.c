@@ -0,0 +1,229 @@
+// Tests for the GLES2 state tracker: state already in effect is not set
+// again, so repeated frames issue a fraction of the first frame's GL calls
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/renderer.h"
+#include "include/defaults.h"
+#include "stubs_gl.h"
+
+#define TEST_W 1920
+#define TEST_H 1080
+#define TEST_LAYERS 4
+
+static const renderer_ops_t *ops = &renderer_headless_ops;
+static renderer_draw_packet_t s_packets[TEST_LAYERS];
+static texture_t s_textures[TEST_LAYERS];
+
+static void setup(void) {
+    /* Cover the two-pass blur path, which saves and restores state */
+    render_options_t options = RENDER_OPTIONS_DEFAULTS;
+    options.separable_blur = true;
+    options.blur_cache = false;
+    renderer_set_options(&options);
+    renderer_config_t config = { .width = TEST_W, .height = TEST_H };
+    ck_assert_int_eq(ops->init(NULL, NULL, &config), HYPRLAX_SUCCESS);
+
+    for (int i = 0; i < TEST_LAYERS; i++) {
+        s_textures[i] = (texture_t){ .id = 10 + (uint32_t)i, .width = 1000 + 200 * i, .height = 800 };
+        renderer_layer_params_t params = {
+            .fit_mode = 1, .content_scale = 1.0f + 0.25f * (float)i,
+            .align_x = 0.5f, .align_y = 0.5f,
+            .tint_r = 1.0f, .tint_g = 0.5f, .tint_b = 1.0f, .tint_strength = 0.25f,
+            .tile_x = i == 1,
+        };
+        float blur = i == TEST_LAYERS - 1 ? 2.0f : 0.0f;
+        ops->compile_layer(&s_textures[i], 0.9f, blur, &params, &s_packets[i]);
+    }
+}
+
+static void teardown(void) {
+    ops->destroy();
+}
+
+static void draw_frame(float x, uint32_t target) {
+    ops->begin_frame();
+    ops->clear(0.0f, 0.0f, 0.0f, 1.0f);
+    ops->fade_frame(0.0f, 0.0f, 0.0f, 0.12f);
+    if (target) ops->blit_target(target);
+
+    renderer_packet_draw_t draws[2];
+    for (int i = 0; i < 2; i++) {
+        draws[i] = (renderer_packet_draw_t){ &s_packets[i], s_textures[i].id, x * (float)i, 0.0f };
+    }
+    int used = ops->draw_packet_batch(draws, 2);
+    for (int i = used; i < TEST_LAYERS; i++) {
+        ops->draw_packet(&s_packets[i], s_textures[i].id, x * (float)i, 0.0f);
+    }
+    ops->end_frame();
+    ops->present();
+}
+
+/* Recompile the top layer without blur: no two-pass draw in the frame */
+static void unblur_top_layer(void) {
+    int i = TEST_LAYERS - 1;
+    renderer_layer_params_t params = { .fit_mode = 1, .content_scale = 2.0f, .align_x = 0.5f, .align_y = 0.5f };
+    ops->compile_layer(&s_textures[i], 0.9f, 0.0f, &params, &s_packets[i]);
+}
+
+START_TEST(test_identical_frame_skips_redundant_state)
+{
+    unblur_top_layer();
+    uint32_t target = ops->create_target(TEST_W, TEST_H);
+    ck_assert(target != 0);
+    gl_stub_counts_t first = gl_stub_counts;
+    draw_frame(0.25f, target);
+    int first_calls = gl_stub_counts.calls - first.calls;
+    int first_uniforms = gl_stub_counts.uniforms - first.uniforms;
+
+    /* Layers sharing a program still differ from one draw to the next;
+     * everything else is already in effect */
+    gl_stub_counts_t second = gl_stub_counts;
+    draw_frame(0.25f, target);
+    int steady_uniforms = gl_stub_counts.uniforms - second.uniforms;
+    ck_assert(steady_uniforms < first_uniforms);
+
+    for (int frame = 0; frame < 10; frame++) {
+        gl_stub_counts_t before = gl_stub_counts;
+        draw_frame(0.25f, target);
+        ck_assert_int_eq(gl_stub_counts.tex_parameters - before.tex_parameters, 0);
+        ck_assert_int_eq(gl_stub_counts.uniforms - before.uniforms, steady_uniforms);
+        ck_assert_int_eq(gl_stub_counts.state_queries - before.state_queries, 0);
+        ck_assert(gl_stub_counts.draws - before.draws >= TEST_LAYERS);
+        ck_assert(gl_stub_counts.calls - before.calls < first_calls);
+    }
+    ops->destroy_target(target);
+}
+END_TEST
+
+START_TEST(test_repeated_draw_issues_only_the_draw)
+{
+    const renderer_draw_packet_t *packet = &s_packets[2];
+    ops->draw_packet(packet, s_textures[2].id, 0.5f, 0.0f);
+
+    gl_stub_counts_t before = gl_stub_counts;
+    ops->draw_packet(packet, s_textures[2].id, 0.5f, 0.0f);
+    ck_assert_int_eq(gl_stub_counts.calls - before.calls, 1);
+    ck_assert_int_eq(gl_stub_counts.draws - before.draws, 1);
+
+    /* A new offset is one uniform upload */
+    before = gl_stub_counts;
+    ops->draw_packet(packet, s_textures[2].id, 0.75f, 0.0f);
+    ck_assert_int_eq(gl_stub_counts.uniforms - before.uniforms, 1);
+    ck_assert_int_eq(gl_stub_counts.calls - before.calls, 2);
+}
+END_TEST
+
+START_TEST(test_separable_blur_restores_state_without_queries)
+{
+    gl_stub_counts_t first = gl_stub_counts;
+    draw_frame(0.25f, 0);
+    int first_uniforms = gl_stub_counts.uniforms - first.uniforms;
+
+    /* The two passes share a program, so only their per-pass uniforms
+     * change; viewport and blend come from the shadow */
+    gl_stub_counts_t before = gl_stub_counts;
+    draw_frame(0.25f, 0);
+    ck_assert_int_eq(gl_stub_counts.state_queries - before.state_queries, 0);
+    ck_assert_int_eq(gl_stub_counts.tex_parameters - before.tex_parameters, 0);
+    ck_assert(gl_stub_counts.uniforms - before.uniforms < first_uniforms);
+}
+END_TEST
+
+START_TEST(test_take_stats_reports_elided_calls)
+{
+    ck_assert_ptr_nonnull(ops->take_stats);
+    draw_frame(0.25f, 0);
+    renderer_stats_t stats = {0};
+    ops->take_stats(&stats);
+    ck_assert(stats.gl_calls > 0);
+
+    gl_stub_counts_t before = gl_stub_counts;
+    draw_frame(0.25f, 0);
+    stats = (renderer_stats_t){0};
+    ops->take_stats(&stats);
+    ck_assert(stats.gl_calls_elided > 0);
+    /* Tracked calls are a subset of what reached GL */
+    ck_assert(stats.gl_calls <= (uint64_t)(gl_stub_counts.calls - before.calls));
+
+    /* Counters reset on take */
+    stats = (renderer_stats_t){0};
+    ops->take_stats(&stats);
+    ck_assert(stats.gl_calls == 0 && stats.gl_calls_elided == 0);
+}
+END_TEST
+
+START_TEST(test_recycled_texture_name_resets_sampler_state)
+{
+    uint8_t pixels[4 * 4 * 4] = {0};
+    uint32_t id = ops->upload_texture(pixels, 4, 4);
+    ck_assert(id != 0);
+    ops->delete_texture(id);
+
+    /* A texture created under a name the tracker has seen must still get
+     * its sampler parameters */
+    gl_stub_counts_t before = gl_stub_counts;
+    uint32_t again = ops->upload_texture(pixels, 4, 4);
+    ck_assert(again != 0);
+    ck_assert(gl_stub_counts.tex_parameters - before.tex_parameters >= 4);
+    ops->delete_texture(again);
+}
+END_TEST
+
+static bool nonblocking(void) {
+    return (renderer_gles2_ops.get_capabilities() & RENDERER_CAP_NONBLOCKING_PRESENT) != 0;
+}
+
+START_TEST(test_blocking_present_follows_render_option)
+{
+    const renderer_ops_t *win = &renderer_gles2_ops;
+    renderer_config_t config = { .width = TEST_W, .height = TEST_H, .vsync = true };
+    render_options_t options = RENDER_OPTIONS_DEFAULTS;
+    options.blocking_present = true;
+    renderer_set_options(&options);
+    ck_assert_int_eq(win->init((void *)1, (void *)1, &config), HYPRLAX_SUCCESS);
+    ck_assert(!nonblocking());
+    ck_assert_int_eq(gl_stub_counts.swap_interval, 1);
+
+    /* Switched live, as through IPC set render.blocking_present */
+    options.blocking_present = false;
+    renderer_set_options(&options);
+    win->apply_options(renderer_get_options());
+    ck_assert(nonblocking());
+    ck_assert_int_eq(gl_stub_counts.swap_interval, 0);
+
+    options.blocking_present = true;
+    renderer_set_options(&options);
+    win->apply_options(renderer_get_options());
+    ck_assert(!nonblocking());
+    ck_assert_int_eq(gl_stub_counts.swap_interval, 1);
+    win->destroy();
+}
+END_TEST
+
+Suite *gles2_state_suite(void) {
+    Suite *s = suite_create("GLES2State");
+    TCase *tc = tcase_create("Core");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, test_identical_frame_skips_redundant_state);
+    tcase_add_test(tc, test_repeated_draw_issues_only_the_draw);
+    tcase_add_test(tc, test_separable_blur_restores_state_without_queries);
+    tcase_add_test(tc, test_take_stats_reports_elided_calls);
+    tcase_add_test(tc, test_recycled_texture_name_resets_sampler_state);
+    suite_add_tcase(s, tc);
+
+    TCase *tc_present = tcase_create("Present");
+    tcase_add_test(tc_present, test_blocking_present_follows_render_option);
+    suite_add_tcase(s, tc_present);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = gles2_state_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,151 @@
+// Tests for the GLES3 backend: immutable mipmapped uploads and layer batches
+// drawn as one instanced draw whose buffers change only when the scene does
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/renderer.h"
+#include "include/defaults.h"
+#include "stubs_gl.h"
+
+#define TEST_W 1920
+#define TEST_H 1080
+#define TEST_LAYERS 4
+
+static const renderer_ops_t *ops = &renderer_headless_gles3_ops;
+
+static void setup(void) {
+    render_options_t options = RENDER_OPTIONS_DEFAULTS;
+    renderer_set_options(&options);
+    renderer_config_t config = { .width = TEST_W, .height = TEST_H };
+    ck_assert_int_eq(ops->init(NULL, NULL, &config), HYPRLAX_SUCCESS);
+}
+
+static void teardown(void) {
+    ops->destroy();
+}
+
+static void compile_scene(renderer_draw_packet_t packets[TEST_LAYERS], texture_t textures[TEST_LAYERS],
+                          float scale) {
+    for (int i = 0; i < TEST_LAYERS; i++) {
+        textures[i] = (texture_t){ .id = 10 + (uint32_t)i, .width = 1920 + 200 * i, .height = 1080 };
+        renderer_layer_params_t params = {
+            .fit_mode = 1, .content_scale = scale + 0.1f * (float)i,
+            .align_x = 0.5f, .align_y = 0.5f,
+            .tint_r = 1.0f, .tint_g = 0.5f, .tint_b = 1.0f, .tint_strength = 0.25f * (float)i,
+        };
+        ops->compile_layer(&textures[i], 1.0f - 0.1f * (float)i, 0.0f, &params, &packets[i]);
+    }
+}
+
+static int draw_batch(const renderer_draw_packet_t packets[TEST_LAYERS],
+                      const texture_t textures[TEST_LAYERS], float x) {
+    renderer_packet_draw_t draws[TEST_LAYERS];
+    for (int i = 0; i < TEST_LAYERS; i++) {
+        draws[i] = (renderer_packet_draw_t){ &packets[i], textures[i].id, x * (float)(i + 1), 0.0f };
+    }
+    return ops->draw_packet_batch(draws, TEST_LAYERS);
+}
+
+START_TEST(test_upload_allocates_full_mip_chain)
+{
+    static uint8_t pixels[1920 * 1080 * 4];
+    gl_stub_counts_t before = gl_stub_counts;
+    uint32_t id = ops->upload_texture(pixels, 1920, 1080);
+    ck_assert(id != 0);
+    /* Immutable storage, mipmapped although 1920x1080 is not a power of two */
+    ck_assert_int_eq(gl_stub_counts.tex_storage - before.tex_storage, 1);
+    ck_assert_int_eq(gl_stub_counts.tex_storage_levels, 11);
+    ck_assert_int_eq(gl_stub_counts.tex_images - before.tex_images, 0);
+    ops->delete_texture(id);
+}
+END_TEST
+
+START_TEST(test_layers_share_one_instanced_draw)
+{
+    renderer_draw_packet_t packets[TEST_LAYERS];
+    texture_t textures[TEST_LAYERS];
+    compile_scene(packets, textures, 1.0f);
+
+    gl_stub_counts_t before = gl_stub_counts;
+    ck_assert_int_eq(draw_batch(packets, textures, 0.0f), TEST_LAYERS);
+    ck_assert_int_eq(gl_stub_counts.draws - before.draws, 1);
+    ck_assert_int_eq(gl_stub_counts.instanced_draws - before.instanced_draws, 1);
+    ck_assert_int_eq(gl_stub_counts.instances - before.instances, TEST_LAYERS);
+}
+END_TEST
+
+START_TEST(test_parallax_frames_update_only_the_uniform_block)
+{
+    renderer_draw_packet_t packets[TEST_LAYERS];
+    texture_t textures[TEST_LAYERS];
+    compile_scene(packets, textures, 1.0f);
+    draw_batch(packets, textures, 0.0f);
+
+    for (int frame = 1; frame <= 60; frame++) {
+        gl_stub_counts_t before = gl_stub_counts;
+        ck_assert_int_eq(draw_batch(packets, textures, 0.001f * (float)frame), TEST_LAYERS);
+        /* New offsets: one block upload, no geometry or attribute setup */
+        ck_assert_int_eq(gl_stub_counts.buffer_sub_data - before.buffer_sub_data, 1);
+        ck_assert_int_eq(gl_stub_counts.buffer_data - before.buffer_data, 0);
+        ck_assert_int_eq(gl_stub_counts.attrib_pointers - before.attrib_pointers, 0);
+        ck_assert_int_eq(gl_stub_counts.uniforms - before.uniforms, 0);
+    }
+
+    /* A still frame uploads nothing */
+    gl_stub_counts_t before = gl_stub_counts;
+    draw_batch(packets, textures, 0.001f * 60.0f);
+    ck_assert_int_eq(gl_stub_counts.buffer_sub_data - before.buffer_sub_data, 0);
+}
+END_TEST
+
+START_TEST(test_recompiled_scene_rewrites_instances)
+{
+    renderer_draw_packet_t packets[TEST_LAYERS];
+    texture_t textures[TEST_LAYERS];
+    compile_scene(packets, textures, 1.0f);
+    draw_batch(packets, textures, 0.0f);
+
+    compile_scene(packets, textures, 1.5f);
+    gl_stub_counts_t before = gl_stub_counts;
+    draw_batch(packets, textures, 0.0f);
+    ck_assert_int_eq(gl_stub_counts.buffer_sub_data - before.buffer_sub_data, 1);
+    ck_assert_int_eq(gl_stub_counts.buffer_data - before.buffer_data, 0);
+}
+END_TEST
+
+START_TEST(test_single_pass_off_disables_batches)
+{
+    render_options_t options = RENDER_OPTIONS_DEFAULTS;
+    options.single_pass = false;
+    renderer_set_options(&options);
+    ops->apply_options(renderer_get_options());
+
+    renderer_draw_packet_t packets[TEST_LAYERS];
+    texture_t textures[TEST_LAYERS];
+    compile_scene(packets, textures, 1.0f);
+    ck_assert_int_eq(draw_batch(packets, textures, 0.0f), 0);
+}
+END_TEST
+
+Suite *gles3_suite(void) {
+    Suite *s = suite_create("GLES3");
+    TCase *tc = tcase_create("Core");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, test_upload_allocates_full_mip_chain);
+    tcase_add_test(tc, test_layers_share_one_instanced_draw);
+    tcase_add_test(tc, test_parallax_frames_update_only_the_uniform_block);
+    tcase_add_test(tc, test_recompiled_scene_rewrites_instances);
+    tcase_add_test(tc, test_single_pass_off_disables_batches);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = gles3_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,160 @@
+// Tests for load-time image downscaling
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/core.h"
+
+static uint8_t *make_image(int w, int h, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+    uint8_t *rgba = malloc((size_t)w * h * 4);
+    for (int i = 0; i < w * h; i++) {
+        rgba[i * 4 + 0] = r;
+        rgba[i * 4 + 1] = g;
+        rgba[i * 4 + 2] = b;
+        rgba[i * 4 + 3] = a;
+    }
+    return rgba;
+}
+
+START_TEST(test_resample_keeps_flat_colour)
+{
+    /* Pyramid (4000 -> 2000 -> 1000) then a 1000 -> 750 Lanczos step */
+    uint8_t *src = make_image(4000, 3000, 10, 20, 30, 255);
+    uint8_t *dst = image_resample_rgba(src, 4000, 3000, 750, 563);
+    ck_assert_ptr_nonnull(dst);
+    for (int i = 0; i < 750 * 563; i++) {
+        ck_assert_int_eq(dst[i * 4 + 0], 10);
+        ck_assert_int_eq(dst[i * 4 + 1], 20);
+        ck_assert_int_eq(dst[i * 4 + 2], 30);
+        ck_assert_int_eq(dst[i * 4 + 3], 255);
+    }
+    free(src);
+    free(dst);
+}
+END_TEST
+
+START_TEST(test_resample_halves_exactly)
+{
+    /* 2x2 blocks of one value each average to that value */
+    uint8_t *src = make_image(8, 8, 0, 0, 0, 255);
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            src[(y * 8 + x) * 4 + 0] = (uint8_t)(((y / 2) * 4 + (x / 2)) * 10);
+        }
+    }
+    uint8_t *dst = image_resample_rgba(src, 8, 8, 4, 4);
+    ck_assert_ptr_nonnull(dst);
+    for (int i = 0; i < 16; i++) ck_assert_int_eq(dst[i * 4 + 0], i * 10);
+    free(src);
+    free(dst);
+}
+END_TEST
+
+START_TEST(test_resample_keeps_gradient)
+{
+    uint8_t *src = make_image(1024, 4, 0, 0, 0, 255);
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 1024; x++) src[(y * 1024 + x) * 4 + 0] = (uint8_t)(x / 4);
+    }
+    uint8_t *dst = image_resample_rgba(src, 1024, 4, 300, 2);
+    ck_assert_ptr_nonnull(dst);
+    for (int x = 0; x < 300; x++) {
+        int expected = (int)((x + 0.5f) * 1024.0f / 300.0f / 4.0f);
+        ck_assert_int_le(abs(dst[x * 4 + 0] - expected), 2);
+        if (x > 0) ck_assert_int_ge(dst[x * 4 + 0], dst[(x - 1) * 4 + 0]);
+    }
+    free(src);
+    free(dst);
+}
+END_TEST
+
+START_TEST(test_resample_transparent_colour_does_not_bleed)
+{
+    /* Opaque red next to transparent green: edge texels fade but stay red */
+    uint8_t *src = make_image(600, 300, 255, 0, 0, 255);
+    for (int y = 0; y < 300; y++) {
+        for (int x = 300; x < 600; x++) {
+            uint8_t *p = src + ((size_t)y * 600 + x) * 4;
+            p[0] = 0; p[1] = 255; p[3] = 0;
+        }
+    }
+    uint8_t *dst = image_resample_rgba(src, 600, 300, 170, 85);
+    ck_assert_ptr_nonnull(dst);
+    bool partial = false;
+    for (int i = 0; i < 170 * 85; i++) {
+        const uint8_t *p = dst + i * 4;
+        if (p[3] == 0) continue;
+        ck_assert_int_eq(p[0], 255);
+        ck_assert_int_eq(p[1], 0);
+        if (p[3] < 255) partial = true;
+    }
+    ck_assert(partial);
+    free(src);
+    free(dst);
+}
+END_TEST
+
+START_TEST(test_resample_rejects_bad_sizes)
+{
+    uint8_t *src = make_image(4, 4, 0, 0, 0, 255);
+    ck_assert_ptr_null(image_resample_rgba(src, 4, 4, 0, 2));
+    ck_assert_ptr_null(image_resample_rgba(NULL, 4, 4, 2, 2));
+    free(src);
+}
+END_TEST
+
+START_TEST(test_resample_kernels_match_scalar)
+{
+    /* Odd sizes leave SIMD tails; opaque rows take the fast box path, the
+     * rest mixes alpha */
+    enum { W = 517, H = 301 };
+    uint8_t *src = make_image(W, H, 0, 0, 0, 255);
+    uint32_t state = 12345;
+    for (int i = 0; i < W * H * 4; i++) {
+        state = state * 1664525u + 1013904223u;
+        bool alpha = i % 4 == 3;
+        if (!alpha || (i / (W * 4)) % 3 == 2) src[i] = (uint8_t)(state >> 24);
+    }
+    static const int sizes[][2] = { { 97, 61 }, { 300, 200 }, { 258, 150 } };
+    static const char *isas[] = { "sse2", "avx2" };
+    for (size_t n = 0; n < sizeof(sizes) / sizeof(sizes[0]); n++) {
+        int ow = sizes[n][0], oh = sizes[n][1];
+        ck_assert_str_eq(image_resample_use("scalar"), "scalar");
+        uint8_t *want = image_resample_rgba(src, W, H, ow, oh);
+        ck_assert_ptr_nonnull(want);
+        for (size_t k = 0; k < sizeof(isas) / sizeof(isas[0]); k++) {
+            if (!image_resample_use(isas[k])) continue;
+            uint8_t *got = image_resample_rgba(src, W, H, ow, oh);
+            ck_assert_ptr_nonnull(got);
+            ck_assert_msg(memcmp(got, want, (size_t)ow * oh * 4) == 0, "%s differs at %dx%d", isas[k], ow, oh);
+            free(got);
+        }
+        free(want);
+    }
+    ck_assert_ptr_null(image_resample_use("mmx"));
+    ck_assert_ptr_nonnull(image_resample_use(NULL));
+    free(src);
+}
+END_TEST
+
+Suite *image_resample_suite(void) {
+    Suite *s = suite_create("ImageResample");
+    TCase *tc = tcase_create("Core");
+    tcase_add_test(tc, test_resample_keeps_flat_colour);
+    tcase_add_test(tc, test_resample_halves_exactly);
+    tcase_add_test(tc, test_resample_keeps_gradient);
+    tcase_add_test(tc, test_resample_transparent_colour_does_not_bleed);
+    tcase_add_test(tc, test_resample_rejects_bad_sizes);
+    tcase_add_test(tc, test_resample_kernels_match_scalar);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = image_resample_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,91 @@
+// Tests for load-time alpha analysis of layer images
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/core.h"
+
+static uint8_t *make_image(int w, int h, uint8_t alpha) {
+    uint8_t *rgba = malloc((size_t)w * h * 4);
+    for (int i = 0; i < w * h; i++) {
+        rgba[i * 4 + 0] = 10;
+        rgba[i * 4 + 1] = 20;
+        rgba[i * 4 + 2] = 30;
+        rgba[i * 4 + 3] = alpha;
+    }
+    return rgba;
+}
+
+START_TEST(test_alpha_opaque_image)
+{
+    uint8_t *rgba = make_image(16, 8, 255);
+    bool opaque = false;
+    int bbox[4];
+    layer_analyze_alpha(rgba, 16, 8, &opaque, bbox);
+    ck_assert(opaque);
+    ck_assert_int_eq(bbox[0], 0);
+    ck_assert_int_eq(bbox[1], 0);
+    ck_assert_int_eq(bbox[2], 16);
+    ck_assert_int_eq(bbox[3], 8);
+    free(rgba);
+}
+END_TEST
+
+START_TEST(test_alpha_bbox_of_visible_texels)
+{
+    uint8_t *rgba = make_image(16, 8, 0);
+    /* Visible texels at (3, 2) and (9, 5), one translucent */
+    rgba[(2 * 16 + 3) * 4 + 3] = 255;
+    rgba[(5 * 16 + 9) * 4 + 3] = 40;
+    bool opaque = true;
+    int bbox[4];
+    layer_analyze_alpha(rgba, 16, 8, &opaque, bbox);
+    ck_assert(!opaque);
+    ck_assert_int_eq(bbox[0], 3);
+    ck_assert_int_eq(bbox[1], 2);
+    ck_assert_int_eq(bbox[2], 7);
+    ck_assert_int_eq(bbox[3], 4);
+    free(rgba);
+}
+END_TEST
+
+START_TEST(test_alpha_transparent_and_partial)
+{
+    uint8_t *rgba = make_image(4, 4, 0);
+    bool opaque = true;
+    int bbox[4] = { 1, 1, 1, 1 };
+    layer_analyze_alpha(rgba, 4, 4, &opaque, bbox);
+    ck_assert(!opaque);
+    ck_assert_int_eq(bbox[2], 0);
+    ck_assert_int_eq(bbox[3], 0);
+
+    /* A single translucent texel breaks opacity but keeps the full box */
+    memset(rgba, 255, 4 * 4 * 4);
+    rgba[(1 * 4 + 1) * 4 + 3] = 254;
+    layer_analyze_alpha(rgba, 4, 4, &opaque, bbox);
+    ck_assert(!opaque);
+    ck_assert_int_eq(bbox[2], 4);
+    ck_assert_int_eq(bbox[3], 4);
+    free(rgba);
+}
+END_TEST
+
+Suite *layer_alpha_suite(void) {
+    Suite *s = suite_create("LayerAlpha");
+    TCase *tc = tcase_create("Core");
+    tcase_add_test(tc, test_alpha_opaque_image);
+    tcase_add_test(tc, test_alpha_bbox_of_visible_texels);
+    tcase_add_test(tc, test_alpha_transparent_and_partial);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = layer_alpha_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_FORK);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
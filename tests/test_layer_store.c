@@ -0,0 +1,122 @@
+// Tests for the structure-of-arrays layer store
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/core.h"
+
+static parallax_layer_t *make_list(int n) {
+    parallax_layer_t *head = NULL;
+    for (int i = 0; i < n; i++) {
+        parallax_layer_t *layer = layer_create("layer.png", 0.5f + 0.1f * i, 1.0f);
+        head = layer_list_add(head, layer);
+    }
+    return head;
+}
+
+START_TEST(test_store_index_matches_list)
+{
+    parallax_layer_t *head = make_list(300);
+    layer_store_t store;
+    memset(&store, 0, sizeof(store));
+
+    ck_assert_int_eq(layer_store_refresh(&store, head), HYPRLAX_SUCCESS);
+    ck_assert_int_eq(store.count, 300);
+
+    int slot = 0;
+    for (parallax_layer_t *it = head; it; it = it->next, slot++) {
+        ck_assert_int_eq(layer_store_slot(&store, it->id), slot);
+        ck_assert_ptr_eq(layer_store_find(&store, it->id), it);
+        ck_assert_float_eq_tol(store.shift[slot], it->shift_multiplier, 1e-6);
+    }
+    ck_assert_int_eq(layer_store_slot(&store, 0xFFFFFFFFu), -1);
+
+    /* Invalidated stores refuse lookups until refreshed */
+    layer_store_invalidate(&store);
+    ck_assert_ptr_null(layer_store_find(&store, head->id));
+
+    layer_store_destroy(&store);
+    layer_list_destroy(head);
+}
+END_TEST
+
+START_TEST(test_store_tick_matches_layer_tick)
+{
+    parallax_layer_t *head = make_list(1);
+    parallax_layer_t *ref = layer_create("ref.png", 1.0f, 1.0f);
+    layer_store_t store;
+    memset(&store, 0, sizeof(store));
+    ck_assert_int_eq(layer_store_refresh(&store, head), HYPRLAX_SUCCESS);
+
+    layer_store_animate_to(&store, 0, 200.0f, -50.0f, 1.0, EASE_CUBIC_OUT);
+    layer_update_offset(ref, 200.0f, -50.0f, 1.0, EASE_CUBIC_OUT);
+    ck_assert(layer_store_animating(&store));
+
+    const double times[] = { 10.0, 10.25, 10.5, 10.9, 11.0, 11.5 };
+    for (size_t i = 0; i < sizeof(times) / sizeof(times[0]); i++) {
+        layer_store_tick(&store, times[i]);
+        layer_tick(ref, times[i]);
+        ck_assert_float_eq_tol(store.current_x[0], ref->current_x, 1e-4);
+        ck_assert_float_eq_tol(store.current_y[0], ref->current_y, 1e-4);
+        /* Offsets are written back to the owning node */
+        ck_assert_float_eq_tol(head->current_x, ref->current_x, 1e-4);
+    }
+    ck_assert(!layer_store_animating(&store));
+    ck_assert(!layer_store_tick(&store, 12.0));
+
+    layer_destroy(ref);
+    layer_store_destroy(&store);
+    layer_list_destroy(head);
+}
+END_TEST
+
+START_TEST(test_store_rebuild_keeps_animation)
+{
+    parallax_layer_t *head = make_list(3);
+    layer_store_t store;
+    memset(&store, 0, sizeof(store));
+    ck_assert_int_eq(layer_store_refresh(&store, head), HYPRLAX_SUCCESS);
+
+    uint32_t id = head->next->id;
+    layer_store_animate_to(&store, 1, 100.0f, 0.0f, 1.0, EASE_LINEAR);
+    layer_store_tick(&store, 1.0);
+    layer_store_tick(&store, 1.5);
+    float mid = store.current_x[1];
+    ck_assert_float_eq_tol(mid, 50.0f, 1e-3);
+
+    /* Remove the first layer: the animated one moves to slot 0 */
+    head = layer_list_remove(head, head->id);
+    layer_store_invalidate(&store);
+    ck_assert_int_eq(layer_store_refresh(&store, head), HYPRLAX_SUCCESS);
+    ck_assert_int_eq(store.count, 2);
+    ck_assert_int_eq(layer_store_slot(&store, id), 0);
+    ck_assert_float_eq_tol(store.current_x[0], mid, 1e-6);
+    ck_assert_int_eq(store.active_count, 1);
+
+    layer_store_tick(&store, 2.0);
+    ck_assert_float_eq_tol(store.current_x[0], 100.0f, 1e-6);
+
+    layer_store_destroy(&store);
+    layer_list_destroy(head);
+}
+END_TEST
+
+Suite *layer_store_suite(void) {
+    Suite *s = suite_create("LayerStore");
+    TCase *tc = tcase_create("Core");
+    tcase_add_test(tc, test_store_index_matches_list);
+    tcase_add_test(tc, test_store_tick_matches_layer_tick);
+    tcase_add_test(tc, test_store_rebuild_keeps_animation);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = layer_store_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_FORK);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,417 @@
+// Tests for the render core driven through headless mode against the
+// counting GL stubs: texture planning, refits and sharing across reloads,
+// and the composite of unchanged bottom layers
+#include <check.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "include/hyprlax.h"
+#include "core/monitor.h"
+#include "stubs_gl.h"
+
+/* Headless mode needs neither a compositor nor a platform */
+int compositor_create_by_name(compositor_adapter_t **adapter, const char *name) {
+    (void)adapter; (void)name;
+    return HYPRLAX_ERROR_INVALID_ARGS;
+}
+void compositor_destroy(compositor_adapter_t *adapter) { (void)adapter; }
+int platform_create_by_name(platform_t **platform, const char *name) {
+    (void)platform; (void)name;
+    return HYPRLAX_ERROR_INVALID_ARGS;
+}
+void platform_destroy(platform_t *platform) { (void)platform; }
+
+static char dir[64];
+static char config_path[128];
+static hyprlax_context_t *ctx;
+
+static void setup(void) {
+    snprintf(dir, sizeof(dir), "/tmp/hyprlax-render-core-XXXXXX");
+    ck_assert_ptr_nonnull(mkdtemp(dir));
+    snprintf(config_path, sizeof(config_path), "%s/hyprlax.toml", dir);
+    gl_stub_max_texture_size = 16384;
+    ctx = NULL;
+}
+
+static void teardown(void) {
+    if (ctx) hyprlax_destroy(ctx);
+    ctx = NULL;
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+    ck_assert_int_eq(system(cmd), 0);
+}
+
+/* An opaque width x height image in dir (stb reads binary PPM) */
+static void write_image(const char *name, int width, int height, unsigned char shade) {
+    char path[192];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *f = fopen(path, "wb");
+    ck_assert_ptr_nonnull(f);
+    fprintf(f, "P6\n%d %d\n255\n", width, height);
+    for (int i = 0; i < width * height; i++) {
+        unsigned char px[3] = { shade, (unsigned char)(i % 251), (unsigned char)(i % 241) };
+        fwrite(px, 1, sizeof(px), f);
+    }
+    fclose(f);
+}
+
+/* A new mtime: a reload has to decode the image again rather than share
+ * the texture already registered for it */
+static void touch_image(const char *name) {
+    char path[192];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    struct timespec times[2] = { { 0, UTIME_OMIT }, { 1000000000, 0 } };
+    ck_assert_int_eq(utimensat(AT_FDCWD, path, times, 0), 0);
+}
+
+static void write_config(const char *toml) {
+    FILE *f = fopen(config_path, "w");
+    ck_assert_ptr_nonnull(f);
+    fputs(toml, f);
+    fclose(f);
+}
+
+/* Start headless on a 320x200 output with the config written above, and
+ * let every image decode and upload */
+static void start(void) {
+    ctx = hyprlax_create();
+    ck_assert_ptr_nonnull(ctx);
+    char *argv[] = { "hyprlax", "--headless", "--headless-size", "320x200", "--config", config_path, NULL };
+    optind = 0;
+    ck_assert_int_eq(hyprlax_init(ctx, 6, argv), HYPRLAX_SUCCESS);
+    hyprlax_finish_texture_decodes(ctx);
+    hyprlax_render_frame(ctx);
+}
+
+static parallax_layer_t *layer_at(int index) {
+    parallax_layer_t *layer = ctx->layers;
+    for (int i = 0; layer && i < index; i++) layer = layer->next;
+    ck_assert_ptr_nonnull(layer);
+    return layer;
+}
+
+/* Frames until decodes and uploads settle; the image cache stays off */
+static void run_frames(int frames) {
+    for (int i = 0; i < frames; i++) {
+        hyprlax_finish_texture_decodes(ctx);
+        monitor_list_mark_dirty(ctx->monitors);
+        hyprlax_render_frame(ctx);
+    }
+}
+
+START_TEST(test_layer_at_gpu_limit_loads_once)
+{
+    /* A repeating layer cannot tile: over the limit it is resampled to it,
+     * which is still fewer texels than the output samples */
+    gl_stub_max_texture_size = 64;
+    write_image("wide.ppm", 400, 100, 0x80);
+    write_config("[global.render]\n"
+                 "image_cache = 0\n"
+                 "[[global.layers]]\n"
+                 "path = \"wide.ppm\"\n"
+                 "overflow = \"repeat\"\n");
+    start();
+    parallax_layer_t *layer = layer_at(0);
+    ck_assert_uint_ne(layer->texture_id, 0);
+    ck_assert_int_eq(layer->texture_width, 64);
+    ck_assert_int_eq(layer->width, 400);
+
+    uint32_t texture = layer->texture_id;
+    gl_stub_counts_t before = gl_stub_counts;
+    touch_image("wide.ppm");
+    hyprlax_mark_layers_changed(ctx);
+    run_frames(4);
+    ck_assert_uint_eq(layer->texture_id, texture);
+    ck_assert_uint_eq(layer->pending.texture, 0);
+    ck_assert_uint_eq(layer->decode_ticket, 0);
+    ck_assert_int_eq(gl_stub_counts.delete_textures - before.delete_textures, 0);
+}
+END_TEST
+
+START_TEST(test_reload_reuses_kept_textures)
+{
+    /* Properties applied after the layer is added change the texture's
+     * plan, and with it the key it is shared under */
+    write_image("a.ppm", 640, 400, 0x20);
+    write_image("b.ppm", 640, 400, 0xa0);
+    write_config("[global.render]\n"
+                 "image_cache = 0\n"
+                 "[[global.layers]]\n"
+                 "path = \"a.ppm\"\n"
+                 "fit = \"contain\"\n"
+                 "overflow = \"none\"\n"
+                 "shift_multiplier = 0.5\n"
+                 "[[global.layers]]\n"
+                 "path = \"b.ppm\"\n"
+                 "blur = 2.0\n"
+                 "shift_multiplier = { x = 0.2, y = 0.0 }\n");
+    start();
+    uint32_t textures[2] = { layer_at(0)->texture_id, layer_at(1)->texture_id };
+    ck_assert_uint_ne(textures[0], 0);
+    ck_assert_uint_ne(textures[1], 0);
+    ck_assert_uint_ne(textures[0], textures[1]);
+
+    gl_stub_counts_t before = gl_stub_counts;
+    ck_assert_int_eq(hyprlax_reload_config(ctx), HYPRLAX_SUCCESS);
+    run_frames(3);
+    ck_assert_uint_eq(layer_at(0)->texture_id, textures[0]);
+    ck_assert_uint_eq(layer_at(1)->texture_id, textures[1]);
+    ck_assert_int_eq(gl_stub_counts.tex_images - before.tex_images, 0);
+    ck_assert_int_eq(gl_stub_counts.delete_textures - before.delete_textures, 0);
+}
+END_TEST
+
+START_TEST(test_added_layer_queued_with_its_properties)
+{
+    write_image("a.ppm", 640, 400, 0x20);
+    write_config("[global.render]\n"
+                 "image_cache = 0\n"
+                 "[[global.layers]]\n"
+                 "path = \"a.ppm\"\n");
+    start();
+    uint32_t first = layer_at(0)->texture_id;
+
+    /* As IPC add does: add, then set properties; the same image with the
+     * same properties shares the first layer's texture */
+    char path[192];
+    snprintf(path, sizeof(path), "%s/a.ppm", dir);
+    ck_assert_int_eq(hyprlax_add_layer(ctx, path, 1.0f, 1.0f, 0.0f), HYPRLAX_SUCCESS);
+    ck_assert_uint_eq(layer_at(1)->texture_id, 0);
+    ck_assert_int_eq(hyprlax_add_layer(ctx, path, 1.0f, 1.0f, 0.0f), HYPRLAX_SUCCESS);
+    char prop[64];
+    snprintf(prop, sizeof(prop), "layer.%u.fit", layer_at(2)->id);
+    ck_assert_int_eq(hyprlax_runtime_set_property(ctx, prop, "contain"), 0);
+    run_frames(2);
+    ck_assert_uint_eq(layer_at(1)->texture_id, first);
+    ck_assert_uint_ne(layer_at(2)->texture_id, 0);
+    ck_assert_uint_ne(layer_at(2)->texture_id, first);
+}
+END_TEST
+
+START_TEST(test_layer_made_croppable_is_cropped)
+{
+    /* Only a window of the wide image is ever on screen */
+    write_image("wide.ppm", 2000, 200, 0x60);
+    write_config("[global.parallax]\n"
+                 "max_offset_px = { x = 0.0, y = 0.0 }\n"
+                 "[global.render]\n"
+                 "image_cache = 0\n"
+                 "[[global.layers]]\n"
+                 "path = \"wide.ppm\"\n"
+                 "shift_multiplier = 0.0\n");
+    start();
+    run_frames(2);
+    parallax_layer_t *layer = layer_at(0);
+    ck_assert_float_eq(layer->crop[2], 0.0f);
+    ck_assert_int_eq(layer->texture_width, 2000);
+
+    char prop[64];
+    snprintf(prop, sizeof(prop), "layer.%u.overflow", layer->id);
+    ck_assert_int_eq(hyprlax_runtime_set_property(ctx, prop, "none"), 0);
+    run_frames(3);
+    ck_assert_float_gt(layer->crop[2], 0.0f);
+    ck_assert_int_lt(layer->texture_width, 2000);
+    ck_assert_int_eq(layer->width, 2000);
+
+    /* Repeating needs the whole image again */
+    ck_assert_int_eq(hyprlax_runtime_set_property(ctx, prop, "repeat"), 0);
+    run_frames(3);
+    ck_assert_float_eq(layer->crop[2], 0.0f);
+    ck_assert_int_eq(layer->texture_width, 2000);
+}
+END_TEST
+
+START_TEST(test_added_layer_cropped)
+{
+    write_image("a.ppm", 640, 400, 0x20);
+    write_image("wide.ppm", 2000, 200, 0x60);
+    write_config("[global.parallax]\n"
+                 "max_offset_px = { x = 0.0, y = 0.0 }\n"
+                 "[global.render]\n"
+                 "image_cache = 0\n"
+                 "[[global.layers]]\n"
+                 "path = \"a.ppm\"\n");
+    start();
+
+    char path[192];
+    snprintf(path, sizeof(path), "%s/wide.ppm", dir);
+    ck_assert_int_eq(hyprlax_add_layer(ctx, path, 0.0f, 1.0f, 0.0f), HYPRLAX_SUCCESS);
+    parallax_layer_t *layer = layer_at(1);
+    char prop[64];
+    snprintf(prop, sizeof(prop), "layer.%u.overflow", layer->id);
+    ck_assert_int_eq(hyprlax_runtime_set_property(ctx, prop, "none"), 0);
+    gl_stub_counts_t before = gl_stub_counts;
+    run_frames(3);
+    ck_assert_float_gt(layer->crop[2], 0.0f);
+    ck_assert_int_lt(layer->texture_width, 2000);
+    /* Planned cropped from the start, not reloaded to crop it */
+    ck_assert_int_eq(gl_stub_counts.delete_textures - before.delete_textures, 0);
+}
+END_TEST
+
+/* Three translucent layers (nothing occludes), all on the composite path */
+static void start_stack(void) {
+    write_image("a.ppm", 320, 200, 0x20);
+    write_image("b.ppm", 320, 200, 0x60);
+    write_image("c.ppm", 320, 200, 0xa0);
+    write_image("d.ppm", 320, 200, 0xe0);
+    write_config("[global.render]\n"
+                 "image_cache = 0\n"
+                 "[[global.layers]]\n"
+                 "path = \"a.ppm\"\n"
+                 "opacity = 0.9\n"
+                 "[[global.layers]]\n"
+                 "path = \"b.ppm\"\n"
+                 "opacity = 0.9\n"
+                 "[[global.layers]]\n"
+                 "path = \"c.ppm\"\n"
+                 "opacity = 0.9\n");
+    start();
+    run_frames(2);
+}
+
+/* Land layer index on a new parallax offset, as a finished animation does */
+static void move_layer(int index, float x) {
+    layer_store_t *store = &ctx->layer_store;
+    layer_store_refresh(store, ctx->layers);
+    int slot = layer_store_slot(store, layer_at(index)->id);
+    ck_assert_int_ge(slot, 0);
+    layer_store_animate_to(store, slot, x, 0.0f, 0.001, EASE_LINEAR);
+    layer_store_tick(store, 0.0);
+    layer_store_tick(store, 1.0);
+}
+
+/* One frame after moving only the top layer; true if it flattened the
+ * layers below into the composite again */
+static bool top_move_rebuilds(float x) {
+    move_layer(2, x);
+    gl_stub_counts_t before = gl_stub_counts;
+    run_frames(1);
+    ck_assert_int_eq(gl_stub_counts.swaps - before.swaps, 1);
+    int binds = gl_stub_counts.target_binds - before.target_binds;
+    if (binds == 0) {
+        /* Composite blit, then the top layer; the blit replaces the clear */
+        ck_assert_int_eq(gl_stub_counts.draws - before.draws, 2);
+        ck_assert_int_eq(gl_stub_counts.clears - before.clears, 0);
+    }
+    return binds > 0;
+}
+
+START_TEST(test_unchanged_frame_issues_nothing)
+{
+    start_stack();
+    gl_stub_counts_t before = gl_stub_counts;
+    run_frames(3);
+    ck_assert_int_eq(gl_stub_counts.draws - before.draws, 0);
+    ck_assert_int_eq(gl_stub_counts.swaps - before.swaps, 0);
+    ck_assert_int_eq(gl_stub_counts.clears - before.clears, 0);
+}
+END_TEST
+
+START_TEST(test_composite_kept_while_bottom_layers_unchanged)
+{
+    start_stack();
+    ck_assert(top_move_rebuilds(10.0f));
+    ck_assert(!top_move_rebuilds(20.0f));
+    ck_assert(!top_move_rebuilds(30.0f));
+}
+END_TEST
+
+START_TEST(test_composite_rebuilt_when_bottom_offset_changes)
+{
+    start_stack();
+    ck_assert(top_move_rebuilds(10.0f));
+    move_layer(0, 15.0f);
+    run_frames(1);
+    ck_assert(top_move_rebuilds(20.0f));
+    ck_assert(!top_move_rebuilds(30.0f));
+}
+END_TEST
+
+START_TEST(test_composite_rebuilt_when_bottom_texture_changes)
+{
+    start_stack();
+    ck_assert(top_move_rebuilds(10.0f));
+    uint32_t texture = layer_at(0)->texture_id;
+    char prop[64], path[192];
+    snprintf(prop, sizeof(prop), "layer.%u.path", layer_at(0)->id);
+    snprintf(path, sizeof(path), "%s/d.ppm", dir);
+    ck_assert_int_eq(hyprlax_runtime_set_property(ctx, prop, path), 0);
+    run_frames(2);
+    ck_assert_uint_ne(layer_at(0)->texture_id, texture);
+    ck_assert(top_move_rebuilds(20.0f));
+    ck_assert(!top_move_rebuilds(30.0f));
+}
+END_TEST
+
+START_TEST(test_composite_rebuilt_when_bottom_properties_change)
+{
+    start_stack();
+    ck_assert(top_move_rebuilds(10.0f));
+    char prop[64];
+    snprintf(prop, sizeof(prop), "layer.%u.content_scale", layer_at(1)->id);
+    ck_assert_int_eq(hyprlax_runtime_set_property(ctx, prop, "1.5"), 0);
+    run_frames(1);
+    ck_assert(top_move_rebuilds(20.0f));
+    ck_assert(!top_move_rebuilds(30.0f));
+
+    snprintf(prop, sizeof(prop), "layer.%u.blur", layer_at(0)->id);
+    ck_assert_int_eq(hyprlax_runtime_set_property(ctx, prop, "2.0"), 0);
+    run_frames(1);
+    ck_assert(top_move_rebuilds(40.0f));
+    ck_assert(!top_move_rebuilds(50.0f));
+}
+END_TEST
+
+START_TEST(test_released_output_frees_composite_target)
+{
+    start_stack();
+    ck_assert(top_move_rebuilds(10.0f));
+    monitor_instance_t *monitor = ctx->monitors->head;
+    ck_assert_uint_ne(monitor->composite_target, 0);
+    gl_stub_counts_t before = gl_stub_counts;
+    hyprlax_render_release_output(ctx, monitor);
+    ck_assert_uint_eq(monitor->composite_target, 0);
+    ck_assert_int_eq(gl_stub_counts.delete_textures - before.delete_textures, 1);
+    /* The next frame flattens into a fresh target */
+    ck_assert(top_move_rebuilds(20.0f));
+    ck_assert_uint_ne(monitor->composite_target, 0);
+}
+END_TEST
+
+Suite *render_core_suite(void) {
+    Suite *s = suite_create("RenderCore");
+    TCase *tc = tcase_create("Textures");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, test_layer_at_gpu_limit_loads_once);
+    tcase_add_test(tc, test_reload_reuses_kept_textures);
+    tcase_add_test(tc, test_added_layer_queued_with_its_properties);
+    tcase_add_test(tc, test_layer_made_croppable_is_cropped);
+    tcase_add_test(tc, test_added_layer_cropped);
+    suite_add_tcase(s, tc);
+
+    TCase *tc_composite = tcase_create("Composite");
+    tcase_add_checked_fixture(tc_composite, setup, teardown);
+    tcase_add_test(tc_composite, test_unchanged_frame_issues_nothing);
+    tcase_add_test(tc_composite, test_composite_kept_while_bottom_layers_unchanged);
+    tcase_add_test(tc_composite, test_composite_rebuilt_when_bottom_offset_changes);
+    tcase_add_test(tc_composite, test_composite_rebuilt_when_bottom_texture_changes);
+    tcase_add_test(tc_composite, test_composite_rebuilt_when_bottom_properties_change);
+    tcase_add_test(tc_composite, test_released_output_frees_composite_target);
+    suite_add_tcase(s, tc_composite);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = render_core_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,163 @@
+// Tests for render options: defaults, environment (canonical and legacy
+// names) and the by-name set/get behind the IPC render.* properties
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/render_options.h"
+
+static const char *k_env[] = {
+    "HYPRLAX_RENDER_SEPARABLE_BLUR", "HYPRLAX_RENDER_BLUR_DOWNSCALE", "HYPRLAX_RENDER_GL_FINISH",
+    "HYPRLAX_RENDER_SINGLE_PASS", "HYPRLAX_RENDER_TINT",
+    "HYPRLAX_SEPARABLE_BLUR", "HYPRLAX_BLUR_DOWNSCALE", "HYPRLAX_NO_GLFINISH",
+    "HYPRLAX_SINGLE_PASS", "HYPRLAX_DISABLE_TINT", "HYPRLAX_FRAME_CALLBACK",
+    "HYPRLAX_BLOCKING_PRESENT", "HYPRLAX_RENDER_BLOCKING_PRESENT",
+};
+
+static void clear_env(void) {
+    for (size_t i = 0; i < sizeof(k_env) / sizeof(k_env[0]); i++) unsetenv(k_env[i]);
+}
+
+START_TEST(test_defaults)
+{
+    render_options_t opts = RENDER_OPTIONS_DEFAULTS;
+    ck_assert(opts.uniform_offset);
+    ck_assert(opts.gl_finish);
+    ck_assert(opts.single_pass);
+    ck_assert(opts.tint);
+    ck_assert(opts.tint_on_blur);
+    ck_assert(opts.blur_cache);
+    ck_assert(opts.image_downscale);
+    ck_assert(opts.image_crop);
+    ck_assert_int_eq(opts.tile_budget, HYPRLAX_TILE_BUDGET_MB);
+    ck_assert_int_eq(opts.decode_threads, HYPRLAX_DECODE_THREADS);
+    ck_assert_int_eq(opts.image_cache, HYPRLAX_IMAGE_CACHE_MB);
+    ck_assert(!opts.separable_blur);
+    ck_assert(!opts.frame_callback);
+    ck_assert(!opts.blocking_present);
+    ck_assert_int_eq(opts.blur_downscale, 0);
+}
+END_TEST
+
+START_TEST(test_env_canonical_names)
+{
+    clear_env();
+    setenv("HYPRLAX_RENDER_SEPARABLE_BLUR", "true", 1);
+    setenv("HYPRLAX_RENDER_BLUR_DOWNSCALE", "2", 1);
+    setenv("HYPRLAX_RENDER_SINGLE_PASS", "off", 1);
+    render_options_t opts = RENDER_OPTIONS_DEFAULTS;
+    render_options_apply_env(&opts);
+    ck_assert(opts.separable_blur);
+    ck_assert_int_eq(opts.blur_downscale, 2);
+    ck_assert(!opts.single_pass);
+    clear_env();
+}
+END_TEST
+
+START_TEST(test_env_legacy_names)
+{
+    clear_env();
+    setenv("HYPRLAX_SEPARABLE_BLUR", "yes-please", 1);  /* any value enabled it */
+    setenv("HYPRLAX_NO_GLFINISH", "1", 1);
+    setenv("HYPRLAX_DISABLE_TINT", "1", 1);
+    setenv("HYPRLAX_FRAME_CALLBACK", "1", 1);
+    setenv("HYPRLAX_BLOCKING_PRESENT", "1", 1);
+    render_options_t opts = RENDER_OPTIONS_DEFAULTS;
+    render_options_apply_env(&opts);
+    ck_assert(opts.separable_blur);
+    ck_assert(!opts.gl_finish);
+    ck_assert(!opts.tint);
+    ck_assert(opts.frame_callback);
+    ck_assert(opts.blocking_present);
+
+    /* ...except "0", which always meant off */
+    setenv("HYPRLAX_BLOCKING_PRESENT", "0", 1);
+    render_options_apply_env(&opts);
+    ck_assert(!opts.blocking_present);
+
+    /* The canonical name wins over the legacy one */
+    setenv("HYPRLAX_RENDER_GL_FINISH", "1", 1);
+    render_options_apply_env(&opts);
+    ck_assert(opts.gl_finish);
+    clear_env();
+}
+END_TEST
+
+START_TEST(test_env_invalid_values_ignored)
+{
+    clear_env();
+    setenv("HYPRLAX_RENDER_TINT", "maybe", 1);
+    setenv("HYPRLAX_RENDER_BLUR_DOWNSCALE", "64", 1);
+    render_options_t opts = RENDER_OPTIONS_DEFAULTS;
+    render_options_apply_env(&opts);
+    ck_assert(opts.tint);
+    ck_assert_int_eq(opts.blur_downscale, 0);
+    clear_env();
+}
+END_TEST
+
+START_TEST(test_set_get_by_name)
+{
+    render_options_t opts = RENDER_OPTIONS_DEFAULTS;
+    char buf[32];
+
+    ck_assert_int_eq(render_options_set(&opts, "single_pass", "false"), 0);
+    ck_assert(!opts.single_pass);
+    ck_assert_int_eq(render_options_get(&opts, "single_pass", buf, sizeof(buf)), 0);
+    ck_assert_str_eq(buf, "false");
+
+    ck_assert_int_eq(render_options_set(&opts, "blur_downscale", "3"), 0);
+    ck_assert_int_eq(render_options_get(&opts, "blur_downscale", buf, sizeof(buf)), 0);
+    ck_assert_str_eq(buf, "3");
+
+    ck_assert_int_eq(render_options_set(&opts, "blur_downscale", "-1"), -1);
+    ck_assert_int_eq(render_options_set(&opts, "blur_downscale", "x"), -1);
+    ck_assert_int_eq(render_options_set(&opts, "tint", "sometimes"), -1);
+    ck_assert_int_eq(render_options_set(&opts, "no_such_option", "1"), -1);
+    ck_assert_int_eq(render_options_get(&opts, "no_such_option", buf, sizeof(buf)), -1);
+    ck_assert_int_eq(opts.blur_downscale, 3);
+
+    /* Integer options have their own ranges */
+    ck_assert_int_eq(render_options_set(&opts, "upload_budget", "5000"), 0);
+    ck_assert_int_eq(opts.upload_budget, 5000);
+    ck_assert_int_eq(render_options_set(&opts, "blur_downscale", "5000"), -1);
+    ck_assert_int_eq(render_options_set(&opts, "upload_budget", "1000000"), -1);
+}
+END_TEST
+
+START_TEST(test_names_enumerate)
+{
+    int count = 0;
+    render_options_t opts = RENDER_OPTIONS_DEFAULTS;
+    char buf[32];
+    for (const char *name; (name = render_options_name(count)); count++) {
+        ck_assert_int_eq(render_options_get(&opts, name, buf, sizeof(buf)), 0);
+    }
+    ck_assert(count > 0);
+    ck_assert(render_options_is_int("blur_downscale"));
+    ck_assert(!render_options_is_int("tint"));
+}
+END_TEST
+
+Suite *render_options_suite(void) {
+    Suite *s = suite_create("RenderOptions");
+    TCase *tc = tcase_create("Core");
+    tcase_add_test(tc, test_defaults);
+    tcase_add_test(tc, test_env_canonical_names);
+    tcase_add_test(tc, test_env_legacy_names);
+    tcase_add_test(tc, test_env_invalid_values_ignored);
+    tcase_add_test(tc, test_set_get_by_name);
+    tcase_add_test(tc, test_names_enumerate);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = render_options_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,304 @@
+// Tests for the render thread: triple buffer hand-off and snapshot
+// consistency while IPC-style edits hammer layers during animations
+#include <check.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "include/render_thread.h"
+
+/* ---- Render core and renderer stand-ins ------------------------------- */
+
+#define MAX_TEXTURES 4096
+
+static renderer_dispatch_fn g_dispatch;
+static pthread_t g_context_owner;
+static atomic_bool g_context_bound;
+static atomic_bool g_texture_live[MAX_TEXTURES];
+static atomic_int g_next_texture;
+static atomic_int g_errors;
+static atomic_int g_frames;
+static double g_last_frame_time;
+static float g_tick;
+
+void renderer_set_dispatch(renderer_dispatch_fn dispatch) { g_dispatch = dispatch; }
+
+static bool on_context_thread(void) {
+    return atomic_load(&g_context_bound) && pthread_equal(pthread_self(), g_context_owner);
+}
+
+static void mock_release_context(void) {
+    if (!on_context_thread()) atomic_fetch_add(&g_errors, 1);
+    atomic_store(&g_context_bound, false);
+}
+
+static int mock_bind_context(void) {
+    if (atomic_load(&g_context_bound)) atomic_fetch_add(&g_errors, 1);
+    g_context_owner = pthread_self();
+    atomic_store(&g_context_bound, true);
+    return HYPRLAX_SUCCESS;
+}
+
+/* Banded uploads touch the context: only its owner may pump them */
+bool renderer_pump_uploads(void) {
+    if (!on_context_thread()) atomic_fetch_add(&g_errors, 1);
+    return false;
+}
+
+static const renderer_ops_t mock_ops = {
+    .release_context = mock_release_context,
+    .bind_context = mock_bind_context,
+};
+
+typedef struct { uint32_t id; } texture_job_t;
+
+static void upload_job(void *arg) {
+    texture_job_t *job = arg;
+    if (!on_context_thread()) atomic_fetch_add(&g_errors, 1);
+    job->id = (uint32_t)atomic_fetch_add(&g_next_texture, 1);
+    atomic_store(&g_texture_live[job->id], true);
+}
+
+static void delete_job(void *arg) {
+    texture_job_t *job = arg;
+    if (!on_context_thread()) atomic_fetch_add(&g_errors, 1);
+    atomic_store(&g_texture_live[job->id], false);
+}
+
+/* Same routing as renderer_upload_texture/renderer_delete_texture */
+static uint32_t upload_texture(void) {
+    texture_job_t job = { 0 };
+    if (g_dispatch) g_dispatch(upload_job, &job);
+    else upload_job(&job);
+    return job.id;
+}
+
+static void delete_texture(uint32_t id) {
+    texture_job_t job = { id };
+    if (g_dispatch) g_dispatch(delete_job, &job);
+    else delete_job(&job);
+}
+
+void hyprlax_render_inputs(hyprlax_context_t *ctx, monitor_instance_t *monitor, render_inputs_t *out) {
+    (void)ctx;
+    memset(out, 0, sizeof(*out));
+    out->present_target = monitor->present_target;
+    out->cursor_x = g_tick;
+    out->cursor_y = g_tick;
+}
+
+bool hyprlax_render_blocked(hyprlax_context_t *ctx, monitor_instance_t *monitor) {
+    (void)ctx;
+    return monitor->frame_pending;
+}
+
+/* Draw: every texture referenced must be alive, every edit whole */
+bool hyprlax_render_output(hyprlax_context_t *ctx, monitor_instance_t *monitor,
+                           const render_inputs_t *inputs, bool recompile) {
+    (void)monitor;
+    (void)recompile;
+    if (!on_context_thread()) atomic_fetch_add(&g_errors, 1);
+    if (inputs->cursor_x != inputs->cursor_y) atomic_fetch_add(&g_errors, 1);
+    if (ctx->frame_target_time < g_last_frame_time) atomic_fetch_add(&g_errors, 1);
+    g_last_frame_time = ctx->frame_target_time;
+    for (parallax_layer_t *l = ctx->layers; l; l = l->next) {
+        if (l->texture_id && !atomic_load(&g_texture_live[l->texture_id])) atomic_fetch_add(&g_errors, 1);
+        if (l->shift_multiplier_x != l->shift_multiplier_y) atomic_fetch_add(&g_errors, 1);
+    }
+    atomic_fetch_add(&g_frames, 1);
+    return true;
+}
+
+/* ---- Triple buffer ---------------------------------------------------- */
+
+START_TEST(test_triple_buffer_latest_wins)
+{
+    triple_buffer_t tb;
+    int slots[3] = { 0 };
+    triple_buffer_init(&tb);
+    ck_assert(!triple_buffer_acquire(&tb));
+
+    for (int v = 1; v <= 3; v++) {
+        slots[triple_buffer_back(&tb)] = v;
+        triple_buffer_publish(&tb);
+    }
+    ck_assert(triple_buffer_acquire(&tb));
+    ck_assert_int_eq(slots[triple_buffer_front(&tb)], 3);
+    ck_assert(!triple_buffer_acquire(&tb));
+
+    /* Front, back and middle stay distinct */
+    unsigned int front = triple_buffer_front(&tb), back = triple_buffer_back(&tb);
+    ck_assert(front != back);
+    ck_assert(front < 3 && back < 3);
+}
+END_TEST
+
+#define TB_WORDS 64
+#define TB_ROUNDS 200000
+
+typedef struct {
+    triple_buffer_t tb;
+    uint64_t slots[3][TB_WORDS];
+    atomic_bool done;
+} tb_shared_t;
+
+static void *tb_writer(void *arg) {
+    tb_shared_t *sh = arg;
+    for (uint64_t seq = 1; seq <= TB_ROUNDS; seq++) {
+        uint64_t *slot = sh->slots[triple_buffer_back(&sh->tb)];
+        for (int i = 0; i < TB_WORDS; i++) slot[i] = seq;
+        triple_buffer_publish(&sh->tb);
+    }
+    atomic_store(&sh->done, true);
+    return NULL;
+}
+
+START_TEST(test_triple_buffer_threads)
+{
+    tb_shared_t *sh = calloc(1, sizeof(*sh));
+    triple_buffer_init(&sh->tb);
+    pthread_t writer;
+    ck_assert_int_eq(pthread_create(&writer, NULL, tb_writer, sh), 0);
+
+    uint64_t last = 0;
+    int torn = 0, backwards = 0;
+    for (;;) {
+        bool finished = atomic_load(&sh->done);
+        if (triple_buffer_acquire(&sh->tb)) {
+            const uint64_t *slot = sh->slots[triple_buffer_front(&sh->tb)];
+            for (int i = 1; i < TB_WORDS; i++) if (slot[i] != slot[0]) torn++;
+            if (slot[0] <= last) backwards++;
+            last = slot[0];
+        } else if (finished) {
+            break;
+        }
+    }
+    pthread_join(writer, NULL);
+    ck_assert_int_eq(torn, 0);
+    ck_assert_int_eq(backwards, 0);
+    ck_assert(last == TB_ROUNDS);
+    free(sh);
+}
+END_TEST
+
+/* ---- Render thread under IPC load ------------------------------------- */
+
+static parallax_layer_t *add_layer(hyprlax_context_t *ctx, float shift) {
+    parallax_layer_t *layer = layer_create("/tmp/layer.png", shift, 1.0f);
+    layer->texture_id = upload_texture();
+    layer->width = layer->height = 64;
+    ctx->layers = layer_list_add(ctx->layers, layer);
+    ctx->layer_count = layer_list_count(ctx->layers);
+    layer_store_invalidate(&ctx->layer_store);
+    monitor_list_mark_layers_changed(ctx->monitors);
+    return layer;
+}
+
+/* Same order as hyprlax_remove_layer: texture first, then the list */
+static void remove_first_layer(hyprlax_context_t *ctx) {
+    parallax_layer_t *layer = ctx->layers;
+    delete_texture(layer->texture_id);
+    layer->texture_id = 0;
+    ctx->layers = layer_list_remove(ctx->layers, layer->id);
+    ctx->layer_count = layer_list_count(ctx->layers);
+    layer_store_invalidate(&ctx->layer_store);
+    monitor_list_mark_layers_changed(ctx->monitors);
+}
+
+START_TEST(test_render_thread_ipc_stress)
+{
+    hyprlax_context_t *ctx = calloc(1, sizeof(*ctx));
+    renderer_t renderer = { .ops = &mock_ops, .initialized = true };
+    ctx->renderer = &renderer;
+    ctx->monitors = monitor_list_create();
+    monitor_list_add(ctx->monitors, monitor_instance_create("DP-1"));
+    monitor_list_add(ctx->monitors, monitor_instance_create("HDMI-A-1"));
+    atomic_store(&g_next_texture, 1);
+    g_context_owner = pthread_self();
+    atomic_store(&g_context_bound, true);
+
+    for (int i = 0; i < 3; i++) add_layer(ctx, 0.5f * (float)(i + 1));
+
+    ck_assert_int_eq(render_thread_start(ctx), HYPRLAX_SUCCESS);
+    ck_assert_ptr_nonnull(ctx->render_thread);
+    ck_assert(!on_context_thread());
+
+    for (int i = 0; i < 3000; i++) {
+        switch (i % 5) {
+            case 0:
+                if (atomic_load(&g_next_texture) < MAX_TEXTURES - 1) add_layer(ctx, (float)(i % 7));
+                break;
+            case 1:
+                if (ctx->layer_count > 1) remove_first_layer(ctx);
+                break;
+            case 2:
+                for (parallax_layer_t *l = ctx->layers; l; l = l->next) {
+                    l->shift_multiplier_x = l->shift_multiplier_y = (float)i;
+                }
+                break;
+            case 3: {
+                /* Frame callbacks arrive while platform events are dispatched */
+                render_thread_lock_outputs(ctx->render_thread);
+                monitor_instance_t *m = ctx->monitors->head;
+                m->frame_pending = !m->frame_pending;
+                render_thread_unlock_outputs(ctx->render_thread);
+                render_thread_kick(ctx->render_thread);
+                break;
+            }
+            default:
+                break;
+        }
+        /* Animations keep every output dirty */
+        g_tick = (float)i;
+        ctx->frame_target_time = 1.0 + i * 0.001;
+        monitor_list_mark_dirty(ctx->monitors);
+        layer_store_refresh(&ctx->layer_store, ctx->layers);
+        render_thread_publish(ctx->render_thread, ctx);
+        if (i % 64 == 0) usleep(100);
+    }
+
+    /* Let it catch up with the last snapshot */
+    for (int i = 0; i < 1000 && atomic_load(&g_frames) == 0; i++) usleep(1000);
+
+    render_stats_t stats = { 0 };
+    render_thread_take_stats(ctx->render_thread, &stats);
+    render_thread_stop(ctx);
+    ck_assert_ptr_null(ctx->render_thread);
+    ck_assert(on_context_thread());
+    ck_assert_int_eq(atomic_load(&g_errors), 0);
+    ck_assert(atomic_load(&g_frames) > 0);
+
+    /* Without the thread, uploads run in place again */
+    uint32_t id = upload_texture();
+    ck_assert(id != 0);
+    ck_assert_int_eq(atomic_load(&g_errors), 0);
+
+    layer_store_destroy(&ctx->layer_store);
+    layer_list_destroy(ctx->layers);
+    monitor_list_destroy(ctx->monitors);
+    free(ctx);
+}
+END_TEST
+
+Suite *render_thread_suite(void) {
+    Suite *s = suite_create("RenderThread");
+    TCase *tc = tcase_create("Core");
+    tcase_set_timeout(tc, 30);
+    tcase_add_test(tc, test_triple_buffer_latest_wins);
+    tcase_add_test(tc, test_triple_buffer_threads);
+    tcase_add_test(tc, test_render_thread_ipc_stress);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = render_thread_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_FORK);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
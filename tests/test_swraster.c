@@ -0,0 +1,214 @@
+// Tests for the software renderer's CPU rasterizer and SIMD span kernels
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include "renderer/swraster.h"
+
+static uint32_t next_rand(uint32_t *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state;
+}
+
+/* Premultiplied pixel: no color byte above alpha */
+static uint32_t random_pixel(uint32_t *state) {
+    uint32_t a = next_rand(state) >> 24;
+    uint32_t p = a << 24;
+    for (int k = 0; k < 24; k += 8) p |= ((next_rand(state) >> 24) % (a + 1)) << k;
+    return p;
+}
+
+/* Fullscreen packet sampling the whole texture, as compile_layer without params */
+static void make_packet(renderer_draw_packet_t *pk) {
+    static const float quad[16] = {
+        -1.0f, -1.0f, 0.0f, 1.0f,
+         1.0f, -1.0f, 1.0f, 1.0f,
+        -1.0f,  1.0f, 0.0f, 0.0f,
+         1.0f,  1.0f, 1.0f, 0.0f,
+    };
+    memset(pk, 0, sizeof(*pk));
+    memcpy(pk->vertices, quad, sizeof(quad));
+    pk->offset_scale[0] = pk->offset_scale[1] = 1.0f;
+    pk->opacity = 1.0f;
+    pk->tint[0] = pk->tint[1] = pk->tint[2] = 1.0f;
+    pk->wrap_s = RENDERER_WRAP_CLAMP;
+    pk->wrap_t = RENDERER_WRAP_CLAMP;
+}
+
+START_TEST(test_swraster_kernels_match_scalar)
+{
+    enum { TW = 23, N = 61 };
+    uint32_t seed = 12345;
+    uint32_t row0[TW], row1[TW];
+    int32_t x0[N], x1[N];
+    uint32_t fx[N];
+    for (int i = 0; i < TW; i++) {
+        row0[i] = random_pixel(&seed);
+        row1[i] = random_pixel(&seed);
+    }
+    for (int i = 0; i < N; i++) {
+        x0[i] = (int32_t)(next_rand(&seed) % TW);
+        x1[i] = (int32_t)(next_rand(&seed) % TW);
+        uint32_t w = next_rand(&seed) % 257;
+        fx[i] = w | (w << 16);
+    }
+    swraster_columns_t cols = { x0, x1, fx };
+    const uint16_t mods[2][4] = { { 256, 256, 256, 256 }, { 40, 128, 200, 180 } };
+
+    swraster_span_fn scalar = swraster_get_span(SWRASTER_ISA_SCALAR);
+    ck_assert_ptr_nonnull(scalar);
+    for (int isa = SWRASTER_ISA_SSE2; isa < SWRASTER_ISA_COUNT; isa++) {
+        swraster_span_fn span = swraster_get_span((swraster_isa_t)isa);
+        if (!span) continue;
+        for (int m = 0; m < 2; m++) {
+            for (int blend = 0; blend < 2; blend++) {
+                for (uint32_t fy = 0; fy <= 256; fy += 64) {
+                    uint32_t expect[N], got[N];
+                    for (int i = 0; i < N; i++) expect[i] = got[i] = random_pixel(&seed);
+                    scalar(expect, row0, row1, &cols, N, fy, mods[m], blend);
+                    span(got, row0, row1, &cols, N, fy, mods[m], blend);
+                    ck_assert_msg(memcmp(expect, got, sizeof(got)) == 0,
+                                  "%s differs from scalar", swraster_isa_name((swraster_isa_t)isa));
+                }
+            }
+        }
+    }
+}
+END_TEST
+
+START_TEST(test_swraster_blend_over)
+{
+    uint32_t opaque = 0xff102030u, clear = 0x00000000u, half = 0x80400000u;
+    int32_t x0[1] = { 0 }, x1[1] = { 0 };
+    uint32_t fx[1] = { 0 };
+    swraster_columns_t cols = { x0, x1, fx };
+    const uint16_t full[4] = { 256, 256, 256, 256 };
+    swraster_span_fn span = swraster_get_span(SWRASTER_ISA_SCALAR);
+
+    uint32_t dst = 0xff808080u;
+    span(&dst, &opaque, &opaque, &cols, 1, 0, full, true);
+    ck_assert_int_eq(dst, 0xff102030u);
+
+    dst = 0xff808080u;
+    span(&dst, &clear, &clear, &cols, 1, 0, full, true);
+    ck_assert_int_eq(dst, 0xff808080u);
+
+    /* Half-covered red over grey: red + grey / 2, alpha stays opaque */
+    dst = 0xff808080u;
+    span(&dst, &half, &half, &cols, 1, 0, full, true);
+    ck_assert_int_eq(dst >> 24, 0xff);
+    ck_assert_int_eq((dst >> 16) & 0xff, 0x40 + 0x40);
+    ck_assert_int_eq(dst & 0xff, 0x40);
+}
+END_TEST
+
+START_TEST(test_swraster_identity_draw)
+{
+    enum { W = 8, H = 4 };
+    uint32_t seed = 99;
+    uint32_t texels[W * H], pixels[W * H];
+    for (int i = 0; i < W * H; i++) texels[i] = random_pixel(&seed) | 0xff000000u;
+    sw_image_t tex = { texels, W, H, W };
+    sw_image_t dst = { pixels, W, H, W };
+    renderer_draw_packet_t pk;
+    make_packet(&pk);
+
+    /* Pixel centres land on texel centres: an exact copy, top row first */
+    memset(pixels, 0, sizeof(pixels));
+    swraster_draw_packet(&dst, NULL, &tex, &pk, 0.0f, 0.0f, true);
+    ck_assert(memcmp(pixels, texels, sizeof(pixels)) == 0);
+
+    /* Clip rects limit the draw */
+    memset(pixels, 0, sizeof(pixels));
+    int clip[4] = { 2, 1, 3, 2 };
+    swraster_draw_packet(&dst, clip, &tex, &pk, 0.0f, 0.0f, false);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            bool inside = x >= 2 && x < 5 && y >= 1 && y < 3;
+            ck_assert_int_eq(pixels[y * W + x], inside ? texels[y * W + x] : 0);
+        }
+    }
+}
+END_TEST
+
+START_TEST(test_swraster_overflow_modes)
+{
+    enum { W = 4, H = 2 };
+    uint32_t texels[W * H], pixels[W * H];
+    for (int i = 0; i < W * H; i++) texels[i] = 0xff000000u | (uint32_t)(i % W) * 0x40;
+    sw_image_t tex = { texels, W, H, W };
+    sw_image_t dst = { pixels, W, H, W };
+    renderer_draw_packet_t pk;
+    make_packet(&pk);
+
+    /* One texel to the right: repeat wraps the first column around */
+    pk.wrap_s = RENDERER_WRAP_REPEAT;
+    swraster_draw_packet(&dst, NULL, &tex, &pk, 0.25f, 0.0f, false);
+    ck_assert_int_eq(pixels[0] & 0xff, 0x40);
+    ck_assert_int_eq(pixels[3] & 0xff, 0x00);
+
+    /* Clamp repeats the edge texel */
+    pk.wrap_s = RENDERER_WRAP_CLAMP;
+    swraster_draw_packet(&dst, NULL, &tex, &pk, 0.25f, 0.0f, false);
+    ck_assert_int_eq(pixels[3] & 0xff, 0xc0);
+
+    /* overflow none masks samples outside the image */
+    memset(pixels, 0, sizeof(pixels));
+    pk.mask[0] = 1.0f;
+    swraster_draw_packet(&dst, NULL, &tex, &pk, 0.25f, 0.0f, false);
+    ck_assert_int_eq(pixels[2] & 0xff, 0xc0);
+    ck_assert_int_eq(pixels[3], 0);
+
+    /* A mask under 1 keeps a tile's gutter out: [0.25, 0.75] here */
+    memset(pixels, 0, sizeof(pixels));
+    pk.mask[0] = 0.75f;
+    swraster_draw_packet(&dst, NULL, &tex, &pk, 0.0f, 0.0f, false);
+    ck_assert_int_eq(pixels[0], 0);
+    ck_assert_int_eq(pixels[1] & 0xff, 0x40);
+    ck_assert_int_eq(pixels[2] & 0xff, 0x80);
+    ck_assert_int_eq(pixels[3], 0);
+}
+END_TEST
+
+START_TEST(test_swraster_opacity_and_premultiply)
+{
+    uint8_t rgba[8] = { 255, 128, 0, 255,  255, 255, 255, 128 };
+    uint32_t words[2];
+    swraster_premultiply(rgba, 2, words);
+    ck_assert_int_eq(words[0], 0xffff8000u);
+    ck_assert_int_eq(words[1], 0x80808080u);
+
+    uint32_t pixel = 0;
+    sw_image_t tex = { words, 1, 1, 1 };
+    sw_image_t dst = { &pixel, 1, 1, 1 };
+    renderer_draw_packet_t pk;
+    make_packet(&pk);
+    pk.opacity = 0.5f;
+    swraster_draw_packet(&dst, NULL, &tex, &pk, 0.0f, 0.0f, false);
+    ck_assert_int_eq(pixel, 0x7f7f4000u);
+
+    ck_assert_int_eq(swraster_pack_color(0.0f, 0.0f, 0.0f, 1.0f), 0xff000000u);
+}
+END_TEST
+
+Suite *swraster_suite(void) {
+    Suite *s = suite_create("SwRaster");
+    TCase *tc = tcase_create("Core");
+    tcase_add_test(tc, test_swraster_kernels_match_scalar);
+    tcase_add_test(tc, test_swraster_blend_over);
+    tcase_add_test(tc, test_swraster_identity_draw);
+    tcase_add_test(tc, test_swraster_overflow_modes);
+    tcase_add_test(tc, test_swraster_opacity_and_premultiply);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = swraster_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_FORK);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
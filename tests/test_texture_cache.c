@@ -0,0 +1,201 @@
+// Tests for the decoded image cache: entries round-trip through a mapping,
+// keys change with the file and the processing, damaged entries are
+// dropped, and trimming removes the least recently used first
+#include <check.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "include/texture_cache.h"
+#include "include/hyprlax_internal.h"
+
+static char cache_home[64];
+static char image_path[128];
+
+static void setup(void) {
+    snprintf(cache_home, sizeof(cache_home), "/tmp/hyprlax-cache-test-XXXXXX");
+    ck_assert_ptr_nonnull(mkdtemp(cache_home));
+    setenv("XDG_CACHE_HOME", cache_home, 1);
+    snprintf(image_path, sizeof(image_path), "%s/image.png", cache_home);
+    FILE *f = fopen(image_path, "w");
+    ck_assert_ptr_nonnull(f);
+    fputs("not really a png", f);
+    fclose(f);
+}
+
+static void teardown(void) {
+    texture_cache_clear();
+    char dir[256];
+    snprintf(dir, sizeof(dir), "%s/hyprlax", cache_home);
+    rmdir(dir);
+    unlink(image_path);
+    rmdir(cache_home);
+}
+
+static uint8_t *make_pixels(int width, int height, uint8_t seed) {
+    size_t bytes = (size_t)width * (size_t)height * 4;
+    uint8_t *rgba = malloc(bytes);
+    ck_assert_ptr_nonnull(rgba);
+    for (size_t i = 0; i < bytes; i++) rgba[i] = (uint8_t)(seed + i * 7);
+    return rgba;
+}
+
+static texture_cache_info_t make_info(int width, int height) {
+    texture_cache_info_t info = {
+        .width = width, .height = height, .source_width = width * 2, .source_height = height * 2,
+        .crop = { 0.25f, 0.0f, 0.75f, 1.0f }, .opaque = false, .alpha_bbox = { 1, 2, 3, 4 },
+    };
+    return info;
+}
+
+static void entry_path(uint64_t key, char *out, size_t size) {
+    char dir[256];
+    ck_assert(texture_cache_dir(dir, sizeof(dir)));
+    snprintf(out, size, "%s/%016llx.tex", dir, (unsigned long long)key);
+}
+
+START_TEST(test_store_and_map)
+{
+    uint64_t key = texture_cache_key(image_path, "a", 1);
+    ck_assert_uint_ne(key, 0);
+    texture_cache_info_t info = make_info(64, 32);
+    uint8_t *rgba = make_pixels(64, 32, 3);
+    ck_assert_int_eq(texture_cache_store(key, &info, rgba), HYPRLAX_SUCCESS);
+
+    texture_cache_info_t got;
+    texture_cache_entry_t *entry = texture_cache_open(key, &got);
+    ck_assert_ptr_nonnull(entry);
+    ck_assert_int_eq(got.width, 64);
+    ck_assert_int_eq(got.height, 32);
+    ck_assert_int_eq(got.source_width, 128);
+    ck_assert_int_eq(got.source_height, 64);
+    ck_assert(got.crop[0] == 0.25f && got.crop[2] == 0.75f);
+    ck_assert(!got.opaque);
+    ck_assert_int_eq(got.alpha_bbox[3], 4);
+    ck_assert_int_eq(memcmp(texture_cache_pixels(entry), rgba, 64 * 32 * 4), 0);
+    texture_cache_close(entry);
+    free(rgba);
+
+    texture_cache_stats_t st;
+    ck_assert_int_eq(texture_cache_stats(&st), HYPRLAX_SUCCESS);
+    ck_assert_int_eq(st.entries, 1);
+    ck_assert(st.bytes > 64 * 32 * 4);
+    ck_assert(st.hits >= 1);
+}
+END_TEST
+
+START_TEST(test_key_follows_file_and_variant)
+{
+    uint64_t key = texture_cache_key(image_path, "a", 1);
+    ck_assert_uint_eq(texture_cache_key(image_path, "a", 1), key);
+    ck_assert_uint_ne(texture_cache_key(image_path, "b", 1), key);
+
+    /* Another mtime is another image */
+    struct timespec times[2] = { { 0, UTIME_OMIT }, { 1000000000, 0 } };
+    ck_assert_int_eq(utimensat(AT_FDCWD, image_path, times, 0), 0);
+    ck_assert_uint_ne(texture_cache_key(image_path, "a", 1), key);
+
+    ck_assert_uint_eq(texture_cache_key("/nonexistent/image.png", "a", 1), 0);
+}
+END_TEST
+
+START_TEST(test_damaged_entry_is_dropped)
+{
+    uint64_t key = texture_cache_key(image_path, "a", 1);
+    texture_cache_info_t info = make_info(16, 16);
+    uint8_t *rgba = make_pixels(16, 16, 9);
+    ck_assert_int_eq(texture_cache_store(key, &info, rgba), HYPRLAX_SUCCESS);
+    free(rgba);
+
+    /* Flip one pixel byte */
+    char path[512];
+    entry_path(key, path, sizeof(path));
+    int fd = open(path, O_RDWR);
+    ck_assert_int_ge(fd, 0);
+    off_t last = lseek(fd, -1, SEEK_END);
+    uint8_t byte;
+    ck_assert_int_eq(pread(fd, &byte, 1, last), 1);
+    byte ^= 0xff;
+    ck_assert_int_eq(pwrite(fd, &byte, 1, last), 1);
+    close(fd);
+
+    texture_cache_info_t got;
+    ck_assert_ptr_null(texture_cache_open(key, &got));
+    ck_assert_int_ne(access(path, F_OK), 0);
+
+    /* A truncated entry goes the same way */
+    rgba = make_pixels(16, 16, 9);
+    ck_assert_int_eq(texture_cache_store(key, &info, rgba), HYPRLAX_SUCCESS);
+    free(rgba);
+    ck_assert_int_eq(truncate(path, 100), 0);
+    ck_assert_ptr_null(texture_cache_open(key, &got));
+    ck_assert_int_ne(access(path, F_OK), 0);
+}
+END_TEST
+
+START_TEST(test_trim_evicts_least_recently_used)
+{
+    texture_cache_info_t info = make_info(32, 32);
+    uint8_t *rgba = make_pixels(32, 32, 1);
+    uint64_t keys[4];
+    char path[512];
+    for (int i = 0; i < 4; i++) {
+        char variant = (char)('a' + i);
+        keys[i] = texture_cache_key(image_path, &variant, 1);
+        ck_assert_int_eq(texture_cache_store(keys[i], &info, rgba), HYPRLAX_SUCCESS);
+        /* Oldest first: entry i last used at second i */
+        entry_path(keys[i], path, sizeof(path));
+        struct timespec times[2] = { { 0, UTIME_OMIT }, { 1000 + i, 0 } };
+        ck_assert_int_eq(utimensat(AT_FDCWD, path, times, 0), 0);
+    }
+    free(rgba);
+
+    /* A hit makes entry 0 the most recently used */
+    texture_cache_info_t got;
+    texture_cache_entry_t *entry = texture_cache_open(keys[0], &got);
+    ck_assert_ptr_nonnull(entry);
+    texture_cache_close(entry);
+
+    struct stat st;
+    ck_assert_int_eq(stat(path, &st), 0);
+    ck_assert_int_eq(texture_cache_trim(2 * (uint64_t)st.st_size), 2);
+    bool present[4];
+    for (int i = 0; i < 4; i++) {
+        entry_path(keys[i], path, sizeof(path));
+        present[i] = access(path, F_OK) == 0;
+    }
+    ck_assert(present[0]);
+    ck_assert(!present[1]);
+    ck_assert(!present[2]);
+    ck_assert(present[3]);
+
+    ck_assert_int_eq(texture_cache_clear(), 2);
+    texture_cache_stats_t stats;
+    texture_cache_stats(&stats);
+    ck_assert_int_eq(stats.entries, 0);
+}
+END_TEST
+
+Suite *texture_cache_suite(void) {
+    Suite *s = suite_create("TextureCache");
+    TCase *tc = tcase_create("Core");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, test_store_and_map);
+    tcase_add_test(tc, test_key_follows_file_and_variant);
+    tcase_add_test(tc, test_damaged_entry_is_dropped);
+    tcase_add_test(tc, test_trim_evicts_least_recently_used);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = texture_cache_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
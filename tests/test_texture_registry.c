@@ -0,0 +1,132 @@
+// Tests for the shared texture registry: layers with the same key share one
+// texture, the last release deletes it, and a hold (a config reload) keeps
+// unreferenced textures for layers added back before it ends
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/renderer.h"
+#include "include/texture_registry.h"
+#include "stubs_gl.h"
+
+static renderer_t *renderer;
+static texture_registry_t *reg;
+
+static void setup(void) {
+    ck_assert_int_eq(renderer_create(&renderer, "headless"), HYPRLAX_SUCCESS);
+    renderer_config_t config = { .width = 640, .height = 480 };
+    ck_assert_int_eq(renderer->ops->init(NULL, NULL, &config), HYPRLAX_SUCCESS);
+    renderer->initialized = true;
+    reg = texture_registry_create();
+    ck_assert_ptr_nonnull(reg);
+}
+
+static void teardown(void) {
+    texture_registry_destroy(reg);
+    reg = NULL;
+    renderer_destroy(renderer);
+    renderer = NULL;
+}
+
+static uint32_t upload(void) {
+    uint8_t rgba[16 * 16 * 4];
+    memset(rgba, 0x40, sizeof(rgba));
+    uint32_t id = renderer_upload_texture(rgba, 16, 16);
+    ck_assert(id != 0);
+    return id;
+}
+
+static const texture_cache_info_t k_info = {
+    .width = 16, .height = 16, .source_width = 32, .source_height = 32,
+    .crop = { 0.0f, 0.0f, 0.5f, 0.5f }, .opaque = true, .alpha_bbox = { 0, 0, 16, 16 },
+};
+
+START_TEST(test_same_key_shares_texture)
+{
+    uint32_t texture = 0;
+    ck_assert(!texture_registry_acquire(reg, 42, &texture, NULL));
+    uint32_t id = upload();
+    ck_assert_int_eq(texture_registry_add(reg, 42, id, &k_info), HYPRLAX_SUCCESS);
+
+    texture_cache_info_t info;
+    ck_assert(texture_registry_acquire(reg, 42, &texture, &info));
+    ck_assert_uint_eq(texture, id);
+    ck_assert_int_eq(info.source_width, 32);
+    ck_assert(info.crop[2] == 0.5f);
+    ck_assert(!texture_registry_acquire(reg, 43, &texture, NULL));
+
+    int textures, refs;
+    texture_registry_stats(reg, &textures, &refs);
+    ck_assert_int_eq(textures, 1);
+    ck_assert_int_eq(refs, 2);
+
+    /* Deleted with the last reference only */
+    gl_stub_counts_t before = gl_stub_counts;
+    texture_registry_release(reg, id);
+    ck_assert_int_eq(gl_stub_counts.delete_textures - before.delete_textures, 0);
+    texture_registry_release(reg, id);
+    ck_assert_int_eq(gl_stub_counts.delete_textures - before.delete_textures, 1);
+    ck_assert(!texture_registry_acquire(reg, 42, &texture, NULL));
+}
+END_TEST
+
+START_TEST(test_unregistered_texture_deleted_at_once)
+{
+    uint32_t id = upload();
+    gl_stub_counts_t before = gl_stub_counts;
+    texture_registry_release(reg, id);
+    ck_assert_int_eq(gl_stub_counts.delete_textures - before.delete_textures, 1);
+
+    /* Without a registry too */
+    id = upload();
+    texture_registry_release(NULL, id);
+    ck_assert_int_eq(gl_stub_counts.delete_textures - before.delete_textures, 2);
+}
+END_TEST
+
+START_TEST(test_hold_keeps_textures_for_reload)
+{
+    uint32_t kept = upload(), dropped = upload();
+    texture_registry_add(reg, 1, kept, &k_info);
+    texture_registry_add(reg, 2, dropped, &k_info);
+
+    /* Reload: every layer goes, then the one that stays comes back */
+    gl_stub_counts_t before = gl_stub_counts;
+    texture_registry_hold(reg);
+    texture_registry_release(reg, kept);
+    texture_registry_release(reg, dropped);
+    ck_assert_int_eq(gl_stub_counts.delete_textures - before.delete_textures, 0);
+    uint32_t texture = 0;
+    ck_assert(texture_registry_acquire(reg, 1, &texture, NULL));
+    ck_assert_uint_eq(texture, kept);
+
+    ck_assert_int_eq(texture_registry_unhold(reg), 1);
+    ck_assert_int_eq(gl_stub_counts.delete_textures - before.delete_textures, 1);
+    ck_assert(!texture_registry_acquire(reg, 2, &texture, NULL));
+
+    int textures, refs;
+    texture_registry_stats(reg, &textures, &refs);
+    ck_assert_int_eq(textures, 1);
+    ck_assert_int_eq(refs, 1);
+}
+END_TEST
+
+Suite *texture_registry_suite(void) {
+    Suite *s = suite_create("TextureRegistry");
+    TCase *tc = tcase_create("Core");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, test_same_key_shares_texture);
+    tcase_add_test(tc, test_unregistered_texture_deleted_at_once);
+    tcase_add_test(tc, test_hold_keeps_textures_for_reload);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = texture_registry_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
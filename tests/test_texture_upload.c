@@ -0,0 +1,184 @@
+// Tests for time-sliced texture uploads: large images are uploaded in row
+// bands over several pumps, a texture is ready only once all are in, and
+// caller-owned pixels are released once they are
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/renderer.h"
+#include "include/defaults.h"
+#include "stubs_gl.h"
+
+#define TEST_W 1920
+#define TEST_H 1080
+
+/* 128 rows per band at this width */
+#define IMAGE_W 2048
+#define IMAGE_H 1024
+#define IMAGE_BANDS (IMAGE_H / (HYPRLAX_UPLOAD_BAND_BYTES / (IMAGE_W * 4)))
+
+static const renderer_ops_t *ops;
+static renderer_t *renderer;
+
+static void init_backend(const char *name, int budget_us) {
+    ck_assert_int_eq(renderer_create(&renderer, name), HYPRLAX_SUCCESS);
+    ops = renderer->ops;
+    render_options_t options = RENDER_OPTIONS_DEFAULTS;
+    options.upload_budget = budget_us;
+    renderer_set_options(&options);
+    renderer_config_t config = { .width = TEST_W, .height = TEST_H };
+    ck_assert_int_eq(ops->init(NULL, NULL, &config), HYPRLAX_SUCCESS);
+    renderer->initialized = true;
+}
+
+/* Bands cost more than the budget: one per pump */
+static void setup(void) {
+    gl_stub_tex_sub_image_us = 50;
+    init_backend("headless", 10);
+}
+
+static void teardown(void) {
+    gl_stub_tex_sub_image_us = 0;
+    renderer_destroy(renderer);
+    renderer = NULL;
+}
+
+static uint8_t *make_image(int width, int height) {
+    uint8_t *rgba = malloc((size_t)width * (size_t)height * 4);
+    ck_assert_ptr_nonnull(rgba);
+    memset(rgba, 0x80, (size_t)width * (size_t)height * 4);
+    return rgba;
+}
+
+START_TEST(test_large_image_uploads_in_bands)
+{
+    gl_stub_counts_t before = gl_stub_counts;
+    uint32_t id = renderer_queue_texture(make_image(IMAGE_W, IMAGE_H), IMAGE_W, IMAGE_H);
+    ck_assert(id != 0);
+    ck_assert(!renderer_texture_ready(id));
+    ck_assert_uint_eq(renderer_upload_pending_bytes(), (uint64_t)IMAGE_W * IMAGE_H * 4);
+    /* Storage only, no pixels yet */
+    ck_assert_int_eq(gl_stub_counts.tex_images - before.tex_images, 1);
+    ck_assert_int_eq(gl_stub_counts.tex_sub_images - before.tex_sub_images, 0);
+
+    for (int band = 1; band <= IMAGE_BANDS; band++) {
+        gl_stub_counts_t frame = gl_stub_counts;
+        bool more = renderer_pump_uploads();
+        ck_assert_int_eq(gl_stub_counts.tex_sub_images - frame.tex_sub_images, 1);
+        ck_assert_int_eq(more, band < IMAGE_BANDS);
+        ck_assert_int_eq(renderer_texture_ready(id), band == IMAGE_BANDS);
+        ck_assert_uint_eq(renderer_upload_pending_bytes(),
+                          (uint64_t)IMAGE_W * 4 * (IMAGE_H - band * (IMAGE_H / IMAGE_BANDS)));
+    }
+    ck_assert_int_eq(gl_stub_counts.tex_sub_rows - before.tex_sub_rows, IMAGE_H);
+    ck_assert(!renderer_pump_uploads());
+    renderer_delete_texture(id);
+}
+END_TEST
+
+START_TEST(test_small_image_uploads_at_once)
+{
+    uint32_t id = renderer_queue_texture(make_image(256, 256), 256, 256);
+    ck_assert(id != 0);
+    ck_assert(renderer_texture_ready(id));
+    ck_assert_uint_eq(renderer_upload_pending_bytes(), 0);
+    ck_assert(!renderer_pump_uploads());
+    renderer_delete_texture(id);
+}
+END_TEST
+
+START_TEST(test_zero_budget_uploads_at_once)
+{
+    teardown();
+    init_backend("headless", 0);
+    gl_stub_counts_t before = gl_stub_counts;
+    uint32_t id = renderer_queue_texture(make_image(IMAGE_W, IMAGE_H), IMAGE_W, IMAGE_H);
+    ck_assert(renderer_texture_ready(id));
+    ck_assert_int_eq(gl_stub_counts.tex_sub_images - before.tex_sub_images, 0);
+    ck_assert_int_eq(gl_stub_counts.tex_images - before.tex_images, 1);
+    renderer_delete_texture(id);
+}
+END_TEST
+
+START_TEST(test_delete_cancels_upload)
+{
+    uint32_t first = renderer_queue_texture(make_image(IMAGE_W, IMAGE_H), IMAGE_W, IMAGE_H);
+    uint32_t second = renderer_queue_texture(make_image(IMAGE_W, IMAGE_H), IMAGE_W, IMAGE_H);
+    ck_assert(renderer_pump_uploads());
+    renderer_delete_texture(first);
+    ck_assert(renderer_texture_ready(first));
+    ck_assert_uint_eq(renderer_upload_pending_bytes(), (uint64_t)IMAGE_W * IMAGE_H * 4);
+
+    /* The next pump starts on the second image */
+    gl_stub_counts_t before = gl_stub_counts;
+    renderer_finish_uploads();
+    ck_assert_int_eq(gl_stub_counts.tex_sub_rows - before.tex_sub_rows, IMAGE_H);
+    ck_assert(renderer_texture_ready(second));
+    ck_assert_uint_eq(renderer_upload_pending_bytes(), 0);
+    renderer_delete_texture(second);
+}
+END_TEST
+
+static void count_release(void *arg) {
+    (*(int *)arg)++;
+}
+
+START_TEST(test_caller_pixels_released_once_uploaded)
+{
+    uint8_t *rgba = make_image(IMAGE_W, IMAGE_H);
+    int released = 0;
+    uint32_t id = renderer_queue_texture_with(rgba, IMAGE_W, IMAGE_H, count_release, &released);
+    ck_assert(id != 0);
+    /* Bands still read from the caller's buffer */
+    ck_assert(renderer_pump_uploads());
+    ck_assert_int_eq(released, 0);
+    while (renderer_pump_uploads()) {}
+    ck_assert(renderer_texture_ready(id));
+    ck_assert_int_eq(released, 1);
+
+    /* Small images go at once, and are released at once */
+    id = renderer_queue_texture_with(rgba, 64, 64, count_release, &released);
+    ck_assert(renderer_texture_ready(id));
+    ck_assert_int_eq(released, 2);
+    free(rgba);
+}
+END_TEST
+
+START_TEST(test_gles3_stages_bands_through_pbo)
+{
+    teardown();
+    init_backend("headless-gles3", 10);
+    gl_stub_counts_t before = gl_stub_counts;
+    uint32_t id = renderer_queue_texture(make_image(IMAGE_W, IMAGE_H), IMAGE_W, IMAGE_H);
+    ck_assert_int_eq(gl_stub_counts.tex_storage - before.tex_storage, 1);
+    while (renderer_pump_uploads()) {}
+    ck_assert(renderer_texture_ready(id));
+    ck_assert_int_eq(gl_stub_counts.buffer_maps - before.buffer_maps, IMAGE_BANDS);
+    ck_assert_int_eq(gl_stub_counts.unpack_uploads - before.unpack_uploads, IMAGE_BANDS);
+    ck_assert_int_eq(gl_stub_counts.tex_sub_rows - before.tex_sub_rows, IMAGE_H);
+    renderer_delete_texture(id);
+}
+END_TEST
+
+Suite *texture_upload_suite(void) {
+    Suite *s = suite_create("TextureUpload");
+    TCase *tc = tcase_create("Core");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, test_large_image_uploads_in_bands);
+    tcase_add_test(tc, test_small_image_uploads_at_once);
+    tcase_add_test(tc, test_zero_budget_uploads_at_once);
+    tcase_add_test(tc, test_delete_cancels_upload);
+    tcase_add_test(tc, test_caller_pixels_released_once_uploaded);
+    tcase_add_test(tc, test_gles3_stages_bands_through_pbo);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = texture_upload_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
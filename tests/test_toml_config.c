@@ -81,10 +81,44 @@ START_TEST(test_parse_parallax_globals)
 }
 END_TEST
 
+START_TEST(test_parse_render_options)
+{
+    static const char *text =
+        "[global.render]\n"
+        "separable_blur = true\n"
+        "blur_downscale = 4\n"
+        "single_pass = false\n"
+        "tint_on_blur = false\n";
+    char path[] = "/tmp/hyprlax-test-toml-XXXXXX";
+    int fd = mkstemp(path);
+    ck_assert_msg(fd >= 0, "Failed to create temp file");
+    FILE *f = fdopen(fd, "w");
+    ck_assert_ptr_nonnull(f);
+    fwrite(text, 1, strlen(text), f);
+    fclose(f);
+
+    config_t cfg;
+    config_set_defaults(&cfg);
+    ck_assert(cfg.render_options.single_pass == true);
+    ck_assert_int_eq(config_load_toml(&cfg, path), 0);
+
+    ck_assert(cfg.render_options.separable_blur == true);
+    ck_assert_int_eq(cfg.render_options.blur_downscale, 4);
+    ck_assert(cfg.render_options.single_pass == false);
+    ck_assert(cfg.render_options.tint_on_blur == false);
+    /* Untouched options keep their defaults */
+    ck_assert(cfg.render_options.uniform_offset == true);
+    ck_assert(cfg.render_options.gl_finish == true);
+
+    unlink(path);
+}
+END_TEST
+
 Suite *toml_suite(void) {
     Suite *s = suite_create("TOML_Parallax");
     TCase *tc = tcase_create("Core");
     tcase_add_test(tc, test_parse_parallax_globals);
+    tcase_add_test(tc, test_parse_render_options);
     suite_add_tcase(s, tc);
     return s;
 }
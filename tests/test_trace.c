@@ -0,0 +1,105 @@
+// Tests for headless replay trace parsing
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "include/trace.h"
+#include "include/hyprlax_internal.h"
+
+START_TEST(test_parse_events)
+{
+    trace_event_t ev;
+
+    ck_assert_int_eq(trace_parse_line("0.5 workspace 3\n", &ev), 1);
+    ck_assert_int_eq(ev.type, TRACE_EVENT_WORKSPACE);
+    ck_assert_double_eq_tol(ev.time, 0.5, 1e-9);
+    ck_assert_int_eq(ev.workspace, 3);
+    ck_assert_str_eq(ev.monitor, "");
+
+    ck_assert_int_eq(trace_parse_line("  2 workspace2d 0 0 1 -1 DP-1  # right/up", &ev), 1);
+    ck_assert_int_eq(ev.type, TRACE_EVENT_WORKSPACE_2D);
+    ck_assert_int_eq(ev.to_x, 1);
+    ck_assert_int_eq(ev.to_y, -1);
+    ck_assert_str_eq(ev.monitor, "DP-1");
+
+    ck_assert_int_eq(trace_parse_line("4.25\tset render.overflow repeat", &ev), 1);
+    ck_assert_int_eq(ev.type, TRACE_EVENT_SET);
+    ck_assert_str_eq(ev.property, "render.overflow");
+    ck_assert_str_eq(ev.value, "repeat");
+}
+END_TEST
+
+START_TEST(test_parse_skips_and_rejects)
+{
+    trace_event_t ev;
+    ck_assert_int_eq(trace_parse_line("", &ev), 0);
+    ck_assert_int_eq(trace_parse_line("   \n", &ev), 0);
+    ck_assert_int_eq(trace_parse_line("# comment", &ev), 0);
+
+    ck_assert_int_lt(trace_parse_line("x workspace 2", &ev), 0);
+    ck_assert_int_lt(trace_parse_line("-1 workspace 2", &ev), 0);
+    ck_assert_int_lt(trace_parse_line("1 workspace two", &ev), 0);
+    ck_assert_int_lt(trace_parse_line("1 workspace2d 0 0 1", &ev), 0);
+    ck_assert_int_lt(trace_parse_line("1 set render.overflow", &ev), 0);
+    ck_assert_int_lt(trace_parse_line("1 teleport 4", &ev), 0);
+    ck_assert_int_lt(trace_parse_line("1 workspace 2 DP-1 extra", &ev), 0);
+}
+END_TEST
+
+START_TEST(test_load_sorts_stably)
+{
+    char path[] = "/tmp/hyprlax-trace-XXXXXX";
+    int fd = mkstemp(path);
+    ck_assert_int_ge(fd, 0);
+    FILE *f = fdopen(fd, "w");
+    fputs("# out of order on purpose\n"
+          "2.0 workspace 3\n"
+          "1.0 workspace 2\n"
+          "\n"
+          "1.0 set render.tile.x true\n"
+          "0.0 workspace 1\n", f);
+    fclose(f);
+
+    trace_t trace;
+    ck_assert_int_eq(trace_load(path, &trace), HYPRLAX_SUCCESS);
+    ck_assert_int_eq(trace.count, 4);
+    ck_assert_int_eq(trace.events[0].workspace, 1);
+    ck_assert_int_eq(trace.events[1].workspace, 2);
+    ck_assert_int_eq(trace.events[2].type, TRACE_EVENT_SET);
+    ck_assert_int_eq(trace.events[3].workspace, 3);
+    trace_free(&trace);
+    ck_assert_ptr_null(trace.events);
+
+    /* A malformed line fails the whole load */
+    f = fopen(path, "w");
+    fputs("0.5 workspace 2\n1.0 bogus\n", f);
+    fclose(f);
+    ck_assert_int_eq(trace_load(path, &trace), HYPRLAX_ERROR_INVALID_ARGS);
+    ck_assert_int_eq(trace.count, 0);
+
+    unlink(path);
+    ck_assert_int_eq(trace_load(path, &trace), HYPRLAX_ERROR_FILE_NOT_FOUND);
+}
+END_TEST
+
+Suite *trace_suite(void) {
+    Suite *s = suite_create("Trace");
+    TCase *tc = tcase_create("Core");
+    tcase_add_test(tc, test_parse_events);
+    tcase_add_test(tc, test_parse_skips_and_rejects);
+    tcase_add_test(tc, test_load_sorts_stably);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = trace_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_FORK);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
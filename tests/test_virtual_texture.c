@@ -0,0 +1,240 @@
+// Tests for tiled virtual textures: only tiles under a requested window are
+// uploaded with a gutter from their neighbours, they become drawable once
+// complete, and trimming evicts the least recently wanted first
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/defaults.h"
+#include "include/renderer.h"
+#include "include/virtual_texture.h"
+#include "stubs_gl.h"
+
+#define TEST_W 1920
+#define TEST_H 1080
+#define TILE_EDGE(s) ((s) + 2 * HYPRLAX_TILE_GUTTER)
+#define TILE_BYTES(s) ((uint64_t)TILE_EDGE(s) * TILE_EDGE(s) * 4)
+
+static renderer_t *renderer;
+
+static void init_backend(int budget_us) {
+    ck_assert_int_eq(renderer_create(&renderer, "headless"), HYPRLAX_SUCCESS);
+    render_options_t options = RENDER_OPTIONS_DEFAULTS;
+    options.upload_budget = budget_us;
+    renderer_set_options(&options);
+    renderer_config_t config = { .width = TEST_W, .height = TEST_H };
+    ck_assert_int_eq(renderer->ops->init(NULL, NULL, &config), HYPRLAX_SUCCESS);
+    renderer->initialized = true;
+}
+
+static void setup(void) {
+    init_backend(0);
+}
+
+static void teardown(void) {
+    gl_stub_tex_sub_image_us = 0;
+    gl_stub_upload_hook = NULL;
+    renderer_destroy(renderer);
+    renderer = NULL;
+}
+
+static virtual_texture_t *make_vt(int width, int height, int tile_size) {
+    uint8_t *rgba = malloc((size_t)width * (size_t)height * 4);
+    ck_assert_ptr_nonnull(rgba);
+    memset(rgba, 0x80, (size_t)width * (size_t)height * 4);
+    virtual_texture_t *vt = virtual_texture_create(rgba, width, height, tile_size);
+    ck_assert_ptr_nonnull(vt);
+    return vt;
+}
+
+START_TEST(test_grid_covers_image)
+{
+    virtual_texture_t *vt = make_vt(5000, 3000, 2048);
+    const virtual_texture_grid_t *grid = virtual_texture_grid(vt);
+    ck_assert_int_eq(grid->cols, 3);
+    ck_assert_int_eq(grid->rows, 2);
+    int rect[4];
+    virtual_texture_tile_rect(grid, 2, rect);
+    ck_assert_int_eq(rect[0], 4096);
+    ck_assert_int_eq(rect[1], 0);
+    ck_assert_int_eq(rect[2], 904);
+    ck_assert_int_eq(rect[3], 2048);
+    virtual_texture_tile_rect(grid, 5, rect);
+    ck_assert_int_eq(rect[0], 4096);
+    ck_assert_int_eq(rect[1], 2048);
+    ck_assert_int_eq(rect[2], 904);
+    ck_assert_int_eq(rect[3], 952);
+    ck_assert_uint_eq(virtual_texture_resident_bytes(vt), 0);
+    virtual_texture_destroy(vt);
+}
+END_TEST
+
+START_TEST(test_request_uploads_tiles_in_window)
+{
+    virtual_texture_t *vt = make_vt(1024, 768, 256);
+    const uint32_t *ids = virtual_texture_ids(vt);
+    gl_stub_counts_t before = gl_stub_counts;
+    /* Pixels 307..614 x 384..691: columns 1-2, rows 1-2 */
+    const float uv[4] = { 0.3f, 0.5f, 0.6f, 0.9f };
+    ck_assert_int_eq(virtual_texture_request(vt, uv, 1), 4);
+    ck_assert_int_eq(gl_stub_counts.tex_images - before.tex_images, 4);
+    ck_assert_uint_eq(virtual_texture_resident_bytes(vt), 4 * TILE_BYTES(256));
+    for (int i = 0; i < 12; i++) {
+        int col = i % 4, row = i / 4;
+        bool wanted = col >= 1 && col <= 2 && row >= 1 && row <= 2;
+        ck_assert_int_eq(ids[i] != 0, wanted);
+    }
+
+    /* Resident tiles are not uploaded again; windows off the image are empty */
+    ck_assert_int_eq(virtual_texture_request(vt, uv, 2), 0);
+    const float outside[4] = { 1.2f, 0.0f, 1.5f, 1.0f };
+    ck_assert_int_eq(virtual_texture_request(vt, outside, 2), 0);
+    ck_assert_int_eq(gl_stub_counts.tex_images - before.tex_images, 4);
+    virtual_texture_destroy(vt);
+}
+END_TEST
+
+/* Tile textures uploaded, in order */
+static uint8_t uploaded[2][TILE_EDGE(4) * TILE_EDGE(4) * 4];
+static int uploads;
+
+static void record_upload(int x, int y, int width, int height, const void *pixels) {
+    ck_assert_int_eq(width, TILE_EDGE(4));
+    ck_assert_int_lt(uploads, 2);
+    memcpy(uploaded[uploads] + ((size_t)y * (size_t)width + (size_t)x) * 4, pixels,
+           (size_t)width * (size_t)height * 4);
+    if (y + height == TILE_EDGE(4)) uploads++;
+}
+
+/* Column and row of the image pixel held at texel x, y of a tile */
+static void texel_source(int tile, int x, int y, int *col, int *row) {
+    const uint8_t *p = uploaded[tile] + ((size_t)y * TILE_EDGE(4) + (size_t)x) * 4;
+    *col = p[0];
+    *row = p[1];
+}
+
+START_TEST(test_tiles_carry_neighbour_gutter)
+{
+    /* Two 4 px tiles side by side; each pixel holds its own coordinates */
+    const int g = HYPRLAX_TILE_GUTTER;
+    uint8_t *rgba = malloc(8 * 4 * 4);
+    ck_assert_ptr_nonnull(rgba);
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 8; x++) {
+            uint8_t *p = rgba + ((size_t)y * 8 + (size_t)x) * 4;
+            p[0] = (uint8_t)x; p[1] = (uint8_t)y; p[2] = 0; p[3] = 0xff;
+        }
+    }
+    virtual_texture_t *vt = virtual_texture_create(rgba, 8, 4, 4);
+    ck_assert_ptr_nonnull(vt);
+    ck_assert_int_eq(virtual_texture_grid(vt)->gutter, g);
+    uploads = 0;
+    gl_stub_upload_hook = record_upload;
+    const float all[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+    ck_assert_int_eq(virtual_texture_request(vt, all, 1), 2);
+    while (renderer_pump_uploads()) {}
+    ck_assert_int_eq(uploads, 2);
+
+    int col, row;
+    for (int t = 0; t < 2; t++) {
+        for (int y = 0; y < TILE_EDGE(4); y++) {
+            for (int x = 0; x < TILE_EDGE(4); x++) {
+                /* Neighbours inside the image, its edge texels past it */
+                int want_col = t * 4 + x - g, want_row = y - g;
+                if (want_col < 0) want_col = 0;
+                if (want_col > 7) want_col = 7;
+                if (want_row < 0) want_row = 0;
+                if (want_row > 3) want_row = 3;
+                texel_source(t, x, y, &col, &row);
+                ck_assert_int_eq(col, want_col);
+                ck_assert_int_eq(row, want_row);
+            }
+        }
+    }
+    virtual_texture_destroy(vt);
+}
+END_TEST
+
+START_TEST(test_tiles_drawable_once_uploaded)
+{
+    /* Bands cost more than the budget: one per pump */
+    teardown();
+    gl_stub_tex_sub_image_us = 50;
+    init_backend(10);
+    virtual_texture_t *vt = make_vt(2048, 1024, 1024);
+    const uint32_t *ids = virtual_texture_ids(vt);
+    const float all[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+    ck_assert_int_eq(virtual_texture_request(vt, all, 1), 2);
+    int pending;
+    ck_assert(!virtual_texture_poll(vt, &pending));
+    ck_assert_int_eq(pending, 2);
+    ck_assert_uint_eq(ids[0], 0);
+    ck_assert_uint_eq(ids[1], 0);
+
+    while (renderer_pump_uploads()) {}
+    ck_assert(virtual_texture_poll(vt, &pending));
+    ck_assert_int_eq(pending, 0);
+    ck_assert(ids[0] != 0);
+    ck_assert(ids[1] != 0);
+    ck_assert(!virtual_texture_poll(vt, &pending));
+    virtual_texture_destroy(vt);
+}
+END_TEST
+
+START_TEST(test_trim_evicts_least_recently_wanted)
+{
+    virtual_texture_t *vt = make_vt(1024, 256, 256);
+    const uint32_t *ids = virtual_texture_ids(vt);
+    for (int i = 0; i < 4; i++) {
+        const float uv[4] = { (float)i / 4.0f + 0.01f, 0.0f, (float)(i + 1) / 4.0f - 0.01f, 1.0f };
+        ck_assert_int_eq(virtual_texture_request(vt, uv, (uint64_t)i + 1), 1);
+    }
+    ck_assert_uint_eq(virtual_texture_resident_bytes(vt), 4 * TILE_BYTES(256));
+
+    virtual_texture_t *vts[] = { vt };
+    ck_assert_int_eq(virtual_texture_trim(vts, 1, 2 * TILE_BYTES(256), 4), 2);
+    ck_assert_uint_eq(ids[0], 0);
+    ck_assert_uint_eq(ids[1], 0);
+    ck_assert(ids[2] != 0);
+    ck_assert(ids[3] != 0);
+    ck_assert_uint_eq(virtual_texture_resident_bytes(vt), 2 * TILE_BYTES(256));
+
+    /* Tiles wanted this frame stay even over budget */
+    ck_assert_int_eq(virtual_texture_trim(vts, 1, 0, 4), 1);
+    ck_assert_uint_eq(ids[2], 0);
+    ck_assert(ids[3] != 0);
+    virtual_texture_destroy(vt);
+}
+END_TEST
+
+START_TEST(test_max_texture_size_from_gl)
+{
+    int saved = gl_stub_max_texture_size;
+    gl_stub_max_texture_size = 8192;
+    ck_assert_int_eq(renderer_max_texture_size(), 8192);
+    gl_stub_max_texture_size = saved;
+}
+END_TEST
+
+Suite *virtual_texture_suite(void) {
+    Suite *s = suite_create("VirtualTexture");
+    TCase *tc = tcase_create("Core");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, test_grid_covers_image);
+    tcase_add_test(tc, test_request_uploads_tiles_in_window);
+    tcase_add_test(tc, test_tiles_carry_neighbour_gutter);
+    tcase_add_test(tc, test_tiles_drawable_once_uploaded);
+    tcase_add_test(tc, test_trim_evicts_least_recently_wanted);
+    tcase_add_test(tc, test_max_texture_size_from_gl);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int failed;
+    Suite *s = virtual_texture_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}